@@ -7,21 +7,141 @@
  * 
  * Description: a simple web crawler
  
- * Usage: ./crawler seedURL pageDirectory maxDepth
+ * Usage: ./crawler seedURL pageDirectory maxDepth [--resume] [-i indexFile] [-d] [--recrawl]
+ *                  [--fsync none|batch|each] [-z] [--dict dictFile] [--train-dict dictFile]
+ *                  [--max-body bytes] [--scope rulesFile]
+ *
+ * Pages are saved by a separate writer thread so that disk latency
+ * stays off the fetch loop; --fsync chooses whether saved pages are
+ * forced to disk never (the default), once per batch, or one by one.
+ * With -z, pages are saved deflated. With --dict (which implies -z),
+ * dictFile (see pagedict.h) is copied into pageDirectory and used as
+ * the preset dictionary; without it, pageDirectory's own dictionary is
+ * used if it has one. pageload inflates either kind transparently.
+ * Pages already saved with a dictionary can only be read with it, so
+ * --dict refuses a different one when pageDirectory has pages.
+ * With --train-dict, a dictionary is trained from pageDirectory's pages
+ * once the crawl is done and saved to dictFile, for --dict in later
+ * crawls of the same site.
+ * With --max-body, pages larger than the given number of bytes are
+ * not downloaded (or the download is cut short) and count as failed.
+ * Links are followed only if they are in scope: by default, if they
+ * start with INTERNAL_URL_PREFIX; with --scope, by the allow/deny
+ * rules in rulesFile (see scope.h). The file is reread whenever it
+ * changes during the crawl, and queued URLs it no longer allows are
+ * dropped when their turn comes.
+ * Every saved page's in-scope links, with their anchor text, are
+ * recorded in pageDirectory/.links (see linkfile.h) for the indexer,
+ * even at maxDepth where they are not followed.
+ *
+ * With --resume, the crawl continues from the last checkpoint written
+ * to pageDirectory instead of starting over from seedURL.
+ * With -i, fetched pages are also indexed in-process by a second thread
+ * and the index is saved to indexFile when the crawl finishes, so the
+ * separate indexer run (and its re-read of every page) is not needed,
+ * unless anchor text or PageRank is wanted: both need the links of every
+ * page, so the index has no anchor text (the words of links to a page,
+ * credited to it) and no indexFile.pagerank is saved. The indexer, run
+ * on pageDirectory afterwards, builds both.
+ * With -d, pages whose text duplicates or nearly duplicates an already
+ * saved page (by SimHash) are not saved or indexed; their links are
+ * still followed.
+ * With --recrawl, pageDirectory holds an earlier crawl: pages are
+ * requested conditionally (ETag / Last-Modified from .crawler.meta),
+ * only changed pages are rewritten (under their old docIDs), and the
+ * added, modified and deleted docIDs are listed in .changes for
+ * 'indexer -u'. The files of deleted pages are removed; the indexer
+ * takes the docIDs that are left, gaps and all.
  */
 
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <unistd.h> // For access()
+#include <pthread.h>
+#include <zlib.h>   // For Z_DEFAULT_COMPRESSION
 #include "webpage.h"
+#include "pageio.h"
 #include "queue.h"
 #include "hash.h"
+#include "checkpoint.h"
+#include "bqueue.h"
+#include "index.h"
+#include "indexio.h"
+#include "simhash.h"
+#include "pagemeta.h"
+#include "pagewriter.h"
+#include "pagedict.h"
+#include "htmllex.h"
+#include "url.h"
+#include "scope.h"
+#include "linkfile.h"
+#include "pagedir.h"
+
+#define PIPELINE_DEPTH 64 // Max pages waiting for the indexing stage
+#define WRITER_DEPTH 64   // Max pages waiting for the page writer
+#define TRAIN_PAGES 1000  // Pages a dictionary is trained from, at most
+
+// --- Local Structs ---
+// Command-line options beyond the three required arguments
+typedef struct crawl_options {
+    bool resume;      // continue from the last checkpoint
+    char* indexFile;  // if non-NULL, index pages in-process and save here
+    bool dedup;       // skip pages that duplicate an already saved page
+    bool recrawl;     // update an earlier crawl of pageDirectory in place
+    pagewriter_fsync_t fsync; // when saved pages are forced to disk
+    int zlevel;       // zlib level for saved pages, 0 for none
+    char* dictFile;   // if non-NULL, preset dictionary for compression
+    char* trainFile;  // if non-NULL, where to save a dictionary trained from the pages
+    long maxBody;     // largest page body to download, 0 for no limit
+    char* scopeFile;  // if non-NULL, allow/deny rules for links to follow
+} crawl_options_t;
+
+// A page handed from the crawl loop to the indexing stage
+typedef struct indexed_page {
+    webpage_t* page;
+    int docID;
+} indexed_page_t;
+
+// The indexing stage: a thread draining a bounded queue into an index,
+// then passing each page on to the writer
+typedef struct index_stage {
+    bqueue_t* queue;
+    hashtable_t* index;
+    pagewriter_t* writer;
+    pthread_t thread;
+} index_stage_t;
+
+// Where enqueue_links puts the links of one page
+typedef struct link_target {
+    webpage_t* page;
+    hashtable_t* seen_urls;
+    queue_t* pages_to_crawl;
+    checkpoint_t* ckpt;
+    url_memo_t* memo;  // links of the page already resolved
+    scope_t* scope;    // which links to follow
+    bool follow;       // whether to queue the new links
+    linkfile_t* links; // if non-NULL, where to record the links
+} link_target_t;
 
 // --- Local Function Prototypes ---
-static void parse_args(const int argc, char* argv[], char** seedURL, char** pageDir, int* maxDepth);
-static void crawl(char* seedURL, char* pageDir, const int maxDepth);
-static int32_t pagesave(webpage_t* pagep, int id, const char* dirname);
+static void parse_args(const int argc, char* argv[], char** seedURL, char** pageDir, int* maxDepth, crawl_options_t* opts);
+static void crawl(char* seedURL, char* pageDir, const int maxDepth, const crawl_options_t* opts);
+static void save_page(webpage_t* page, int docID, index_stage_t* stage, pagewriter_t* writer);
+static void commit_checkpoint(checkpoint_t* ckpt, pagewriter_t* writer, int saved, int dequeued, int nextID, bool force);
+static index_stage_t* index_stage_start(pagewriter_t* writer);
+static void index_stage_put(index_stage_t* stage, webpage_t* page, int docID);
+static void index_stage_finish(index_stage_t* stage, const char* indexFile);
+static void* index_stage_run(void* arg);
+static void enqueue_links(webpage_t* page, hashtable_t* seen_urls, queue_t* pages_to_crawl, checkpoint_t* ckpt,
+                          url_memo_t* memo, scope_t* scope, bool follow, linkfile_t* links);
+static void link_helper(const char* href, int href_len, const char* text, int text_len, void* arg);
+static dupindex_t* load_fingerprints(char* pageDir, int nextID);
+static pagedict_t* setup_dict(char* pageDir, const crawl_options_t* opts);
+static void train_dict(char* pageDir, const char* trainFile);
+static void list_deleted(pagemeta_t* meta, FILE* changes, char* pageDir);
+static void deleted_helper(page_meta_t* m, void* arg);
+static bool page_on_disk(int docID, char* pageDir);
 static bool search_url(void* elementp, const void* keyp);
 static void free_item(void* item);
 
@@ -30,9 +150,10 @@ int main(const int argc, char* argv[]) {
     char* seedURL;
     char* pageDir;
     int maxDepth;
+    crawl_options_t opts;
 
-    parse_args(argc, argv, &seedURL, &pageDir, &maxDepth);
-    crawl(seedURL, pageDir, maxDepth);
+    parse_args(argc, argv, &seedURL, &pageDir, &maxDepth, &opts);
+    crawl(seedURL, pageDir, maxDepth, &opts);
 
     return EXIT_SUCCESS;
 }
@@ -41,14 +162,85 @@ int main(const int argc, char* argv[]) {
  * Parses and validates command-line arguments.
  * Exits the program if arguments are invalid.
  */
-static void parse_args(const int argc, char* argv[], char** seedURL, char** pageDir, int* maxDepth) {
-    if (argc != 4) {
-        fprintf(stderr, "Usage: %s seedURL pageDirectory maxDepth\n", argv[0]);
+static void parse_args(const int argc, char* argv[], char** seedURL, char** pageDir, int* maxDepth, crawl_options_t* opts) {
+    const char* usage = "Usage: %s seedURL pageDirectory maxDepth [--resume] [-i indexFile] [-d] [--recrawl]"
+                        " [--fsync none|batch|each] [-z] [--dict dictFile] [--train-dict dictFile]"
+                        " [--max-body bytes] [--scope rulesFile]\n";
+    if (argc < 4) {
+        fprintf(stderr, usage, argv[0]);
         exit(EXIT_FAILURE);
     }
 
     *seedURL = argv[1];
     *pageDir = argv[2];
+    opts->resume = false;
+    opts->indexFile = NULL;
+    opts->dedup = false;
+    opts->recrawl = false;
+    opts->fsync = PW_FSYNC_NONE;
+    opts->zlevel = 0;
+    opts->dictFile = NULL;
+    opts->trainFile = NULL;
+    opts->maxBody = 0;
+    opts->scopeFile = NULL;
+
+    // Optional flags follow the required arguments
+    for (int i = 4; i < argc; i++) {
+        if (strcmp(argv[i], "--resume") == 0) {
+            opts->resume = true;
+        } else if (strcmp(argv[i], "-i") == 0 && i + 1 < argc) {
+            opts->indexFile = argv[++i];
+        } else if (strcmp(argv[i], "-d") == 0) {
+            opts->dedup = true;
+        } else if (strcmp(argv[i], "--recrawl") == 0) {
+            opts->recrawl = true;
+        } else if (strcmp(argv[i], "--fsync") == 0 && i + 1 < argc) {
+            i++;
+            if (strcmp(argv[i], "none") == 0) {
+                opts->fsync = PW_FSYNC_NONE;
+            } else if (strcmp(argv[i], "batch") == 0) {
+                opts->fsync = PW_FSYNC_BATCH;
+            } else if (strcmp(argv[i], "each") == 0) {
+                opts->fsync = PW_FSYNC_EACH;
+            } else {
+                fprintf(stderr, "Error: --fsync must be none, batch or each.\n");
+                exit(EXIT_FAILURE);
+            }
+        } else if (strcmp(argv[i], "-z") == 0) {
+            opts->zlevel = Z_DEFAULT_COMPRESSION;
+        } else if (strcmp(argv[i], "--dict") == 0 && i + 1 < argc) {
+            opts->dictFile = argv[++i];
+            opts->zlevel = Z_DEFAULT_COMPRESSION;
+        } else if (strcmp(argv[i], "--train-dict") == 0 && i + 1 < argc) {
+            opts->trainFile = argv[++i];
+        } else if (strcmp(argv[i], "--max-body") == 0 && i + 1 < argc) {
+            if (sscanf(argv[++i], "%ld", &opts->maxBody) != 1 || opts->maxBody <= 0) {
+                fprintf(stderr, "Error: --max-body must be a positive number of bytes.\n");
+                exit(EXIT_FAILURE);
+            }
+        } else if (strcmp(argv[i], "--scope") == 0 && i + 1 < argc) {
+            opts->scopeFile = argv[++i];
+        } else {
+            fprintf(stderr, usage, argv[0]);
+            fprintf(stderr, "Error: Unrecognized argument '%s'.\n", argv[i]);
+            exit(EXIT_FAILURE);
+        }
+    }
+
+    // The in-memory index of the interrupted run is gone, so a resumed
+    // crawl cannot produce a complete one
+    if (opts->resume && opts->indexFile != NULL) {
+        fprintf(stderr, "Error: --resume cannot be combined with -i; run the indexer afterwards.\n");
+        exit(EXIT_FAILURE);
+    }
+
+    // A recrawl touches only what changed, so there is no full page set
+    // to index or deduplicate, and restarting it is cheap (unchanged
+    // pages cost a 304) while resuming would lose which pages were visited
+    if (opts->recrawl && (opts->resume || opts->indexFile != NULL || opts->dedup)) {
+        fprintf(stderr, "Error: --recrawl cannot be combined with --resume, -i or -d.\n");
+        exit(EXIT_FAILURE);
+    }
 
     // Validate pageDirectory
     char filepath[256];
@@ -71,79 +263,478 @@ static void parse_args(const int argc, char* argv[], char** seedURL, char** page
 /**
  * Contains the main crawling loop and logic.
  */
-static void crawl(char* seedURL, char* pageDir, const int maxDepth) {
+static void crawl(char* seedURL, char* pageDir, const int maxDepth, const crawl_options_t* opts) {
     hashtable_t* seen_urls = hopen(200);
     queue_t* pages_to_crawl = qopen();
+    url_memo_t* memo = calloc(1, sizeof(url_memo_t));
     int docID = 1;
+    int dequeued = 0; // URLs taken off the queue so far, for checkpoints
+    int saved = 0;    // pages handed to the writer so far
+    checkpoint_t* ckpt;
+    index_stage_t* stage = NULL;
+    dupindex_t* dups = NULL;
+    FILE* changes = NULL; // change list, for --recrawl
+
+    // Links to follow: by the rules file, or everything under INTERNAL_URL_PREFIX
+    scope_t* scope;
+    if (opts->scopeFile != NULL) {
+        scope = scope_load(opts->scopeFile);
+        if (scope == NULL) {
+            exit(EXIT_FAILURE);
+        }
+    } else {
+        scope = scope_new();
+        scope_add(scope, INTERNAL_URL_PREFIX, true);
+    }
+
+    // Metadata of earlier crawls is kept when resuming or recrawling
+    pagemeta_t* meta = pagemeta_open(pageDir, opts->resume || opts->recrawl);
+    linkfile_t* links = linkfile_open(pageDir, opts->resume || opts->recrawl);
+    if (meta == NULL || links == NULL) {
+        exit(EXIT_FAILURE);
+    }
+    if (opts->recrawl) {
+        docID = pagemeta_maxid(meta) + 1; // new pages go after the old ones
+        char filepath[256];
+        sprintf(filepath, "%s/.changes", pageDir);
+        changes = fopen(filepath, "w");
+        if (changes == NULL) {
+            perror("Error opening change list for writing");
+            exit(EXIT_FAILURE);
+        }
+    }
+
+    webpage_setMaxBody(opts->maxBody);
+    page_codec_t codec = { opts->zlevel, setup_dict(pageDir, opts) };
+    pagewriter_t* writer = pagewriter_start(pageDir, WRITER_DEPTH, opts->fsync, &codec);
+    if (writer == NULL) {
+        fprintf(stderr, "Error: Failed to start the page writer.\n");
+        exit(EXIT_FAILURE);
+    }
+    if (opts->indexFile != NULL) {
+        stage = index_stage_start(writer);
+    }
+
+    if (opts->resume) {
+        // Rebuild the queue, seen set and docID from the last checkpoint
+        ckpt = checkpoint_resume(pageDir, seen_urls, pages_to_crawl, &dequeued, &docID);
+        if (ckpt == NULL) {
+            fprintf(stderr, "Error: No checkpoint to resume from in '%s'.\n", pageDir);
+            hclose(seen_urls);
+            qclose(pages_to_crawl);
+            exit(EXIT_FAILURE);
+        }
+        // Pages saved after the last commit are in the metadata already
+        if (pagemeta_maxid(meta) >= docID) {
+            docID = pagemeta_maxid(meta) + 1;
+        }
+        printf("Resuming at docID %d after %d crawled URLs\n", docID, dequeued);
+        if (opts->dedup) {
+            dups = load_fingerprints(pageDir, docID);
+        }
+    } else {
+        ckpt = checkpoint_open(pageDir);
 
-    // Normalize the seed URL and add it to the hash table first
-    char* seedURL_copy = malloc(strlen(seedURL) + 1);
-    strcpy(seedURL_copy, seedURL);
-    NormalizeURL(seedURL_copy);
-    hput(seen_urls, seedURL_copy, seedURL_copy, strlen(seedURL_copy));
-    
-    // Create the first webpage and add it to the queue
-    webpage_t* first_page = webpage_new(seedURL, 0, NULL);
-    qput(pages_to_crawl, first_page);
+        // Normalize the seed URL and add it to the hash table first
+        char* seedURL_copy = malloc(strlen(seedURL) + 1);
+        strcpy(seedURL_copy, seedURL);
+        NormalizeURL(seedURL_copy);
+        hput(seen_urls, seedURL_copy, seedURL_copy, strlen(seedURL_copy));
+
+        // Create the first webpage and add it to the queue
+        webpage_t* first_page = webpage_new(seedURL, 0, NULL);
+        qput(pages_to_crawl, first_page);
+        checkpoint_seen(ckpt, seedURL, 0);
+        if (opts->dedup) {
+            dups = dupindex_new();
+        }
+    }
 
     webpage_t* current_page;
     while ((current_page = qget(pages_to_crawl)) != NULL) {
+        dequeued++;
+
+        // The rules may have changed since this URL was queued
+        if (scope_reload(scope)) {
+            printf("Reloaded scope rules from %s\n", opts->scopeFile);
+        }
+        if (webpage_getDepth(current_page) > 0 && !scope_allows(scope, webpage_getURL(current_page))) {
+            printf("Out of scope: %s\n", webpage_getURL(current_page));
+            webpage_delete(current_page);
+            commit_checkpoint(ckpt, writer, saved, dequeued, docID, false);
+            continue;
+        }
         printf("Crawling: %s\n", webpage_getURL(current_page));
 
-        if (!webpage_fetch(current_page)) {
+        // If an earlier crawl saved this URL, only ask for changes
+        page_meta_t* old = pagemeta_get(meta, webpage_getURL(current_page));
+        webpage_validators_t val = { "", "" };
+        if (old != NULL) {
+            val = old->val;
+            old->visited = true;
+        }
+
+        int fetched = webpage_fetchIfModified(current_page, &val);
+        if (fetched < 0 || (fetched == 0 && old == NULL)) {
             fprintf(stderr, "Warning: Failed to fetch HTML for %s\n", webpage_getURL(current_page));
             webpage_delete(current_page);
+            commit_checkpoint(ckpt, writer, saved, dequeued, docID, false);
             continue; // Ignore this URL and move on
         }
 
-        pagesave(current_page, docID++, pageDir);
-
-        if (webpage_getDepth(current_page) < maxDepth) {
-            int pos = 0;
-            char* result_url;
-            while ((pos = webpage_getNextURL(current_page, pos, &result_url)) > 0) {
-                if (IsInternalURL(result_url)) {
-                    if (hsearch(seen_urls, search_url, result_url, strlen(result_url)) == NULL) {
-                        char* url_copy = malloc(strlen(result_url) + 1);
-                        strcpy(url_copy, result_url);
-                        hput(seen_urls, url_copy, url_copy, strlen(url_copy));
+        webpage_t* stored_page = NULL; // saved copy, if the page is unchanged
+        bool rewrite = false;          // save even if the content is the same
+        int save_id = 0;               // docID to save the page as, if any
+        if (fetched == 0) {
+            // 304 Not Modified: follow the links of the saved copy
+            stored_page = pageload(old->docID, pageDir);
+            if (stored_page == NULL) {
+                // The saved copy is gone (e.g. lost in a crash): get it in full
+                val.etag[0] = val.lastmod[0] = '\0';
+                fetched = webpage_fetchIfModified(current_page, &val);
+                rewrite = true;
+            }
+        }
+        if (fetched > 0) {
+            uint64_t hash = pagemeta_hash(webpage_getHTML(current_page), webpage_getHTMLlen(current_page));
+            if (old != NULL && old->hash == hash && !rewrite && page_on_disk(old->docID, pageDir)) {
+                // Same content, maybe new validators; don't rewrite it
+                // (the metadata is written as a page is queued for the
+                // writer, so a crash can leave it without its file)
+                pagemeta_put(meta, old->url, old->docID, hash, &val);
+            } else {
+                int original = 0;
+                if (dups != NULL) {
+                    fingerprint_t fp = page_fingerprint(current_page);
+                    original = dupindex_find(dups, &fp, SIMHASH_MAXDIST);
+                    if (original > 0) {
+                        printf("Duplicate of page %d, not saved\n", original);
+                    } else {
+                        dupindex_add(dups, &fp, docID);
+                    }
+                }
 
-                        webpage_t* new_page = webpage_new(result_url, webpage_getDepth(current_page) + 1, NULL);
-                        qput(pages_to_crawl, new_page);
+                if (original == 0) {
+                    save_id = (old != NULL) ? old->docID : docID++;
+                    pagemeta_put(meta, webpage_getURL(current_page), save_id, hash, &val);
+                    if (old == NULL) {
+                        // A page new to this crawl is not one of the deleted ones
+                        pagemeta_get(meta, webpage_getURL(current_page))->visited = true;
+                    }
+                    if (changes != NULL) {
+                        fprintf(changes, "%c %d\n", (old != NULL) ? 'M' : 'A', save_id);
                     }
                 }
-                free(result_url);
             }
         }
-        webpage_delete(current_page);
+
+        // Links are followed short of maxDepth, and recorded for saved pages
+        webpage_t* link_page = (stored_page != NULL) ? stored_page : (fetched > 0) ? current_page : NULL;
+        bool follow = webpage_getDepth(current_page) < maxDepth;
+        if (link_page != NULL && (follow || save_id > 0)) {
+            enqueue_links(link_page, seen_urls, pages_to_crawl, ckpt, memo, scope,
+                          follow, (save_id > 0) ? links : NULL);
+        }
+        if (save_id > 0 && linkfile_end(links, save_id) != 0) {
+            fprintf(stderr, "Warning: Failed to record the links of %s\n", webpage_getURL(current_page));
+        }
+        webpage_delete(stored_page);
+
+        // Link extraction leaves the html as it is, so the page itself
+        // goes on to be indexed and saved
+        if (save_id > 0) {
+            save_page(current_page, save_id, stage, writer);
+            saved++;
+        } else {
+            webpage_delete(current_page);
+        }
+
+        // The page and its links are complete; a crash from here on
+        // resumes with the next URL rather than refetching this one
+        commit_checkpoint(ckpt, writer, saved, dequeued, docID, false);
+    }
+
+    // Drain the indexing stage into the writer, then the writer to disk
+    if (stage != NULL) {
+        index_stage_finish(stage, opts->indexFile);
+    }
+    int failed = pagewriter_finish(writer);
+    if (failed > 0) {
+        fprintf(stderr, "Warning: %d pages could not be saved\n", failed);
+    }
+    pagedict_delete(codec.dict);
+
+    // Pages of the earlier crawl that are no longer reachable
+    if (changes != NULL) {
+        list_deleted(meta, changes, pageDir);
+        pagemeta_compact(meta);
+        fclose(changes);
+    }
+
+    if (opts->trainFile != NULL) {
+        train_dict(pageDir, opts->trainFile);
     }
 
     // Clean up
+    checkpoint_commit(ckpt, dequeued, docID, true);
+    checkpoint_close(ckpt);
+    pagemeta_close(meta);
+    linkfile_close(links);
+    dupindex_delete(dups);
     happly(seen_urls, free_item);
     hclose(seen_urls);
     qclose(pages_to_crawl);
+    free(memo);
+    scope_delete(scope);
+}
+
+/**
+ * Hands a fetched page (and its ownership) on to be saved as docID:
+ * through the indexing stage if there is one, or straight to the writer.
+ */
+static void save_page(webpage_t* page, int docID, index_stage_t* stage, pagewriter_t* writer) {
+    if (stage != NULL) {
+        index_stage_put(stage, page, docID);
+    } else {
+        pagewriter_put(writer, page, docID);
+    }
+}
+
+/**
+ * Commits a checkpoint when one is due (or forced), after waiting for
+ * the writer to finish the first `saved` pages, so that a checkpoint
+ * never covers a page that is not yet on disk.
+ */
+static void commit_checkpoint(checkpoint_t* ckpt, pagewriter_t* writer, int saved, int dequeued, int nextID, bool force) {
+    if (force || checkpoint_due(ckpt)) {
+        pagewriter_wait(writer, saved);
+        checkpoint_commit(ckpt, dequeued, nextID, true);
+    }
 }
 
 /**
- * Saves a fetched page to a file in a specified directory.
+ * Returns true if page docID of pageDir is saved and loads.
  */
-static int32_t pagesave(webpage_t* pagep, int id, const char* dirname) {
+static bool page_on_disk(int docID, char* pageDir) {
+    webpage_t* page = pagemap(docID, pageDir);
+    bool loads = (page != NULL);
+    webpage_delete(page);
+    return loads;
+}
+
+/**
+ * Returns the preset dictionary for compressing pages, if any: dictFile,
+ * after copying it into pageDir where pageload will look for it, or
+ * else pageDir's existing dictionary.
+ * Exits the program if dictFile cannot be read or copied, or if it
+ * would replace the dictionary of pages already in pageDir.
+ */
+static pagedict_t* setup_dict(char* pageDir, const crawl_options_t* opts) {
     char filepath[256];
-    sprintf(filepath, "%s/%d", dirname, id);
+    snprintf(filepath, sizeof(filepath), "%s/%s", pageDir, PAGEDICT_FILE);
+    if (opts->dictFile == NULL) {
+        return opts->zlevel != 0 ? pagedict_load(filepath) : NULL;
+    }
 
-    FILE* fp = fopen(filepath, "w");
-    if (fp == NULL) {
-        perror("Error opening file for writing");
-        return 1;
+    pagedict_t* dict = pagedict_load(opts->dictFile);
+    if (dict == NULL) {
+        fprintf(stderr, "Error: Cannot read dictionary '%s'.\n", opts->dictFile);
+        exit(EXIT_FAILURE);
+    }
+
+    // Pages compressed with the old dictionary could no longer be inflated
+    pagedict_t* old = pagedict_load(filepath);
+    int num_pages = 0;
+    free(pagedir_list(pageDir, &num_pages));
+    bool same = old != NULL && old->len == dict->len && memcmp(old->data, dict->data, dict->len) == 0;
+    if (old != NULL && !same && num_pages > 0) {
+        fprintf(stderr, "Error: The pages in '%s' were saved with another dictionary than '%s'.\n",
+                pageDir, opts->dictFile);
+        exit(EXIT_FAILURE);
     }
+    pagedict_delete(old);
 
-    fprintf(fp, "%s\n", webpage_getURL(pagep));
-    fprintf(fp, "%d\n", webpage_getDepth(pagep));
-    fprintf(fp, "%d\n", webpage_getHTMLlen(pagep));
-    fprintf(fp, "%s", webpage_getHTML(pagep));
+    if (!same && pagedict_save(dict, filepath) != 0) {
+        exit(EXIT_FAILURE);
+    }
+    return dict;
+}
 
-    fclose(fp);
-    return 0;
+/**
+ * Trains a dictionary from the pages in pageDir (see pagedict.h) and
+ * saves it to trainFile, warning if that fails.
+ */
+static void train_dict(char* pageDir, const char* trainFile) {
+    pagedict_t* dict = pagedict_train(pageDir, TRAIN_PAGES);
+    if (dict == NULL) {
+        fprintf(stderr, "Warning: The pages share too little to train a dictionary.\n");
+        return;
+    }
+    if (pagedict_save(dict, trainFile) == 0) {
+        printf("Dictionary of %d bytes saved to %s\n", dict->len, trainFile);
+    } else {
+        fprintf(stderr, "Warning: Failed to save the dictionary to %s\n", trainFile);
+    }
+    pagedict_delete(dict);
+}
+
+/**
+ * Starts the indexing stage's thread on an empty index; indexed pages
+ * are passed on to writer.
+ * Exits the program if the thread cannot be started.
+ */
+static index_stage_t* index_stage_start(pagewriter_t* writer) {
+    index_stage_t* stage = malloc(sizeof(index_stage_t));
+    stage->queue = bqopen(PIPELINE_DEPTH);
+    stage->index = index_new();
+    stage->writer = writer;
+    if (pthread_create(&stage->thread, NULL, index_stage_run, stage) != 0) {
+        fprintf(stderr, "Error: Failed to start the indexing thread.\n");
+        exit(EXIT_FAILURE);
+    }
+    return stage;
+}
+
+/**
+ * Hands a page (which the stage now owns) to the indexing stage,
+ * blocking if it is PIPELINE_DEPTH pages behind.
+ */
+static void index_stage_put(index_stage_t* stage, webpage_t* page, int docID) {
+    indexed_page_t* item = malloc(sizeof(indexed_page_t));
+    item->page = page;
+    item->docID = docID;
+    bqput(stage->queue, item);
+}
+
+/**
+ * Waits for the indexing stage to drain, saves the index and frees the stage.
+ */
+static void index_stage_finish(index_stage_t* stage, const char* indexFile) {
+    bqdone(stage->queue);
+    pthread_join(stage->thread, NULL);
+
+    if (indexsave(stage->index, indexFile, ANALYZER_LOWER) != 0) {
+        fprintf(stderr, "Failed to save index to file: %s\n", indexFile);
+    } else {
+        printf("Index saved to %s\n", indexFile);
+    }
+    index_delete(stage->index);
+    bqclose(stage->queue);
+    free(stage);
+}
+
+/**
+ * Body of the indexing thread: indexes pages until the queue is done,
+ * passing each one on to the writer.
+ */
+static void* index_stage_run(void* arg) {
+    index_stage_t* stage = (index_stage_t*)arg;
+    indexed_page_t* item;
+    while ((item = bqget(stage->queue)) != NULL) {
+        index_addpage(stage->index, item->page, item->docID, ANALYZER_LOWER);
+        pagewriter_put(stage->writer, item->page, item->docID);
+        free(item);
+    }
+    return NULL;
+}
+
+/**
+ * If follow is true, adds every new in-scope link of page to the queue,
+ * one level deeper than the page; if links is not NULL, records every
+ * in-scope link there, new or not, with its anchor text. Leaves the
+ * page's html unchanged.
+ */
+static void enqueue_links(webpage_t* page, hashtable_t* seen_urls, queue_t* pages_to_crawl, checkpoint_t* ckpt,
+                          url_memo_t* memo, scope_t* scope, bool follow, linkfile_t* links) {
+    link_target_t target = { page, seen_urls, pages_to_crawl, ckpt, memo, scope, follow, links };
+    url_memo_reset(memo, webpage_getURL(page));
+    htmllex_handler_t handler = { .link = link_helper, .arg = &target };
+    htmllex_run(webpage_getHTML(page), webpage_getHTMLlen(page), &handler);
+}
+
+// Records one link found by the lexer, and queues it if it is new (for htmllex_run)
+static void link_helper(const char* href, int href_len, const char* text, int text_len, void* arg) {
+    link_target_t* target = (link_target_t*)arg;
+    const char* result_url;
+    char* long_url = NULL; // a link too long for the memo, resolved the old way
+    int len = url_memo_resolve(target->memo, href, href_len, &result_url);
+    if (len == URL_TOOLONG) {
+        long_url = webpage_resolveURL(target->page, href, href_len);
+        if (long_url == NULL || !NormalizeURL(long_url)) {
+            free(long_url);
+            return;
+        }
+        result_url = long_url;
+    } else if (len < 0) {
+        return;
+    }
+
+    if (!scope_allows(target->scope, result_url)) {
+        free(long_url);
+        return;
+    }
+    if (target->links != NULL) {
+        linkfile_add(target->links, result_url, text, text_len);
+    }
+    if (target->follow && hsearch(target->seen_urls, search_url, result_url, strlen(result_url)) == NULL) {
+        char* url_copy = malloc(strlen(result_url) + 1);
+        strcpy(url_copy, result_url);
+        hput(target->seen_urls, url_copy, url_copy, strlen(url_copy));
+
+        webpage_t* new_page = webpage_new(url_copy, webpage_getDepth(target->page) + 1, NULL);
+        qput(target->pages_to_crawl, new_page);
+        checkpoint_seen(target->ckpt, url_copy, webpage_getDepth(new_page));
+    }
+    free(long_url);
+}
+
+/**
+ * Rebuilds the duplicate index of a resumed crawl from the pages
+ * already saved in pageDir (docIDs below nextID).
+ */
+static dupindex_t* load_fingerprints(char* pageDir, int nextID) {
+    dupindex_t* dups = dupindex_new();
+    for (int id = 1; id < nextID; id++) {
+        webpage_t* page = pageload(id, pageDir);
+        if (page != NULL) {
+            fingerprint_t fp = page_fingerprint(page);
+            dupindex_add(dups, &fp, id);
+            webpage_delete(page);
+        }
+    }
+    return dups;
+}
+
+/**
+ * Lists every page of the earlier crawl that this recrawl did not reach
+ * as deleted, forgets its metadata and removes its file from pageDir.
+ */
+static void list_deleted(pagemeta_t* meta, FILE* changes, char* pageDir) {
+    queue_t* gone = qopen(); // URLs to forget; can't remove while applying
+    pagemeta_apply(meta, deleted_helper, gone);
+
+    char* url;
+    while ((url = qget(gone)) != NULL) {
+        page_meta_t* m = pagemeta_get(meta, url);
+        fprintf(changes, "D %d\n", m->docID);
+        char filepath[256];
+        snprintf(filepath, sizeof(filepath), "%s/%d", pageDir, m->docID);
+        if (remove(filepath) != 0) {
+            fprintf(stderr, "Warning: Could not remove deleted page %s\n", filepath);
+        }
+        pagemeta_remove(meta, url);
+        free(url);
+    }
+    qclose(gone);
+}
+
+// Collects a copy of the URL of each record the recrawl did not visit
+static void deleted_helper(page_meta_t* m, void* arg) {
+    if (!m->visited) {
+        char* url = malloc(strlen(m->url) + 1);
+        strcpy(url, m->url);
+        qput((queue_t*)arg, url);
+    }
 }
 
 /**
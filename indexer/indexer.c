@@ -4,61 +4,166 @@
  * Author: Insecticide
  * Date: 10-30-2025
  *
- * Usage: ./indexer pageDirectory indexFilename
+ * Usage: ./indexer pageDirectory indexFilename [-d] [-u] [--stem] [--stopwords wordsFile]
+ *                  [--snippets]
+ *
+ * The pages are the files of pageDirectory named by docIDs, which need
+ * not start at 1 or be consecutive: a recrawl deletes the files of
+ * pages that are gone. They are listed with one pass over the
+ * directory and loaded on other threads, a few pages ahead.
+ *
+ * With -d, a page whose text duplicates or nearly duplicates an earlier
+ * page (by SimHash) is collapsed into that earlier, canonical docID:
+ * it is not indexed again.
+ * With -u, the existing indexFilename is updated in place from the
+ * change list (pageDirectory/.changes) left by 'crawler --recrawl':
+ * only added, modified and deleted pages are (re)processed.
+ * With --stem, words are indexed by their Porter2 stem (see analyzer.h),
+ * and the index records it so the querier stems queries the same way.
+ * An update uses the analyzer the index was built with, so it need not
+ * repeat the option; giving one that disagrees is an error.
+ * With --stopwords, the words listed in wordsFile (whitespace separated,
+ * '#' to the end of a line is a comment; see stopwords.txt) are kept in
+ * the index's stopword tier: a bitmap of their pages, with no counts.
+ * The index remembers them, so updates need not repeat the option.
+ * With --snippets, the visible text of every indexed page is saved next
+ * to the index as indexFilename.text (see doctext.h), from which the
+ * querier shows the words around each match. An update keeps that file
+ * up to date whenever it exists.
+ *
+ * The anchor text of the links the crawler recorded (pageDirectory/.links,
+ * see linkfile.h) is indexed as words of the pages the links lead to,
+ * in the anchor field. Links from a page to itself do not count. An
+ * update redoes the pages whose incoming links may have changed: the
+ * changed pages and those the changed pages link to, or linked to.
+ *
+ * The PageRank of the pages, over the same links (see linkgraph.h), is
+ * saved next to the index as indexFilename.pagerank for the querier;
+ * an update computes it afresh.
  */
 
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
-#include <ctype.h> // For isalpha, tolower
 #include <unistd.h> // For access()
 #include "webpage.h"
 #include "pageio.h"
 #include "hash.h"
 #include "queue.h"
-#include "index.h"    // Contains the shared struct definitions
+#include "index.h"    // Shared struct definitions and index_addpage()
 #include "indexio.h"  // For indexsave() and indexload()
+#include "simhash.h"  // For page_fingerprint() and the duplicate index
+#include "utf8.h"     // For utf8_fold_span()
+#include "linkfile.h" // For the crawler's links and their anchor text
+#include "pagemeta.h" // For the URLs of the pages, when updating
+#include "linkgraph.h" // For PageRank
+#include "doctext.h"  // For the pages' text, for snippets
+#include "pagedir.h"  // For pagedir_list() and the page loader
 
-// --- Local Function Prototypes ---
-static void parse_args(const int argc, char* argv[], char** pageDir, char** indexFile);
-static hashtable_t* build_index(char* pageDir);
-static char* NormalizeWord(char* word);
+#define DAMPING 0.85       // PageRank's chance of following a link
+#define RANK_TOLERANCE 1e-9 // ...and how little the ranks change when it is done
+#define MAX_RANK_ITERS 200
+#define URL_SLOTS 65536     // of the table of page URLs, for the anchor text
+#define LOAD_THREADS 2      // threads loading pages ahead of build_index()
+
+// --- Local Structs ---
+// Command-line options beyond the two required arguments
+typedef struct index_options {
+    bool dedup;  // collapse near-duplicate pages
+    bool update; // apply the crawler's change list to an existing index
+    analyzer_t analyzer; // how words become terms
+    bool analyzer_set; // the analyzer was given, rather than the default
+    char* stopwordsFile; // if non-NULL, words to keep as bitmaps
+    bool snippets; // save the pages' text
+} index_options_t;
 
-// Helper functions for data structures
-static bool search_word(void* elementp, const void* keyp);
-static bool search_doc(void* elementp, const void* keyp);
-static void free_doc_entry(void* data);
-static void free_word_entry(void* data);
+// A saved page's URL (normalized), and the docID it is indexed under
+typedef struct url_entry {
+    char* url;
+    int docID;
+} url_entry_t;
+
+// A set of docIDs, one byte each
+typedef struct docset {
+    char* has;
+    int len;
+} docset_t;
+
+// What anchor_helper needs to credit anchor text to pages
+typedef struct anchor_target {
+    hashtable_t* index;
+    analyzer_t analyzer;
+    hashtable_t* urls;  // url_entry_t of every page, by URL
+    docset_t live;      // pages whose links count
+    docset_t* only;     // if non-NULL, the only pages to credit
+    int num_anchors;
+} anchor_target_t;
+
+// What redo_helper needs to find the pages a changed page links to
+typedef struct redo_target {
+    hashtable_t* urls;
+    docset_t* changed;
+    docset_t* redo;     // where the pages linked to are added
+} redo_target_t;
+
+// --- Local Function Prototypes ---
+static void parse_args(const int argc, char* argv[], char** pageDir, char** indexFile, index_options_t* opts);
+static hashtable_t* build_index(char* pageDir, const index_options_t* opts, doctext_t* text);
+static hashtable_t* update_index(char* pageDir, char* indexFile, index_options_t* opts, doctext_t* text);
+static doctext_t* open_text(char* indexFile, const index_options_t* opts);
+static int load_stopwords(hashtable_t* index, const char* path, analyzer_t analyzer);
+static void add_anchors(char* pageDir, anchor_target_t* target);
+static void save_pagerank(char* pageDir, char* indexFile);
+static void anchor_helper(int source, const char* url, const char* text, int text_len, bool latest, void* arg);
+static void redo_helper(int source, const char* url, const char* text, int text_len, bool latest, void* arg);
+static void meta_helper(page_meta_t* m, void* arg);
+static void url_put(hashtable_t* urls, const char* url, int docID);
+static int url_lookup(hashtable_t* urls, const char* url);
+static bool search_url(void* elementp, const void* keyp);
+static void free_url_entry(void* data);
+static void docset_add(docset_t* set, int docID);
+static bool docset_has(const docset_t* set, int docID);
 
 // --- Main Function ---
 
 int main(int argc, char* argv[]) {
     char* pageDir;
     char* indexFile;
+    index_options_t opts;
 
     // 1. Validate command-line arguments
-    parse_args(argc, argv, &pageDir, &indexFile);
+    parse_args(argc, argv, &pageDir, &indexFile, &opts);
 
-    // 2. Build the index from the page directory
-    hashtable_t* index = build_index(pageDir);
+    // 2. Build the index from the page directory (or update it)
+    doctext_t* text = open_text(indexFile, &opts);
+    hashtable_t* index;
+    if (opts.update) {
+        index = update_index(pageDir, indexFile, &opts, text);
+    } else {
+        index = build_index(pageDir, &opts, text);
+    }
+    if (text != NULL && doctext_close(text) != 0) {
+        fprintf(stderr, "Warning: Failed to save the text of the pages.\n");
+    }
     if (index == NULL) {
         fprintf(stderr, "Failed to build index.\n");
         return EXIT_FAILURE;
     }
 
     // 3. Save the index to the output file
-    if (indexsave(index, indexFile) != 0) {
+    if (indexsave(index, indexFile, opts.analyzer) != 0) {
         fprintf(stderr, "Failed to save index to file: %s\n", indexFile);
-        happly(index, free_word_entry);
-        hclose(index);
+        index_delete(index);
         return EXIT_FAILURE;
     }
     
     printf("Index saved to %s\n", indexFile);
 
-    // 4. Clean up all allocated memory
-    happly(index, free_word_entry);
-    hclose(index);
+    // 4. The static rank of every page, from the links between them
+    save_pagerank(pageDir, indexFile);
+
+    // 5. Clean up all allocated memory
+    index_delete(index);
 
     return EXIT_SUCCESS;
 }
@@ -67,157 +172,408 @@ int main(int argc, char* argv[]) {
  * Parses and validates command-line arguments.
  * Exits the program if arguments are invalid.
  */
-static void parse_args(const int argc, char* argv[], char** pageDir, char** indexFile) {
-    if (argc != 3) {
-        fprintf(stderr, "Usage: %s pageDirectory indexFilename\n", argv[0]);
+static void parse_args(const int argc, char* argv[], char** pageDir, char** indexFile, index_options_t* opts) {
+    const char* usage = "Usage: %s pageDirectory indexFilename [-d] [-u] [--stem] [--stopwords wordsFile]"
+                        " [--snippets]\n";
+    if (argc < 3) {
+        fprintf(stderr, usage, argv[0]);
         exit(EXIT_FAILURE);
     }
 
     *pageDir = argv[1];
     *indexFile = argv[2];
+    opts->dedup = false;
+    opts->update = false;
+    opts->analyzer = ANALYZER_LOWER;
+    opts->analyzer_set = false;
+    opts->stopwordsFile = NULL;
+    opts->snippets = false;
+
+    // Optional flags follow the required arguments
+    for (int i = 3; i < argc; i++) {
+        if (strcmp(argv[i], "-d") == 0) {
+            opts->dedup = true;
+        } else if (strcmp(argv[i], "-u") == 0) {
+            opts->update = true;
+        } else if (strcmp(argv[i], "--stem") == 0) {
+            opts->analyzer = ANALYZER_PORTER2;
+            opts->analyzer_set = true;
+        } else if (strcmp(argv[i], "--stopwords") == 0 && i + 1 < argc) {
+            opts->stopwordsFile = argv[++i];
+        } else if (strcmp(argv[i], "--snippets") == 0) {
+            opts->snippets = true;
+        } else {
+            fprintf(stderr, usage, argv[0]);
+            fprintf(stderr, "Error: Unrecognized argument '%s'.\n", argv[i]);
+            exit(EXIT_FAILURE);
+        }
+    }
+
+    // Validate pageDirectory by checking that it has pages (not necessarily page 1)
+    int num_ids = 0;
+    int* ids = pagedir_list(*pageDir, &num_ids);
+    free(ids);
+    if (num_ids == 0) {
+        fprintf(stderr, "Error: pageDirectory '%s' is not a valid crawler directory (it has no pages).\n", *pageDir);
+        exit(EXIT_FAILURE);
+    }
 
-    // Validate pageDirectory by checking if the first page is readable
-    webpage_t* first_page = pageload(1, *pageDir);
-    if (first_page == NULL) {
-        fprintf(stderr, "Error: pageDirectory '%s' is not a valid crawler directory (or page 1 is missing).\n", *pageDir);
+    // Duplicates are only detected across a full pass over the pages
+    if (opts->update && opts->dedup) {
+        fprintf(stderr, "Error: -u cannot be combined with -d.\n");
         exit(EXIT_FAILURE);
     }
-    webpage_delete(first_page);
 }
 
 /**
- * Loops through all page files in pageDir, building the index.
+ * Opens indexFile's text file (see doctext.h) for the pages about to be
+ * indexed: afresh for --snippets, or to be updated if -u finds one.
+ * Returns NULL if the pages' text is not wanted, or on failure.
+ */
+static doctext_t* open_text(char* indexFile, const index_options_t* opts) {
+    char* path = malloc(strlen(indexFile) + strlen(DOCTEXT_SUFFIX) + 1);
+    sprintf(path, "%s%s", indexFile, DOCTEXT_SUFFIX);
+    doctext_t* text = NULL;
+    if (opts->snippets || (opts->update && access(path, F_OK) == 0)) {
+        text = doctext_create(path, opts->update);
+    }
+    free(path);
+    return text;
+}
+
+/**
+ * Indexes every page file in pageDir, in docID order (docIDs may have
+ * gaps, where a recrawl deleted pages), and saves each page's text in
+ * text, if it is not NULL.
  * Returns a pointer to the new index.
  */
-static hashtable_t* build_index(char* pageDir) {
-    hashtable_t* index = hopen(500); // Our main index
+static hashtable_t* build_index(char* pageDir, const index_options_t* opts, doctext_t* text) {
+    hashtable_t* index = index_new(); // Our main index
     if (index == NULL) {
         return NULL;
     }
+    if (opts->stopwordsFile != NULL && load_stopwords(index, opts->stopwordsFile, opts->analyzer) != 0) {
+        index_delete(index);
+        return NULL;
+    }
+    dupindex_t* dups = opts->dedup ? dupindex_new() : NULL;
+    anchor_target_t anchors = { index, opts->analyzer, hopen(URL_SLOTS), { NULL, 0 }, NULL, 0 };
+
+    // The pages there are, gaps and all, loaded a few at a time ahead of indexing
+    int num_ids;
+    int* ids = pagedir_list(pageDir, &num_ids);
+    pagedir_t* loader = (ids != NULL) ? pagedir_open(pageDir, ids, num_ids, LOAD_THREADS) : NULL;
+    if (loader == NULL) {
+        fprintf(stderr, "Error: Cannot list the pages of '%s'.\n", pageDir);
+        free(ids);
+        dupindex_delete(dups);
+        hclose(anchors.urls);
+        index_delete(index);
+        return NULL;
+    }
 
     int docID;
+    int num_pages = 0;
     webpage_t* page;
-
-    // --- MODIFIED LOOP LOGIC ---
-    // Loop from docID 1 upwards
-    for (docID = 1; ; docID++) {
-        page = pageload(docID, pageDir);
-
+    while (pagedir_next(loader, &docID, &page)) {
         if (page == NULL) {
-            // pageload failed. Was it a corrupt file or the end of the list?
-            char filepath[256];
-            sprintf(filepath, "%s/%d", pageDir, docID);
-            
-            // Check if the file exists using access()
-            if (access(filepath, F_OK) != 0) {
-                // File does not exist (access returns -1). This is the end.
-                break; // Exit the for loop
-            } else {
-                // File *does* exist, but pageload failed. It's corrupt.
-                fprintf(stderr, "Warning: Skipping corrupt file %s/%d\n", pageDir, docID);
-                // Continue to the next docID
+            fprintf(stderr, "Warning: Skipping corrupt file %s/%d\n", pageDir, docID);
+            continue;
+        }
+
+        if (dups != NULL) {
+            fingerprint_t fp = page_fingerprint(page);
+            int original = dupindex_find(dups, &fp, SIMHASH_MAXDIST);
+            if (original > 0) {
+                printf("Page %d duplicates page %d, skipped\n", docID, original);
+                url_put(anchors.urls, webpage_getURL(page), original); // links to it credit the original
+                webpage_delete(page);
                 continue;
             }
+            dupindex_add(dups, &fp, docID);
         }
-        
-        // --- If pageload Succeeded ---
+
         printf("Processing page %d\n", docID);
-        
-        int pos = 0;
-        char* word;
-        
-        while ((pos = webpage_getNextWord(page, pos, &word)) > 0) {
-            char* normalized = NormalizeWord(word);
-            
-            if (normalized != NULL) {
-                word_entry_t* found_word = hsearch(index, search_word, normalized, strlen(normalized));
-                
-                if (found_word == NULL) {
-                    // New word, not in hash table
-                    word_entry_t* new_word_entry = malloc(sizeof(word_entry_t));
-                    new_word_entry->word = malloc(strlen(normalized) + 1);
-                    strcpy(new_word_entry->word, normalized);
-                    new_word_entry->docs = qopen();
-                    
-                    doc_entry_t* new_doc_entry = malloc(sizeof(doc_entry_t));
-                    new_doc_entry->docID = docID;
-                    new_doc_entry->count = 1;
-                    
-                    qput(new_word_entry->docs, new_doc_entry);
-                    hput(index, new_word_entry, new_word_entry->word, strlen(new_word_entry->word));
-                } else {
-                    // Word is already in the hash table
-                    doc_entry_t* found_doc = qsearch(found_word->docs, search_doc, &docID);
-                    
-                    if (found_doc == NULL) {
-                        // Word's first time in this doc
-                        doc_entry_t* new_doc_entry = malloc(sizeof(doc_entry_t));
-                        new_doc_entry->docID = docID;
-                        new_doc_entry->count = 1;
-                        qput(found_word->docs, new_doc_entry);
-                    } else {
-                        // Word seen before in this doc, increment count
-                        found_doc->count++;
-                    }
-                }
+        index_addpage(index, page, docID, opts->analyzer);
+        if (text != NULL) {
+            doctext_put(text, docID, webpage_getHTML(page), webpage_getHTMLlen(page));
+        }
+        url_put(anchors.urls, webpage_getURL(page), docID);
+        docset_add(&anchors.live, docID);
+        webpage_delete(page);
+        num_pages++;
+    }
+    pagedir_close(loader);
+    free(ids);
+
+    printf("Indexed %d pages.\n", num_pages);
+    dupindex_delete(dups);
+
+    // Anchor text goes after the pages' own words, out of docID order
+    add_anchors(pageDir, &anchors);
+    index_sortpostings(index);
+    happly(anchors.urls, free_url_entry);
+    hclose(anchors.urls);
+    free(anchors.live.has);
+    return index;
+}
+
+/**
+ * Loads the index in indexFile and applies pageDir/.changes to it:
+ * each changed docID's old postings are removed, and added or modified
+ * pages are indexed again with the index's analyzer, which becomes
+ * opts->analyzer (unless opts set another one, which is an error).
+ * So are the pages the changed pages link to, or linked to, whose
+ * anchor text may have changed; then every link to a redone page
+ * credits it with its anchor text again.
+ * Words in opts->stopwordsFile, if any, join the index's stopwords first.
+ * The changed pages' text is updated in text, if it is not NULL.
+ * Returns a pointer to the updated index, or NULL on failure.
+ */
+static hashtable_t* update_index(char* pageDir, char* indexFile, index_options_t* opts, doctext_t* text) {
+    char filepath[256];
+    sprintf(filepath, "%s/.changes", pageDir);
+    FILE* fp = fopen(filepath, "r");
+    if (fp == NULL) {
+        fprintf(stderr, "Error: No change list in '%s'.\n", pageDir);
+        return NULL;
+    }
+
+    analyzer_t analyzer;
+    hashtable_t* index = indexload(indexFile, &analyzer);
+    if (index == NULL) {
+        fclose(fp);
+        return NULL;
+    }
+    if (opts->analyzer_set && opts->analyzer != analyzer) {
+        fprintf(stderr, "Error: '%s' was built with analyzer %s, not %s.\n", indexFile,
+                analyzer_name(analyzer), analyzer_name(opts->analyzer));
+        index_delete(index);
+        fclose(fp);
+        return NULL;
+    }
+    opts->analyzer = analyzer; // so the index is saved with it
+    if (opts->stopwordsFile != NULL && load_stopwords(index, opts->stopwordsFile, analyzer) != 0) {
+        index_delete(index);
+        fclose(fp);
+        return NULL;
+    }
+
+    char kind;
+    int docID;
+    int num_changes = 0;
+    docset_t changed = { NULL, 0 };
+    while (fscanf(fp, " %c %d", &kind, &docID) == 2) {
+        // Every kind starts from a clean slate, so re-applying is harmless
+        index_removepage(index, docID);
+        docset_add(&changed, docID);
+        num_changes++;
+        if (text != NULL) {
+            doctext_remove(text, docID);
+        }
+
+        if (kind == 'A' || kind == 'M') {
+            webpage_t* page = pagemap(docID, pageDir);
+            if (page == NULL) {
+                fprintf(stderr, "Warning: Skipping corrupt file %s/%d\n", pageDir, docID);
+                continue;
+            }
+            printf("Processing page %d\n", docID);
+            index_addpage(index, page, docID, analyzer);
+            if (text != NULL) {
+                doctext_put(text, docID, webpage_getHTML(page), webpage_getHTMLlen(page));
             }
-            free(word); // webpage_getNextWord allocates memory for word
+            webpage_delete(page);
         }
-        webpage_delete(page); // Free the page
-        // docID is incremented by the for loop
     }
-    
-    // docID will be one *past* the last valid file (e.g., 83)
-    printf("Indexed %d pages.\n", docID - 1);
+    fclose(fp);
+
+    // The recrawl left the URL of every page that is still there
+    anchor_target_t anchors = { index, analyzer, hopen(URL_SLOTS), { NULL, 0 }, NULL, 0 };
+    pagemeta_t* meta = pagemeta_open(pageDir, true);
+    if (meta != NULL) {
+        pagemeta_apply(meta, meta_helper, &anchors);
+        pagemeta_close(meta);
+    }
+
+    // Pages whose incoming links may have changed are redone as well
+    docset_t redo = { NULL, 0 };
+    redo_target_t redo_target = { anchors.urls, &changed, &redo };
+    linkfile_apply(pageDir, redo_helper, &redo_target);
+    int num_redone = 0;
+    for (docID = 1; docID < redo.len; docID++) {
+        if (!docset_has(&redo, docID) || docset_has(&changed, docID)) {
+            continue;
+        }
+        index_removepage(index, docID);
+        webpage_t* page = pagemap(docID, pageDir);
+        if (page != NULL) {
+            index_addpage(index, page, docID, analyzer);
+            webpage_delete(page);
+        }
+        docset_add(&changed, docID);
+        num_redone++;
+    }
+    anchors.only = &changed;
+    add_anchors(pageDir, &anchors);
+
+    // Re-added pages were appended at the end of their postings
+    index_sortpostings(index);
+    printf("Applied %d changes, redid %d linked pages.\n", num_changes, num_redone);
+    happly(anchors.urls, free_url_entry);
+    hclose(anchors.urls);
+    free(anchors.live.has);
+    free(changed.has);
+    free(redo.has);
     return index;
 }
 
+/**
+ * Makes every word listed in the file at path a stopword of index,
+ * normalized as index_addpage() normalizes words.
+ * Returns 0 on success, non-zero (after reporting why) on failure.
+ */
+static int load_stopwords(hashtable_t* index, const char* path, analyzer_t analyzer) {
+    FILE* fp = fopen(path, "r");
+    if (fp == NULL) {
+        fprintf(stderr, "Error: Cannot read stopwords file '%s'.\n", path);
+        return 1;
+    }
+
+    char word[256];
+    int num_stopwords = 0;
+    while (fscanf(fp, "%255s", word) == 1) {
+        if (word[0] == '#') {
+            fscanf(fp, "%*[^\n]"); // the rest of the line is a comment
+            continue;
+        }
+        int len = strlen(word);
+        utf8_fold_span(word, len);
+        if (analyzer_apply(analyzer, word, len) >= MIN_WORD_LEN) {
+            index_addstopword(index, word);
+            num_stopwords++;
+        }
+    }
+    fclose(fp);
+    printf("Keeping %d stopwords as bitmaps.\n", num_stopwords);
+    return 0;
+}
 
-// --- Helper Functions ---
+/**
+ * Credits the anchor text of every link in pageDir's link file (the
+ * last one recorded for each page) to the page it leads to, under
+ * target's rules.
+ */
+static void add_anchors(char* pageDir, anchor_target_t* target) {
+    int num_links = linkfile_apply(pageDir, anchor_helper, target);
+    if (num_links >= 0) {
+        printf("Credited the anchor text of %d links.\n", target->num_anchors);
+    }
+}
 
 /**
- * Normalizes a word: converts to lowercase, skips if non-alphabetic
- * or length < 3.
- * Returns the word if valid, NULL otherwise.
+ * Computes the PageRank of the pages of pageDir, if the crawler
+ * recorded their links, and saves it as indexFile.pagerank.
  */
-static char* NormalizeWord(char* word) {
-    if (word == NULL || strlen(word) < 3) {
-        return NULL;
+static void save_pagerank(char* pageDir, char* indexFile) {
+    linkgraph_t* graph = linkgraph_load(pageDir);
+    if (graph == NULL) {
+        return;
+    }
+    int iterations;
+    double* ranks = linkgraph_pagerank(graph, DAMPING, RANK_TOLERANCE, MAX_RANK_ITERS, 0, &iterations);
+    char* path = malloc(strlen(indexFile) + strlen(LINKGRAPH_RANKS_SUFFIX) + 1);
+    sprintf(path, "%s%s", indexFile, LINKGRAPH_RANKS_SUFFIX);
+    if (ranks != NULL && linkgraph_saveranks(path, graph, ranks) == 0) {
+        printf("PageRank of %d pages (%u links), %d iterations, saved to %s\n",
+               graph->num_pages, graph->num_links, iterations, path);
+    } else {
+        fprintf(stderr, "Warning: Failed to save PageRank to %s\n", path);
+    }
+    free(path);
+    free(ranks);
+    linkgraph_delete(graph);
+}
+
+// Indexes the anchor text of one link, if it counts (for linkfile_apply)
+static void anchor_helper(int source, const char* url, const char* text, int text_len, bool latest, void* arg) {
+    anchor_target_t* target = (anchor_target_t*)arg;
+    if (!latest || !docset_has(&target->live, source)) {
+        return;
     }
-    for (int i = 0; word[i] != '\0'; i++) {
-        if (!isalpha(word[i])) {
-            return NULL; // Contains non-alpha char
+    int docID = url_lookup(target->urls, url);
+    if (docID == 0 || docID == source || (target->only != NULL && !docset_has(target->only, docID))) {
+        return;
+    }
+    index_addanchor(target->index, text, text_len, docID, target->analyzer);
+    target->num_anchors++;
+}
+
+// Notes the page a changed page links to, or linked to (for linkfile_apply)
+static void redo_helper(int source, const char* url, const char* text, int text_len, bool latest, void* arg) {
+    redo_target_t* target = (redo_target_t*)arg;
+    if (docset_has(target->changed, source)) {
+        int docID = url_lookup(target->urls, url);
+        if (docID > 0) {
+            docset_add(target->redo, docID);
         }
-        word[i] = tolower(word[i]);
     }
-    return word;
 }
 
-// Search function for hash table (compares word)
-static bool search_word(void* elementp, const void* keyp) {
-    word_entry_t* entry = (word_entry_t*)elementp;
-    return strcmp(entry->word, (const char*)keyp) == 0;
+// Files the URL of one saved page, which is live (for pagemeta_apply)
+static void meta_helper(page_meta_t* m, void* arg) {
+    anchor_target_t* target = (anchor_target_t*)arg;
+    url_put(target->urls, m->url, m->docID);
+    docset_add(&target->live, m->docID);
+}
+
+/**
+ * Files url, normalized as the crawler normalizes links, under docID
+ * (unless it is already filed).
+ */
+static void url_put(hashtable_t* urls, const char* url, int docID) {
+    char* copy = malloc(strlen(url) + 1);
+    strcpy(copy, url);
+    NormalizeURL(copy); // the seed URL is saved as it was given
+    if (hsearch(urls, search_url, copy, strlen(copy)) != NULL) {
+        free(copy);
+        return;
+    }
+    url_entry_t* entry = malloc(sizeof(url_entry_t));
+    entry->url = copy;
+    entry->docID = docID;
+    hput(urls, entry, copy, strlen(copy));
+}
+
+// The docID filed under url, or 0 if there is none
+static int url_lookup(hashtable_t* urls, const char* url) {
+    url_entry_t* entry = hsearch(urls, search_url, url, strlen(url));
+    return (entry != NULL) ? entry->docID : 0;
 }
 
-// Search function for inner queue (compares docID)
-static bool search_doc(void* elementp, const void* keyp) {
-    doc_entry_t* entry = (doc_entry_t*)elementp;
-    return entry->docID == *(int*)keyp;
+// Search function for the URL table (compares URL)
+static bool search_url(void* elementp, const void* keyp) {
+    return strcmp(((url_entry_t*)elementp)->url, (const char*)keyp) == 0;
 }
 
-// Frees a doc_entry_t (for qapply)
-static void free_doc_entry(void* data) {
-    doc_entry_t* doc = (doc_entry_t*)data;
-    if (doc) free(doc);
+// Frees a url_entry_t (for happly)
+static void free_url_entry(void* data) {
+    url_entry_t* entry = (url_entry_t*)data;
+    free(entry->url);
+    free(entry);
 }
 
-// Frees a word_entry_t (for happly)
-static void free_word_entry(void* data) {
-    word_entry_t* word = (word_entry_t*)data;
-    if (word) {
-        free(word->word); // Free the word string
-        qapply(word->docs, free_doc_entry); // Free all doc entries
-        qclose(word->docs); // Free the queue itself
-        free(word); // Free the word entry struct
+// Adds docID to the set, growing it as needed
+static void docset_add(docset_t* set, int docID) {
+    if (docID >= set->len) {
+        int len = (2 * set->len > docID + 1) ? 2 * set->len : docID + 1;
+        set->has = realloc(set->has, len);
+        memset(set->has + set->len, 0, len - set->len);
+        set->len = len;
     }
+    set->has[docID] = 1;
+}
+
+static bool docset_has(const docset_t* set, int docID) {
+    return docID >= 0 && docID < set->len && set->has[docID];
 }
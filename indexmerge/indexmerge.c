@@ -0,0 +1,617 @@
+/*
+ * indexmerge.c - merges independently built index files into one
+ *
+ * Author: Insecticide
+ * Date: 10-17-2026
+ *
+ * Usage: ./indexmerge outputIndex [-o offset | -m mapFile] inputIndex
+ *                     [[-o offset | -m mapFile] inputIndex ...]
+ *
+ * Each input's docIDs are renumbered before they are merged: -o adds
+ * offset to every docID of the input that follows it; -m maps them by
+ * mapFile, whitespace-separated pairs "oldID newID", and drops the
+ * postings of the docIDs it does not list. Without either, the input's
+ * docIDs are kept. Once renumbered, no two pages of the inputs may
+ * have the same docID: before anything is written, one pass over each
+ * input collects the docIDs it has (in postings or stopword bitmaps),
+ * and a docID of two inputs, or two of one input's pages mapped to one
+ * docID, fails the merge. The docIDs of the merged index name pages of
+ * the one page directory it is queried with, so the crawls' pages must
+ * be copied there under their new docIDs.
+ *
+ * The inputs are read as streams, a word at a time, which needs their
+ * words in byte order (as indexsave() writes them; see indexio.h): a
+ * k-way merge takes the least word of all inputs next, so only one word
+ * per input is in memory at a time. All inputs must have been built with
+ * the same analyzer. A word that is a stopword of any input is one of
+ * the merged index (see index_addstopword()).
+ *
+ * The pages' text and PageRank (indexFile.text and .pagerank) are not
+ * merged.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "queue.h"
+#include "index.h"    // For word_entry_t and doc_entry_t
+#include "indexio.h"  // For the index reader and writer
+#include "analyzer.h"
+
+#define MAX_WORD_LEN 256 // as indexload() reads them
+
+// --- Local Structs ---
+// One input index, and the word of it next in line
+typedef struct input {
+    const char* name;
+    indexreader_t* reader;
+    analyzer_t analyzer;
+    word_entry_t* word;     // NULL once the input is exhausted
+    char last[MAX_WORD_LEN]; // the word before, to check the order
+    int offset;             // added to each docID, unless there is a map
+    int* map;               // if non-NULL, the new docID of each old one (0: dropped)
+    int map_len;
+} input_t;
+
+// A page of an input, by its docID in the merged index
+typedef struct owned {
+    int docID;
+    int input; // index of the input it is a page of
+} owned_t;
+
+// A min-heap of inputs, by their next words
+typedef struct heap {
+    input_t** items;
+    int count;
+} heap_t;
+
+// The merged entry of one word, as it is gathered from the inputs
+typedef struct merged {
+    doc_entry_t** docs;
+    int num_docs;
+    int cap;
+    unsigned char* stopbits; // non-NULL once any input has the word as a stopword
+    int stopbits_len;
+} merged_t;
+
+// --- Local Function Prototypes ---
+static input_t* parse_args(const int argc, char* argv[], char** outputFile, int* num_inputs);
+static int* load_map(const char* path, int* map_len);
+static int check_docids(input_t* inputs, int num_inputs);
+static int collect_docids(const input_t* in, int input, owned_t** owned, int* num_owned);
+static int merge(input_t* inputs, int num_inputs, indexwriter_t* w);
+static bool advance(input_t* in);
+static int map_docid(const input_t* in, int docID);
+static int gather(merged_t* m, input_t* in);
+static void write_word(merged_t* m, const char* word, indexwriter_t* w);
+static bool set_bit(unsigned char** bits, int* len, int docID);
+static void heap_push(heap_t* h, input_t* in);
+static input_t* heap_pop(heap_t* h);
+static bool heap_less(const heap_t* h, int a, int b);
+static int compare_docs(const void* a, const void* b);
+static int compare_owned(const void* a, const void* b);
+
+// --- Main Function ---
+
+int main(int argc, char* argv[]) {
+    char* outputFile;
+    int num_inputs;
+
+    // 1. Validate command-line arguments and load the docID maps
+    input_t* inputs = parse_args(argc, argv, &outputFile, &num_inputs);
+
+    // 2. Open every input; they must share an analyzer
+    int status = 0;
+    for (int i = 0; i < num_inputs && status == 0; i++) {
+        inputs[i].reader = indexreader_open(inputs[i].name, &inputs[i].analyzer);
+        if (inputs[i].reader == NULL) {
+            status = 1;
+        } else if (inputs[i].analyzer != inputs[0].analyzer) {
+            fprintf(stderr, "Error: '%s' was built with analyzer %s, but '%s' with %s.\n",
+                    inputs[i].name, analyzer_name(inputs[i].analyzer),
+                    inputs[0].name, analyzer_name(inputs[0].analyzer));
+            status = 1;
+        }
+    }
+
+    // 3. Their pages must not share docIDs once renumbered
+    if (status == 0) {
+        status = check_docids(inputs, num_inputs);
+    }
+
+    // 4. Merge them into the output
+    if (status == 0) {
+        indexwriter_t* w = indexwriter_open(outputFile, inputs[0].analyzer);
+        if (w == NULL) {
+            status = 1;
+        } else {
+            status = merge(inputs, num_inputs, w);
+            if (indexwriter_close(w) != 0) {
+                status = 1;
+            }
+            if (status != 0) {
+                remove(outputFile); // don't leave half an index
+            }
+        }
+    }
+    if (status == 0) {
+        printf("Merged %d indexes into %s\n", num_inputs, outputFile);
+    }
+
+    // 5. Clean up
+    for (int i = 0; i < num_inputs; i++) {
+        if (inputs[i].word != NULL) {
+            index_freeword(inputs[i].word);
+        }
+        if (inputs[i].reader != NULL) {
+            indexreader_close(inputs[i].reader);
+        }
+        free(inputs[i].map);
+    }
+    free(inputs);
+
+    return status == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+/**
+ * Parses and validates command-line arguments, loading any docID maps.
+ * Exits the program if arguments are invalid.
+ * Returns the inputs, in the order given.
+ */
+static input_t* parse_args(const int argc, char* argv[], char** outputFile, int* num_inputs) {
+    const char* usage = "Usage: %s outputIndex [-o offset | -m mapFile] inputIndex"
+                        " [[-o offset | -m mapFile] inputIndex ...]\n";
+    if (argc < 3) {
+        fprintf(stderr, usage, argv[0]);
+        exit(EXIT_FAILURE);
+    }
+
+    *outputFile = argv[1];
+    input_t* inputs = calloc(argc, sizeof(input_t));
+    if (inputs == NULL) {
+        exit(EXIT_FAILURE);
+    }
+    *num_inputs = 0;
+
+    // Each input follows the option that renumbers it, if any
+    int offset = 0;
+    int* map = NULL;
+    int map_len = 0;
+    bool renumbered = false;
+    for (int i = 2; i < argc; i++) {
+        char* end;
+        if (strcmp(argv[i], "-o") == 0 && i + 1 < argc && !renumbered) {
+            long value = strtol(argv[++i], &end, 10);
+            if (*end != '\0' || end == argv[i] || value < 0 || value > 1000000000) {
+                fprintf(stderr, "Error: Offset '%s' is not a docID offset.\n", argv[i]);
+                exit(EXIT_FAILURE);
+            }
+            offset = (int)value;
+            renumbered = true;
+        } else if (strcmp(argv[i], "-m") == 0 && i + 1 < argc && !renumbered) {
+            map = load_map(argv[++i], &map_len);
+            if (map == NULL) {
+                exit(EXIT_FAILURE);
+            }
+            renumbered = true;
+        } else if (argv[i][0] == '-') {
+            fprintf(stderr, usage, argv[0]);
+            fprintf(stderr, "Error: Unrecognized argument '%s'.\n", argv[i]);
+            exit(EXIT_FAILURE);
+        } else {
+            // Reading an input while writing over it would lose it
+            if (strcmp(argv[i], *outputFile) == 0) {
+                fprintf(stderr, "Error: '%s' is both an input and the output.\n", argv[i]);
+                exit(EXIT_FAILURE);
+            }
+            input_t* in = &inputs[(*num_inputs)++];
+            in->name = argv[i];
+            in->offset = offset;
+            in->map = map;
+            in->map_len = map_len;
+            offset = 0;
+            map = NULL;
+            map_len = 0;
+            renumbered = false;
+        }
+    }
+    if (renumbered || *num_inputs == 0) {
+        fprintf(stderr, usage, argv[0]);
+        fprintf(stderr, "Error: %s.\n", renumbered ? "An -o or -m has no input after it" : "No input index");
+        exit(EXIT_FAILURE);
+    }
+    return inputs;
+}
+
+/**
+ * Reads a docID map: pairs "oldID newID", whitespace separated.
+ * Returns the new docID of each old one (0 for those not listed) and
+ * sets map_len to its length, or returns NULL (having said why).
+ */
+static int* load_map(const char* path, int* map_len) {
+    FILE* fp = fopen(path, "r");
+    if (fp == NULL) {
+        fprintf(stderr, "Error: Cannot read docID map '%s'.\n", path);
+        return NULL;
+    }
+    int* map = NULL;
+    int len = 0;
+    int old_id, new_id, n;
+    while ((n = fscanf(fp, "%d %d", &old_id, &new_id)) == 2) {
+        if (old_id <= 0 || new_id <= 0) {
+            break;
+        }
+        if (old_id >= len) {
+            int grown_len = (2 * len > old_id + 1) ? 2 * len : old_id + 1;
+            int* grown = realloc(map, grown_len * sizeof(int));
+            if (grown == NULL) {
+                break;
+            }
+            memset(grown + len, 0, (grown_len - len) * sizeof(int));
+            map = grown;
+            len = grown_len;
+        }
+        map[old_id] = new_id;
+    }
+    fclose(fp);
+    if (n != EOF) {
+        fprintf(stderr, "Error: docID map '%s' is not pairs of docIDs.\n", path);
+        free(map);
+        return NULL;
+    }
+    if (map == NULL) {
+        map = calloc(1, sizeof(int)); // maps nothing: every posting is dropped
+        len = 1;
+    }
+    *map_len = len;
+    return map;
+}
+
+/**
+ * Collects the pages of every input under their docIDs in the merged
+ * index, and checks that no docID is had by two of them.
+ * Returns 0 if none is, non-zero (having said why) otherwise.
+ */
+static int check_docids(input_t* inputs, int num_inputs) {
+    owned_t* owned = NULL;
+    int num_owned = 0;
+    int status = 0;
+    for (int i = 0; i < num_inputs && status == 0; i++) {
+        status = collect_docids(&inputs[i], i, &owned, &num_owned);
+    }
+    if (status == 0 && num_owned > 1) {
+        qsort(owned, num_owned, sizeof(owned_t), compare_owned);
+    }
+    for (int i = 1; i < num_owned && status == 0; i++) {
+        if (owned[i].docID != owned[i - 1].docID) {
+            continue;
+        }
+        const input_t* a = &inputs[owned[i - 1].input];
+        const input_t* b = &inputs[owned[i].input];
+        if (a == b) {
+            fprintf(stderr, "Error: The docID map of '%s' gives two of its pages docID %d.\n",
+                    a->name, owned[i].docID);
+        } else {
+            fprintf(stderr, "Error: '%s' and '%s' both have docID %d; renumber them apart with -o or -m.\n",
+                    a->name, b->name, owned[i].docID);
+        }
+        status = 1;
+    }
+    free(owned);
+    return status;
+}
+
+/**
+ * Reads the input through once, noting each docID it has a posting or
+ * stopword bit on, and appends those it keeps, renumbered, to *owned.
+ * Returns 0 on success, non-zero (having said why) on failure.
+ */
+static int collect_docids(const input_t* in, int input, owned_t** owned, int* num_owned) {
+    analyzer_t analyzer;
+    indexreader_t* r = indexreader_open(in->name, &analyzer);
+    if (r == NULL) {
+        return 1;
+    }
+
+    // Its pages, by their own docIDs
+    unsigned char* pages = NULL;
+    int pages_len = 0;
+    bool ok = true;
+    word_entry_t* word;
+    while ((word = indexreader_next(r)) != NULL) {
+        for (int byte = 0; byte < word->stopbits_len && ok; byte++) {
+            for (int bit = 0; bit < 8 && ok; bit++) {
+                if (word->stopbits[byte] & (1 << bit)) {
+                    ok = set_bit(&pages, &pages_len, 8 * byte + bit);
+                }
+            }
+        }
+        doc_entry_t* doc;
+        while ((doc = qget(word->docs)) != NULL) {
+            ok = ok && (doc->docID <= 0 || set_bit(&pages, &pages_len, doc->docID));
+            free(doc);
+        }
+        index_freeword(word);
+    }
+    indexreader_close(r);
+
+    // The pages it keeps, by their new docIDs
+    int count = 0;
+    for (int byte = 0; byte < pages_len; byte++) {
+        count += __builtin_popcount(pages[byte]);
+    }
+    owned_t* grown = ok ? realloc(*owned, (*num_owned + count + 1) * sizeof(owned_t)) : NULL; // never 0 bytes
+    if (grown == NULL) {
+        fprintf(stderr, "Error: indexmerge ran out of memory reading '%s'.\n", in->name);
+        free(pages);
+        return 1;
+    }
+    *owned = grown;
+    for (int docID = 1; docID < 8 * pages_len; docID++) {
+        int new_id = (pages[docID / 8] & (1 << (docID % 8))) ? map_docid(in, docID) : 0;
+        if (new_id > 0) {
+            (*owned)[*num_owned].docID = new_id;
+            (*owned)[*num_owned].input = input;
+            (*num_owned)++;
+        }
+    }
+    free(pages);
+    return 0;
+}
+
+/**
+ * The k-way merge: repeatedly takes the least next word of all inputs,
+ * gathers its postings from every input that has it, and writes them.
+ * Returns 0 on success, non-zero (having said why) on failure.
+ */
+static int merge(input_t* inputs, int num_inputs, indexwriter_t* w) {
+    heap_t heap = { malloc(num_inputs * sizeof(input_t*)), 0 };
+    merged_t m = { NULL, 0, 0, NULL, 0 };
+    if (heap.items == NULL) {
+        return 1;
+    }
+
+    int status = 0;
+    for (int i = 0; i < num_inputs && status == 0; i++) {
+        if (advance(&inputs[i])) {
+            heap_push(&heap, &inputs[i]);
+        } else if (inputs[i].word != NULL) {
+            status = 1;
+        }
+    }
+
+    char word[MAX_WORD_LEN];
+    while (status == 0 && heap.count > 0) {
+        input_t* in = heap_pop(&heap);
+        strcpy(word, in->word->word);
+
+        // Every input whose next word is this one is at the top of the heap
+        while (status == 0 && in != NULL) {
+            status = gather(&m, in);
+            if (status == 0 && advance(in)) {
+                heap_push(&heap, in);
+            } else if (in->word != NULL) {
+                status = 1; // out of order
+            }
+            in = (heap.count > 0 && strcmp(heap.items[0]->word->word, word) == 0) ? heap_pop(&heap) : NULL;
+        }
+        if (status == 0) {
+            write_word(&m, word, w);
+        }
+    }
+
+    for (int i = 0; i < m.num_docs; i++) {
+        free(m.docs[i]);
+    }
+    free(m.docs);
+    free(m.stopbits);
+    free(heap.items);
+    return status;
+}
+
+/**
+ * Moves an input on to its next word, freeing the one before.
+ * Returns true if it has one, which is in order; false at its end (word
+ * NULL), or (having said why) if the word is out of order (word kept).
+ */
+static bool advance(input_t* in) {
+    if (in->word != NULL) {
+        snprintf(in->last, sizeof(in->last), "%s", in->word->word);
+        index_freeword(in->word);
+    }
+    in->word = indexreader_next(in->reader);
+    if (in->word == NULL) {
+        return false;
+    }
+    if (in->last[0] != '\0' && strcmp(in->word->word, in->last) <= 0) {
+        fprintf(stderr, "Error: '%s' is not sorted by word ('%s' after '%s'); save it again with"
+                " the current indexer.\n", in->name, in->word->word, in->last);
+        return false;
+    }
+    return true;
+}
+
+/**
+ * The docID a posting of page docID of the input gets in the merged
+ * index, or 0 if it is dropped.
+ */
+static int map_docid(const input_t* in, int docID) {
+    if (docID <= 0) {
+        return 0;
+    }
+    if (in->map != NULL) {
+        return (docID < in->map_len) ? in->map[docID] : 0;
+    }
+    return docID + in->offset;
+}
+
+/**
+ * Adds the renumbered postings (or bits) of the input's word to m.
+ * Returns 0 on success, non-zero (having said why) on failure.
+ */
+static int gather(merged_t* m, input_t* in) {
+    word_entry_t* word = in->word;
+
+    // A stopword's bitmap: the bits of its pages
+    bool ok = true;
+    if (word->stopbits != NULL) {
+        if (m->stopbits == NULL) {
+            m->stopbits = calloc(1, 1);
+            ok = (m->stopbits != NULL);
+            m->stopbits_len = ok ? 1 : 0;
+            for (int i = 0; i < m->num_docs; i++) {
+                ok = ok && set_bit(&m->stopbits, &m->stopbits_len, m->docs[i]->docID);
+                free(m->docs[i]);
+            }
+            m->num_docs = 0;
+        }
+        for (int byte = 0; byte < word->stopbits_len && ok; byte++) {
+            for (int bit = 0; bit < 8 && ok; bit++) {
+                int docID = (word->stopbits[byte] & (1 << bit)) ? map_docid(in, 8 * byte + bit) : 0;
+                if (docID > 0) {
+                    ok = set_bit(&m->stopbits, &m->stopbits_len, docID);
+                }
+            }
+        }
+        if (!ok) {
+            fprintf(stderr, "Error: indexmerge ran out of memory merging '%s'.\n", word->word);
+        }
+        return ok ? 0 : 1;
+    }
+
+    // Postings: kept, unless the word is a stopword of another input
+    doc_entry_t* doc;
+    while ((doc = qget(word->docs)) != NULL) {
+        doc->docID = map_docid(in, doc->docID);
+        if (doc->docID <= 0) {
+            free(doc);
+        } else if (m->stopbits != NULL) {
+            ok = set_bit(&m->stopbits, &m->stopbits_len, doc->docID);
+            free(doc);
+            if (!ok) {
+                fprintf(stderr, "Error: indexmerge ran out of memory merging '%s'.\n", word->word);
+                return 1;
+            }
+        } else {
+            if (m->num_docs == m->cap) {
+                int cap = (m->cap == 0) ? 64 : 2 * m->cap;
+                doc_entry_t** grown = realloc(m->docs, cap * sizeof(doc_entry_t*));
+                if (grown == NULL) {
+                    fprintf(stderr, "Error: indexmerge ran out of memory merging '%s'.\n", word->word);
+                    free(doc);
+                    return 1;
+                }
+                m->docs = grown;
+                m->cap = cap;
+            }
+            m->docs[m->num_docs++] = doc;
+        }
+    }
+    return 0;
+}
+
+/**
+ * Writes the word's merged postings (in docID order; check_docids()
+ * saw to it that no two share one) or bitmap, and empties m for the
+ * next word.
+ */
+static void write_word(merged_t* m, const char* word, indexwriter_t* w) {
+    word_entry_t entry = { (char*)word, qopen(), m->stopbits, m->stopbits_len };
+
+    if (m->num_docs > 1) {
+        qsort(m->docs, m->num_docs, sizeof(doc_entry_t*), compare_docs);
+    }
+    for (int i = 0; i < m->num_docs; i++) {
+        qput(entry.docs, m->docs[i]);
+    }
+    indexwriter_put(w, &entry);
+
+    doc_entry_t* doc;
+    while ((doc = qget(entry.docs)) != NULL) {
+        free(doc);
+    }
+    qclose(entry.docs);
+    free(m->stopbits);
+    m->stopbits = NULL;
+    m->stopbits_len = 0;
+    m->num_docs = 0;
+}
+
+/*
+ * Sets docID's bit in the bitmap *bits of *len bytes, growing it as
+ * needed. Returns false, leaving the bitmap as it was, if it cannot.
+ */
+static bool set_bit(unsigned char** bits, int* len, int docID) {
+    int byte = docID / 8;
+    if (byte >= *len) {
+        int grown_len = 2 * *len > byte + 1 ? 2 * *len : byte + 1;
+        unsigned char* grown = realloc(*bits, grown_len);
+        if (grown == NULL) {
+            return false;
+        }
+        memset(grown + *len, 0, grown_len - *len);
+        *bits = grown;
+        *len = grown_len;
+    }
+    (*bits)[byte] |= 1 << (docID % 8);
+    return true;
+}
+
+// Adds an input to the heap
+static void heap_push(heap_t* h, input_t* in) {
+    int i = h->count++;
+    h->items[i] = in;
+    while (i > 0 && heap_less(h, i, (i - 1) / 2)) {
+        input_t* parent = h->items[(i - 1) / 2];
+        h->items[(i - 1) / 2] = h->items[i];
+        h->items[i] = parent;
+        i = (i - 1) / 2;
+    }
+}
+
+// Removes and returns the input with the least next word
+static input_t* heap_pop(heap_t* h) {
+    input_t* top = h->items[0];
+    h->items[0] = h->items[--h->count];
+    int i = 0;
+    while (true) {
+        int least = i;
+        int left = 2 * i + 1, right = 2 * i + 2;
+        if (left < h->count && heap_less(h, left, least)) {
+            least = left;
+        }
+        if (right < h->count && heap_less(h, right, least)) {
+            least = right;
+        }
+        if (least == i) {
+            break;
+        }
+        input_t* swap = h->items[least];
+        h->items[least] = h->items[i];
+        h->items[i] = swap;
+        i = least;
+    }
+    return top;
+}
+
+// Whether heap item a's next word comes before item b's
+static bool heap_less(const heap_t* h, int a, int b) {
+    return strcmp(h->items[a]->word->word, h->items[b]->word->word) < 0;
+}
+
+// qsort comparator: increasing docID
+static int compare_docs(const void* a, const void* b) {
+    const doc_entry_t* doc_a = *(doc_entry_t* const*)a;
+    const doc_entry_t* doc_b = *(doc_entry_t* const*)b;
+    return doc_a->docID - doc_b->docID;
+}
+
+// qsort comparator: increasing docID, then input
+static int compare_owned(const void* a, const void* b) {
+    const owned_t* own_a = (const owned_t*)a;
+    const owned_t* own_b = (const owned_t*)b;
+    if (own_a->docID != own_b->docID) {
+        return own_a->docID - own_b->docID;
+    }
+    return own_a->input - own_b->input;
+}
@@ -6,28 +6,59 @@
  *
  * Description: Implements the querier component of the Tiny Search Engine.
  * Reads queries from stdin, validates and normalizes them,
- * searches the index, and ranks the results based on AND/OR logic
- * with Google-style output.
+ * searches the index, and ranks the results with Google-style output.
+ * Queries may use "and", "or", "not", parentheses, quoted phrases and
+ * fuzzy words ("word~2"); they are compiled into a tree of postings
+ * iterators (see querytree.h) that streams the matching pages. A query
+ * that matches nothing gets a "did you mean" with its misspelled words
+ * replaced by the closest terms of the index (see spell.h). Query
+ * words go through the same analyzer as the index's words (see
+ * analyzer.h), as the index file records it. A query word in a page's
+ * title, meta description or the anchor text of links to it adds a
+ * boost to its rank (the index records the fields each word was found
+ * in). If the indexer left the pages' PageRank scores next to the index
+ * (indexFile.pagerank, see linkgraph.h), every match's rank also gains
+ * the PageRank boost times log2(1 + its score), rounded, so that a page
+ * with many links to it breaks ties and small differences. If the
+ * indexer kept the pages' text (indexFile.text, see doctext.h), each
+ * result shows the stretch of its text with the most query words in
+ * place of its description, the words highlighted **like this**.
  *
- * Usage: ./query <pageDirectory> <indexFile> [-q]
+ * Usage: ./query <pageDirectory> <indexFile> [-q] [--title-boost N] [--description-boost N]
+ *                [--anchor-boost N] [--pagerank-boost N]
  */
 
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
-#include <ctype.h>   // For isalpha, tolower
 #include <stdbool.h> // For bool
+#include <math.h>    // For log2() and lround()
 
 // TSE Utility Libraries
 #include "index.h"    // For index data structures
 #include "indexio.h"  // For indexload()
-#include "pageio.h"   // For pageload()
+#include "analyzer.h" // For analyzer_apply()
+#include "utf8.h"     // For utf8_letter(), utf8_fold_span()
+#include "querytree.h" // For querytree_compile()
+#include "spell.h"    // For spell_suggest()
+#include "pageio.h"   // For pagemap()
+#include "pagedir.h"  // For pagedir_list()
 #include "webpage.h"  // For webpage_delete()
+#include "htmllex.h"  // For htmllex_run()
+#include "linkgraph.h" // For linkgraph_loadranks()
+#include "doctext.h"  // For doctext_snippet()
 #include "hash.h"
 #include "queue.h"
 
-#define MAX_WORDS 100 // Max words/operators in a query
+#define MAX_WORDS 100 // Max words/operators/marks in a query
+#define QUERY_MARKS "()\"~" // Characters that are tokens of their own
 #define MAX_LINE 512  // Max query line length
+#define MAX_TITLE 200 // Max title characters printed
+#define MAX_DESC 128  // Max description characters printed
+#define TITLE_BOOST 5       // Default rank added for a word in the title
+#define DESCRIPTION_BOOST 2 // ...and in the meta description
+#define ANCHOR_BOOST 3      // ...and in the text of links to the page
+#define PAGERANK_BOOST 2    // Default rank added per doubling of 1 + a page's PageRank score
 
 // --- Local Structs ---
 typedef struct {
@@ -35,32 +66,55 @@ typedef struct {
     int rank;
 } query_result_t;
 
+// Query-independent scores of the pages, from the link graph
+typedef struct {
+    double* scores; // by docID, or NULL if the index has none
+    int size;
+    int boost;
+} static_rank_t;
+
+// What the snippets of a query's results are made from
+typedef struct {
+    doctext_t* text;   // the pages' text, or NULL if the index has none
+    char* buf;         // room for one page's text
+    const char* terms[MAX_WORDS]; // the query's words
+    int num_terms;
+    analyzer_t analyzer;
+} snippets_t;
+
+// Title and description of a result page, as found by the lexer
+typedef struct {
+    char* title;
+    char* desc;
+} page_summary_t;
+
 // --- Globals for iterator helpers ---
-static queue_t* g_results_queue;
 static int g_count;
 static query_result_t** g_results_array;
 
 // --- Local function prototypes ---
-static void parse_args(const int argc, char* argv[], char** pageDir, char** indexFile, bool* quiet_mode);
-static int validate_and_parse_query(char* line, char* tokens[]);
-static bool validate_word(char* word);
-static void process_query(hashtable_t* index, char* pageDirectory, char* tokens[], int num_tokens);
-static queue_t* compute_and_intersection(hashtable_t* index, char* tokens[], int start, int end);
-static void merge_or_results(queue_t* final_results, queue_t* and_results);
-static void print_results(queue_t* final_results, char* pageDirectory, bool quiet_mode);
+static void parse_args(const int argc, char* argv[], char** pageDir, char** indexFile, bool* quiet_mode,
+                       field_boosts_t* boosts, static_rank_t* statics);
+static bool parse_boost(const char* arg, int* boost);
+static int validate_and_parse_query(char* line, char* tokens[], analyzer_t analyzer);
+static char* lex_mark(char** p);
+static bool validate_word(char* word, analyzer_t analyzer);
+static int process_query(querytree_t* query, char* pageDirectory, const static_rank_t* statics,
+                         const snippets_t* snippets);
+static void snippet_terms(char* tokens[], int num_tokens, snippets_t* snippets);
+static void suggest_query(char* tokens[], int num_tokens, spell_t* spell);
+static void print_results(queue_t* final_results, char* pageDirectory, bool quiet_mode, const snippets_t* snippets);
 
 // --- Iterator & Helper Prototypes ---
-static void init_results_helper(void* elementp);
 static void count_helper(void* elementp);
 static void fill_array_helper(void* elementp);
 static void free_result_helper(void* elementp);
 static int compare_results(const void* a, const void* b);
-static char* extract_from_tag(const char* html, const char* start_tag, const char* end_tag, int max_len);
-static bool search_docid_queue(void* elementp, const void* keyp);
+static void title_helper(const char* title, int len, void* arg);
+static void desc_helper(const char* desc, int len, void* arg);
+static char* copy_text(const char* text, int len, int max_len);
 
 // --- Data structure helper prototypes ---
-static bool search_word(void* elementp, const void* keyp);
-static bool search_doc(void* elementp, const void* keyp);
 static void free_doc_entry(void* data);
 static void free_word_entry(void* data);
 
@@ -72,14 +126,28 @@ int main(int argc, char* argv[]) {
     char* pageDirectory;
     char* indexFile;
     bool quiet_mode = false;
+    field_boosts_t boosts;
+    static_rank_t statics;
 
-    parse_args(argc, argv, &pageDirectory, &indexFile, &quiet_mode);
+    parse_args(argc, argv, &pageDirectory, &indexFile, &quiet_mode, &boosts, &statics);
 
-    hashtable_t* index = indexload(indexFile);
+    analyzer_t analyzer;
+    hashtable_t* index = indexload(indexFile, &analyzer);
     if (index == NULL) {
         fprintf(stderr, "Error: Failed to load index from '%s'.\n", indexFile);
         return EXIT_FAILURE;
     }
+    spell_t* spell = spell_new(index);
+    char* ranks_path = malloc(strlen(indexFile) + strlen(LINKGRAPH_RANKS_SUFFIX) + 1);
+    sprintf(ranks_path, "%s%s", indexFile, LINKGRAPH_RANKS_SUFFIX);
+    statics.scores = linkgraph_loadranks(ranks_path, &statics.size);
+    free(ranks_path);
+    snippets_t snippets = { NULL, NULL, { NULL }, 0, analyzer };
+    char* text_path = malloc(strlen(indexFile) + strlen(DOCTEXT_SUFFIX) + 1);
+    sprintf(text_path, "%s%s", indexFile, DOCTEXT_SUFFIX);
+    snippets.text = doctext_open(text_path);
+    snippets.buf = (snippets.text != NULL) ? malloc(DOCTEXT_MAXTEXT + 1) : NULL;
+    free(text_path);
 
     char line[MAX_LINE];
     char* tokens[MAX_WORDS];
@@ -91,7 +159,16 @@ int main(int argc, char* argv[]) {
         
         if (!quiet_mode) printf("Query: %s", line);
 
-        num_tokens = validate_and_parse_query(line, tokens);
+        num_tokens = validate_and_parse_query(line, tokens, analyzer);
+        querytree_t* query = NULL;
+        if (num_tokens > 0) {
+            const char* error;
+            query = querytree_compile(index, spell, tokens, num_tokens, pageDirectory, analyzer, &boosts, &error);
+            if (query == NULL) {
+                fprintf(stderr, "Error: %s\n", error);
+                num_tokens = -1;
+            }
+        }
 
         if (num_tokens == -1) {
             printf("[invalid query]\n");
@@ -101,7 +178,11 @@ int main(int argc, char* argv[]) {
                 for(int i = 0; i < num_tokens; i++) printf("%s ", tokens[i]);
                 printf("\n");
             }
-            process_query(index, pageDirectory, tokens, num_tokens);
+            snippet_terms(tokens, num_tokens, &snippets);
+            if (process_query(query, pageDirectory, &statics, &snippets) == 0) {
+                suggest_query(tokens, num_tokens, spell);
+            }
+            querytree_delete(query);
         }
         
         if (!quiet_mode) printf("-----------------------------------------------\n> ");
@@ -109,6 +190,12 @@ int main(int argc, char* argv[]) {
     
     if (!quiet_mode) printf("\n");
 
+    spell_delete(spell);
+    free(statics.scores);
+    if (snippets.text != NULL) {
+        doctext_close(snippets.text);
+    }
+    free(snippets.buf);
     happly(index, free_word_entry);
     hclose(index);
 
@@ -118,31 +205,49 @@ int main(int argc, char* argv[]) {
 /**
  * Parses and validates command-line arguments.
  */
-static void parse_args(const int argc, char* argv[], char** pageDir, char** indexFile, bool* quiet_mode) {
-    if (argc < 3 || argc > 4) {
-        fprintf(stderr, "Usage: %s <pageDirectory> <indexFile> [-q]\n", argv[0]);
+static void parse_args(const int argc, char* argv[], char** pageDir, char** indexFile, bool* quiet_mode,
+                       field_boosts_t* boosts, static_rank_t* statics) {
+    const char* usage = "Usage: %s <pageDirectory> <indexFile> [-q] [--title-boost N] [--description-boost N]"
+                        " [--anchor-boost N] [--pagerank-boost N]\n";
+    if (argc < 3) {
+        fprintf(stderr, usage, argv[0]);
         exit(EXIT_FAILURE);
     }
     *pageDir = argv[1];
     *indexFile = argv[2];
     *quiet_mode = false;
+    boosts->title = TITLE_BOOST;
+    boosts->description = DESCRIPTION_BOOST;
+    boosts->anchor = ANCHOR_BOOST;
+    statics->boost = PAGERANK_BOOST;
 
-    if (argc == 4) {
-        if (strcmp(argv[3], "-q") == 0) {
+    for (int i = 3; i < argc; i++) {
+        if (strcmp(argv[i], "-q") == 0) {
             *quiet_mode = true;
+        } else if (strcmp(argv[i], "--title-boost") == 0 && i + 1 < argc && parse_boost(argv[i + 1], &boosts->title)) {
+            i++;
+        } else if (strcmp(argv[i], "--description-boost") == 0 && i + 1 < argc
+                   && parse_boost(argv[i + 1], &boosts->description)) {
+            i++;
+        } else if (strcmp(argv[i], "--anchor-boost") == 0 && i + 1 < argc && parse_boost(argv[i + 1], &boosts->anchor)) {
+            i++;
+        } else if (strcmp(argv[i], "--pagerank-boost") == 0 && i + 1 < argc
+                   && parse_boost(argv[i + 1], &statics->boost)) {
+            i++;
         } else {
-            fprintf(stderr, "Usage: %s <pageDirectory> <indexFile> [-q]\n", argv[0]);
-            fprintf(stderr, "Error: Unrecognized 4th argument '%s'.\n", argv[3]);
+            fprintf(stderr, usage, argv[0]);
+            fprintf(stderr, "Error: Unrecognized argument '%s'.\n", argv[i]);
             exit(EXIT_FAILURE);
         }
     }
 
-    webpage_t* test_page = pageload(1, *pageDir);
-    if (test_page == NULL) {
+    int num_pages = 0;
+    int* ids = pagedir_list(*pageDir, &num_pages);
+    free(ids);
+    if (num_pages == 0) {
         fprintf(stderr, "Error: '%s' is not a valid crawler directory.\n", *pageDir);
         exit(EXIT_FAILURE);
     }
-    webpage_delete(test_page);
 
     FILE* fp = fopen(*indexFile, "r");
     if (fp == NULL) {
@@ -153,159 +258,190 @@ static void parse_args(const int argc, char* argv[], char** pageDir, char** inde
 }
 
 /**
- * Validates the syntax of the query (operators) and normalizes words.
+ * Reads a boost: a whole number, 0 or more.
  */
-static int validate_and_parse_query(char* line, char* tokens[]) {
-    int count = 0;
-    char* token = strtok(line, " \t\n");
-
-    while (token != NULL) {
-        if (count >= MAX_WORDS) {
-            fprintf(stderr, "Error: Query exceeds %d words/operators.\n", MAX_WORDS);
-            return -1;
-        }
-        tokens[count++] = token;
-        token = strtok(NULL, " \t\n");
-    }
-    if (count == 0) return 0;
-    
-    if (strcmp(tokens[0], "and") == 0 || strcmp(tokens[0], "or") == 0) {
-        fprintf(stderr, "Error: Query cannot begin with an operator.\n");
-        return -1;
-    }
-    if (strcmp(tokens[count-1], "and") == 0 || strcmp(tokens[count-1], "or") == 0) {
-        fprintf(stderr, "Error: Query cannot end with an operator.\n");
-        return -1;
+static bool parse_boost(const char* arg, int* boost) {
+    char* end;
+    long value = strtol(arg, &end, 10);
+    if (*arg == '\0' || *end != '\0' || value < 0 || value > 1000000) {
+        return false;
     }
+    *boost = value;
+    return true;
+}
 
-    bool last_was_operator = false;
-    for (int i = 0; i < count; i++) {
-        bool this_is_operator = (strcmp(tokens[i], "and") == 0 || strcmp(tokens[i], "or") == 0);
-        if (this_is_operator) {
-            if (last_was_operator) {
-                fprintf(stderr, "Error: Cannot have adjacent operators.\n");
-                return -1;
-            }
-            last_was_operator = true;
+/**
+ * Splits the query into words, operators and the marks '(', ')', '"'
+ * and '~' with its digit (which need no spaces around them), and
+ * normalizes the words with analyzer. How they fit together is checked
+ * by querytree_compile().
+ */
+static int validate_and_parse_query(char* line, char* tokens[], analyzer_t analyzer) {
+    int count = 0;
+    char* p = line;
+
+    while (*(p += strspn(p, " \t\n")) != '\0') {
+        char* token = p;
+        char* mark = NULL; // a mark that ended the word
+        if (strchr(QUERY_MARKS, *p) != NULL) {
+            token = lex_mark(&p);
         } else {
-            if (!validate_word(tokens[i])) {
+            p += strcspn(p, " \t\n" QUERY_MARKS);
+            if (*p != '\0' && strchr(QUERY_MARKS, *p) != NULL) {
+                char* end = p;
+                mark = lex_mark(&p); // read before the word's end overwrites it
+                *end = '\0';
+            } else if (*p != '\0') {
+                *p++ = '\0';
+            }
+            if (!validate_word(token, analyzer)) {
                 fprintf(stderr, "Error: Invalid characters in query (must be letters).\n");
                 return -1;
             }
-            last_was_operator = false;
+        }
+
+        if (count + (mark != NULL) >= MAX_WORDS) {
+            fprintf(stderr, "Error: Query exceeds %d words/operators.\n", MAX_WORDS);
+            return -1;
+        }
+        tokens[count++] = token;
+        if (mark != NULL) {
+            tokens[count++] = mark;
         }
     }
     return count;
 }
 
 /**
- * Validates and normalizes a word (in-place).
+ * The token for the mark at *p, which it moves past: '(', ')', '"', or
+ * '~' and the digit after it, if there is one.
  */
-static bool validate_word(char* word) {
+static char* lex_mark(char** p) {
+    static char marks[][2] = { "(", ")", "\"", "~" };
+    static char fuzzy[][3] = { "~0", "~1", "~2", "~3", "~4", "~5", "~6", "~7", "~8", "~9" };
+    char c = *(*p)++;
+    if (c == '~' && **p >= '0' && **p <= '9') {
+        return fuzzy[*(*p)++ - '0'];
+    }
+    return marks[strchr(QUERY_MARKS, c) - QUERY_MARKS];
+}
+
+/**
+ * Validates and normalizes a word (in-place): all letters (ASCII or
+ * UTF-8), folded to lowercase, then turned into a term by analyzer,
+ * just as index_addpage() does.
+ */
+static bool validate_word(char* word, analyzer_t analyzer) {
     if (word == NULL) return false;
-    for (int i = 0; word[i] != '\0'; i++) {
-        if (!isalpha((unsigned char)word[i])) {
+    int len = strlen(word);
+    for (int i = 0, n; i < len; i += n) {
+        if ((n = utf8_letter(word, len, i)) == 0) {
             return false;
         }
-        word[i] = tolower((unsigned char)word[i]);
     }
+    utf8_fold_span(word, len);
+    analyzer_apply(analyzer, word, len);
     return true;
 }
 
 /**
- * Main query processor. Splits the query by 'or' and merges the results.
+ * Main query processor. Streams the matching pages out of the query's
+ * iterator tree into the results, adds their static ranks, then ranks
+ * and prints them with their snippets.
+ * Returns the number of pages that matched.
  */
-static void process_query(hashtable_t* index, char* pageDirectory, char* tokens[], int num_tokens) {
+static int process_query(querytree_t* query, char* pageDirectory, const static_rank_t* statics,
+                         const snippets_t* snippets) {
     queue_t* final_results = qopen();
-    int and_start_index = 0;
-
-    for (int i = 0; i <= num_tokens; i++) {
-        if (i == num_tokens || strcmp(tokens[i], "or") == 0) {
-            queue_t* and_results = compute_and_intersection(index, tokens, and_start_index, i - 1);
-            if (and_results != NULL) {
-                merge_or_results(final_results, and_results);
-                qclose(and_results);
+    int docID, rank;
+    int matched = 0;
+
+    while ((docID = querytree_next(query, &rank)) >= 0) {
+        matched++;
+        query_result_t* qr = malloc(sizeof(query_result_t));
+        if (qr) {
+            qr->docID = docID;
+            qr->rank = rank;
+            if (statics->scores != NULL && docID < statics->size) {
+                qr->rank += lround(statics->boost * log2(1 + statics->scores[docID]));
             }
-            and_start_index = i + 1;
+            qput(final_results, qr);
         }
     }
 
-    print_results(final_results, pageDirectory, false); // false = not quiet for this step
+    print_results(final_results, pageDirectory, false, snippets); // false = not quiet for this step
 
     qapply(final_results, free_result_helper);
     qclose(final_results);
+    return matched;
 }
 
 /**
- * Computes the intersection (AND) of a sequence of tokens.
+ * Picks the words of the query its results' snippets highlight: not
+ * operators, marks or words too short to be terms, nor what a "not"
+ * excludes (a word, a quoted phrase or a parenthesized group).
  */
-static queue_t* compute_and_intersection(hashtable_t* index, char* tokens[], int start, int end) {
-    queue_t* results_queue = qopen();
-    
-    int first_word_idx = -1;
-    word_entry_t* first_word = NULL;
-    for (int i = start; i <= end; i++) {
-        if (strcmp(tokens[i], "and") != 0 && strlen(tokens[i]) >= 3) {
-            first_word = hsearch(index, search_word, tokens[i], strlen(tokens[i]));
-            if (first_word != NULL) {
-                first_word_idx = i;
-                break;
-            } else {
-                qclose(results_queue); return NULL;
+static void snippet_terms(char* tokens[], int num_tokens, snippets_t* snippets) {
+    snippets->num_terms = 0;
+    for (int i = 0; i < num_tokens; i++) {
+        if (strcmp(tokens[i], "not") == 0 && i + 1 < num_tokens) {
+            char open = tokens[++i][0];
+            int depth = (open == '(') - (open == ')');
+            bool quoted = (open == '"');
+            while ((depth > 0 || quoted) && ++i < num_tokens) {
+                depth += (tokens[i][0] == '(') - (tokens[i][0] == ')');
+                quoted ^= (tokens[i][0] == '"');
             }
+            continue;
         }
-    }
-
-    if (first_word == NULL) {
-        qclose(results_queue); return NULL;
-    }
-    
-    g_results_queue = results_queue;
-    qapply(first_word->docs, init_results_helper);
-
-    for (int i = first_word_idx + 1; i <= end; i++) {
-        if (strcmp(tokens[i], "and") == 0 || strlen(tokens[i]) < 3) continue;
-
-        word_entry_t* next_word = hsearch(index, search_word, tokens[i], strlen(tokens[i]));
-        if (next_word == NULL) {
-            qapply(results_queue, free_result_helper);
-            qclose(results_queue);
-            return NULL;
-        }
-
-        g_count = 0;
-        qapply(results_queue, count_helper);
-        int num_to_check = g_count;
-
-        for (int j = 0; j < num_to_check; j++) {
-            query_result_t* qr = qget(results_queue);
-            doc_entry_t* found = qsearch(next_word->docs, search_doc, &(qr->docID));
-
-            if (found) {
-                if (found->count < qr->rank) qr->rank = found->count;
-                qput(results_queue, qr);
-            } else {
-                free(qr);
-            }
+        if (strchr(QUERY_MARKS, tokens[i][0]) == NULL && strcmp(tokens[i], "and") != 0
+            && strcmp(tokens[i], "or") != 0 && strlen(tokens[i]) >= MIN_WORD_LEN) {
+            snippets->terms[snippets->num_terms++] = tokens[i];
         }
     }
-    return results_queue;
 }
 
 /**
- * Merges a queue of AND results into the final master queue.
+ * Prints the query again with each word that is not a term of the index
+ * replaced by the one spell_suggest() finds for it, if it finds any.
+ * Operators, marks, words too short to be terms and fuzzy words (which
+ * are spelled loosely already) are kept as they are.
  */
-static void merge_or_results(queue_t* final_results, queue_t* and_results) {
-    query_result_t* qr;
-    while ((qr = qget(and_results)) != NULL) {
-        query_result_t* master_qr = qsearch(final_results, search_docid_queue, &(qr->docID));
-        if (master_qr == NULL) {
-            qput(final_results, qr);
-        } else {
-            master_qr->rank += qr->rank;
-            free(qr);
+static void suggest_query(char* tokens[], int num_tokens, spell_t* spell) {
+    const char* words[MAX_WORDS];
+    bool changed = false;
+    for (int i = 0; i < num_tokens; i++) {
+        words[i] = tokens[i];
+        bool fuzzy = (i + 1 < num_tokens && tokens[i + 1][0] == '~');
+        if (strchr(QUERY_MARKS, tokens[i][0]) == NULL && strcmp(tokens[i], "and") != 0
+            && strcmp(tokens[i], "or") != 0 && strcmp(tokens[i], "not") != 0
+            && strlen(tokens[i]) >= MIN_WORD_LEN && !fuzzy) {
+            const char* suggestion = spell_suggest(spell, tokens[i]);
+            if (suggestion != NULL) {
+                words[i] = suggestion;
+                changed = true;
+            }
         }
     }
+    if (!changed) {
+        return;
+    }
+
+    // Spaced as typed: none inside parentheses or quotes, or before '~'
+    printf("Did you mean: ");
+    bool quoted = false;
+    for (int i = 0; i < num_tokens; i++) {
+        bool closing = (words[i][0] == ')' || words[i][0] == '~' || (words[i][0] == '"' && quoted));
+        bool after_opening = (i > 0 && (words[i - 1][0] == '(' || (words[i - 1][0] == '"' && quoted)));
+        if (i > 0 && !closing && !after_opening) {
+            printf(" ");
+        }
+        if (words[i][0] == '"') {
+            quoted = !quoted;
+        }
+        printf("%s", words[i]);
+    }
+    printf("?\n");
 }
 
 /**
@@ -313,7 +449,7 @@ static void merge_or_results(queue_t* final_results, queue_t* and_results) {
  * Converts the final results queue into a sorted array and prints
  * in the Google-style format.
  */
-static void print_results(queue_t* final_results, char* pageDirectory, bool quiet_mode) {
+static void print_results(queue_t* final_results, char* pageDirectory, bool quiet_mode, const snippets_t* snippets) {
     g_count = 0;
     qapply(final_results, count_helper);
     int num_final = g_count;
@@ -335,23 +471,38 @@ static void print_results(queue_t* final_results, char* pageDirectory, bool quie
         query_result_t* qr = results_array[i];
         
         // Load the full page to get HTML
-        webpage_t* page = pageload(qr->docID, pageDirectory);
+        webpage_t* page = pagemap(qr->docID, pageDirectory);
         if (page == NULL) {
             fprintf(stderr, "Warning: Could not load page for docID %d\n", qr->docID);
             continue;
         }
 
         const char* url = webpage_getURL(page);
-        const char* html = webpage_getHTML(page);
 
         // Extract title and description
-        char* title = extract_from_tag(html, "<title>", "</title>", 200);
-        char* desc = extract_from_tag(html, "<meta name=\"description\" content=\"", "\"", 128);
+        page_summary_t summary = { NULL, NULL };
+        htmllex_handler_t handler = { .title = title_helper, .description = desc_helper, .arg = &summary };
+        htmllex_run(webpage_getHTML(page), webpage_getHTMLlen(page), &handler);
+        char* title = summary.title;
+        char* desc = summary.desc;
+
+        // The words around the match, if the indexer kept the page's text
+        char snippet[DOCTEXT_MAXSNIPPET];
+        int highlighted = -1;
+        int len = (snippets->text != NULL) ? doctext_get(snippets->text, qr->docID, snippets->buf) : -1;
+        if (len >= 0) {
+            highlighted = doctext_snippet(snippets->buf, len, snippets->terms, snippets->num_terms,
+                                          snippets->analyzer, snippet);
+        }
 
         // Print in new format
         printf("\n%s\n", (title ? title : "No Title"));
         printf("%s\n", url);
-        printf("%s\n", (desc ? desc : "No Description"));
+        if (highlighted > 0 || (highlighted == 0 && desc == NULL && snippet[0] != '\0')) {
+            printf("%s\n", snippet);
+        } else {
+            printf("%s\n", (desc ? desc : "No Description"));
+        }
         printf("Rank: %d\n", qr->rank);
 
         // Clean up for this page
@@ -364,79 +515,42 @@ static void print_results(queue_t* final_results, char* pageDirectory, bool quie
 }
 
 /**
- * --- NEW HELPER FOR OPTIONAL STEP ---
- * Extracts text from HTML.
- * Can extract from between tags (e.g., <title>text</title>)
- * or from a content attribute (e.g., <meta... content="text">)
- *
- * @param html - The full HTML string to search.
- * @param start_tag - The string marking the beginning of the content.
- * @param end_tag - The string marking the end of the content.
- * @param max_len - The maximum number of characters to extract.
- * @return A new, heap-allocated string with the content, or NULL if not found.
- * The caller is responsible for free()-ing this string.
+ * Keeps a copy of the page's title (for htmllex_run).
  */
-static char* extract_from_tag(const char* html, const char* start_tag, const char* end_tag, int max_len) {
-    if (html == NULL) return NULL;
-
-    const char* start = strstr(html, start_tag);
-    if (start == NULL) return NULL;
-
-    // Move the start pointer past the tag itself
-    start += strlen(start_tag);
-
-    // Stop search for end tag before </head> or <body>
-    const char* head_end = strstr(start, "</head>");
-    const char* body_start = strstr(start, "<body>");
-    const char* search_limit = NULL;
-
-    if (head_end && body_start) {
-        search_limit = (head_end < body_start) ? head_end : body_start;
-    } else {
-        search_limit = head_end ? head_end : body_start;
-    }
-    
-    const char* end = strstr(start, end_tag);
+static void title_helper(const char* title, int len, void* arg) {
+    ((page_summary_t*)arg)->title = copy_text(title, len, MAX_TITLE);
+}
 
-    // If end_tag wasn't found, or it was found *after* the limit
-    if (end == NULL || (search_limit != NULL && end > search_limit)) {
-        return NULL;
-    }
+/**
+ * Keeps a copy of the page's meta description (for htmllex_run).
+ */
+static void desc_helper(const char* desc, int len, void* arg) {
+    ((page_summary_t*)arg)->desc = copy_text(desc, len, MAX_DESC);
+}
 
-    int len = end - start;
+/**
+ * Copies at most max_len characters of text into a new string, with
+ * newlines replaced by spaces for cleaner output.
+ * The caller is responsible for free()-ing this string.
+ */
+static char* copy_text(const char* text, int len, int max_len) {
     if (len > max_len) {
         len = max_len;
     }
 
-    char* extracted = malloc(len + 1);
-    if (extracted == NULL) return NULL;
-
-    strncpy(extracted, start, len);
-    extracted[len] = '\0';
+    char* copy = malloc(len + 1);
+    if (copy == NULL) return NULL;
 
-    // Basic cleanup: replace newlines with spaces for cleaner output
-    for (char* p = extracted; *p; ++p) {
-        if (*p == '\n' || *p == '\r') {
-            *p = ' ';
-        }
+    for (int i = 0; i < len; i++) {
+        copy[i] = (text[i] == '\n' || text[i] == '\r') ? ' ' : text[i];
     }
-
-    return extracted;
+    copy[len] = '\0';
+    return copy;
 }
 
 
 // --- Iterator & Helper Functions ---
 
-static void init_results_helper(void* elementp) {
-    doc_entry_t* d_entry = (doc_entry_t*)elementp;
-    query_result_t* qr = malloc(sizeof(query_result_t));
-    if (qr) {
-        qr->docID = d_entry->docID;
-        qr->rank = d_entry->count;
-        qput(g_results_queue, qr);
-    }
-}
-
 static void count_helper(void* elementp) {
     if (elementp != NULL) g_count++;
 }
@@ -454,28 +568,16 @@ static void free_result_helper(void* elementp) {
 static int compare_results(const void* a, const void* b) {
     query_result_t* res_a = *(query_result_t**)a;
     query_result_t* res_b = *(query_result_t**)b;
-    return res_b->rank - res_a->rank;
+    if (res_a->rank != res_b->rank) {
+        return res_b->rank - res_a->rank;
+    }
+    return res_a->docID - res_b->docID; // ties in page order
 }
 
 //
 // --- Data Structure Helper Functions ---
 //
 
-static bool search_word(void* elementp, const void* keyp) {
-    word_entry_t* entry = (word_entry_t*)elementp;
-    return strcmp(entry->word, (const char*)keyp) == 0;
-}
-
-static bool search_doc(void* elementp, const void* keyp) {
-    doc_entry_t* entry = (doc_entry_t*)elementp;
-    return entry->docID == *(int*)keyp;
-}
-
-static bool search_docid_queue(void* elementp, const void* keyp) {
-    query_result_t* entry = (query_result_t*)elementp;
-    return entry->docID == *(int*)keyp;
-}
-
 static void free_doc_entry(void* data) {
     doc_entry_t* doc = (doc_entry_t*)data;
     if (doc) free(doc);
@@ -485,6 +587,7 @@ static void free_word_entry(void* data) {
     word_entry_t* word = (word_entry_t*)data;
     if (word) {
         free(word->word); 
+        free(word->stopbits);
         qapply(word->docs, free_doc_entry); 
         qclose(word->docs); 
         free(word); 
@@ -0,0 +1,129 @@
+#!/bin/bash
+#
+# anchortest.sh - tests that the crawler records links with their anchor
+# text and that the indexer credits it to the pages they lead to, in a
+# full build and in 'indexer -u', and that the index 'crawler -i' builds
+# is the indexer's but for the anchor text, against a local fixture
+# HTTP server
+#
+# Author: Insecticide
+# Date: 10-17-2026
+#
+# Usage: ./anchortest.sh   (after building ../crawler and ../indexer)
+
+CRAWLER="../crawler/crawler"
+INDEXER="../indexer/indexer"
+PORT="${PORT:-8643}"
+WORK="$(mktemp -d)"
+SITE="$WORK/site"
+PAGES="$WORK/pages"
+SEED="http://127.0.0.1:$PORT/index.html"
+SCOPE="$WORK/scope"
+
+fail() {
+    echo "FAIL: $1"
+    exit 1
+}
+
+# The word's postings: docID, count and fields of each, e.g. "1 1 2 1/8"
+postings() {
+    grep "^$1 " "$2" | cut -d' ' -f2-
+}
+
+# Every posting of an index, one "word docID count fields" line each
+expand_postings() {
+    awk '{
+        for (i = 2; i < NF; i += 2) {
+            n = split($(i + 1), c, "/")
+            fields = (n == 2) ? index("0123456789abcdef", c[2]) - 1 : 1
+            print $1, $i, c[1], fields
+        }
+    }' "$1" | sort
+}
+
+for exe in "$CRAWLER" "$INDEXER"; do
+    if [ ! -x "$exe" ]; then
+        echo "FAIL: Executable '$exe' not found. Please compile it first with 'make'."
+        exit 1
+    fi
+done
+
+mkdir -p "$SITE" "$PAGES"
+cat > "$SITE/index.html" <<EOF
+<html><title>Fixture</title><body>apple
+<a href="b.html">zebra stripes</a> <a href="index.html">itself quokka</a>
+<a href="http://elsewhere.example/">outside walrus</a></body></html>
+EOF
+echo "<html><title>Second</title><body>banana</body></html>" > "$SITE/b.html"
+echo "+ http://127.0.0.1:$PORT/" > "$SCOPE"
+
+python3 -m http.server "$PORT" --bind 127.0.0.1 --directory "$SITE" >/dev/null 2>&1 &
+SERVER=$!
+trap 'kill $SERVER 2>/dev/null; rm -rf "$WORK"' EXIT
+sleep 1
+
+echo "Starting anchortest..."
+
+# 1. Links are recorded even at maxDepth, where they are not followed
+"$CRAWLER" "$SEED" "$PAGES" 0 --scope "$SCOPE" > /dev/null || fail "depth 0 crawl failed"
+[ -s "$PAGES/.links" ] || fail "crawl recorded no links"
+"$INDEXER" "$PAGES" "$WORK/index" > /dev/null || fail "depth 0 index failed"
+[ "$(postings zebra "$WORK/index")" = "1 1" ] || fail "anchor text credited to a page that was not saved"
+
+# 2. Anchor words count for the page linked to, in the anchor field
+#    (page 1 has them in its body, as the text of its links)
+rm -rf "$PAGES"/* "$PAGES"/.[!.]*
+"$CRAWLER" "$SEED" "$PAGES" 1 --scope "$SCOPE" > /dev/null || fail "crawl failed"
+[ -f "$PAGES/2" ] || fail "linked page was not saved"
+"$INDEXER" "$PAGES" "$WORK/index" > /dev/null || fail "index failed"
+[ "$(postings zebra "$WORK/index")" = "1 1 2 1/8" ] || fail "zebra: $(postings zebra "$WORK/index")"
+[ "$(postings banana "$WORK/index")" = "2 1" ] || fail "banana: $(postings banana "$WORK/index")"
+[ "$(postings quokka "$WORK/index")" = "1 1" ] || fail "a page's link to itself was credited"
+[ "$(postings walrus "$WORK/index")" = "1 1" ] || fail "an out-of-scope link was credited"
+
+# The page linked to outranks the page linking to it
+[ -s "$WORK/index.pagerank" ] || fail "no PageRank saved"
+awk '{ score[$1] = $2 } END { exit !(score[2] > score[1]) }' "$WORK/index.pagerank" \
+    || fail "PageRank: $(cat "$WORK/index.pagerank")"
+
+# 3. The anchor text changed: the update redoes the page linked to
+sed -i 's/zebra stripes/yak fur/' "$SITE/index.html"
+touch -d "@$(( $(date +%s) + 60 ))" "$SITE/index.html"
+"$CRAWLER" "$SEED" "$PAGES" 1 --recrawl --scope "$SCOPE" > /dev/null || fail "recrawl failed"
+grep -qx "M 1" "$PAGES/.changes" || fail "modified page not listed: $(cat "$PAGES/.changes")"
+grep -q "^2 " "$PAGES/.changes" && fail "unchanged page listed: $(cat "$PAGES/.changes")"
+"$INDEXER" "$PAGES" "$WORK/index" -u > /dev/null || fail "index update failed"
+"$INDEXER" "$PAGES" "$WORK/full" > /dev/null || fail "full reindex failed"
+diff <(sort "$WORK/index") <(sort "$WORK/full") > /dev/null || fail "updated index differs from a full rebuild"
+grep -q "^zebra " "$WORK/index" && fail "stale anchor text survived the update"
+[ "$(postings yak "$WORK/index")" = "1 1 2 1/8" ] || fail "yak: $(postings yak "$WORK/index")"
+
+# 4. 'crawler -i' indexes what the indexer does, but for the anchor text:
+#    postings with the anchor field are left to the indexer, and a page
+#    with a word in both its text and links to it counts only the text
+echo "<html><title>Second</title><body>banana fur</body></html>" > "$SITE/b.html"
+PIPED="$WORK/piped"
+mkdir -p "$PIPED"
+"$CRAWLER" "$SEED" "$PIPED" 1 --scope "$SCOPE" -i "$WORK/pipe" > /dev/null || fail "crawl with -i failed"
+[ -f "$WORK/pipe.pagerank" ] && fail "crawler -i saved a PageRank"
+"$INDEXER" "$PIPED" "$WORK/full" > /dev/null || fail "index of the -i crawl failed"
+expand_postings "$WORK/pipe" > "$WORK/pipe.post"
+expand_postings "$WORK/full" > "$WORK/full.post"
+[ "$(postings fur "$WORK/full")" = "1 1 2 2/9" ] || fail "fur: $(postings fur "$WORK/full")"
+awk '$4 >= 8 { exit 1 }' "$WORK/pipe.post" || fail "crawler -i credited anchor text"
+awk '$4 >= 8 { print $1, $2 }' "$WORK/full.post" > "$WORK/anchored"
+diff <(awk '$4 < 8' "$WORK/full.post") \
+     <(awk 'NR == FNR { anchored[$1 " " $2] = 1; next } !(($1 " " $2) in anchored)' "$WORK/anchored" "$WORK/pipe.post") \
+    > /dev/null || fail "crawler -i and the indexer differ outside the anchor field"
+awk 'NR == FNR { count[$1 " " $2] = $3; fields[$1 " " $2] = $4; next }
+     $4 >= 8 {
+         key = $1 " " $2
+         if ($4 == 8 ? (key in fields) : fields[key] != $4 - 8 || count[key] >= $3) {
+             print key; bad = 1
+         }
+     }
+     END { exit bad }' "$WORK/pipe.post" "$WORK/full.post" > "$WORK/bad" \
+    || fail "crawler -i postings of anchor words: $(cat "$WORK/bad")"
+
+echo "PASS: anchor text was recorded, credited to the linked page, kept up to date and left to the indexer."
+exit 0
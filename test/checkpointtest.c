@@ -0,0 +1,205 @@
+/*
+ * checkpointtest.c - test program for the 'checkpoint' module
+ *
+ * Author: Insecticide
+ * Date: 10-17-2026
+ *
+ * Usage: ./checkpointtest
+ *
+ * Description:
+ * 1. Writes a checkpoint log as a crawl would: seen URLs and two
+ *    commits, then seen URLs that are not committed, then (as if the
+ *    crawler were killed mid-write) half a '+' record.
+ * 2. Checks that checkpoint_resume() rebuilds the seen set from the
+ *    committed URLs only (normalized), the frontier from those not yet
+ *    dequeued (in order, with their depths), and the dequeued count and
+ *    next docID of the last commit; and that it cuts the log back to
+ *    just past that commit.
+ * 3. Checks that records appended after resuming are replayed by the
+ *    next resume.
+ * 4. Checks that a log with no commit, or with garbage in it, is only
+ *    trusted up to its last commit before the garbage.
+ * 5. Reports PASS/FAIL.
+ */
+
+#define _POSIX_C_SOURCE 200809L // mkdtemp
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include "checkpoint.h"
+#include "webpage.h"
+#include "hash.h"
+#include "queue.h"
+
+#define NUM_COMMITTED 7
+#define NUM_DEQUEUED 3
+
+static int failures = 0;
+
+static const char *urls[] = {
+    "http://example.test/", "HTTP://Example.test/a.html", "http://example.test/b.html",
+    "http://example.test/c.html", "http://example.test/d.html", "http://example.test/e.html",
+    "http://example.test/f.html",
+    // not committed
+    "http://example.test/late1.html", "http://example.test/late2.html"
+};
+static const int depths[] = { 0, 1, 1, 1, 2, 2, 2, 3, 3 };
+
+static void check(int ok, const char *what) {
+    if (!ok) {
+        fprintf(stderr, "FAIL: %s\n", what);
+        failures++;
+    }
+}
+
+static bool search_url(void *elementp, const void *keyp) {
+    return strcmp((const char *)elementp, (const char *)keyp) == 0;
+}
+
+// Whether url, normalized as the crawler keys it, is in seen
+static bool is_seen(hashtable_t *seen, const char *url) {
+    char normalized[256];
+    snprintf(normalized, sizeof(normalized), "%s", url);
+    NormalizeURL(normalized);
+    return hsearch(seen, search_url, normalized, strlen(normalized)) != NULL;
+}
+
+// Appends text to the file at path
+static void append(const char *path, const char *text) {
+    FILE *fp = fopen(path, "a");
+    fputs(text, fp);
+    fclose(fp);
+}
+
+// The last line of the file at path (without its newline), or "" if it does not end in one
+static void last_line(const char *path, char *line, int size) {
+    FILE *fp = fopen(path, "r");
+    line[0] = '\0';
+    char buf[256];
+    while (fp != NULL && fgets(buf, sizeof(buf), fp) != NULL) {
+        int len = strlen(buf);
+        if (len > 0 && buf[len - 1] == '\n') {
+            buf[len - 1] = '\0';
+            snprintf(line, size, "%s", buf);
+        } else {
+            line[0] = '\0';
+        }
+    }
+    if (fp != NULL) {
+        fclose(fp);
+    }
+}
+
+// Resumes from dir into a fresh seen set and frontier, which the caller frees
+static checkpoint_t *resume(char *dir, hashtable_t **seen, queue_t **frontier, int *dequeued, int *nextID) {
+    *seen = hopen(64);
+    *frontier = qopen();
+    *dequeued = -1;
+    *nextID = -1;
+    return checkpoint_resume(dir, *seen, *frontier, dequeued, nextID);
+}
+
+static void free_state(hashtable_t *seen, queue_t *frontier) {
+    happly(seen, free);
+    hclose(seen);
+    qapply(frontier, webpage_delete);
+    qclose(frontier);
+}
+
+int main(int argc, char *argv[]) {
+    printf("Starting checkpointtest...\n");
+    char dir[] = "/tmp/checkpointtest.XXXXXX";
+    if (mkdtemp(dir) == NULL) {
+        perror("mkdtemp");
+        return 1;
+    }
+    char path[256];
+    snprintf(path, sizeof(path), "%s/.crawler.ckpt", dir);
+
+    // 1. Two commits, records after them, and a torn record
+    checkpoint_t *cp = checkpoint_open(dir);
+    for (int i = 0; i < 5; i++) {
+        checkpoint_seen(cp, urls[i], depths[i]);
+    }
+    checkpoint_commit(cp, 1, 2, true);
+    for (int i = 5; i < NUM_COMMITTED; i++) {
+        checkpoint_seen(cp, urls[i], depths[i]);
+    }
+    checkpoint_commit(cp, NUM_DEQUEUED, 4, true);
+    checkpoint_seen(cp, urls[7], depths[7]);
+    checkpoint_seen(cp, urls[8], depths[8]);
+    checkpoint_close(cp); // killed: no final commit
+    append(path, "+3 http://example.test/to");
+
+    // 2. The committed state, and only it
+    hashtable_t *seen;
+    queue_t *frontier;
+    int dequeued, nextID;
+    cp = resume(dir, &seen, &frontier, &dequeued, &nextID);
+    check(cp != NULL, "no checkpoint to resume from");
+    check(dequeued == NUM_DEQUEUED && nextID == 4, "dequeued count or next docID not those of the last commit");
+    for (int i = 0; i < NUM_COMMITTED; i++) {
+        check(is_seen(seen, urls[i]), "a committed URL is not seen");
+    }
+    check(!is_seen(seen, urls[7]) && !is_seen(seen, urls[8]), "an uncommitted URL is seen");
+    check(!is_seen(seen, "http://example.test/to"), "the torn record was replayed");
+    for (int i = NUM_DEQUEUED; i < NUM_COMMITTED; i++) {
+        webpage_t *page = qget(frontier);
+        check(page != NULL && strcmp(webpage_getURL(page), urls[i]) == 0 && webpage_getDepth(page) == depths[i],
+              "the frontier is not the committed URLs not yet dequeued, in order");
+        webpage_delete(page);
+    }
+    webpage_t *extra = qget(frontier);
+    check(extra == NULL, "the frontier has more than the committed URLs");
+    webpage_delete(extra);
+    free_state(seen, frontier);
+
+    char line[256];
+    last_line(path, line, sizeof(line));
+    check(strcmp(line, "=3 4") == 0, "the log was not cut back to its last commit");
+
+    // 3. Records appended after resuming count next time
+    checkpoint_seen(cp, urls[8], 4);
+    checkpoint_commit(cp, 5, 6, true);
+    checkpoint_close(cp);
+    cp = resume(dir, &seen, &frontier, &dequeued, &nextID);
+    check(cp != NULL && dequeued == 5 && nextID == 6, "the commit after resuming was lost");
+    check(is_seen(seen, urls[8]) && !is_seen(seen, urls[7]), "the record after resuming was lost");
+    int num_queued = 0;
+    webpage_t *page;
+    while ((page = qget(frontier)) != NULL) {
+        num_queued++;
+        check(num_queued < 3 || (strcmp(webpage_getURL(page), urls[8]) == 0 && webpage_getDepth(page) == 4),
+              "the frontier lost the record after resuming");
+        webpage_delete(page);
+    }
+    check(num_queued == 3, "the frontier after resuming twice is wrong");
+    free_state(seen, frontier);
+    checkpoint_close(cp);
+
+    // 4. No commit at all; garbage after a commit
+    cp = checkpoint_open(dir);
+    checkpoint_seen(cp, urls[0], 0);
+    checkpoint_close(cp);
+    cp = resume(dir, &seen, &frontier, &dequeued, &nextID);
+    check(cp == NULL, "a log without a commit was resumed");
+    free_state(seen, frontier);
+    checkpoint_close(cp);
+
+    append(path, "=0 2\n#garbage\n+1 http://example.test/after.html\n=1 3\n");
+    cp = resume(dir, &seen, &frontier, &dequeued, &nextID);
+    check(cp != NULL && dequeued == 0 && nextID == 2, "garbage in the log was not the end of it");
+    check(!is_seen(seen, "http://example.test/after.html"), "a record after garbage was replayed");
+    free_state(seen, frontier);
+    checkpoint_close(cp);
+
+    char cmd[300];
+    snprintf(cmd, sizeof(cmd), "rm -rf %s", dir);
+    if (system(cmd) != 0) {
+        fprintf(stderr, "Warning: could not remove %s\n", dir);
+    }
+    printf(failures == 0 ? "PASS\n" : "FAIL\n");
+    return failures != 0;
+}
@@ -7,9 +7,12 @@
  * Usage: ./indextest
  *
  * Description:
- * 1. Creates a simple in-memory index.
- * 2. Saves it to a file "test.dat" using indexsave().
- * 3. Loads it from "test.dat" into a new index structure using indexload().
+ * 1. Creates a simple in-memory index, with one stopword and postings
+ *    in the title and description fields.
+ * 2. Saves it to a file "test.dat" using indexsave(), as built with the
+ *    porter2 analyzer.
+ * 3. Loads it from "test.dat" into a new index structure using indexload(),
+ *    which must report that analyzer.
  * 4. Saves the new index to "test_reload.dat".
  * 5. Runs 'diff' to compare "test.dat" and "test_reload.dat".
  * 6. Reports PASS/FAIL and cleans up memory and files.
@@ -44,20 +47,24 @@ int main(void) {
     }
 
     // 2. Save the index to a file
-    if (indexsave(index1, testfile) != 0) {
+    if (indexsave(index1, testfile, ANALYZER_PORTER2) != 0) {
         fprintf(stderr, "indexsave() failed.\n");
         status = 1; // Mark as FAIL
     }
 
     // 3. Load the index from that file
-    hashtable_t* index2 = indexload(testfile);
+    analyzer_t analyzer;
+    hashtable_t* index2 = indexload(testfile, &analyzer);
     if (index2 == NULL) {
         fprintf(stderr, "indexload() failed.\n");
         status = 1; // Mark as FAIL
+    } else if (analyzer != ANALYZER_PORTER2) {
+        fprintf(stderr, "FAIL: indexload() did not read back the analyzer.\n");
+        status = 1;
     }
 
     // 4. Save the newly loaded index to a second file
-    if (status == 0 && indexsave(index2, reloadfile) != 0) {
+    if (status == 0 && indexsave(index2, reloadfile, analyzer) != 0) {
         fprintf(stderr, "indexsave() failed on reloaded index.\n");
         status = 1; // Mark as FAIL
     }
@@ -95,8 +102,8 @@ int main(void) {
  * Creates a simple, hard-coded index for testing.
  *
  * Index will contain:
- * "cat": (doc 1, count 2), (doc 3, count 1)
- * "dog": (doc 2, count 5)
+ * "cat": (doc 1, count 2, title and body), (doc 3, count 1, description)
+ * "dog": (doc 2, count 5), then made a stopword (bit 2)
  */
 static hashtable_t* create_test_index(void) {
     hashtable_t* index = hopen(10);
@@ -106,13 +113,14 @@ static hashtable_t* create_test_index(void) {
     word_entry_t* cat_entry = malloc(sizeof(word_entry_t));
     cat_entry->word = "cat"; // Use string literal for simplicity
     cat_entry->docs = qopen();
+    cat_entry->stopbits = NULL;
     
     doc_entry_t* cat_doc1 = malloc(sizeof(doc_entry_t));
-    cat_doc1->docID = 1; cat_doc1->count = 2;
+    cat_doc1->docID = 1; cat_doc1->count = 2; cat_doc1->fields = FIELD_TITLE | FIELD_BODY;
     qput(cat_entry->docs, cat_doc1);
     
     doc_entry_t* cat_doc3 = malloc(sizeof(doc_entry_t));
-    cat_doc3->docID = 3; cat_doc3->count = 1;
+    cat_doc3->docID = 3; cat_doc3->count = 1; cat_doc3->fields = FIELD_DESC;
     qput(cat_entry->docs, cat_doc3);
     
     hput(index, cat_entry, cat_entry->word, strlen(cat_entry->word));
@@ -121,13 +129,17 @@ static hashtable_t* create_test_index(void) {
     word_entry_t* dog_entry = malloc(sizeof(word_entry_t));
     dog_entry->word = "dog"; // Use string literal
     dog_entry->docs = qopen();
+    dog_entry->stopbits = NULL;
     
     doc_entry_t* dog_doc2 = malloc(sizeof(doc_entry_t));
-    dog_doc2->docID = 2; dog_doc2->count = 5;
+    dog_doc2->docID = 2; dog_doc2->count = 5; dog_doc2->fields = FIELD_BODY;
     qput(dog_entry->docs, dog_doc2);
     
     hput(index, dog_entry, dog_entry->word, strlen(dog_entry->word));
 
+    // "dog" moves to the stopword tier
+    index_addstopword(index, "dog");
+
     return index;
 }
 
@@ -148,6 +160,7 @@ static void free_word_entry(void* data) {
         // A real index would malloc/free the word string.
         qapply(word->docs, free_doc_entry);
         qclose(word->docs);
+        free(word->stopbits);
         free(word);
     }
 }
@@ -0,0 +1,310 @@
+/*
+ * linkgraphtest.c - test program for the 'linkgraph' module
+ *
+ * Author: Insecticide
+ * Date: 10-17-2026
+ *
+ * Usage: ./linkgraphtest
+ *
+ * Description:
+ * 1. Writes the page metadata and link file of a made-up crawl to a
+ *    temporary directory: random links, with repeated links, links to
+ *    themselves, to pages outside the crawl and from deleted pages,
+ *    and pages whose links were recorded twice.
+ * 2. Checks that linkgraph_load() finds exactly the links that count.
+ * 3. Checks linkgraph_pagerank() with one and four threads against a
+ *    straightforward power iteration over the list of links, and that
+ *    the ranks add up to 1.
+ * 4. Checks that linkgraph_saveranks() and linkgraph_loadranks() agree.
+ * 5. Checks that reopening a link file to append drops a block cut
+ *    short, so the blocks added after it are read.
+ * 6. Loads and ranks a crawl of a few million links, checks that
+ *    loading it took far less memory than its link file, reports how
+ *    long it took, and PASS/FAIL.
+ */
+
+#define _POSIX_C_SOURCE 200809L // clock_gettime, mkdtemp
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <time.h>
+#include <sys/resource.h>
+#include <sys/stat.h>
+#include "linkgraph.h"
+#include "linkfile.h"
+#include "pagemeta.h"
+#include "webpage.h"
+
+#define NUM_PAGES 500
+#define BIG_PAGES 300000
+#define BIG_LINKS 10 // per page
+#define DAMPING 0.85
+
+// A made-up crawl: which pages are in it, and who links to whom
+typedef struct crawl {
+    int num_pages;
+    bool* live;
+    unsigned char* links; // links[s * num_pages + t]: whether s links to t (small crawls only)
+} crawl_t;
+
+static double now(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+// The most memory the process has held so far, in bytes
+static long peak_memory(void) {
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    return usage.ru_maxrss * 1024L;
+}
+
+static void page_url(int docID, char* url) {
+    sprintf(url, "http://example.test/page%d.html", docID);
+    NormalizeURL(url);
+}
+
+/*
+ * Writes a crawl of num_pages pages with about links_per_page links
+ * each to dir. Pages are deleted (left out of the metadata) now and
+ * then; if c->links is not NULL, the links that count are noted there.
+ */
+static void write_crawl(const char* dir, crawl_t* c, int links_per_page) {
+    pagemeta_t* meta = pagemeta_open((char*)dir, false);
+    linkfile_t* lf = linkfile_open(dir, false);
+    webpage_validators_t val = { "", "" };
+    char url[128];
+    for (int d = 1; d < c->num_pages; d++) {
+        c->live[d] = (rand() % 20 != 0);
+        if (c->live[d]) {
+            page_url(d, url);
+            pagemeta_put(meta, (d == 1) ? "HTTP://Example.test/page1.html" : url, d, 0, &val);
+        }
+    }
+    for (int d = 1; d < c->num_pages; d++) {
+        // Links recorded before the page changed, which no longer count
+        if (rand() % 10 == 0) {
+            page_url(1 + rand() % (c->num_pages - 1), url);
+            linkfile_add(lf, url, "old", 3);
+            linkfile_end(lf, d);
+        }
+    }
+    for (int d = 1; d < c->num_pages; d++) {
+        int n = rand() % (2 * links_per_page + 1);
+        for (int i = 0; i < n; i++) {
+            int t = (rand() % 8 == 0) ? d : 1 + rand() % (c->num_pages - 1);
+            if (rand() % 30 == 0) {
+                linkfile_add(lf, "http://elsewhere.test/", "away", 4);
+                continue;
+            }
+            page_url(t, url);
+            linkfile_add(lf, url, "text", 4);
+            if (i > 0 && rand() % 4 == 0) {
+                linkfile_add(lf, url, "again", 5);
+            }
+            if (c->links != NULL && c->live[d] && c->live[t] && t != d) {
+                c->links[d * c->num_pages + t] = 1;
+            }
+        }
+        linkfile_end(lf, d);
+    }
+    linkfile_close(lf);
+    pagemeta_close(meta);
+}
+
+// Counts the links read, and those of page 2 (for linkfile_apply)
+static void count_helper(int source, const char* url, const char* text, int text_len, bool latest, void* arg) {
+    int* counts = (int*)arg;
+    counts[0]++;
+    counts[1] += (source == 2 && latest && text_len == 5 && memcmp(text, "after", 5) == 0);
+}
+
+// Power iteration over the list of links, one page at a time
+static double* reference_pagerank(const crawl_t* c, int iterations) {
+    int n = c->num_pages, num_live = 0;
+    double* rank = calloc(n, sizeof(double));
+    double* next = calloc(n, sizeof(double));
+    int* out = calloc(n, sizeof(int));
+    for (int s = 1; s < n; s++) {
+        num_live += c->live[s];
+        for (int t = 1; t < n; t++) {
+            out[s] += c->links[s * n + t];
+        }
+    }
+    for (int d = 1; d < n; d++) {
+        rank[d] = c->live[d] ? 1.0 / num_live : 0;
+    }
+    for (int it = 0; it < iterations; it++) {
+        double dangling = 0;
+        for (int s = 1; s < n; s++) {
+            if (c->live[s] && out[s] == 0) {
+                dangling += rank[s];
+            }
+        }
+        for (int t = 1; t < n; t++) {
+            next[t] = 0;
+            if (!c->live[t]) {
+                continue;
+            }
+            next[t] = (1 - DAMPING + DAMPING * dangling) / num_live;
+            for (int s = 1; s < n; s++) {
+                if (c->links[s * n + t]) {
+                    next[t] += DAMPING * rank[s] / out[s];
+                }
+            }
+        }
+        double* swap = rank;
+        rank = next;
+        next = swap;
+    }
+    free(next);
+    free(out);
+    return rank;
+}
+
+int main(int argc, char* argv[]) {
+    int status = 0;
+    printf("Starting linkgraphtest...\n");
+    char dir[] = "/tmp/linkgraphtest.XXXXXX";
+    if (mkdtemp(dir) == NULL) {
+        perror("mkdtemp");
+        return 1;
+    }
+    srand(11);
+
+    // 1. A small crawl
+    crawl_t c = { NUM_PAGES + 1, calloc(NUM_PAGES + 1, sizeof(bool)),
+                  calloc((NUM_PAGES + 1) * (NUM_PAGES + 1), 1) };
+    write_crawl(dir, &c, 6);
+
+    // 2. The graph has the links that count, and no others
+    linkgraph_t* g = linkgraph_load(dir);
+    if (g == NULL) {
+        fprintf(stderr, "FAIL: linkgraph_load() found no graph\n");
+        return 1;
+    }
+    uint32_t expected_links = 0;
+    for (int t = 1; t < c.num_pages && status == 0; t++) {
+        int in = 0, out = 0;
+        for (int s = 1; s < c.num_pages; s++) {
+            in += c.links[s * c.num_pages + t];
+            out += c.links[t * c.num_pages + s];
+        }
+        expected_links += in;
+        bool same = (t < g->size && g->page[t] == c.live[t] && (int)g->out_degree[t] == out
+                     && (int)(g->in_start[t + 1] - g->in_start[t]) == in);
+        for (uint32_t i = g->in_start[t]; same && i < g->in_start[t + 1]; i++) {
+            same = c.links[g->sources[i] * c.num_pages + t];
+        }
+        if (!same) {
+            fprintf(stderr, "FAIL: links of page %d differ\n", t);
+            status = 1;
+        }
+    }
+    if (g->num_links != expected_links) {
+        fprintf(stderr, "FAIL: %u links, expected %u\n", g->num_links, expected_links);
+        status = 1;
+    }
+
+    // 3. PageRank, threaded or not, against the reference
+    int iterations;
+    double* ranks = linkgraph_pagerank(g, DAMPING, 0, 60, 1, &iterations);
+    double* threaded = linkgraph_pagerank(g, DAMPING, 0, 60, 4, NULL);
+    double* expected = reference_pagerank(&c, 60);
+    double sum = 0;
+    for (int d = 1; d < c.num_pages && status == 0; d++) {
+        sum += ranks[d];
+        double diff = ranks[d] - expected[d], tdiff = ranks[d] - threaded[d];
+        if (diff > 1e-12 || diff < -1e-12 || tdiff > 1e-15 || tdiff < -1e-15) {
+            fprintf(stderr, "FAIL: page %d ranks %g (%g with threads), expected %g\n",
+                    d, ranks[d], threaded[d], expected[d]);
+            status = 1;
+        }
+    }
+    if (iterations != 60 || sum < 1 - 1e-9 || sum > 1 + 1e-9) {
+        fprintf(stderr, "FAIL: %d iterations, ranks add up to %.12f\n", iterations, sum);
+        status = 1;
+    }
+
+    // 4. The scores survive a round trip
+    char path[256];
+    snprintf(path, sizeof(path), "%s/ranks", dir);
+    int size = 0;
+    double* scores = NULL;
+    if (linkgraph_saveranks(path, g, ranks) != 0 || (scores = linkgraph_loadranks(path, &size)) == NULL) {
+        fprintf(stderr, "FAIL: ranks not saved and loaded\n");
+        status = 1;
+    }
+    for (int d = 1; scores != NULL && d < c.num_pages && status == 0; d++) {
+        double score = (d < size) ? scores[d] : 0;
+        double want = ranks[d] * g->num_pages;
+        if (score - want > 1e-5 * want || want - score > 1e-5 * want) {
+            fprintf(stderr, "FAIL: page %d scores %g, expected %g\n", d, score, want);
+            status = 1;
+        }
+    }
+    free(scores);
+    free(ranks);
+    free(threaded);
+    free(expected);
+    linkgraph_delete(g);
+    free(c.live);
+    free(c.links);
+
+    // 5. A block cut short by a crash is dropped when the file is reopened
+    linkfile_t* lf = linkfile_open(dir, false);
+    linkfile_add(lf, "http://example.test/a", "before", 6);
+    linkfile_end(lf, 1);
+    linkfile_add(lf, "http://example.test/torn", "torn", 4);
+    linkfile_add(lf, "http://example.test/torn", "torn", 4);
+    linkfile_end(lf, 3);
+    linkfile_close(lf);
+    snprintf(path, sizeof(path), "%s/.links", dir);
+    FILE* fp = fopen(path, "rb+");
+    fseek(fp, 0, SEEK_END);
+    if (ftruncate(fileno(fp), ftell(fp) - 10) != 0) {
+        perror("ftruncate");
+    }
+    fclose(fp);
+    lf = linkfile_open(dir, true);
+    linkfile_add(lf, "http://example.test/b", "after", 5);
+    linkfile_end(lf, 2);
+    linkfile_close(lf);
+    int counts[2] = { 0, 0 };
+    if (linkfile_apply(dir, count_helper, counts) != 2 || counts[0] != 2 || counts[1] != 1) {
+        fprintf(stderr, "FAIL: %d links read after a torn block, expected 2\n", counts[0]);
+        status = 1;
+    }
+
+    // 6. A crawl of a few million links: loading it streams the link file
+    crawl_t big = { BIG_PAGES + 1, calloc(BIG_PAGES + 1, sizeof(bool)), NULL };
+    write_crawl(dir, &big, BIG_LINKS);
+    struct stat st;
+    stat(path, &st);
+    long before = peak_memory();
+    double start = now();
+    g = linkgraph_load(dir);
+    double loaded = now();
+    long grew = peak_memory() - before;
+    ranks = linkgraph_pagerank(g, DAMPING, 1e-9, 200, 0, &iterations);
+    printf("%d pages, %u links: loaded in %.0f ms (%ld MB for a %ld MB link file), ranked in %.0f ms (%d iterations)\n",
+           g->num_pages, g->num_links, (loaded - start) * 1e3, grew >> 20, (long)st.st_size >> 20,
+           (now() - loaded) * 1e3, iterations);
+    if (g->num_links < 2000000 || grew > st.st_size / 2) {
+        fprintf(stderr, "FAIL: loading %u links took %ld bytes\n", g->num_links, grew);
+        status = 1;
+    }
+    free(ranks);
+    linkgraph_delete(g);
+    free(big.live);
+
+    snprintf(path, sizeof(path), "rm -rf %s", dir);
+    if (system(path) != 0) {
+        fprintf(stderr, "Warning: could not remove %s\n", dir);
+    }
+    printf(status == 0 ? "PASS\n" : "FAIL\n");
+    return status;
+}
@@ -0,0 +1,76 @@
+#!/bin/bash
+#
+# mergetest.sh - tests that 'indexmerge' of indexes built from parts of
+# a page directory reproduces the index of the whole of it
+#
+# Author: Insecticide
+# Date: 10-17-2026
+#
+# Usage: ./mergetest.sh [pageDirectory]   (after building ../indexer and ../indexmerge)
+#
+# The pages are split in two at SPLIT: the first part keeps its docIDs,
+# the second is renumbered from 1, as if crawled separately. Merging the
+# two indexes with -o, or with an equivalent -m map, must give the full
+# index byte for byte.
+
+INDEXER="../indexer/indexer"
+MERGE="../indexmerge/indexmerge"
+SOURCE="${1:-../pages}"
+SPLIT=40
+WORK="$(mktemp -d)"
+
+fail() {
+    echo "FAIL: $1"
+    exit 1
+}
+
+for exe in "$INDEXER" "$MERGE"; do
+    if [ ! -x "$exe" ]; then
+        echo "FAIL: Executable '$exe' not found. Please compile it first with 'make'."
+        exit 1
+    fi
+done
+trap 'rm -rf "$WORK"' EXIT
+
+echo "Starting mergetest..."
+
+# 1. The two parts, and an index of each and of the whole, stemmed and
+#    with stopwords so that bitmaps are merged too
+mkdir -p "$WORK/a" "$WORK/b"
+for f in "$SOURCE"/[0-9]*; do
+    id=$(basename "$f")
+    if [ "$id" -le "$SPLIT" ]; then
+        cp "$f" "$WORK/a/$id"
+    else
+        cp "$f" "$WORK/b/$((id - SPLIT))"
+        echo "$((id - SPLIT)) $id" >> "$WORK/b.map"
+    fi
+done
+OPTS="--stem --stopwords ../indexer/stopwords.txt"
+"$INDEXER" "$WORK/a" "$WORK/a.idx" $OPTS > /dev/null 2>&1 || fail "indexing the first part failed"
+"$INDEXER" "$WORK/b" "$WORK/b.idx" $OPTS > /dev/null 2>&1 || fail "indexing the second part failed"
+"$INDEXER" "$SOURCE" "$WORK/full.idx" $OPTS > /dev/null 2>&1 || fail "indexing the whole failed"
+LC_ALL=C sort -c "$WORK/full.idx" || fail "the indexer did not save the words in order"
+
+# 2. Merged by offset, and by map
+"$MERGE" "$WORK/merged.idx" "$WORK/a.idx" -o "$SPLIT" "$WORK/b.idx" > /dev/null || fail "merge by offset failed"
+cmp -s "$WORK/merged.idx" "$WORK/full.idx" || fail "merge by offset differs from the full index"
+"$MERGE" "$WORK/mapped.idx" -m "$WORK/b.map" "$WORK/b.idx" -o 0 "$WORK/a.idx" > /dev/null || fail "merge by map failed"
+cmp -s "$WORK/mapped.idx" "$WORK/full.idx" || fail "merge by map differs from the full index"
+
+# 3. Inputs that cannot be merged, and leave no output
+"$MERGE" "$WORK/clash.idx" "$WORK/a.idx" "$WORK/a.idx" > /dev/null 2>&1 && fail "docIDs on two inputs were merged"
+[ -e "$WORK/clash.idx" ] && fail "a failed merge left its output"
+printf 'the * 02\n' > "$WORK/stop.idx"
+printf 'zebra 1 1\n' > "$WORK/zebra.idx"
+"$MERGE" "$WORK/x.idx" "$WORK/stop.idx" "$WORK/zebra.idx" 2>&1 | grep -q "both have docID 1" \
+    || fail "a docID on two inputs with no word in common was merged"
+printf '1 50\n2 50\n' > "$WORK/dup.map"
+"$MERGE" "$WORK/x.idx" -m "$WORK/dup.map" "$WORK/a.idx" > /dev/null 2>&1 && fail "a map giving two pages one docID was used"
+(head -1 "$WORK/a.idx"; tail -n +2 "$WORK/a.idx" | sort -r) > "$WORK/unsorted.idx"
+"$MERGE" "$WORK/x.idx" "$WORK/unsorted.idx" 2>&1 | grep -q "not sorted" || fail "an unsorted input was merged"
+"$INDEXER" "$WORK/b" "$WORK/lower.idx" > /dev/null 2>&1 || fail "indexing without stemming failed"
+"$MERGE" "$WORK/x.idx" "$WORK/a.idx" -o "$SPLIT" "$WORK/lower.idx" > /dev/null 2>&1 && fail "indexes of two analyzers were merged"
+
+echo "PASS: the merged indexes match the index of all the pages."
+exit 0
@@ -0,0 +1,215 @@
+/*
+ * pagebench.c - benchmark of compressed page storage
+ *
+ * Author: Insecticide
+ * Date: 10-17-2026
+ *
+ * Usage: ./pagebench <pageDirectory> [maxPages]
+ *
+ * Description:
+ * 1. Loads pages 1..maxPages (default 1000) from <pageDirectory> and
+ *    trains a dictionary on them.
+ * 2. Saves them into a scratch directory three ways: plain html,
+ *    deflated, and deflated with the dictionary.
+ * 3. For each, reports the bytes on disk and how fast pageload() and
+ *    pagemap() read the pages back (MB of html per second), and the
+ *    indexer's loader (pagedir_open()) with 1 and with 4 threads,
+ *    checking that every page comes back unchanged.
+ * 4. Checks pagemap() on pages of the sizes that take each of its
+ *    paths, among them one whose file ends on a memory page boundary,
+ *    where its html cannot be used in place.
+ * 5. Reports PASS/FAIL and cleans up.
+ */
+
+#define _POSIX_C_SOURCE 200809L // clock_gettime, open
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <zlib.h>
+#include "webpage.h"
+#include "pageio.h"
+#include "pagedict.h"
+#include "pagedir.h"
+
+#define BENCH_DIR "bench_pages"
+#define LOAD_ROUNDS 5 // times every page is loaded, per storage mode
+#define DIR_THREADS 4 // loader threads, against one
+
+static double now(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+// Loads the saved pages with load, LOAD_ROUNDS times, checking them;
+// returns the seconds it took, or -1 if a page came back changed
+static double time_loads(webpage_t *(*load)(int, char *), const char *name, webpage_t **pages, int num_pages) {
+    int status = 0;
+    double start = now();
+    for (int round = 0; round < LOAD_ROUNDS; round++) {
+        for (int i = 0; i < num_pages; i++) {
+            webpage_t *page = load(i + 1, BENCH_DIR);
+            if (page == NULL || webpage_getHTMLlen(page) != webpage_getHTMLlen(pages[i]) ||
+                memcmp(webpage_getHTML(page), webpage_getHTML(pages[i]), webpage_getHTMLlen(page) + 1) != 0) {
+                fprintf(stderr, "FAIL: page %d did not load back unchanged (%s)\n", i + 1, name);
+                status = 1;
+            }
+            webpage_delete(page);
+        }
+    }
+    return status == 0 ? now() - start : -1;
+}
+
+// Loads the saved pages through a pagedir_t with num_threads threads,
+// LOAD_ROUNDS times, checking them; returns the seconds it took, or -1
+// if a page came back changed
+static double time_dir_loads(int num_threads, const char *name, webpage_t **pages, int num_pages) {
+    int *ids = malloc(num_pages * sizeof(int));
+    for (int i = 0; i < num_pages; i++) {
+        ids[i] = i + 1;
+    }
+    int status = 0;
+    double start = now();
+    for (int round = 0; round < LOAD_ROUNDS; round++) {
+        pagedir_t *pd = pagedir_open(BENCH_DIR, ids, num_pages, num_threads);
+        int docID, count = 0;
+        webpage_t *page;
+        while (pd != NULL && pagedir_next(pd, &docID, &page)) {
+            webpage_t *want = pages[docID - 1];
+            if (page == NULL || webpage_getHTMLlen(page) != webpage_getHTMLlen(want) ||
+                memcmp(webpage_getHTML(page), webpage_getHTML(want), webpage_getHTMLlen(want) + 1) != 0) {
+                fprintf(stderr, "FAIL: page %d did not load back unchanged (%s, %d threads)\n",
+                        docID, name, num_threads);
+                status = 1;
+            }
+            webpage_delete(page);
+            count++;
+        }
+        pagedir_close(pd);
+        if (count != num_pages) {
+            fprintf(stderr, "FAIL: %d of %d pages loaded (%s, %d threads)\n", count, num_pages, name, num_threads);
+            status = 1;
+        }
+    }
+    free(ids);
+    return status == 0 ? now() - start : -1;
+}
+
+// Saves pages with codec, measures and checks loading; returns 0 on PASS
+static int bench(const char *name, webpage_t **pages, int num_pages, const page_codec_t *codec) {
+    char filepath[256];
+    long raw_bytes = 0, disk_bytes = 0;
+
+    for (int i = 0; i < num_pages; i++) {
+        snprintf(filepath, sizeof(filepath), "%s/%d", BENCH_DIR, i + 1);
+        int fd = open(filepath, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+        if (fd < 0 || pagewrite(pages[i], fd, codec) != 0) {
+            fprintf(stderr, "FAIL: could not save page %d (%s)\n", i + 1, name);
+            return 1;
+        }
+        close(fd);
+
+        struct stat st;
+        stat(filepath, &st);
+        disk_bytes += st.st_size;
+        raw_bytes += webpage_getHTMLlen(pages[i]);
+    }
+
+    double loaded = time_loads(pageload, name, pages, num_pages);
+    double mapped = time_loads(pagemap, name, pages, num_pages);
+    double dir_one = time_dir_loads(1, name, pages, num_pages);
+    double dir_many = time_dir_loads(DIR_THREADS, name, pages, num_pages);
+    printf("%-12s %10ld bytes on disk (%5.1f%% of html)  load %8.1f MB/s  map %8.1f MB/s"
+           "  dir x1 %8.1f MB/s  x%d %8.1f MB/s\n", name, disk_bytes,
+           100.0 * disk_bytes / raw_bytes, LOAD_ROUNDS * raw_bytes / 1e6 / loaded,
+           LOAD_ROUNDS * raw_bytes / 1e6 / mapped, LOAD_ROUNDS * raw_bytes / 1e6 / dir_one,
+           DIR_THREADS, LOAD_ROUNDS * raw_bytes / 1e6 / dir_many);
+    return loaded < 0 || mapped < 0 || dir_one < 0 || dir_many < 0;
+}
+
+// Saves a page whose file is file_size bytes long; returns 0 if
+// pagemap() loads it back unchanged, and NUL-terminated
+static int check_mapped(long file_size) {
+    const char *url = "http://example.test/";
+    int html_len = file_size;
+    while (html_len + snprintf(NULL, 0, "%s\n0\n%d\n", url, html_len) > file_size) {
+        html_len--;
+    }
+    char *html = malloc(html_len + 1);
+    memset(html, 'x', html_len);
+    html[html_len] = '\0';
+    webpage_t *page = webpage_new((char *)url, 0, html);
+    int status = pagesave(page, 1, BENCH_DIR);
+
+    webpage_t *mapped = pagemap(1, BENCH_DIR);
+    if (status != 0 || mapped == NULL || webpage_getHTMLlen(mapped) != html_len ||
+        memcmp(webpage_getHTML(mapped), html, html_len + 1) != 0) {
+        fprintf(stderr, "FAIL: a %ld-byte page file did not map back unchanged\n", file_size);
+        status = 1;
+    }
+    webpage_delete(mapped);
+    webpage_delete(page);
+    return status;
+}
+
+int main(int argc, char *argv[]) {
+    if (argc != 2 && argc != 3) {
+        fprintf(stderr, "Usage: %s <pageDirectory> [maxPages]\n", argv[0]);
+        return 1;
+    }
+    char *pageDir = argv[1];
+    int maxPages = (argc == 3) ? atoi(argv[2]) : 1000;
+
+    printf("Starting pagebench...\n");
+
+    webpage_t **pages = malloc(maxPages * sizeof(webpage_t *));
+    int num_pages = 0;
+    while (num_pages < maxPages && (pages[num_pages] = pageload(num_pages + 1, pageDir)) != NULL) {
+        num_pages++;
+    }
+    if (num_pages == 0) {
+        fprintf(stderr, "FAIL: no pages to load from %s\n", pageDir);
+        free(pages);
+        return 1;
+    }
+    pagedict_t *dict = pagedict_train(pageDir, num_pages);
+    printf("%d pages, %d-byte dictionary\n", num_pages, dict ? dict->len : 0);
+
+    mkdir(BENCH_DIR, 0755);
+    page_codec_t plain = { 0, NULL };
+    page_codec_t zlib = { Z_DEFAULT_COMPRESSION, NULL };
+    page_codec_t zlib_dict = { Z_DEFAULT_COMPRESSION, dict };
+
+    int status = bench("plain", pages, num_pages, &plain);
+    status |= bench("zlib", pages, num_pages, &zlib);
+    if (dict != NULL) {
+        pagedict_save(dict, BENCH_DIR "/" PAGEDICT_FILE);
+        status |= bench("zlib+dict", pages, num_pages, &zlib_dict);
+    }
+    // Read whole, read past the header's block, mapped but ending on a
+    // memory page boundary (copied), mapped and used in place
+    long sizes[] = { 100, PAGEIO_HEADMAX + 100, PAGEIO_MAPMIN, PAGEIO_MAPMIN + 1 };
+    for (int i = 0; i < 4; i++) {
+        status |= check_mapped(sizes[i]);
+    }
+
+    printf("Cleaning up...\n");
+    char filepath[256];
+    for (int i = 0; i < num_pages; i++) {
+        snprintf(filepath, sizeof(filepath), "%s/%d", BENCH_DIR, i + 1);
+        remove(filepath);
+        webpage_delete(pages[i]);
+    }
+    remove(BENCH_DIR "/" PAGEDICT_FILE);
+    rmdir(BENCH_DIR);
+    free(pages);
+    pagedict_delete(dict);
+
+    printf(status == 0 ? "PASS: every storage mode loads pages back unchanged.\n" : "FAIL\n");
+    return status;
+}
@@ -0,0 +1,211 @@
+/*
+ * pagewritertest.c - test program for the 'pagewriter' and 'bqueue'
+ * modules
+ *
+ * Author: Insecticide
+ * Date: 10-17-2026
+ *
+ * Usage: ./pagewritertest
+ *
+ * Description:
+ * 1. Checks that bqtryget() takes queued elements in order and returns
+ *    NULL at once from an empty queue, and that bqget() returns NULL
+ *    once the queue is done and drained.
+ * 2. Under each fsync policy (none, batch, each), and compressed under
+ *    batch, writes pages of many sizes through a writer with a short
+ *    queue, so that the crawler's side blocks and the writer takes
+ *    batches. Every so often it waits for the pages so far, as the
+ *    crawler does before committing a checkpoint, and checks that each
+ *    of them loads back as it was put. One page's file cannot be
+ *    created (a directory is in the way): it must be counted as failed
+ *    by pagewriter_finish(), and still as written, so that waiting for
+ *    it does not block. No temporary file may be left behind.
+ * 3. Rewrites some of the pages, as a recrawl does, and checks that
+ *    they load back as rewritten.
+ * 4. Checks that a writer into a missing directory fails every page.
+ * 5. Reports how long each policy took, and PASS/FAIL.
+ */
+
+#define _POSIX_C_SOURCE 200809L // clock_gettime, mkdtemp
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <dirent.h>
+#include <sys/stat.h>
+#include "webpage.h"
+#include "pageio.h"
+#include "pagewriter.h"
+#include "bqueue.h"
+
+#define NUM_PAGES 300
+#define QUEUE_DEPTH 8
+#define WAIT_EVERY 37 // pages between two waits, as between checkpoints
+#define BLOCKED_ID 7  // the page whose file cannot be created
+#define NUM_REWRITTEN 20
+
+static int failures = 0;
+
+static void check(int ok, const char *what) {
+    if (!ok) {
+        fprintf(stderr, "FAIL: %s\n", what);
+        failures++;
+    }
+}
+
+static double now(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+// The html of page id: its length varies, one is large enough for pagemap to map
+static char *page_html(int id) {
+    int len = (id == 100) ? 300000 : (id * 7919) % 6000;
+    char *html = malloc(len + 1);
+    for (int i = 0; i < len; i++) {
+        html[i] = (i % 11 == 10) ? ' ' : 'a' + (id + i) % 26;
+    }
+    html[len] = '\0';
+    return html;
+}
+
+static webpage_t *make_page(int id) {
+    char url[64];
+    snprintf(url, sizeof(url), "http://example.test/%d.html", id);
+    return webpage_new(url, id % 4, page_html(id));
+}
+
+// Whether page id loads back from dir as make_page(made) made it
+static int loads_back(char *dir, int id, int made) {
+    webpage_t *page = pageload(id, dir);
+    if (page == NULL) {
+        return 0;
+    }
+    char url[64];
+    snprintf(url, sizeof(url), "http://example.test/%d.html", made);
+    char *html = page_html(made);
+    int ok = strcmp(webpage_getURL(page), url) == 0 && webpage_getDepth(page) == made % 4 &&
+             webpage_getHTMLlen(page) == (int)strlen(html) && strcmp(webpage_getHTML(page), html) == 0;
+    free(html);
+    webpage_delete(page);
+    return ok;
+}
+
+// The number of files in dir whose names start with '.', but . and ..
+static int hidden_files(const char *dir) {
+    DIR *d = opendir(dir);
+    int count = 0;
+    struct dirent *entry;
+    while (d != NULL && (entry = readdir(d)) != NULL) {
+        count += (entry->d_name[0] == '.' && strcmp(entry->d_name, ".") != 0 && strcmp(entry->d_name, "..") != 0);
+    }
+    if (d != NULL) {
+        closedir(d);
+    }
+    return count;
+}
+
+// Writes NUM_PAGES pages into a fresh directory under base with policy and codec
+static void run_policy(const char *base, const char *name, pagewriter_fsync_t policy, const page_codec_t *codec) {
+    char dir[256], what[320];
+    snprintf(dir, sizeof(dir), "%s/%s", base, name);
+    mkdir(dir, 0755);
+    char blocked[300];
+    snprintf(blocked, sizeof(blocked), "%s/%d", dir, BLOCKED_ID);
+    mkdir(blocked, 0755);
+
+    double start = now();
+    pagewriter_t *pw = pagewriter_start(dir, QUEUE_DEPTH, policy, codec);
+    if (pw == NULL) {
+        snprintf(what, sizeof(what), "%s: writer not started", name);
+        check(0, what);
+        return;
+    }
+    int bad = 0;
+    for (int id = 1; id <= NUM_PAGES; id++) {
+        check(pagewriter_put(pw, make_page(id), id) == 0, "a page was not queued");
+        if (id % WAIT_EVERY == 0) {
+            pagewriter_wait(pw, id);
+            for (int i = 1; i <= id; i++) {
+                bad += (i != BLOCKED_ID && !loads_back(dir, i, i));
+            }
+        }
+    }
+    pagewriter_wait(pw, NUM_PAGES);
+    int failed = pagewriter_finish(pw);
+    double elapsed = now() - start;
+
+    for (int id = 1; id <= NUM_PAGES; id++) {
+        bad += (id != BLOCKED_ID && !loads_back(dir, id, id));
+    }
+    snprintf(what, sizeof(what), "%s: %d pages did not load back as written", name, bad);
+    check(bad == 0, what);
+    snprintf(what, sizeof(what), "%s: %d pages failed, expected 1", name, failed);
+    check(failed == 1, what);
+    snprintf(what, sizeof(what), "%s: a temporary file was left behind", name);
+    check(hidden_files(dir) == 0, what);
+
+    // 3. The pages after the blocked one rewritten as pages NUM_PAGES + 1..
+    pw = pagewriter_start(dir, QUEUE_DEPTH, policy, codec);
+    for (int id = BLOCKED_ID + 1; pw != NULL && id <= BLOCKED_ID + NUM_REWRITTEN; id++) {
+        pagewriter_put(pw, make_page(NUM_PAGES + id), id);
+    }
+    snprintf(what, sizeof(what), "%s: a rewritten page failed", name);
+    check(pw != NULL && pagewriter_finish(pw) == 0, what);
+    for (int id = BLOCKED_ID + 1; id <= BLOCKED_ID + NUM_REWRITTEN; id++) {
+        bad += !loads_back(dir, id, NUM_PAGES + id);
+    }
+    snprintf(what, sizeof(what), "%s: %d rewritten pages did not load back as rewritten", name, bad);
+    check(bad == 0, what);
+    printf("%-11s %d pages in %.0f ms\n", name, NUM_PAGES, elapsed * 1e3);
+}
+
+int main(int argc, char *argv[]) {
+    printf("Starting pagewritertest...\n");
+    char base[] = "/tmp/pagewritertest.XXXXXX";
+    if (mkdtemp(base) == NULL) {
+        perror("mkdtemp");
+        return 1;
+    }
+
+    // 1. The queue's non-blocking side
+    int values[3] = { 1, 2, 3 };
+    bqueue_t *bq = bqopen(4);
+    check(bqtryget(bq) == NULL, "bqtryget() of an empty queue returned an element");
+    for (int i = 0; i < 3; i++) {
+        bqput(bq, &values[i]);
+    }
+    check(bqtryget(bq) == &values[0] && bqtryget(bq) == &values[1], "bqtryget() out of order");
+    bqdone(bq);
+    check(bqget(bq) == &values[2], "bqget() lost an element left when the queue was done");
+    check(bqget(bq) == NULL && bqtryget(bq) == NULL, "a done, drained queue returned an element");
+    check(bqput(bq, &values[0]) != 0, "bqput() accepted an element after bqdone()");
+    bqclose(bq);
+
+    // 2. Every policy, and compressed pages
+    page_codec_t zlib = { 6, NULL };
+    run_policy(base, "none", PW_FSYNC_NONE, NULL);
+    run_policy(base, "batch", PW_FSYNC_BATCH, NULL);
+    run_policy(base, "each", PW_FSYNC_EACH, NULL);
+    run_policy(base, "batch-zlib", PW_FSYNC_BATCH, &zlib);
+
+    // 4. Nowhere to write
+    char missing[300];
+    snprintf(missing, sizeof(missing), "%s/missing", base);
+    pagewriter_t *pw = pagewriter_start(missing, QUEUE_DEPTH, PW_FSYNC_BATCH, NULL);
+    for (int id = 1; pw != NULL && id <= 10; id++) {
+        pagewriter_put(pw, make_page(id), id);
+    }
+    pagewriter_wait(pw, 10);
+    check(pw != NULL && pagewriter_finish(pw) == 10, "pages written to a missing directory were not all failed");
+
+    char cmd[300];
+    snprintf(cmd, sizeof(cmd), "rm -rf %s", base);
+    if (system(cmd) != 0) {
+        fprintf(stderr, "Warning: could not remove %s\n", base);
+    }
+    printf(failures == 0 ? "PASS\n" : "FAIL\n");
+    return failures != 0;
+}
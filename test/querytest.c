@@ -0,0 +1,403 @@
+/*
+ * querytest.c - test program for the 'querytree' module
+ *
+ * Author: Insecticide
+ * Date: 10-17-2026
+ *
+ * Usage: ./querytest pageDirectory
+ *
+ * Description:
+ * 1. Indexes the pages of <pageDirectory>, with a few stopwords, and
+ *    credits each page with the anchor text of a made-up link.
+ * 2. Builds random queries of indexed and unknown words and stopwords,
+ *    nested "and", "or" and "not", and checks that the iterator tree
+ *    returns the same pages, with the same ranks (title, description
+ *    and anchor boosts included) and in increasing order, as evaluating the query
+ *    on each page in turn does.
+ * 3. Checks that phrases taken from the pages find exactly the pages
+ *    where their words appear in sequence, ranked by how often.
+ * 4. Checks that malformed queries are rejected.
+ * 5. Checks that the words of a page's description set its DESC field
+ *    but are not counted.
+ * 6. Reports how long the random queries took, and PASS/FAIL.
+ */
+
+#define _POSIX_C_SOURCE 200809L // clock_gettime
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "webpage.h"
+#include "pageio.h"
+#include "index.h"
+#include "tokenize.h"
+#include "querytree.h"
+
+#define MAX_PAGES 1000
+#define NUM_QUERIES 3000
+#define NUM_PHRASES 200
+#define MAX_TOKENS 100
+#define MAX_DEPTH 3
+
+static const char* stopwords[] = { "the", "for", "with", "that" };
+
+// A random query, as the test sees it
+typedef enum { E_WORD, E_AND, E_OR, E_ANDNOT } expr_type_t;
+
+typedef struct expr {
+    expr_type_t type;
+    const char* word;
+    struct expr* left;
+    struct expr* right;
+} expr_t;
+
+// The words of every page, analyzed, for the phrase checks
+typedef struct page_words {
+    char* lower;
+    const char** words;
+    int num_words;
+} page_words_t;
+
+static hashtable_t* g_index;
+static char** g_vocab;
+static int g_vocab_len;
+static int g_count;
+static const field_boosts_t g_boosts = { 3, 2, 4 }; // for the random queries
+
+static double now(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static bool search_word(void* elementp, const void* keyp) {
+    return strcmp(((word_entry_t*)elementp)->word, (const char*)keyp) == 0;
+}
+
+static bool search_doc(void* elementp, const void* keyp) {
+    return ((doc_entry_t*)elementp)->docID == *(const int*)keyp;
+}
+
+static void count_word(void* data) {
+    g_count++;
+}
+
+static void collect_word(void* data) {
+    g_vocab[g_vocab_len++] = ((word_entry_t*)data)->word;
+}
+
+// Checks the count and fields of word's posting on page 1 of index
+static int check_posting(hashtable_t* index, const char* word, int count, int fields) {
+    word_entry_t* entry = hsearch(index, search_word, word, strlen(word));
+    int docID = 1;
+    doc_entry_t* doc = (entry != NULL) ? qsearch(entry->docs, search_doc, &docID) : NULL;
+    if (doc == NULL || doc->count != count || doc->fields != fields) {
+        fprintf(stderr, "FAIL: '%s' has count %d and fields %x, not %d and %x\n", word,
+                doc ? doc->count : -1, doc ? doc->fields : 0, count, fields);
+        return 1;
+    }
+    return 0;
+}
+
+static expr_t* random_expr(int depth) {
+    expr_t* e = calloc(1, sizeof(expr_t));
+    int r = rand() % 10;
+    if (depth >= MAX_DEPTH || r < 4) {
+        e->type = E_WORD;
+        int w = rand() % 20;
+        if (w == 0) {
+            e->word = "zzzunknown";
+        } else if (w < 4) {
+            e->word = stopwords[rand() % (sizeof(stopwords) / sizeof(stopwords[0]))];
+        } else {
+            e->word = g_vocab[rand() % (g_vocab_len < 300 ? g_vocab_len : 300)];
+        }
+        return e;
+    }
+    e->type = (r < 6) ? E_AND : (r < 8) ? E_OR : E_ANDNOT;
+    e->left = random_expr(depth + 1);
+    e->right = random_expr(depth + 1);
+    return e;
+}
+
+static void free_expr(expr_t* e) {
+    if (e != NULL) {
+        free_expr(e->left);
+        free_expr(e->right);
+        free(e);
+    }
+}
+
+// Writes e as tokens, with every operator in parentheses
+static void render(const expr_t* e, char* tokens[], int* n) {
+    static char* ops[] = { NULL, "and", "or", "not" };
+    if (e->type == E_WORD) {
+        tokens[(*n)++] = (char*)e->word;
+        return;
+    }
+    tokens[(*n)++] = "(";
+    render(e->left, tokens, n);
+    tokens[(*n)++] = ops[e->type];
+    render(e->right, tokens, n);
+    tokens[(*n)++] = ")";
+}
+
+/*
+ * Evaluates e on page docID the long way: a posting search per word.
+ * Returns whether it matches; *score gets its rank, 0 if it only
+ * filters (stopwords).
+ */
+static bool evaluate(const expr_t* e, int docID, int* score) {
+    int a, b;
+    switch (e->type) {
+    case E_WORD: {
+        word_entry_t* entry = hsearch(g_index, search_word, e->word, strlen(e->word));
+        *score = 0;
+        if (entry == NULL) {
+            return false;
+        } else if (entry->stopbits != NULL) {
+            return index_stopbit(entry, docID);
+        }
+        doc_entry_t* doc = qsearch(entry->docs, search_doc, &docID);
+        if (doc != NULL) {
+            *score = doc->count + ((doc->fields & FIELD_TITLE) ? g_boosts.title : 0)
+                     + ((doc->fields & FIELD_DESC) ? g_boosts.description : 0)
+                     + ((doc->fields & FIELD_ANCHOR) ? g_boosts.anchor : 0);
+        }
+        return doc != NULL;
+    }
+    case E_AND:
+        if (!evaluate(e->left, docID, &a) || !evaluate(e->right, docID, &b)) {
+            return false;
+        }
+        *score = (a == 0) ? b : (b == 0) ? a : (a < b ? a : b);
+        return true;
+    case E_OR: {
+        bool left = evaluate(e->left, docID, &a);
+        bool right = evaluate(e->right, docID, &b);
+        *score = (left ? (a ? a : 1) : 0) + (right ? (b ? b : 1) : 0);
+        return left || right;
+    }
+    default:
+        return evaluate(e->left, docID, score) && !evaluate(e->right, docID, &b);
+    }
+}
+
+// Places on page p where words[0..n) follow one another
+static int count_phrase(const page_words_t* p, char* words[], int n) {
+    int count = 0;
+    for (int i = 0; i + n <= p->num_words; i++) {
+        int j = 0;
+        while (j < n && strcmp(p->words[i + j], words[j]) == 0) {
+            j++;
+        }
+        count += (j == n);
+    }
+    return count;
+}
+
+int main(int argc, char* argv[]) {
+    if (argc != 2) {
+        fprintf(stderr, "Usage: %s pageDirectory\n", argv[0]);
+        return 1;
+    }
+    int status = 0;
+    printf("Starting querytest...\n");
+
+    // 1. Index the pages, and keep their words for the phrases
+    g_index = index_new();
+    static page_words_t pages[MAX_PAGES + 1];
+    int max_doc = 0;
+    for (int id = 1; id <= MAX_PAGES; id++) {
+        webpage_t* page = pageload(id, argv[1]);
+        if (page == NULL) {
+            continue;
+        }
+        index_addpage(g_index, page, id, ANALYZER_LOWER);
+        int len = webpage_getHTMLlen(page);
+        page_words_t* p = &pages[id];
+        p->lower = malloc(len + 1);
+        p->words = malloc((len / 2 + 1) * sizeof(char*));
+        tokenizer_t tk;
+        tokenizer_init(&tk, webpage_getHTML(page), len, p->lower);
+        const char* word;
+        int word_len;
+        while (tokenizer_next(&tk, &word, &word_len) > 0) {
+            p->words[p->num_words++] = word;
+        }
+        webpage_delete(page);
+        max_doc = id;
+    }
+    for (int i = 0; i < (int)(sizeof(stopwords) / sizeof(stopwords[0])); i++) {
+        index_addstopword(g_index, stopwords[i]);
+    }
+    happly(g_index, count_word);
+    g_vocab = malloc(g_count * sizeof(char*));
+    happly(g_index, collect_word);
+
+    // Anchor text of three known words for every page, after its own words
+    srand(7);
+    for (int id = 1; id <= max_doc; id++) {
+        if (pages[id].lower == NULL) {
+            continue;
+        }
+        char text[512];
+        snprintf(text, sizeof(text), "%.160s %.160s %.160s", g_vocab[rand() % g_vocab_len],
+                 g_vocab[rand() % g_vocab_len], g_vocab[rand() % g_vocab_len]);
+        index_addanchor(g_index, text, strlen(text), id, ANALYZER_LOWER);
+    }
+    index_sortpostings(g_index);
+
+    // 2. Random queries against evaluating them page by page
+    srand(42);
+    double query_time = 0;
+    long matches = 0;
+    for (int q = 0; q < NUM_QUERIES && status == 0; q++) {
+        expr_t* e = random_expr(0);
+        char* tokens[MAX_TOKENS];
+        int n = 0;
+        render(e, tokens, &n);
+
+        const char* error = NULL;
+        double start = now();
+        querytree_t* query = querytree_compile(g_index, NULL, tokens, n, argv[1], ANALYZER_LOWER, &g_boosts, &error);
+        int found[MAX_PAGES + 1], ranks[MAX_PAGES + 1], num_found = 0;
+        int docID, rank;
+        while (query != NULL && (docID = querytree_next(query, &rank)) >= 0 && num_found <= MAX_PAGES) {
+            found[num_found] = docID;
+            ranks[num_found++] = rank;
+        }
+        query_time += now() - start;
+        querytree_delete(query);
+
+        if (query == NULL) {
+            fprintf(stderr, "FAIL: query %d rejected (%s)\n", q, error);
+            status = 1;
+        }
+
+        int k = 0;
+        for (int doc = 1; doc <= max_doc && status == 0; doc++) {
+            int score;
+            if (evaluate(e, doc, &score)) {
+                if (score == 0) {
+                    score = 1;
+                }
+                if (k >= num_found || found[k] != doc || ranks[k] != score) {
+                    fprintf(stderr, "FAIL: query %d: page %d (rank %d) was %s\n", q, doc, score,
+                            (k < num_found && found[k] == doc) ? "ranked differently" : "missed");
+                    status = 1;
+                }
+                k++;
+            }
+        }
+        if (status == 0 && k != num_found) {
+            fprintf(stderr, "FAIL: query %d matched %d pages too many\n", q, num_found - k);
+            status = 1;
+        }
+        if (status != 0) {
+            for (int i = 0; i < n; i++) {
+                fprintf(stderr, "%s ", tokens[i]);
+            }
+            fprintf(stderr, "\n");
+        }
+        matches += num_found;
+        free_expr(e);
+    }
+
+    // 3. Phrases of 2 to 4 words from the pages
+    for (int t = 0; t < NUM_PHRASES && status == 0; t++) {
+        int id = 1 + rand() % max_doc;
+        page_words_t* p = &pages[id];
+        int n = 2 + rand() % 3;
+        if (p->num_words < n) {
+            continue;
+        }
+        int at = rand() % (p->num_words - n + 1);
+        char* tokens[MAX_TOKENS];
+        int num_tokens = 0;
+        tokens[num_tokens++] = "\"";
+        for (int i = 0; i < n; i++) {
+            tokens[num_tokens++] = (char*)p->words[at + i];
+        }
+        tokens[num_tokens++] = "\"";
+
+        const char* error = NULL;
+        querytree_t* query = querytree_compile(g_index, NULL, tokens, num_tokens, argv[1], ANALYZER_LOWER, NULL, &error);
+        if (query == NULL) {
+            fprintf(stderr, "FAIL: phrase %d rejected (%s)\n", t, error);
+            status = 1;
+            break;
+        }
+        bool indexed = false; // a phrase of nothing but short words finds nothing
+        for (int i = 0; i < n; i++) {
+            indexed |= (int)strlen(p->words[at + i]) >= MIN_WORD_LEN;
+        }
+        int docID, rank, doc = 1;
+        while ((docID = querytree_next(query, &rank)) >= 0 && status == 0) {
+            for (; doc < docID && status == 0; doc++) {
+                if (count_phrase(&pages[doc], &tokens[1], n) > 0) {
+                    fprintf(stderr, "FAIL: phrase %d missed page %d\n", t, doc);
+                    status = 1;
+                }
+            }
+            if (status == 0 && count_phrase(&pages[docID], &tokens[1], n) != rank) {
+                fprintf(stderr, "FAIL: phrase %d ranked page %d %d, not %d\n", t, docID, rank,
+                        count_phrase(&pages[docID], &tokens[1], n));
+                status = 1;
+            }
+            doc = docID + 1;
+        }
+        for (; doc <= max_doc && status == 0 && indexed; doc++) {
+            if (count_phrase(&pages[doc], &tokens[1], n) > 0) {
+                fprintf(stderr, "FAIL: phrase %d missed page %d\n", t, doc);
+                status = 1;
+            }
+        }
+        querytree_delete(query);
+    }
+
+    // 4. Malformed queries
+    static char* malformed[][4] = {
+        { "and", "dog" }, { "dog", "or" }, { "dog", "and", "or", "cat" }, { "not", "dog" },
+        { "dog", "or", "not", "cat" }, { "(", "dog" }, { "dog", ")" }, { "(", ")" },
+        { "\"", "dog" }, { "\"", "\"" }, { "\"", "(", "dog", "\"" }, { "not", "not", "dog" }
+    };
+    for (int i = 0; i < (int)(sizeof(malformed) / sizeof(malformed[0])); i++) {
+        int n = 0;
+        while (n < 4 && malformed[i][n] != NULL) {
+            n++;
+        }
+        const char* error = NULL;
+        querytree_t* query = querytree_compile(g_index, NULL, malformed[i], n, argv[1], ANALYZER_LOWER, NULL, &error);
+        if (query != NULL || error == NULL) {
+            fprintf(stderr, "FAIL: malformed query %d was accepted\n", i);
+            querytree_delete(query);
+            status = 1;
+        }
+    }
+
+    // 5. A description's words mark the field, and leave the counts alone
+    hashtable_t* described = index_new();
+    const char* html = "<html><head><title>Fruit</title><meta name=\"description\" content=\"kumquat lychee\">"
+                       "</head><body>lychee lychee</body></html>";
+    char* copy = malloc(strlen(html) + 1);
+    strcpy(copy, html);
+    webpage_t* page = webpage_new("http://test/", 0, copy);
+    index_addpage(described, page, 1, ANALYZER_LOWER);
+    webpage_delete(page);
+    status |= check_posting(described, "lychee", 2, FIELD_BODY | FIELD_DESC);
+    status |= check_posting(described, "kumquat", 0, FIELD_DESC);
+    index_delete(described);
+
+    printf("%d random queries, %ld matches: %.1f us/query\n", NUM_QUERIES, matches, query_time * 1e6 / NUM_QUERIES);
+
+    for (int id = 1; id <= max_doc; id++) {
+        free(pages[id].lower);
+        free(pages[id].words);
+    }
+    free(g_vocab);
+    index_delete(g_index);
+    printf(status == 0 ? "PASS: the iterator tree matches page-by-page evaluation.\n" : "FAIL\n");
+    return status;
+}
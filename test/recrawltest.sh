@@ -0,0 +1,190 @@
+#!/bin/bash
+#
+# recrawltest.sh - tests 'crawler --recrawl' and 'indexer -u',
+# 'crawler --resume' after a crash, and 'crawler --max-body', against a
+# local fixture HTTP server (python3 -m http.server, which answers
+# If-Modified-Since with 304 Not Modified) and a second one that sends
+# the pages under /nolen/ without a Content-Length or validators (ETag,
+# Last-Modified)
+#
+# Author: Insecticide
+# Date: 10-17-2026
+#
+# Usage: ./recrawltest.sh   (after building ../crawler and ../indexer)
+
+CRAWLER="../crawler/crawler"
+INDEXER="../indexer/indexer"
+PORT="${PORT:-8642}"
+NOLEN_PORT=$((PORT + 1))
+WORK="$(mktemp -d)"
+SITE="$WORK/site"
+PAGES="$WORK/pages"
+SEED="http://127.0.0.1:$PORT/index.html"
+
+fail() {
+    echo "FAIL: $1"
+    exit 1
+}
+
+for exe in "$CRAWLER" "$INDEXER"; do
+    if [ ! -x "$exe" ]; then
+        echo "FAIL: Executable '$exe' not found. Please compile it first with 'make'."
+        exit 1
+    fi
+done
+
+mkdir -p "$SITE" "$PAGES"
+echo "<html><title>Fixture</title><body>apple banana cherry</body></html>" > "$SITE/index.html"
+
+python3 -m http.server "$PORT" --bind 127.0.0.1 --directory "$SITE" >/dev/null 2>&1 &
+SERVER=$!
+# The same files, with the body ended by closing the connection and
+# nothing to make a request conditional on
+python3 - "$NOLEN_PORT" "$SITE" >/dev/null 2>&1 <<'PYEOF' &
+import http.server, os, sys
+class Handler(http.server.BaseHTTPRequestHandler):
+    def do_GET(self):
+        path = os.path.join(sys.argv[2], os.path.basename(self.path))
+        if not os.path.isfile(path):
+            self.send_error(404)
+            return
+        self.send_response(200)
+        self.send_header("Content-Type", "text/html")
+        self.end_headers()
+        with open(path, "rb") as f:
+            self.wfile.write(f.read())
+http.server.HTTPServer(("127.0.0.1", int(sys.argv[1])), Handler).serve_forever()
+PYEOF
+NOLEN_SERVER=$!
+trap 'kill $SERVER $NOLEN_SERVER 2>/dev/null; rm -rf "$WORK"' EXIT
+sleep 1
+
+echo "Starting recrawltest..."
+
+# 1. A full crawl and index
+"$CRAWLER" "$SEED" "$PAGES" 0 > /dev/null || fail "initial crawl failed"
+[ "$(head -1 "$PAGES/1")" = "$SEED" ] || fail "page 1 was not saved"
+"$INDEXER" "$PAGES" "$WORK/index" > /dev/null || fail "initial index failed"
+
+# 2. Nothing changed: the recrawl gets a 304 and lists no changes
+"$CRAWLER" "$SEED" "$PAGES" 0 --recrawl > /dev/null || fail "first recrawl failed"
+[ -f "$PAGES/.changes" ] || fail "recrawl wrote no change list"
+[ -s "$PAGES/.changes" ] && fail "unchanged page listed as changed: $(cat "$PAGES/.changes")"
+
+# 3. The page changed: it is rewritten under the same docID and listed
+echo "<html><title>Fixture</title><body>apple banana durian</body></html>" > "$SITE/index.html"
+touch -d "@$(( $(date +%s) + 60 ))" "$SITE/index.html"
+"$CRAWLER" "$SEED" "$PAGES" 0 --recrawl > /dev/null || fail "second recrawl failed"
+grep -qx "M 1" "$PAGES/.changes" || fail "modified page not listed: $(cat "$PAGES/.changes")"
+grep -q "durian" "$PAGES/1" || fail "modified page not rewritten"
+[ -f "$PAGES/2" ] && fail "modified page saved under a new docID"
+
+# 4. The incremental index update matches a full rebuild
+"$INDEXER" "$PAGES" "$WORK/index" -u > /dev/null || fail "index update failed"
+"$INDEXER" "$PAGES" "$WORK/full" > /dev/null || fail "full reindex failed"
+diff <(sort "$WORK/index") <(sort "$WORK/full") > /dev/null || fail "updated index differs from a full rebuild"
+grep -q "^cherry " "$WORK/index" && fail "stale word survived the update"
+
+# 5. A page gone from the site: its file is removed and it is listed;
+#    the indexer takes the pages that are left, gap and all
+echo "+ http://127.0.0.1:$PORT/" > "$WORK/scope"
+echo '<html><title>Fixture</title><body>apple banana durian <a href="b.html">b</a> <a href="c.html">c</a></body></html>' > "$SITE/index.html"
+echo "<html><title>B</title><body>elderberry</body></html>" > "$SITE/b.html"
+echo "<html><title>C</title><body>feijoa</body></html>" > "$SITE/c.html"
+touch -d "@$(( $(date +%s) + 120 ))" "$SITE/index.html"
+"$CRAWLER" "$SEED" "$PAGES" 1 --recrawl --scope "$WORK/scope" > /dev/null || fail "third recrawl failed"
+[ "$(head -1 "$PAGES/2")" = "http://127.0.0.1:$PORT/b.html" ] || fail "linked page b.html not saved as page 2"
+"$INDEXER" "$PAGES" "$WORK/index" -u > /dev/null || fail "index update with new pages failed"
+
+echo '<html><title>Fixture</title><body>apple banana durian <a href="c.html">c</a></body></html>' > "$SITE/index.html"
+rm "$SITE/b.html"
+touch -d "@$(( $(date +%s) + 180 ))" "$SITE/index.html"
+"$CRAWLER" "$SEED" "$PAGES" 1 --recrawl --scope "$WORK/scope" > /dev/null || fail "fourth recrawl failed"
+grep -qx "D 2" "$PAGES/.changes" || fail "deleted page not listed: $(cat "$PAGES/.changes")"
+[ -f "$PAGES/2" ] && fail "deleted page's file was kept"
+"$INDEXER" "$PAGES" "$WORK/index" -u > /dev/null || fail "index update with a deleted page failed"
+"$INDEXER" "$PAGES" "$WORK/full" > /dev/null || fail "full reindex with a gap failed"
+diff <(sort "$WORK/index") <(sort "$WORK/full") > /dev/null || fail "updated index differs from a rebuild with a gap"
+grep -q "^elderberry " "$WORK/full" && fail "deleted page was indexed"
+grep -q "^feijoa " "$WORK/full" || fail "page after the gap was not indexed"
+
+# 6. A page the recrawl finds for the first time is added, and stays
+#    added (here the seed, which leaves the old page unvisited)
+echo "<html><title>New</title><body>grape</body></html>" > "$SITE/new.html"
+"$CRAWLER" "http://127.0.0.1:$PORT/new.html" "$PAGES" 0 --recrawl > /dev/null || fail "recrawl of a new page failed"
+NEW_ID=$(sed -n 's/^A //p' "$PAGES/.changes")
+[ -n "$NEW_ID" ] || fail "new page not listed as added: $(cat "$PAGES/.changes")"
+grep -qx "D $NEW_ID" "$PAGES/.changes" && fail "new page also listed as deleted"
+"$INDEXER" "$PAGES" "$WORK/index" -u > /dev/null || fail "index update with a new page failed"
+grep -q "^grape $NEW_ID " "$WORK/index" || fail "new page dropped by the update"
+
+# 7. A crawl killed after saving a page it had not yet checkpointed:
+#    resuming gives the next new page a docID past it
+RESUMED="$WORK/resumed"
+mkdir -p "$RESUMED"
+echo '<html><title>Root</title><body>root <a href="rb.html">b</a> <a href="rc.html">c</a></body></html>' > "$SITE/r.html"
+echo "<html><title>B</title><body>huckleberry</body></html>" > "$SITE/rb.html"
+"$CRAWLER" "http://127.0.0.1:$PORT/r.html" "$RESUMED" 1 --scope "$WORK/scope" > /dev/null 2>&1 || fail "crawl to resume failed"
+[ "$(head -1 "$RESUMED/2")" = "http://127.0.0.1:$PORT/rb.html" ] || fail "rb.html not saved as page 2"
+# The last commit before the "crash" was right after page 1
+grep "^+" "$RESUMED/.crawler.ckpt" > "$WORK/ckpt"
+echo "=1 2" >> "$WORK/ckpt"
+mv "$WORK/ckpt" "$RESUMED/.crawler.ckpt"
+echo "<html><title>C</title><body>kiwano</body></html>" > "$SITE/rc.html"
+"$CRAWLER" "http://127.0.0.1:$PORT/r.html" "$RESUMED" 1 --resume --scope "$WORK/scope" > /dev/null 2>&1 || fail "resume failed"
+[ "$(head -1 "$RESUMED/2")" = "http://127.0.0.1:$PORT/rb.html" ] || fail "resume overwrote a page saved after the last commit"
+[ "$(head -1 "$RESUMED/3")" = "http://127.0.0.1:$PORT/rc.html" ] || fail "resumed page rc.html not saved as page 3"
+
+# 8. An update takes the analyzer the index was built with: --stem need
+#    not be repeated, and only one that disagrees is refused
+"$INDEXER" "$PAGES" "$WORK/stemmed" --stem > /dev/null || fail "stemmed index failed"
+"$INDEXER" "$PAGES" "$WORK/stemmed" -u > /dev/null || fail "update of a stemmed index without --stem failed"
+"$INDEXER" "$PAGES" "$WORK/stemfull" --stem > /dev/null || fail "full stemmed reindex failed"
+diff <(sort "$WORK/stemmed") <(sort "$WORK/stemfull") > /dev/null || fail "updated stemmed index differs from a rebuild"
+"$INDEXER" "$PAGES" "$WORK/index" -u --stem > /dev/null 2>&1 && fail "update with a different analyzer was accepted"
+
+# 9. --max-body: a page over the limit is refused and not saved, whether
+#    or not the server announces its length; a large page under it is
+#    saved byte for byte either way
+python3 -c 'import sys
+words = " ".join("word%d" % (i % 5000) for i in range(500000))
+sys.stdout.write("<html><title>Big</title><body>" + words + "</body></html>\n")' > "$SITE/big.html"
+BIG_SIZE=$(stat -c %s "$SITE/big.html")
+[ "$BIG_SIZE" -gt 3000000 ] || fail "big.html is only $BIG_SIZE bytes"
+# The html of a saved page: what follows its url, depth and length
+saved_html() {
+    tail -n +4 "$1"
+}
+for url in "http://127.0.0.1:$PORT/big.html" "http://127.0.0.1:$NOLEN_PORT/nolen/big.html"; do
+    rm -rf "$WORK/big"
+    mkdir -p "$WORK/big"
+    "$CRAWLER" "$url" "$WORK/big" 0 --max-body 1000000 > "$WORK/big.log" 2>&1
+    [ -f "$WORK/big/1" ] && fail "page over --max-body saved from $url"
+    "$CRAWLER" "$url" "$WORK/big" 0 --max-body $((BIG_SIZE + 1)) > /dev/null 2>&1 || fail "crawl of $url failed"
+    [ "$(head -1 "$WORK/big/1")" = "$url" ] || fail "page under --max-body not saved from $url"
+    saved_html "$WORK/big/1" | cmp -s - "$SITE/big.html" || fail "$url not saved byte for byte"
+    rm -rf "$WORK/big"
+    mkdir -p "$WORK/big"
+    "$CRAWLER" "$url" "$WORK/big" 0 > /dev/null 2>&1 || fail "crawl of $url without --max-body failed"
+    saved_html "$WORK/big/1" | cmp -s - "$SITE/big.html" || fail "$url not saved byte for byte without --max-body"
+done
+
+# 10. A crawl killed with a page still queued for the writer: the page
+#     is in the metadata but not on disk. From a server without
+#     validators the resumed crawl gets the same bytes, and must still
+#     save them
+NOVAL="$WORK/noval"
+mkdir -p "$NOVAL"
+printf '+ http://127.0.0.1:%s/\n' "$NOLEN_PORT" >> "$WORK/scope"
+"$CRAWLER" "http://127.0.0.1:$NOLEN_PORT/nolen/r.html" "$NOVAL" 1 --scope "$WORK/scope" > /dev/null 2>&1 || fail "crawl without validators failed"
+[ "$(head -1 "$NOVAL/2")" = "http://127.0.0.1:$NOLEN_PORT/nolen/rb.html" ] || fail "rb.html not saved as page 2 without validators"
+rm "$NOVAL/2"
+grep "^+" "$NOVAL/.crawler.ckpt" > "$WORK/ckpt"
+echo "=1 2" >> "$WORK/ckpt"
+mv "$WORK/ckpt" "$NOVAL/.crawler.ckpt"
+"$CRAWLER" "http://127.0.0.1:$NOLEN_PORT/nolen/r.html" "$NOVAL" 1 --resume --scope "$WORK/scope" > /dev/null 2>&1 || fail "resume without validators failed"
+[ "$(head -1 "$NOVAL/2" 2>/dev/null)" = "http://127.0.0.1:$NOLEN_PORT/nolen/rb.html" ] || fail "a page lost before it was written was not saved on resume"
+grep -q "huckleberry" "$NOVAL/2" || fail "page 2 saved without its text on resume"
+
+echo "PASS: recrawl rewrote only the changed page and indexer -u applied it."
+exit 0
@@ -0,0 +1,102 @@
+#!/bin/bash
+#
+# resumetest.sh - tests 'crawler --resume' after the crawler is killed:
+# the crawl is killed once it has committed a checkpoint, half a record
+# is appended to the log as if it had died writing it, and the resumed
+# crawl must rebuild the seen set, the queue and the next docID from
+# the last commit, against a local fixture HTTP server
+#
+# Author: Insecticide
+# Date: 10-17-2026
+#
+# Usage: ./resumetest.sh   (after building ../crawler)
+
+CRAWLER="../crawler/crawler"
+PORT="${PORT:-8644}"
+WORK="$(mktemp -d)"
+SITE="$WORK/site"
+PAGES="$WORK/pages"
+SEED="http://127.0.0.1:$PORT/index.html"
+SCOPE="$WORK/scope"
+NUM_PAGES=12
+
+fail() {
+    echo "FAIL: $1"
+    exit 1
+}
+
+if [ ! -x "$CRAWLER" ]; then
+    echo "FAIL: Executable '$CRAWLER' not found. Please compile it first with 'make'."
+    exit 1
+fi
+
+# Every page links to every other, so a lost seen set would fetch them again
+mkdir -p "$SITE" "$PAGES"
+LINKS='<a href="index.html">home</a>'
+for i in $(seq 1 $NUM_PAGES); do
+    LINKS="$LINKS <a href=\"p$i.html\">page $i</a>"
+done
+echo "<html><title>Home</title><body>$LINKS</body></html>" > "$SITE/index.html"
+for i in $(seq 1 $NUM_PAGES); do
+    echo "<html><title>Page $i</title><body>$LINKS</body></html>" > "$SITE/p$i.html"
+done
+echo "<html><title>Torn</title><body>never linked</body></html>" > "$SITE/torn.html"
+echo "+ http://127.0.0.1:$PORT/" > "$SCOPE"
+
+python3 -m http.server "$PORT" --bind 127.0.0.1 --directory "$SITE" >/dev/null 2>&1 &
+SERVER=$!
+trap 'kill $SERVER $CRAWL 2>/dev/null; rm -rf "$WORK"' EXIT
+sleep 1
+
+echo "Starting resumetest..."
+
+# 1. Kill the crawl (a page a second) a little after it has committed
+#    past a page, with a page or two crawled since
+"$CRAWLER" "$SEED" "$PAGES" 1 --scope "$SCOPE" > /dev/null 2>&1 &
+CRAWL=$!
+for tries in $(seq 1 300); do
+    grep -q "^=[1-9]" "$PAGES/.crawler.ckpt" 2>/dev/null && break
+    sleep 0.1
+done
+sleep 2.5
+{ kill -9 $CRAWL; wait $CRAWL; } 2>/dev/null
+COMMIT=$(grep "^=" "$PAGES/.crawler.ckpt" | tail -1)
+[ -n "$COMMIT" ] || fail "the crawl committed no checkpoint"
+NEXT_ID=${COMMIT#* }
+[ "$NEXT_ID" -le $NUM_PAGES ] || fail "the crawl finished before it was killed"
+[ "$(ls "$PAGES" | grep -c '^[0-9]*$')" -ge "$NEXT_ID" ] || fail "no page was saved after the last commit"
+for id in $(seq 1 $((NEXT_ID - 1))); do
+    md5sum "$PAGES/$id"
+done > "$WORK/committed.md5"
+
+# 2. The crawler died writing a record
+printf '+1 http://127.0.0.1:%s/torn.html' "$PORT" >> "$PAGES/.crawler.ckpt"
+
+# 3. Resume, and finish the crawl
+"$CRAWLER" "$SEED" "$PAGES" 1 --resume --scope "$SCOPE" > /dev/null 2>&1 || fail "resume failed"
+
+# The queue was rebuilt: every page of the site was saved
+for url in "$SEED" $(seq -f "http://127.0.0.1:$PORT/p%g.html" 1 $NUM_PAGES); do
+    grep -qlx "$url" "$PAGES"/[0-9]* || fail "$url was never saved"
+done
+
+# The half record was dropped, and the log goes on from the last commit
+grep -qx "http://127.0.0.1:$PORT/torn.html" "$PAGES"/[0-9]* && fail "the torn record was replayed"
+grep -q "torn.html" "$PAGES/.crawler.ckpt" && fail "the torn record was left in the log"
+[ "$(grep -c "^+" "$PAGES/.crawler.ckpt")" -eq $((NUM_PAGES + 1)) ] || fail "the log has the wrong number of records"
+
+# The seen set was rebuilt: no page was saved twice (one saved after
+# the last commit is fetched again, but keeps its docID)
+TOTAL=$(ls "$PAGES" | grep -c '^[0-9]*$')
+[ "$TOTAL" -eq $((NUM_PAGES + 1)) ] || fail "$TOTAL pages saved, expected $((NUM_PAGES + 1))"
+[ -z "$(head -qn1 "$PAGES"/[0-9]* | sort | uniq -d)" ] || fail "a page was saved twice"
+
+# The next docID was rebuilt: no page the commit covers was overwritten,
+# and new pages were numbered on from the pages saved
+md5sum -c --quiet "$WORK/committed.md5" > /dev/null 2>&1 || fail "a page saved before the last commit was overwritten"
+for id in $(seq 1 "$TOTAL"); do
+    [ -f "$PAGES/$id" ] || fail "docID $id was skipped"
+done
+
+echo "PASS: the killed crawl resumed from its last commit, past a torn record."
+exit 0
@@ -0,0 +1,166 @@
+/*
+ * scopetest.c - test program for the 'scope' module
+ *
+ * Author: Insecticide
+ * Date: 10-17-2026
+ *
+ * Usage: ./scopetest
+ *
+ * Description:
+ * 1. Adds random allow and deny prefixes (over a small alphabet, so
+ *    they share long prefixes) and checks scope_allows() on random
+ *    URLs against a linear scan for the longest matching rule.
+ * 2. Writes a rules file, loads it, rewrites it, and checks that
+ *    scope_reload() picks up the change only when there is one, and
+ *    keeps the old rules when the new file is malformed. Checks that a
+ *    rule without a prefix is malformed.
+ * 3. Times scope_allows() with a thousand rules.
+ * 4. Reports PASS/FAIL.
+ */
+
+#define _POSIX_C_SOURCE 200809L // clock_gettime
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <time.h>
+#include "scope.h"
+
+#define NUM_RULES 1000
+#define NUM_URLS 100000
+#define MAX_LEN 24
+#define RULES_FILE "scopetest.rules"
+
+typedef struct rule {
+    char prefix[MAX_LEN + 1];
+    bool allow;
+} rule_t;
+
+static double now(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+// Random string of 1..max_len bytes from a small alphabet
+static void random_string(char *buf, int max_len) {
+    static const char alphabet[] = "ab/.:";
+    int len = 1 + rand() % max_len;
+    for (int i = 0; i < len; i++) {
+        buf[i] = alphabet[rand() % (sizeof(alphabet) - 1)];
+    }
+    buf[len] = '\0';
+}
+
+// The longest rule that is a prefix of url decides (the later of equal ones)
+static bool linear_allows(const rule_t *rules, int num_rules, const char *url) {
+    int best_len = -1;
+    bool allow = false;
+    for (int i = 0; i < num_rules; i++) {
+        int len = strlen(rules[i].prefix);
+        if (len >= best_len && strncmp(url, rules[i].prefix, len) == 0) {
+            best_len = len;
+            allow = rules[i].allow;
+        }
+    }
+    return allow;
+}
+
+// Writes text to the rules file
+static void write_rules(const char *text) {
+    FILE *fp = fopen(RULES_FILE, "w");
+    fputs(text, fp);
+    fclose(fp);
+}
+
+int main(void) {
+    int status = 0;
+    printf("Starting scopetest...\n");
+
+    // 1. Random rules against the linear scan
+    static rule_t rules[NUM_RULES];
+    scope_t *scope = scope_new();
+    srand(42);
+    for (int i = 0; i < NUM_RULES; i++) {
+        random_string(rules[i].prefix, MAX_LEN / 2);
+        rules[i].allow = rand() % 2;
+        scope_add(scope, rules[i].prefix, rules[i].allow);
+    }
+    static char urls[NUM_URLS][MAX_LEN + 1];
+    for (int i = 0; i < NUM_URLS; i++) {
+        random_string(urls[i], MAX_LEN);
+        if (scope_allows(scope, urls[i]) != linear_allows(rules, NUM_RULES, urls[i])) {
+            fprintf(stderr, "FAIL: scope_allows(\"%s\") disagrees with the linear scan\n", urls[i]);
+            status = 1;
+            break;
+        }
+    }
+
+    // 3. Timing, while the random scope is here
+    double start = now();
+    int allowed = 0;
+    for (int i = 0; i < NUM_URLS; i++) {
+        allowed += scope_allows(scope, urls[i]);
+    }
+    double trie = now() - start;
+    start = now();
+    for (int i = 0; i < NUM_URLS; i++) {
+        allowed -= linear_allows(rules, NUM_RULES, urls[i]);
+    }
+    double linear = now() - start;
+    printf("%d rules: trie %.3f us/url, linear scan %.3f us/url\n", NUM_RULES,
+           trie * 1e6 / NUM_URLS, linear * 1e6 / NUM_URLS);
+    scope_delete(scope);
+
+    // 2. Loading and reloading a rules file
+    write_rules("# engs50 only\n"
+                "+ https://thayer.github.io/engs50/\n"
+                "\n"
+                "  - https://thayer.github.io/engs50/Labs/  \n");
+    scope = scope_load(RULES_FILE);
+    if (scope == NULL ||
+        !scope_allows(scope, "https://thayer.github.io/engs50/Notes/") ||
+        scope_allows(scope, "https://thayer.github.io/engs50/Labs/Lab1.html") ||
+        scope_allows(scope, "https://thayer.github.io/cs10/") ||
+        scope_reload(scope)) {
+        fprintf(stderr, "FAIL: the loaded rules are wrong\n");
+        status = 1;
+    }
+
+    struct timespec pause = { 0, 20 * 1000 * 1000 }; // let the mtime move on
+    nanosleep(&pause, NULL);
+    write_rules("+ https://thayer.github.io/\n");
+    if (scope == NULL || !scope_reload(scope) ||
+        !scope_allows(scope, "https://thayer.github.io/cs10/") ||
+        !scope_allows(scope, "https://thayer.github.io/engs50/Labs/Lab1.html")) {
+        fprintf(stderr, "FAIL: the rewritten rules were not reloaded\n");
+        status = 1;
+    }
+
+    nanosleep(&pause, NULL);
+    write_rules("+ https://thayer.github.io/\n"
+                "* https://example.com/\n");
+    fprintf(stderr, "(an error about line 2 is expected here)\n");
+    if (scope == NULL || scope_reload(scope) ||
+        !scope_allows(scope, "https://thayer.github.io/cs10/")) {
+        fprintf(stderr, "FAIL: malformed rules replaced good ones\n");
+        status = 1;
+    }
+    scope_delete(scope);
+
+    // A sign without a prefix would be a rule for every url
+    write_rules("- https://example.com/\n"
+                "+\n");
+    fprintf(stderr, "(an error about line 2 is expected here)\n");
+    scope = scope_load(RULES_FILE);
+    if (scope != NULL) {
+        fprintf(stderr, "FAIL: a rule with an empty prefix was loaded\n");
+        status = 1;
+    }
+    scope_delete(scope);
+    remove(RULES_FILE);
+
+    printf(status == 0 ? "PASS: the scope trie matches the linear scan and reloads.\n" : "FAIL\n");
+    return status;
+}
@@ -0,0 +1,144 @@
+/*
+ * simhashtest.c - test program for the 'simhash' module
+ *
+ * Author: Insecticide
+ * Date: 10-17-2026
+ *
+ * Usage: ./simhashtest
+ *
+ * Description:
+ * 1. Records random simhashes in a duplicate index and checks that each
+ *    is found from a simhash 1 to 3 bits away, whichever bands the bits
+ *    fall in, and never from one 4 bits away.
+ * 2. Checks that the closest page wins, that an exact match wins over
+ *    a page just as close, and that ties otherwise go to the oldest.
+ * 3. Checks that pages with fewer than 3 words get a fingerprint that
+ *    depends only on their words, and that such pages are told apart.
+ * 4. Checks that pages with no words are never recorded or reported as
+ *    duplicates, so that they are not collapsed into one another.
+ * 5. Reports PASS/FAIL.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "webpage.h"
+#include "simhash.h"
+
+#define NUM_RANDOM 2000
+
+static int failures = 0;
+
+static void check(int ok, const char *what) {
+    if (!ok) {
+        fprintf(stderr, "FAIL: %s\n", what);
+        failures++;
+    }
+}
+
+static uint64_t random64(void) {
+    uint64_t x = 0;
+    for (int i = 0; i < 4; i++) {
+        x = (x << 16) ^ (rand() & 0xFFFF);
+    }
+    return x;
+}
+
+// x with n distinct random bits flipped
+static uint64_t flip_bits(uint64_t x, int n) {
+    uint64_t mask = 0;
+    while (__builtin_popcountll(mask) < n) {
+        mask |= 1ULL << (rand() % 64);
+    }
+    return x ^ mask;
+}
+
+// The fingerprints of a page with the given html
+static fingerprint_t fingerprint_of(const char *html) {
+    char *copy = malloc(strlen(html) + 1);
+    strcpy(copy, html);
+    webpage_t *page = webpage_new("http://test/", 0, copy);
+    fingerprint_t fp = page_fingerprint(page);
+    webpage_delete(page);
+    return fp;
+}
+
+static int same(fingerprint_t a, fingerprint_t b) {
+    return a.exact == b.exact && a.simhash == b.simhash && a.num_words == b.num_words;
+}
+
+int main(int argc, char *argv[]) {
+    printf("Starting simhashtest...\n");
+    srand(7);
+
+    // 1. Found within 3 bits, not at 4
+    dupindex_t *di = dupindex_new();
+    fingerprint_t *recorded = malloc(NUM_RANDOM * sizeof(fingerprint_t));
+    for (int i = 0; i < NUM_RANDOM; i++) {
+        recorded[i] = (fingerprint_t){ random64(), random64(), 10 };
+        dupindex_add(di, &recorded[i], i + 1);
+    }
+    int near_missed = 0, far_found = 0;
+    for (int i = 0; i < NUM_RANDOM; i++) {
+        for (int bits = 1; bits <= SIMHASH_MAXDIST; bits++) {
+            fingerprint_t near = { random64(), flip_bits(recorded[i].simhash, bits), 10 };
+            near_missed += (dupindex_find(di, &near, SIMHASH_MAXDIST) != i + 1);
+        }
+        fingerprint_t far = { random64(), flip_bits(recorded[i].simhash, SIMHASH_MAXDIST + 1), 10 };
+        far_found += (dupindex_find(di, &far, SIMHASH_MAXDIST) == i + 1);
+    }
+    check(near_missed == 0, "a simhash at most 3 bits away was not found");
+    check(far_found == 0, "a simhash 4 bits away was found");
+
+    // The three bits in three different bands still leave one band equal
+    fingerprint_t spread = { 1, recorded[0].simhash ^ (1ULL << 3) ^ (1ULL << 20) ^ (1ULL << 40), 10 };
+    check(dupindex_find(di, &spread, SIMHASH_MAXDIST) == 1, "3 bits in 3 bands not found");
+    fingerprint_t tight = { 1, recorded[0].simhash ^ 0x7, 10 };
+    check(dupindex_find(di, &tight, 2) == 0, "a simhash 3 bits away was found within 2");
+    dupindex_delete(di);
+
+    // 2. The closest page, then an exact match, then the oldest
+    uint64_t base = random64();
+    di = dupindex_new();
+    fingerprint_t three = { 1, base ^ 0x7, 10 }, one = { 2, base ^ 0x100, 10 };
+    dupindex_add(di, &three, 1);
+    dupindex_add(di, &one, 2);
+    fingerprint_t query = { 3, base, 10 };
+    check(dupindex_find(di, &query, SIMHASH_MAXDIST) == 2, "the closer page did not win");
+
+    fingerprint_t near = { 4, base, 10 }, exact = { 5, base, 10 };
+    dupindex_add(di, &near, 3);
+    dupindex_add(di, &exact, 4);
+    check(dupindex_find(di, &exact, SIMHASH_MAXDIST) == 4, "an exact match lost to an older page as close");
+    check(dupindex_find(di, &query, SIMHASH_MAXDIST) == 3, "a tie did not go to the oldest page");
+    dupindex_delete(di);
+
+    // 3. Short pages: the same words, the same fingerprint
+    fingerprint_t two = fingerprint_of("<html><body>hello world</body></html>");
+    check(two.num_words == 2, "a two-word page was not counted as such");
+    check(same(two, fingerprint_of("<p>Hello</p>\n<b>WORLD</b>")), "a two-word page's fingerprint depends on its markup");
+    check(same(two, fingerprint_of("<html><body>hello world</body></html>")), "a two-word page's fingerprint changed");
+    check(!same(two, fingerprint_of("hello there")), "two different two-word pages share a fingerprint");
+    check(!same(two, fingerprint_of("world hello")), "a two-word page's order did not count");
+    fingerprint_t word = fingerprint_of("hello");
+    check(word.num_words == 1 && same(word, fingerprint_of("<i>hello</i>")), "a one-word page's fingerprint is not stable");
+    check(!same(word, two), "one and two words share a fingerprint");
+
+    di = dupindex_new();
+    dupindex_add(di, &two, 1);
+    check(dupindex_find(di, &two, SIMHASH_MAXDIST) == 1, "a two-word page did not find its copy");
+    check(dupindex_find(di, &word, 0) == 0, "a one-word page found a two-word page at distance 0");
+
+    // 4. Pages without words duplicate nothing, and nothing duplicates them
+    fingerprint_t empty = fingerprint_of("<html><head></head><body></body></html>");
+    fingerprint_t blank = fingerprint_of("<p> </p><img src=\"a.png\"> 42 !");
+    check(empty.num_words == 0 && blank.num_words == 0, "a page without words was given words");
+    dupindex_add(di, &empty, 2);
+    check(dupindex_find(di, &blank, SIMHASH_MAXDIST) == 0, "a page without words was taken for a duplicate");
+    check(dupindex_find(di, &empty, SIMHASH_MAXDIST) == 0, "a page without words found itself");
+    dupindex_delete(di);
+    free(recorded);
+
+    printf(failures == 0 ? "PASS\n" : "FAIL\n");
+    return failures != 0;
+}
@@ -0,0 +1,148 @@
+/*
+ * snippettest.c - test program for the 'doctext' module
+ *
+ * Author: Insecticide
+ * Date: 10-17-2026
+ *
+ * Usage: ./snippettest pageDirectory
+ *
+ * Description:
+ * 1. Checks doctext_extract() on small documents: tags, script, the
+ *    title and comments left out, whitespace collapsed, references
+ *    decoded (a lone surrogate as U+FFFD; not '<', '>' and '&'), and
+ *    long text cut at a character boundary.
+ * 2. Checks doctext_snippet(): the stretch with the most terms, their
+ *    highlighting, stemmed matches and the "..." at either end.
+ * 3. Writes the text of the crawled pages to a text file, replaces and
+ *    removes some in an appended update, and checks that every page
+ *    reads back as doctext_extract() makes it.
+ * 4. Reports PASS/FAIL.
+ */
+
+#define _POSIX_C_SOURCE 200809L // mkstemp
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "doctext.h"
+#include "pageio.h"
+#include "webpage.h"
+
+#define MAX_PAGES 1000
+
+static int status = 0;
+
+static void expect(const char* what, const char* got, const char* want) {
+    if (strcmp(got, want) != 0) {
+        fprintf(stderr, "FAIL: %s: got \"%s\", expected \"%s\"\n", what, got, want);
+        status = 1;
+    }
+}
+
+static void check_extract(const char* html, int max, const char* want) {
+    char out[256];
+    int len = doctext_extract(html, strlen(html), out, max);
+    expect(html, out, want);
+    if (len != (int)strlen(out)) {
+        fprintf(stderr, "FAIL: %s: length %d\n", html, len);
+        status = 1;
+    }
+}
+
+static void check_snippet(const char* text, const char* const terms[], int num_terms, analyzer_t analyzer,
+                          int want_hits, const char* want) {
+    char out[DOCTEXT_MAXSNIPPET];
+    int hits = doctext_snippet(text, strlen(text), terms, num_terms, analyzer, out);
+    expect(text, out, want);
+    if (hits != want_hits) {
+        fprintf(stderr, "FAIL: %s: %d words highlighted, expected %d\n", text, hits, want_hits);
+        status = 1;
+    }
+}
+
+int main(int argc, char* argv[]) {
+    if (argc != 2) {
+        fprintf(stderr, "Usage: %s pageDirectory\n", argv[0]);
+        return 1;
+    }
+    printf("Starting snippettest...\n");
+
+    // 1. What counts as the visible text
+    check_extract("<html><title>Skip me</title><body>\n  Hello,\t<b>wor</b>ld!  </body></html>", 200,
+                  "Hello, wor ld!");
+    check_extract("a<script>var x = '<p>';</script>b<!-- c -->d<style>p{}</style>", 200, "a b d");
+    check_extract("caf&eacute; &amp; &lt;tag&gt; &#8217;s&nbsp;end &bogus;", 200,
+                  "caf\xc3\xa9 &amp; &lt;tag&gt; \xe2\x80\x99s end &bogus;");
+    check_extract("&#xD83D;&#128512;", 200, "\xef\xbf\xbd\xf0\x9f\x98\x80");
+    check_extract("ab\xc3\xa9", 3, "ab");
+    check_extract("one two three", 7, "one two");
+
+    // 2. Snippets
+    const char* terms[] = { "search", "engine" };
+    check_snippet("A search engine finds pages.", terms, 2, ANALYZER_LOWER, 2,
+                  "A **search** **engine** finds pages.");
+    check_snippet("w1 w2 w3 w4 w5 w6 w7 w8 w9 w10 search w12 w13 w14 w15 w16 w17 w18 w19 w20 w21 w22 w23 "
+                  "w24 w25 w26 w27 w28 w29 w30 search engine w33 w34 w35 w36 w37 w38", terms, 2, ANALYZER_LOWER, 2,
+                  "... w27 w28 w29 w30 **search** **engine** w33 w34 w35 w36 w37 w38");
+    const char* stems[] = { "search", "engin" };
+    check_snippet("Searching with engines, all day.", stems, 2, ANALYZER_PORTER2, 2,
+                  "**Searching** with **engines**, all day.");
+    check_snippet("Nothing matches here.", terms, 2, ANALYZER_LOWER, 0, "Nothing matches here.");
+    check_snippet("", terms, 2, ANALYZER_LOWER, 0, "");
+
+    // 3. The crawl's pages, through a file and an update
+    char path[] = "/tmp/snippettest.XXXXXX";
+    int fd = mkstemp(path);
+    if (fd < 0) {
+        perror("mkstemp");
+        return 1;
+    }
+    close(fd);
+    doctext_t* dt = doctext_create(path, false);
+    int num_pages = 0;
+    webpage_t* page;
+    for (int d = 1; d < MAX_PAGES && (page = pageload(d, argv[1])) != NULL; d++, num_pages++) {
+        doctext_put(dt, d, webpage_getHTML(page), webpage_getHTMLlen(page));
+        webpage_delete(page);
+    }
+    if (doctext_close(dt) != 0 || num_pages < 3) {
+        fprintf(stderr, "FAIL: text of %d pages not written\n", num_pages);
+        status = 1;
+    }
+    dt = doctext_create(path, true);
+    const char* changed = "<p>Page two, changed</p>";
+    doctext_put(dt, 2, changed, strlen(changed));
+    doctext_remove(dt, 3);
+    doctext_close(dt);
+
+    char* text = malloc(DOCTEXT_MAXTEXT + 1);
+    char* want = malloc(DOCTEXT_MAXTEXT + 1);
+    dt = doctext_open(path);
+    for (int d = 1; dt != NULL && d <= num_pages + 1 && status == 0; d++) {
+        int len = doctext_get(dt, d, text);
+        int want_len = -1;
+        if (d == 2) {
+            want_len = doctext_extract(changed, strlen(changed), want, DOCTEXT_MAXTEXT);
+        } else if (d != 3 && (page = pageload(d, argv[1])) != NULL) {
+            want_len = doctext_extract(webpage_getHTML(page), webpage_getHTMLlen(page), want, DOCTEXT_MAXTEXT);
+            webpage_delete(page);
+        }
+        if (len != want_len || (len >= 0 && memcmp(text, want, len) != 0)) {
+            fprintf(stderr, "FAIL: page %d reads back %d bytes, expected %d\n", d, len, want_len);
+            status = 1;
+        }
+    }
+    if (dt == NULL) {
+        fprintf(stderr, "FAIL: text file not read back\n");
+        status = 1;
+    } else {
+        doctext_close(dt);
+    }
+    free(text);
+    free(want);
+    unlink(path);
+
+    printf(status == 0 ? "PASS\n" : "FAIL\n");
+    return status;
+}
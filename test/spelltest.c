@@ -0,0 +1,318 @@
+/*
+ * spelltest.c - test program for the 'spell' module
+ *
+ * Author: Insecticide
+ * Date: 10-17-2026
+ *
+ * Usage: ./spelltest pageDirectory
+ *
+ * Description:
+ * 1. Indexes the pages of <pageDirectory>, with a few stopwords.
+ * 2. Misspells random terms with up to two random edits and checks
+ *    that spell_lookup() finds the same terms, in the same order, as
+ *    measuring the distance to every term does.
+ * 3. Checks spell_suggest() against the lookups.
+ * 4. Checks that a fuzzy query word matches the pages of the terms it
+ *    finds, with their ranks added up.
+ * 5. Reports how long filing the terms and the lookups took, and
+ *    PASS/FAIL.
+ */
+
+#define _POSIX_C_SOURCE 200809L // clock_gettime
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "webpage.h"
+#include "pageio.h"
+#include "index.h"
+#include "utf8.h"
+#include "spell.h"
+#include "querytree.h"
+
+#define MAX_PAGES 1000
+#define NUM_LOOKUPS 2000
+#define NUM_QUERIES 200
+#define MAX_FOUND 64   // what a lookup returns at most
+#define MAX_CHARS 48   // longest term the speller files
+#define FUZZY_TERMS 16 // terms a fuzzy query word matches at most
+
+static const char* stopwords[] = { "the", "for", "with", "that" };
+
+// A term, with what the brute-force lookup needs
+typedef struct term {
+    const char* word;
+    uint32_t chars[MAX_CHARS];
+    int num_chars;
+    int pages;
+    int distance;
+} term_t;
+
+static hashtable_t* g_index;
+static term_t* g_terms;
+static int g_num_terms;
+static int g_count;
+
+static double now(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static bool search_word(void* elementp, const void* keyp) {
+    return strcmp(((word_entry_t*)elementp)->word, (const char*)keyp) == 0;
+}
+
+static bool search_doc(void* elementp, const void* keyp) {
+    return ((doc_entry_t*)elementp)->docID == *(const int*)keyp;
+}
+
+static void count_doc(void* data) {
+    g_count++;
+}
+
+static int decode(const char* word, uint32_t* chars) {
+    int len = strlen(word), n = 0;
+    for (int i = 0, bytes; i < len; i += bytes, n++) {
+        if (n == MAX_CHARS) {
+            return -1;
+        }
+        if ((bytes = utf8_decode(word, len, i, &chars[n])) == 0) {
+            chars[n] = (unsigned char)word[i];
+            bytes = 1;
+        }
+    }
+    return n;
+}
+
+static void collect_term(void* data) {
+    word_entry_t* entry = (word_entry_t*)data;
+    term_t* t = &g_terms[g_num_terms];
+    t->word = entry->word;
+    t->num_chars = decode(entry->word, t->chars);
+    t->pages = 0;
+    if (entry->stopbits != NULL) {
+        for (int d = 0; d <= MAX_PAGES; d++) {
+            t->pages += index_stopbit(entry, d);
+        }
+    } else {
+        g_count = 0;
+        qapply(entry->docs, count_doc);
+        t->pages = g_count;
+    }
+    if (t->num_chars >= 0 && t->pages > 0) {
+        g_num_terms++;
+    }
+}
+
+// Optimal string alignment distance, the whole table
+static int osa(const uint32_t* a, int n, const uint32_t* b, int m) {
+    static int d[MAX_CHARS + 8][MAX_CHARS + 8];
+    for (int i = 0; i <= n; i++) d[i][0] = i;
+    for (int j = 0; j <= m; j++) d[0][j] = j;
+    for (int i = 1; i <= n; i++) {
+        for (int j = 1; j <= m; j++) {
+            int best = d[i - 1][j - 1] + (a[i - 1] != b[j - 1]);
+            if (d[i - 1][j] + 1 < best) best = d[i - 1][j] + 1;
+            if (d[i][j - 1] + 1 < best) best = d[i][j - 1] + 1;
+            if (i > 1 && j > 1 && a[i - 1] == b[j - 2] && a[i - 2] == b[j - 1] && d[i - 2][j - 2] + 1 < best) {
+                best = d[i - 2][j - 2] + 1;
+            }
+            d[i][j] = best;
+        }
+    }
+    return d[n][m];
+}
+
+static int compare_found(const void* a, const void* b) {
+    const term_t* ta = *(const term_t* const*)a;
+    const term_t* tb = *(const term_t* const*)b;
+    if (ta->distance != tb->distance) return ta->distance - tb->distance;
+    if (ta->pages != tb->pages) return tb->pages - ta->pages;
+    return strcmp(ta->word, tb->word);
+}
+
+// Every term within max edits of word, in lookup order
+static int brute_lookup(const char* word, int max, const term_t* found[]) {
+    uint32_t chars[MAX_CHARS];
+    int n = decode(word, chars), num_found = 0;
+    for (int t = 0; t < g_num_terms; t++) {
+        if (abs(g_terms[t].num_chars - n) > max) {
+            continue; // needs that many insertions or deletions at least
+        }
+        g_terms[t].distance = osa(chars, n, g_terms[t].chars, g_terms[t].num_chars);
+        if (g_terms[t].distance <= max) {
+            found[num_found++] = &g_terms[t];
+        }
+    }
+    qsort(found, num_found, sizeof(term_t*), compare_found);
+    return num_found;
+}
+
+// Applies edits random insertions, deletions, replacements or swaps
+static void misspell(const char* word, int edits, char* out) {
+    strcpy(out, word);
+    for (int e = 0; e < edits; e++) {
+        int len = strlen(out);
+        int pos = rand() % (len + 1);
+        char letter = 'a' + rand() % 26;
+        switch (rand() % 4) {
+        case 0:
+            memmove(out + pos + 1, out + pos, len - pos + 1);
+            out[pos] = letter;
+            break;
+        case 1:
+            if (pos < len) memmove(out + pos, out + pos + 1, len - pos);
+            break;
+        case 2:
+            if (pos < len) out[pos] = letter;
+            break;
+        default:
+            if (pos + 1 < len) {
+                char c = out[pos];
+                out[pos] = out[pos + 1];
+                out[pos + 1] = c;
+            }
+        }
+    }
+}
+
+int main(int argc, char* argv[]) {
+    if (argc != 2) {
+        fprintf(stderr, "Usage: %s pageDirectory\n", argv[0]);
+        return 1;
+    }
+    int status = 0;
+    printf("Starting spelltest...\n");
+
+    // 1. Index the pages
+    g_index = index_new();
+    for (int id = 1; id <= MAX_PAGES; id++) {
+        webpage_t* page = pageload(id, argv[1]);
+        if (page != NULL) {
+            index_addpage(g_index, page, id, ANALYZER_LOWER);
+            webpage_delete(page);
+        }
+    }
+    for (int i = 0; i < (int)(sizeof(stopwords) / sizeof(stopwords[0])); i++) {
+        index_addstopword(g_index, stopwords[i]);
+    }
+    g_terms = malloc(100000 * sizeof(term_t));
+    happly(g_index, collect_term);
+    spell_t* spell = spell_new(g_index);
+    const char* first;
+    double start = now();
+    spell_lookup(spell, "first", 1, &first, 1); // builds the deletion index
+    printf("%d terms, filed in %.1f ms\n", g_num_terms, (now() - start) * 1e3);
+
+    // 2. Lookups of misspelled terms against the brute force
+    srand(7);
+    static const term_t* expected[100000];
+    double lookup_time = 0;
+    long found_total = 0;
+    for (int l = 0; l < NUM_LOOKUPS && status == 0; l++) {
+        char word[4 * MAX_CHARS + 8];
+        const char* source = g_terms[rand() % g_num_terms].word;
+        if (strlen(source) > 40) {
+            continue;
+        }
+        misspell(source, rand() % 3, word);
+        int max = 1 + rand() % 2;
+
+        const char* found[MAX_FOUND];
+        start = now();
+        int num_found = spell_lookup(spell, word, max, found, MAX_FOUND);
+        lookup_time += now() - start;
+        found_total += num_found;
+
+        int num_expected = brute_lookup(word, max, expected);
+        if (num_expected > MAX_FOUND) {
+            num_expected = MAX_FOUND;
+        }
+        bool same = (num_found == num_expected);
+        for (int i = 0; same && i < num_found; i++) {
+            same = (strcmp(found[i], expected[i]->word) == 0);
+        }
+        if (!same) {
+            fprintf(stderr, "FAIL: lookup of '%s' within %d found %d terms, expected %d\n",
+                    word, max, num_found, num_expected);
+            status = 1;
+        }
+
+        // 3. The suggestion is the best lookup, unless the word is a term
+        const char* suggestion = spell_suggest(spell, word);
+        int suggest_max = (strlen(word) <= 4) ? 1 : 2;
+        num_expected = brute_lookup(word, suggest_max, expected);
+        const char* best = (num_expected > 0 && expected[0]->distance > 0) ? expected[0]->word : NULL;
+        if ((suggestion == NULL) != (best == NULL) || (best != NULL && strcmp(suggestion, best) != 0)) {
+            fprintf(stderr, "FAIL: suggestion for '%s' is '%s', expected '%s'\n",
+                    word, suggestion ? suggestion : "(none)", best ? best : "(none)");
+            status = 1;
+        }
+    }
+
+    // 4. Fuzzy query words match the pages of their terms
+    for (int q = 0; q < NUM_QUERIES && status == 0; q++) {
+        char word[4 * MAX_CHARS + 8];
+        const char* source = g_terms[rand() % g_num_terms].word;
+        if (strlen(source) > 40) {
+            continue;
+        }
+        misspell(source, rand() % 2, word);
+        char* tokens[] = { word, (q % 2) ? "~2" : "~" };
+        const char* error = NULL;
+        querytree_t* query = querytree_compile(g_index, spell, tokens, 2, argv[1], ANALYZER_LOWER, NULL, &error);
+        if (query == NULL) {
+            fprintf(stderr, "FAIL: '%s%s' rejected: %s\n", tokens[0], tokens[1], error);
+            status = 1;
+            break;
+        }
+        const char* terms[FUZZY_TERMS];
+        int num_terms = spell_lookup(spell, word, (q % 2) ? 2 : 1, terms, FUZZY_TERMS);
+        int docID, rank, last = 0;
+        while ((docID = querytree_next(query, &rank)) >= 0 && status == 0) {
+            for (int d = last + 1; d <= docID && status == 0; d++) {
+                int expected_rank = 0;
+                for (int t = 0; t < num_terms; t++) {
+                    word_entry_t* entry = hsearch(g_index, search_word, terms[t], strlen(terms[t]));
+                    if (entry->stopbits != NULL) {
+                        expected_rank += index_stopbit(entry, d);
+                    } else {
+                        doc_entry_t* doc = qsearch(entry->docs, search_doc, &d);
+                        expected_rank += (doc != NULL) ? doc->count : 0;
+                    }
+                }
+                int got = (d == docID) ? rank : 0;
+                if (expected_rank != got) {
+                    fprintf(stderr, "FAIL: '%s%s' ranks page %d %d, expected %d\n",
+                            tokens[0], tokens[1], d, got, expected_rank);
+                    status = 1;
+                }
+            }
+            last = docID;
+        }
+        querytree_delete(query);
+    }
+
+    // Fuzzy marks in the wrong place, or with a bad distance
+    char* bad[][3] = { { "~", "cat", NULL }, { "cat", "~3", NULL }, { "\"", "cat", "~" } };
+    int bad_len[] = { 2, 2, 3 };
+    for (int i = 0; i < 3; i++) {
+        const char* error = NULL;
+        querytree_t* query = querytree_compile(g_index, spell, bad[i], bad_len[i], argv[1], ANALYZER_LOWER, NULL, &error);
+        if (query != NULL) {
+            fprintf(stderr, "FAIL: malformed fuzzy query %d accepted\n", i);
+            querytree_delete(query);
+            status = 1;
+        }
+    }
+
+    printf("%d lookups: %.1f us per lookup, %.1f terms found on average\n", NUM_LOOKUPS,
+           lookup_time * 1e6 / NUM_LOOKUPS, (double)found_total / NUM_LOOKUPS);
+    printf(status == 0 ? "PASS\n" : "FAIL\n");
+
+    spell_delete(spell);
+    free(g_terms);
+    return status;
+}
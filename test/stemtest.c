@@ -0,0 +1,199 @@
+/*
+ * stemtest.c - test program for the 'analyzer' module
+ *
+ * Author: Insecticide
+ * Date: 10-17-2026
+ *
+ * Usage: ./stemtest [pageDirectory]
+ *
+ * Description:
+ * 1. Stems words from the Snowball sample vocabulary (and the
+ *    algorithm's exceptions) and checks them against their published
+ *    Porter2 stems.
+ * 2. If a <pageDirectory> is given, indexes its pages with the lower
+ *    and porter2 analyzers, checks that every word of the first index,
+ *    stemmed as the querier stems a query word, is a term of the
+ *    second, and reports both vocabulary sizes and how fast words are
+ *    indexed and stemmed.
+ * 3. Reports PASS/FAIL.
+ */
+
+#define _POSIX_C_SOURCE 200809L // clock_gettime
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "webpage.h"
+#include "pageio.h"
+#include "index.h"
+#include "analyzer.h"
+
+#define MAX_PAGES 1000
+#define MAX_WORD 256
+#define BENCH_ROUNDS 20
+
+static const char *vocabulary[][2] = {
+    { "consign", "consign" }, { "consigned", "consign" }, { "consigning", "consign" },
+    { "consignment", "consign" }, { "consist", "consist" }, { "consisted", "consist" },
+    { "consistency", "consist" }, { "consistent", "consist" }, { "consistently", "consist" },
+    { "consisting", "consist" }, { "consists", "consist" }, { "consolation", "consol" },
+    { "consolations", "consol" }, { "consolatory", "consolatori" }, { "console", "consol" },
+    { "consoled", "consol" }, { "consoles", "consol" }, { "consolidate", "consolid" },
+    { "consolidated", "consolid" }, { "consolidating", "consolid" }, { "consoling", "consol" },
+    { "consolingly", "consol" }, { "consols", "consol" }, { "consonant", "conson" },
+    { "consort", "consort" }, { "consorted", "consort" }, { "consorting", "consort" },
+    { "conspicuous", "conspicu" }, { "conspicuously", "conspicu" }, { "conspiracy", "conspiraci" },
+    { "conspirator", "conspir" }, { "conspirators", "conspir" }, { "conspire", "conspir" },
+    { "conspired", "conspir" }, { "conspiring", "conspir" }, { "constable", "constabl" },
+    { "constables", "constabl" }, { "constance", "constanc" }, { "constancy", "constanc" },
+    { "constant", "constant" }, { "knack", "knack" }, { "knackeries", "knackeri" },
+    { "knacks", "knack" }, { "knag", "knag" }, { "knave", "knave" }, { "knaves", "knave" },
+    { "knavish", "knavish" }, { "kneaded", "knead" }, { "kneading", "knead" }, { "knee", "knee" },
+    { "kneel", "kneel" }, { "kneeled", "kneel" }, { "kneeling", "kneel" }, { "kneels", "kneel" },
+    { "knees", "knee" }, { "knell", "knell" }, { "knelt", "knelt" }, { "knew", "knew" },
+    { "knick", "knick" }, { "knif", "knif" }, { "knife", "knife" }, { "knight", "knight" },
+    { "knightly", "knight" }, { "knights", "knight" }, { "knit", "knit" }, { "knits", "knit" },
+    { "knitted", "knit" }, { "knitting", "knit" }, { "knives", "knive" }, { "knob", "knob" },
+    { "knobs", "knob" }, { "knock", "knock" }, { "knocked", "knock" }, { "knocker", "knocker" },
+    { "knockers", "knocker" }, { "knocking", "knock" }, { "knocks", "knock" }, { "knopp", "knopp" },
+    { "knot", "knot" }, { "knots", "knot" }, { "skies", "sky" }, { "dying", "die" },
+    { "news", "news" }, { "proceed", "proceed" }, { "generously", "generous" },
+    { "college", "colleg" }, { "colleges", "colleg" }, { "hopping", "hop" }, { "hoped", "hope" },
+    { "agreed", "agre" }, { "cries", "cri" }, { "ties", "tie" }, { "caresses", "caress" },
+    { "happy", "happi" }, { "sayings", "say" }, { "yelling", "yell" }, { "by", "by" }
+};
+
+static double now(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+// Where the checks over the lower index keep their state
+typedef struct check {
+    hashtable_t *stemmed;   // index built with porter2
+    long words;
+    long missing;
+    char **vocab;           // words of the lower index, for timing
+} check_t;
+
+static check_t g_check;
+
+static bool search_word(void *elementp, const void *keyp) {
+    return strcmp(((word_entry_t *)elementp)->word, (const char *)keyp) == 0;
+}
+
+static void count_word(void *data) {
+    g_check.words++;
+}
+
+static void collect_word(void *data) {
+    g_check.vocab[g_check.words++] = ((word_entry_t *)data)->word;
+}
+
+// Stems a word of the lower index and looks the term up in the porter2 one (for happly)
+static void check_word(void *data) {
+    word_entry_t *entry = (word_entry_t *)data;
+    char term[MAX_WORD];
+    int len = strlen(entry->word);
+    if (len >= MAX_WORD) {
+        return;
+    }
+    memcpy(term, entry->word, len + 1);
+    len = analyzer_apply(ANALYZER_PORTER2, term, len);
+    if (len >= 3 && hsearch(g_check.stemmed, search_word, term, len) == NULL) {
+        if (g_check.missing++ == 0) {
+            fprintf(stderr, "FAIL: \"%s\" stems to \"%s\", which was not indexed\n", entry->word, term);
+        }
+    }
+}
+
+int main(int argc, char *argv[]) {
+    if (argc > 2) {
+        fprintf(stderr, "Usage: %s [pageDirectory]\n", argv[0]);
+        return 1;
+    }
+    int status = 0;
+    printf("Starting stemtest...\n");
+
+    // 1. Known stems
+    for (int i = 0; i < (int)(sizeof(vocabulary) / sizeof(vocabulary[0])); i++) {
+        char word[MAX_WORD];
+        strcpy(word, vocabulary[i][0]);
+        int len = stem_porter2(word, strlen(word));
+        if (len != (int)strlen(word) || strcmp(word, vocabulary[i][1]) != 0) {
+            fprintf(stderr, "FAIL: \"%s\" stems to \"%s\", expected \"%s\"\n",
+                    vocabulary[i][0], word, vocabulary[i][1]);
+            status = 1;
+        }
+    }
+
+    // 2. Both analyzers over real pages
+    if (argc == 2) {
+        webpage_t *pages[MAX_PAGES];
+        int num_pages = 0;
+        for (int id = 1; id <= MAX_PAGES; id++) {
+            webpage_t *page = pageload(id, argv[1]);
+            if (page != NULL) {
+                pages[num_pages++] = page;
+            }
+        }
+
+        hashtable_t *plain = index_new();
+        hashtable_t *stemmed = index_new();
+        double start = now();
+        long num_words = 0;
+        for (int i = 0; i < num_pages; i++) {
+            num_words += index_addpage(plain, pages[i], i + 1, ANALYZER_LOWER);
+        }
+        double lower_time = now() - start;
+        start = now();
+        for (int i = 0; i < num_pages; i++) {
+            index_addpage(stemmed, pages[i], i + 1, ANALYZER_PORTER2);
+        }
+        double porter2_time = now() - start;
+
+        g_check.stemmed = stemmed;
+        happly(plain, check_word);
+        if (g_check.missing > 0) {
+            fprintf(stderr, "FAIL: %ld words stem to terms that were not indexed\n", g_check.missing);
+            status = 1;
+        }
+        happly(plain, count_word);
+        long plain_terms = g_check.words;
+        g_check.words = 0;
+        happly(stemmed, count_word);
+        printf("%d pages: %ld terms with lower, %ld with porter2\n", num_pages, plain_terms, g_check.words);
+
+        // Stemming alone, over the pages' vocabulary
+        g_check.vocab = malloc(plain_terms * sizeof(char *));
+        g_check.words = 0;
+        happly(plain, collect_word);
+        start = now();
+        long stems = 0;
+        for (int round = 0; round < BENCH_ROUNDS; round++) {
+            for (long i = 0; i < g_check.words; i++) {
+                char word[MAX_WORD];
+                int len = strlen(g_check.vocab[i]);
+                if (len < MAX_WORD) {
+                    memcpy(word, g_check.vocab[i], len + 1);
+                    stems += stem_porter2(word, len) > 0;
+                }
+            }
+        }
+        double stem_time = now() - start;
+        free(g_check.vocab);
+        printf("indexing %.3f us/word with lower, %.3f with porter2; %.3f us/stem\n",
+               lower_time * 1e6 / num_words, porter2_time * 1e6 / num_words, stem_time * 1e6 / stems);
+
+        index_delete(plain);
+        index_delete(stemmed);
+        for (int i = 0; i < num_pages; i++) {
+            webpage_delete(pages[i]);
+        }
+    }
+
+    printf(status == 0 ? "PASS: the stems are Porter2's, and query words stem like indexed ones.\n" : "FAIL\n");
+    return status;
+}
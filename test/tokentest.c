@@ -0,0 +1,256 @@
+/*
+ * tokentest.c - test program for the 'tokenize' module
+ *
+ * Author: Insecticide
+ * Date: 10-17-2026
+ *
+ * Usage: ./tokentest [pageDirectory]
+ *
+ * Description:
+ * 1. Tokenizes random html-like text (letters of both cases, tags,
+ *    unbalanced '<' and '>', punctuation, UTF-8 letters and symbols,
+ *    stray high bytes, pieces of script, style and comment regions and
+ *    of entities) of every length around the block size with both the
+ *    vectorized tokenizer and the scalar webpage_getNextWordSpan(), and
+ *    checks that they find the same words at the same positions,
+ *    lowercased. The words reported by the html lexer are checked the
+ *    same way.
+ * 2. Checks that an embedded NUL does not end the vectorized scan.
+ * 3. Checks the words, folded, of a sentence in several scripts.
+ * 4. Checks that references to letters (caf&eacute;) join their words,
+ *    decoded, and that other references separate words.
+ * 5. If a <pageDirectory> is given, does the same check on its pages
+ *    and reports the throughput of both tokenizers on them.
+ * 6. Reports PASS/FAIL.
+ */
+
+#define _POSIX_C_SOURCE 200809L // clock_gettime
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "webpage.h"
+#include "pageio.h"
+#include "tokenize.h"
+#include "htmllex.h"
+#include "utf8.h"
+
+#define NUM_RANDOM 20000
+#define MAX_RANDOM_LEN 200
+#define MAX_PAGES 1000
+#define BENCH_ROUNDS 20
+
+static double now(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+// Sum over words of their offsets and lengths, to compare word lists
+typedef struct word_sum {
+    const char *html;
+    long count;
+    long sum;
+} word_sum_t;
+
+static void sum_word(const char *word, int len, void *arg) {
+    word_sum_t *ws = (word_sum_t *)arg;
+    ws->count++;
+    ws->sum += (word - ws->html) * 31 + len;
+}
+
+// Compares both tokenizers (and the lexer) on html[0..len); returns 0 if they agree
+static int compare(const char *html, int len) {
+    char *copy = malloc(len + 1);
+    memcpy(copy, html, len);
+    copy[len] = '\0';
+    webpage_t *page = webpage_new("http://test/", 0, copy);
+
+    char *lower = malloc(len + 1);
+    tokenizer_t tk;
+    tokenizer_init(&tk, html, len, lower);
+
+    word_sum_t scalar_sum = { html, 0, 0 }, lexer_sum = { html, 0, 0 };
+    htmllex_handler_t handler = { .word = sum_word, .arg = &lexer_sum };
+    htmllex_run(html, len, &handler);
+
+    int status = 0;
+    int pos = 0, fast_pos;
+    const char *word, *fast_word;
+    int word_len, fast_len;
+    while (status == 0) {
+        pos = webpage_getNextWordSpan(page, pos, &word, &word_len);
+        fast_pos = tokenizer_next(&tk, &fast_word, &fast_len);
+        if (pos < 0 || fast_pos < 0) {
+            status = (pos < 0) != (fast_pos < 0);
+            break;
+        }
+        if (pos != fast_pos || (int)strlen(fast_word) != fast_len) {
+            status = 1;
+        }
+        sum_word(html + (word - webpage_getHTML(page)), word_len, &scalar_sum);
+        if (status == 0) {
+            char *folded = malloc(word_len + 1);
+            int folded_len = htmllex_decode(word, word_len, folded);
+            utf8_fold_span(folded, folded_len);
+            status = folded_len != fast_len || memcmp(folded, fast_word, fast_len) != 0;
+            free(folded);
+        }
+    }
+    if (status == 0 && (scalar_sum.count != lexer_sum.count || scalar_sum.sum != lexer_sum.sum)) {
+        fprintf(stderr, "FAIL: the lexer's words differ on \"%.*s\"\n", len, html);
+        status = 1;
+    } else if (status != 0) {
+        fprintf(stderr, "FAIL: tokenizers disagree at offset %d on \"%.*s\"\n", pos, len, html);
+    }
+
+    free(lower);
+    webpage_delete(page);
+    return status;
+}
+
+// Random html-like text without NULs, with pieces of regions and references
+static void random_html(char *buf, int len) {
+    static const char pieces[] = "abcXYZ  <<>>/=\"!.-09";
+    static const char *const words[] = { "<script>", "</script>", "<Style a=1>", "</STYLE>", "<!--",
+                                         "-->", "&amp;", "&nbsp;", "&#65;", "&#x2019;", "&#;", "&bogus;",
+                                         "&eacute;", "&Eacute;", "&#x416;", "&szlig",
+                                         "&amp", ";", "<s", "<scripts>", "\xC3\xA9", "\xC3\x89",
+                                         "\xD0\x96", "\xD0\xB6", "\xCE\x86\xCE\xA3", "\xE4\xB8\xAD",
+                                         "\xE2\x80\x99", "\xE2\x82\xAC", "\xC3", "\xE2\x82" };
+    int i = 0;
+    while (i < len) {
+        int r = rand() % 28;
+        if (r < 20) {
+            buf[i++] = pieces[r];
+        } else if (r < 24) {
+            buf[i++] = (char)(0x80 + rand() % 0x80);
+        } else {
+            const char *w = words[rand() % (sizeof(words) / sizeof(words[0]))];
+            for (int j = 0; w[j] != '\0' && i < len; j++) {
+                buf[i++] = w[j];
+            }
+        }
+    }
+}
+
+int main(int argc, char *argv[]) {
+    if (argc > 2) {
+        fprintf(stderr, "Usage: %s [pageDirectory]\n", argv[0]);
+        return 1;
+    }
+    int status = 0;
+
+    printf("Starting tokentest...\n");
+
+    // 1. Random text of every short length, so words and tags straddle
+    //    block boundaries in every way
+    char buf[MAX_RANDOM_LEN];
+    srand(42);
+    for (int i = 0; i < NUM_RANDOM && status == 0; i++) {
+        int len = i % MAX_RANDOM_LEN;
+        random_html(buf, len);
+        status = compare(buf, len);
+    }
+
+    // 2. A NUL is a separator, not the end, for the vectorized tokenizer
+    const char with_nul[] = "<p>first\0second</p>";
+    char lower[sizeof(with_nul)];
+    tokenizer_t tk;
+    const char *word;
+    int len;
+    tokenizer_init(&tk, with_nul, sizeof(with_nul) - 1, lower);
+    if (tokenizer_next(&tk, &word, &len) < 0 || strcmp(word, "first") != 0 ||
+        tokenizer_next(&tk, &word, &len) < 0 || strcmp(word, "second") != 0 ||
+        tokenizer_next(&tk, &word, &len) >= 0) {
+        fprintf(stderr, "FAIL: an embedded NUL ended the vectorized scan\n");
+        status = 1;
+    }
+
+    // 3. Letters of other scripts join words, and fold; symbols separate them
+    const char *const scripts = "<p>CAF\xC3\x89 Stra\xC3\x9F" "e \xD0\x96\xD0\xA3\xD0\x9A\xE2\x80\x99s "
+                                "\xCE\x86\xCE\xA3\xCE\xA4\xCE\xA1\xCE\x9F \xE2\x82\xAC" "5 \xE4\xB8\xAD\xE6\x96\x87</p>";
+    const char *const expected[] = { "caf\xC3\xA9", "stra\xC3\x9F" "e", "\xD0\xB6\xD1\x83\xD0\xBA", "s",
+                                     "\xCE\xAC\xCF\x83\xCF\x84\xCF\x81\xCE\xBF", "\xE4\xB8\xAD\xE6\x96\x87" };
+    int num_scripts = (int)strlen(scripts);
+    char *folded = malloc(num_scripts + 1);
+    tokenizer_init(&tk, scripts, num_scripts, folded);
+    for (int i = 0; i < (int)(sizeof(expected) / sizeof(expected[0])) && status == 0; i++) {
+        if (tokenizer_next(&tk, &word, &len) < 0 || strcmp(word, expected[i]) != 0) {
+            fprintf(stderr, "FAIL: word %d of the multi-script sentence is not \"%s\"\n", i, expected[i]);
+            status = 1;
+        }
+    }
+    if (status == 0 && tokenizer_next(&tk, &word, &len) >= 0) {
+        fprintf(stderr, "FAIL: the multi-script sentence has too many words\n");
+        status = 1;
+    }
+    free(folded);
+    status |= compare(scripts, num_scripts);
+
+    // 4. A reference to a letter is part of its word; any other separates words
+    const char *const refs = "<p>Caf&eacute; na&#xEF;ve &Eacute;t&eacute; rock&amp;roll</p>";
+    const char *const decoded[] = { "caf\xC3\xA9", "na\xC3\xAFve", "\xC3\xA9t\xC3\xA9", "rock", "roll" };
+    int num_refs = (int)strlen(refs);
+    folded = malloc(num_refs + 1);
+    tokenizer_init(&tk, refs, num_refs, folded);
+    for (int i = 0; i < (int)(sizeof(decoded) / sizeof(decoded[0])) && status == 0; i++) {
+        if (tokenizer_next(&tk, &word, &len) < 0 || strcmp(word, decoded[i]) != 0) {
+            fprintf(stderr, "FAIL: word %d of the sentence with references is not \"%s\"\n", i, decoded[i]);
+            status = 1;
+        }
+    }
+    free(folded);
+    status |= compare(refs, num_refs);
+
+    // 5. Real pages, and throughput
+    if (argc == 2 && status == 0) {
+        webpage_t *pages[MAX_PAGES];
+        int num_pages = 0;
+        long bytes = 0;
+        while (num_pages < MAX_PAGES && (pages[num_pages] = pageload(num_pages + 1, argv[1])) != NULL) {
+            bytes += webpage_getHTMLlen(pages[num_pages]);
+            status |= compare(webpage_getHTML(pages[num_pages]), webpage_getHTMLlen(pages[num_pages]));
+            num_pages++;
+        }
+
+        long words = 0;
+        double start = now();
+        for (int round = 0; round < BENCH_ROUNDS; round++) {
+            for (int i = 0; i < num_pages; i++) {
+                int pos = 0;
+                while ((pos = webpage_getNextWordSpan(pages[i], pos, &word, &len)) > 0) {
+                    words++;
+                }
+            }
+        }
+        double scalar = now() - start;
+
+        start = now();
+        for (int round = 0; round < BENCH_ROUNDS; round++) {
+            for (int i = 0; i < num_pages; i++) {
+                char *lowered = malloc(webpage_getHTMLlen(pages[i]) + 1);
+                tokenizer_init(&tk, webpage_getHTML(pages[i]), webpage_getHTMLlen(pages[i]), lowered);
+                while (tokenizer_next(&tk, &word, &len) > 0) {
+                    words--;
+                }
+                free(lowered);
+            }
+        }
+        double fast = now() - start;
+
+        printf("%d pages, %ld bytes: scalar %.0f MB/s, vectorized %.0f MB/s\n", num_pages, bytes,
+               BENCH_ROUNDS * bytes / 1e6 / scalar, BENCH_ROUNDS * bytes / 1e6 / fast);
+        if (words != 0) {
+            fprintf(stderr, "FAIL: the tokenizers found different numbers of words\n");
+            status = 1;
+        }
+        for (int i = 0; i < num_pages; i++) {
+            webpage_delete(pages[i]);
+        }
+    }
+
+    printf(status == 0 ? "PASS: the vectorized tokenizer matches the scalar one.\n" : "FAIL\n");
+    return status;
+}
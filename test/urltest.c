@@ -0,0 +1,281 @@
+/*
+ * urltest.c - test program for the 'url' module
+ *
+ * Author: Insecticide
+ * Date: 10-17-2026
+ *
+ * Usage: ./urltest [pageDirectory]
+ *
+ * Description:
+ * 1. Builds random URLs from tricky pieces (mixed case, user info,
+ *    dot segments, extensions, queries, fragments) and checks that
+ *    url_normalize() gives what NormalizeURL() gives.
+ * 2. Resolves random links against random base URLs and checks that
+ *    url_resolve_link() and url_memo_resolve() agree with
+ *    webpage_resolveURL() followed by NormalizeURL().
+ * 3. If a <pageDirectory> is given, does the same for every link on
+ *    its pages and reports the time both ways take.
+ * 4. Reports PASS/FAIL.
+ */
+
+#define _POSIX_C_SOURCE 200809L // clock_gettime
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "webpage.h"
+#include "pageio.h"
+#include "htmllex.h"
+#include "url.h"
+
+#define NUM_RANDOM 20000
+#define MAX_PAGES 1000
+#define MAX_LINKS 100000
+#define BENCH_ROUNDS 20
+
+static const char *schemes[] = { "http://", "HTTP://", "https://", "hTTps://", "http:", "ftp://" };
+static const char *users[] = { "", "", "", "UsEr:PaSs@" };
+static const char *hosts[] = { "www.EXAMPLE.com", "thayer.github.io", "Host:8080", "" };
+static const char *segments[] = { "/", "/a", "/B", "/.", "/..", "/./", "/../", "/...", "/.x",
+                                  "//", "/c.html", "/d.HTM", "/e.php3", "/f.jpg", "/g.", "/h.jsp" };
+static const char *queries[] = { "", "", "?q=1", "?a=/../b.jpg", "?" };
+static const char *fragments[] = { "", "", "#top", "#a?b", "#" };
+static const char *links[] = { "", " ", "#top", "a.html", "../b.html", "/c/./d.html", "./",
+                               "..", "x/../y.html", "?q", "mailto:x@y", "HTTP://Foo.COM/A/../b",
+                               " sp ace.html\n", "ftp://x/", "java\nscript:go()", "HtTp:", "a:b",
+                               "img.png", "dir/", "/", "../../../z", "q.php#x", "h" };
+
+static double now(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+#define PICK(a) (a[rand() % (sizeof(a) / sizeof(a[0]))])
+
+// Random absolute URL into buf
+static void random_url(char *buf) {
+    strcpy(buf, PICK(schemes));
+    strcat(buf, PICK(users));
+    strcat(buf, PICK(hosts));
+    for (int n = rand() % 5; n > 0; n--) {
+        strcat(buf, PICK(segments));
+    }
+    strcat(buf, PICK(queries));
+    strcat(buf, PICK(fragments));
+}
+
+/*
+ * Whether NormalizeURL() can be trusted with url: its parser misbehaves
+ * when a '?' or '#' comes before the first '/' after the scheme (the
+ * fast path rejects such URLs).
+ */
+static int oracle_safe(const char *url) {
+    const char *p = strpbrk(url, ":/?#");
+    if (p == NULL || *p != ':') {
+        return 1; // rejected before parsing
+    }
+    p++;
+    if (strncmp(p, "//", 2) == 0) {
+        p += 2;
+    }
+    const char *slash = strchr(p, '/');
+    const char *mark = strpbrk(p, "?#");
+    return mark == NULL || (slash != NULL && slash < mark);
+}
+
+// NormalizeURL() on a copy of url; returns the result, or NULL if invalid
+static char *old_normalize(const char *url) {
+    char *copy = malloc(strlen(url) + 1);
+    strcpy(copy, url);
+    if (!NormalizeURL(copy)) {
+        free(copy);
+        return NULL;
+    }
+    return copy;
+}
+
+// Checks one URL both ways; returns 0 if they agree
+static int check_normalize(const char *url) {
+    char out[URL_MAXLEN];
+    int len = url_normalize(url, strlen(url), out, sizeof(out));
+    if (!oracle_safe(url)) {
+        if (len != URL_INVALID) {
+            fprintf(stderr, "FAIL: accepted unparsable \"%s\"\n", url);
+            return 1;
+        }
+        return 0;
+    }
+    char *expect = old_normalize(url);
+    int status = (expect == NULL) ? len != URL_INVALID
+                                  : (len != (int)strlen(expect) || strcmp(out, expect) != 0);
+    if (status != 0) {
+        fprintf(stderr, "FAIL: normalizing \"%s\": expected \"%s\", got \"%s\"\n",
+                url, expect ? expect : "(invalid)", len >= 0 ? out : "(invalid)");
+    }
+    free(expect);
+    return status;
+}
+
+// Checks one link on page both ways, and through memo; returns 0 if they agree
+static int check_link(webpage_t *page, url_memo_t *memo, const char *href, int href_len) {
+    char out[URL_MAXLEN];
+    const char *memo_url;
+    int len = url_resolve_link(webpage_getURL(page), href, href_len, out, sizeof(out));
+    int memo_len = url_memo_resolve(memo, href, href_len, &memo_url);
+
+    char *expect = NULL;
+    char *resolved = webpage_resolveURL(page, href, href_len);
+    if (resolved != NULL && oracle_safe(resolved)) {
+        expect = old_normalize(resolved);
+    } else if (resolved != NULL && len != URL_INVALID) {
+        fprintf(stderr, "FAIL: accepted unparsable \"%s\"\n", resolved);
+        free(resolved);
+        return 1;
+    }
+    free(resolved);
+
+    int status = (expect == NULL) ? len != URL_INVALID
+                                  : (len != (int)strlen(expect) || strcmp(out, expect) != 0);
+    status |= memo_len != len || (len >= 0 && strcmp(memo_url, out) != 0);
+    if (status != 0) {
+        fprintf(stderr, "FAIL: resolving \"%.*s\" on \"%s\": expected \"%s\", got \"%s\"\n",
+                href_len, href, webpage_getURL(page), expect ? expect : "(invalid)",
+                len >= 0 ? out : "(invalid)");
+    }
+    free(expect);
+    return status;
+}
+
+// A link found on a page
+typedef struct link {
+    int page;
+    const char *href;
+    int len;
+} link_t;
+
+// Where the lexer's link callback collects the links of the pages
+typedef struct link_list {
+    int page;
+    link_t *links;
+    int num_links;
+} link_list_t;
+
+static void link_helper(const char *href, int href_len, const char *text, int text_len, void *arg) {
+    link_list_t *list = (link_list_t *)arg;
+    if (list->num_links < MAX_LINKS) {
+        link_t link = { list->page, href, href_len };
+        list->links[list->num_links++] = link;
+    }
+}
+
+int main(int argc, char *argv[]) {
+    if (argc > 2) {
+        fprintf(stderr, "Usage: %s [pageDirectory]\n", argv[0]);
+        return 1;
+    }
+    int status = 0;
+    url_memo_t *memo = calloc(1, sizeof(url_memo_t));
+
+    printf("Starting urltest...\n");
+
+    // 1. Normalizing random URLs
+    char base[512];
+    srand(42);
+    for (int i = 0; i < NUM_RANDOM && status == 0; i++) {
+        random_url(base);
+        status = check_normalize(base);
+    }
+
+    // 2. Resolving random links against random bases (each base a few
+    //    times, so the memo sees repeats)
+    for (int i = 0; i < NUM_RANDOM / 10 && status == 0; i++) {
+        do {
+            random_url(base);
+        } while (!oracle_safe(base));
+        webpage_t *page = webpage_new(base, 0, NULL);
+        url_memo_reset(memo, webpage_getURL(page));
+        char hrefs[20][64]; // the memo keeps pointers to them
+        for (int j = 0; j < 20 && status == 0; j++) {
+            strcpy(hrefs[j], PICK(links));
+            if (rand() % 2) {
+                strcat(hrefs[j], PICK(links));
+            }
+            status = check_link(page, memo, hrefs[j], strlen(hrefs[j]));
+        }
+        webpage_delete(page);
+    }
+
+    // 3. Every link of real pages, and timing
+    if (argc == 2 && status == 0) {
+        webpage_t *pages[MAX_PAGES];
+        int num_pages = 0;
+        while (num_pages < MAX_PAGES && (pages[num_pages] = pageload(num_pages + 1, argv[1])) != NULL) {
+            num_pages++;
+        }
+
+        link_list_t list = { 0, malloc(MAX_LINKS * sizeof(link_t)), 0 };
+        htmllex_handler_t handler = { .link = link_helper, .arg = &list };
+        for (list.page = 0; list.page < num_pages; list.page++) {
+            webpage_t *page = pages[list.page];
+            htmllex_run(webpage_getHTML(page), webpage_getHTMLlen(page), &handler);
+        }
+        link_t *links = list.links;
+        int num_links = list.num_links;
+        for (int i = 0, page = -1; i < num_links; i++) {
+            if (links[i].page != page) {
+                page = links[i].page;
+                url_memo_reset(memo, webpage_getURL(pages[page]));
+            }
+            status |= check_link(pages[page], memo, links[i].href, links[i].len);
+        }
+
+        // What the crawler does with each link: resolve, normalize, check the prefix
+        int slow_internal = 0;
+        double start = now();
+        for (int round = 0; round < BENCH_ROUNDS; round++) {
+            for (int i = 0; i < num_links; i++) {
+                char *url = webpage_resolveURL(pages[links[i].page], links[i].href, links[i].len);
+                if (url != NULL) {
+                    slow_internal += IsInternalURL(url);
+                    free(url);
+                }
+            }
+        }
+        double slow = now() - start;
+
+        int fast_internal = 0;
+        size_t prefix_len = strlen(INTERNAL_URL_PREFIX);
+        start = now();
+        for (int round = 0; round < BENCH_ROUNDS; round++) {
+            for (int i = 0, page = -1; i < num_links; i++) {
+                if (links[i].page != page) {
+                    page = links[i].page;
+                    url_memo_reset(memo, webpage_getURL(pages[page]));
+                }
+                const char *url;
+                if (url_memo_resolve(memo, links[i].href, links[i].len, &url) >= 0) {
+                    fast_internal += strncmp(url, INTERNAL_URL_PREFIX, prefix_len) == 0;
+                }
+            }
+        }
+        double fast = now() - start;
+
+        printf("%d pages, %d links: old path %.3f us/link, span path with memo %.3f us/link\n",
+               num_pages, num_links, slow * 1e6 / (BENCH_ROUNDS * num_links),
+               fast * 1e6 / (BENCH_ROUNDS * num_links));
+        if (slow_internal != fast_internal) {
+            fprintf(stderr, "FAIL: the two paths found different internal links\n");
+            status = 1;
+        }
+        free(links);
+        for (int i = 0; i < num_pages; i++) {
+            webpage_delete(pages[i]);
+        }
+    }
+
+    free(memo);
+    printf(status == 0 ? "PASS: the span-based URL functions match the webpage ones.\n" : "FAIL\n");
+    return status;
+}
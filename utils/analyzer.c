@@ -0,0 +1,418 @@
+/*
+ * analyzer.c - implementation of the word analyzers
+ *
+ * Author: Insecticide
+ * Date: 10-17-2026
+ *
+ * Description: The Porter2 stemmer follows the Snowball English
+ * algorithm step by step. Steps 1b to 4 each remove the longest of a
+ * table of suffixes, split by last letter and sorted longest first, so
+ * the word's last letter picks the few rules to try and the first that
+ * matches is the one to apply; if its condition fails, the step does
+ * nothing. Words are assumed to be lowercase, which is what the
+ * tokenizer produces; the bytes of a UTF-8 letter count as consonants,
+ * so only English suffixes are ever removed. A 'y' that acts as a
+ * consonant is marked 'Y' while the stem is being worked on. See
+ * analyzer.h.
+ */
+
+#include <stdbool.h>
+#include <string.h>
+#include "analyzer.h"
+
+static const char *names[] = { "lower", "porter2" };
+
+// When a suffix may be replaced, given where it starts
+typedef enum rule_cond {
+    IN_R1,          // the suffix is in R1
+    IN_R2,          // the suffix is in R2
+    HAS_VOWEL,      // what precedes it contains a vowel
+    AFTER_L,        // in R1, after an 'l'
+    AFTER_LI_END,   // in R1, after a valid li-ending
+    AFTER_S_OR_T    // in R2, after an 's' or a 't'
+} rule_cond_t;
+
+typedef struct rule {
+    const char *suffix;
+    int suffix_len;
+    const char *replace;
+    int replace_len;
+    rule_cond_t cond;
+} rule_t;
+
+// The rules of a step for one last letter, longest suffix first
+typedef struct rule_set {
+    const rule_t *rules;
+    int num_rules;
+} rule_set_t;
+
+#define RULE(s, r, cond) { s, sizeof(s) - 1, r, sizeof(r) - 1, cond }
+#define COUNT(a) ((int)(sizeof(a) / sizeof(a[0])))
+#define SET(letter, rules) [letter - 'a'] = { rules, COUNT(rules) }
+
+static const rule_t step1b_d[] = { RULE("eed", "ee", IN_R1), RULE("ed", "", HAS_VOWEL) };
+static const rule_t step1b_g[] = { RULE("ing", "", HAS_VOWEL) };
+static const rule_t step1b_y[] = {
+    RULE("eedly", "ee", IN_R1), RULE("ingly", "", HAS_VOWEL), RULE("edly", "", HAS_VOWEL)
+};
+static const rule_set_t step1b[26] = { SET('d', step1b_d), SET('g', step1b_g), SET('y', step1b_y) };
+
+static const rule_t step2_i[] = {
+    RULE("biliti", "ble", IN_R1), RULE("lessli", "less", IN_R1), RULE("entli", "ent", IN_R1),
+    RULE("aliti", "al", IN_R1), RULE("ousli", "ous", IN_R1), RULE("iviti", "ive", IN_R1),
+    RULE("fulli", "ful", IN_R1), RULE("enci", "ence", IN_R1), RULE("anci", "ance", IN_R1),
+    RULE("abli", "able", IN_R1), RULE("alli", "al", IN_R1), RULE("bli", "ble", IN_R1),
+    RULE("ogi", "og", AFTER_L), RULE("li", "", AFTER_LI_END)
+};
+static const rule_t step2_l[] = { RULE("ational", "ate", IN_R1), RULE("tional", "tion", IN_R1) };
+static const rule_t step2_m[] = { RULE("alism", "al", IN_R1) };
+static const rule_t step2_n[] = { RULE("ization", "ize", IN_R1), RULE("ation", "ate", IN_R1) };
+static const rule_t step2_r[] = { RULE("izer", "ize", IN_R1), RULE("ator", "ate", IN_R1) };
+static const rule_t step2_s[] = {
+    RULE("fulness", "ful", IN_R1), RULE("ousness", "ous", IN_R1), RULE("iveness", "ive", IN_R1)
+};
+static const rule_set_t step2[26] = {
+    SET('i', step2_i), SET('l', step2_l), SET('m', step2_m), SET('n', step2_n), SET('r', step2_r),
+    SET('s', step2_s)
+};
+
+static const rule_t step3_e[] = {
+    RULE("alize", "al", IN_R1), RULE("icate", "ic", IN_R1), RULE("ative", "", IN_R2)
+};
+static const rule_t step3_i[] = { RULE("iciti", "ic", IN_R1) };
+static const rule_t step3_l[] = {
+    RULE("ational", "ate", IN_R1), RULE("tional", "tion", IN_R1), RULE("ical", "ic", IN_R1),
+    RULE("ful", "", IN_R1)
+};
+static const rule_t step3_s[] = { RULE("ness", "", IN_R1) };
+static const rule_set_t step3[26] = {
+    SET('e', step3_e), SET('i', step3_i), SET('l', step3_l), SET('s', step3_s)
+};
+
+static const rule_t step4_c[] = { RULE("ic", "", IN_R2) };
+static const rule_t step4_e[] = {
+    RULE("ance", "", IN_R2), RULE("ence", "", IN_R2), RULE("able", "", IN_R2), RULE("ible", "", IN_R2),
+    RULE("ate", "", IN_R2), RULE("ive", "", IN_R2), RULE("ize", "", IN_R2)
+};
+static const rule_t step4_i[] = { RULE("iti", "", IN_R2) };
+static const rule_t step4_l[] = { RULE("al", "", IN_R2) };
+static const rule_t step4_m[] = { RULE("ism", "", IN_R2) };
+static const rule_t step4_n[] = { RULE("ion", "", AFTER_S_OR_T) };
+static const rule_t step4_r[] = { RULE("er", "", IN_R2) };
+static const rule_t step4_s[] = { RULE("ous", "", IN_R2) };
+static const rule_t step4_t[] = {
+    RULE("ement", "", IN_R2), RULE("ment", "", IN_R2), RULE("ant", "", IN_R2), RULE("ent", "", IN_R2)
+};
+static const rule_set_t step4[26] = {
+    SET('c', step4_c), SET('e', step4_e), SET('i', step4_i), SET('l', step4_l), SET('m', step4_m),
+    SET('n', step4_n), SET('r', step4_r), SET('s', step4_s), SET('t', step4_t)
+};
+
+// A word and what it stems to
+typedef struct exception {
+    const char *word;
+    int word_len;
+    const char *stem;
+    int stem_len;
+} exception_t;
+
+#define EXCEPTION(w, s) { w, sizeof(w) - 1, s, sizeof(s) - 1 }
+#define MAX_EXCEPTION 7 // no exception is longer
+
+// Words with a stem of their own, checked first
+static const exception_t exceptions[] = {
+    EXCEPTION("skis", "ski"), EXCEPTION("skies", "sky"), EXCEPTION("dying", "die"),
+    EXCEPTION("lying", "lie"), EXCEPTION("tying", "tie"), EXCEPTION("idly", "idl"),
+    EXCEPTION("gently", "gentl"), EXCEPTION("ugly", "ugli"), EXCEPTION("early", "earli"),
+    EXCEPTION("only", "onli"), EXCEPTION("singly", "singl"), EXCEPTION("sky", "sky"),
+    EXCEPTION("news", "news"), EXCEPTION("howe", "howe"), EXCEPTION("atlas", "atlas"),
+    EXCEPTION("cosmos", "cosmos"), EXCEPTION("bias", "bias"), EXCEPTION("andes", "andes")
+};
+
+// Words left alone once step 1a is done
+static const exception_t invariants[] = {
+    EXCEPTION("inning", "inning"), EXCEPTION("outing", "outing"), EXCEPTION("canning", "canning"),
+    EXCEPTION("herring", "herring"), EXCEPTION("earring", "earring"), EXCEPTION("proceed", "proceed"),
+    EXCEPTION("exceed", "exceed"), EXCEPTION("succeed", "succeed")
+};
+
+// A word being stemmed: w[0..len), with regions R1 = w[r1..) and R2 = w[r2..)
+typedef struct stem {
+    char *w;
+    int len;
+    int r1;
+    int r2;
+} stem_t;
+
+// --- Static helper function prototypes ---
+static bool is_vowel(char c);
+static bool ends_with(const stem_t *s, const char *suffix, int suffix_len);
+static bool has_vowel(const char *w, int len);
+static bool ends_short_syllable(const char *w, int len);
+static int region_after(const char *w, int from, int len);
+static void mark_regions(stem_t *s);
+static const rule_t *apply_rules(stem_t *s, const rule_set_t *step);
+static bool rule_holds(const stem_t *s, const rule_t *rule, int at);
+static void step_1a(stem_t *s);
+static void step_1b(stem_t *s);
+static void step_1c(stem_t *s);
+static void step_5(stem_t *s);
+static const exception_t *find_exception(const exception_t *table, int size, const char *w, int len);
+
+/*
+ * analyzer_name - Its entry in the names table.
+ */
+const char *analyzer_name(analyzer_t analyzer) {
+    return names[analyzer];
+}
+
+/*
+ * analyzer_lookup - Searches the names table.
+ */
+int analyzer_lookup(const char *name) {
+    for (int i = 0; i < COUNT(names); i++) {
+        if (strcmp(names[i], name) == 0) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+/*
+ * analyzer_apply - Stems the word, or leaves it as it is.
+ */
+int analyzer_apply(analyzer_t analyzer, char *word, int len) {
+    if (analyzer == ANALYZER_PORTER2) {
+        return stem_porter2(word, len);
+    }
+    word[len] = '\0';
+    return len;
+}
+
+/*
+ * stem_porter2 - Runs the steps of the algorithm in order.
+ */
+int stem_porter2(char *word, int len) {
+    const exception_t *exception = find_exception(exceptions, COUNT(exceptions), word, len);
+    if (exception != NULL) {
+        memcpy(word, exception->stem, exception->stem_len);
+        word[exception->stem_len] = '\0';
+        return exception->stem_len;
+    }
+    if (len <= 2) {
+        word[len] = '\0';
+        return len;
+    }
+
+    // A 'y' at the start or after a vowel is a consonant
+    if (word[0] == 'y') {
+        word[0] = 'Y';
+    }
+    for (int i = 1; i < len; i++) {
+        if (word[i] == 'y' && is_vowel(word[i - 1])) {
+            word[i] = 'Y';
+        }
+    }
+
+    stem_t s = { word, len, 0, 0 };
+    mark_regions(&s);
+    step_1a(&s);
+    if (find_exception(invariants, COUNT(invariants), s.w, s.len) == NULL) {
+        step_1b(&s);
+        step_1c(&s);
+        apply_rules(&s, step2);
+        apply_rules(&s, step3);
+        apply_rules(&s, step4);
+        step_5(&s);
+    }
+
+    for (int i = 0; i < s.len; i++) {
+        if (word[i] == 'Y') {
+            word[i] = 'y';
+        }
+    }
+    word[s.len] = '\0';
+    return s.len;
+}
+
+
+// --- Helper Functions ---
+
+static bool is_vowel(char c) {
+    switch (c) {
+    case 'a': case 'e': case 'i': case 'o': case 'u': case 'y':
+        return true;
+    default:
+        return false;
+    }
+}
+
+// Compares from the end, where most candidates already differ
+static bool ends_with(const stem_t *s, const char *suffix, int suffix_len) {
+    if (s->len < suffix_len) {
+        return false;
+    }
+    const char *end = s->w + s->len;
+    for (int i = 1; i <= suffix_len; i++) {
+        if (end[-i] != suffix[suffix_len - i]) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static bool has_vowel(const char *w, int len) {
+    for (int i = 0; i < len; i++) {
+        if (is_vowel(w[i])) {
+            return true;
+        }
+    }
+    return false;
+}
+
+/*
+ * Whether w[0..len) ends in a short syllable: a vowel between two
+ * non-vowels, the last not 'w', 'x' or 'Y'; or, for two letters, a
+ * vowel then a non-vowel.
+ */
+static bool ends_short_syllable(const char *w, int len) {
+    if (len == 2) {
+        return is_vowel(w[0]) && !is_vowel(w[1]);
+    }
+    return len >= 3 && !is_vowel(w[len - 3]) && is_vowel(w[len - 2]) && !is_vowel(w[len - 1]) &&
+           w[len - 1] != 'w' && w[len - 1] != 'x' && w[len - 1] != 'Y';
+}
+
+// Where the region after the first non-vowel following a vowel in w[from..len) starts
+static int region_after(const char *w, int from, int len) {
+    for (int i = from + 1; i < len; i++) {
+        if (is_vowel(w[i - 1]) && !is_vowel(w[i])) {
+            return i + 1;
+        }
+    }
+    return len;
+}
+
+// Finds R1 and R2, with the algorithm's exceptions for R1
+static void mark_regions(stem_t *s) {
+    static const char *prefixes[] = { "gener", "commun", "arsen" };
+    s->r1 = -1;
+    for (int i = 0; i < COUNT(prefixes); i++) {
+        int n = strlen(prefixes[i]);
+        if (s->len >= n && memcmp(s->w, prefixes[i], n) == 0) {
+            s->r1 = n;
+        }
+    }
+    if (s->r1 < 0) {
+        s->r1 = region_after(s->w, 0, s->len);
+    }
+    s->r2 = region_after(s->w, s->r1, s->len);
+}
+
+/*
+ * Replaces the longest suffix of step's that the word ends with, if its
+ * condition holds. Returns the rule applied, or NULL.
+ */
+static const rule_t *apply_rules(stem_t *s, const rule_set_t *step) {
+    char last = s->w[s->len - 1];
+    if (last < 'a' || last > 'z') {
+        return NULL; // 'Y'
+    }
+    const rule_set_t *set = &step[last - 'a'];
+    for (int i = 0; i < set->num_rules; i++) {
+        const rule_t *rule = &set->rules[i];
+        if (!ends_with(s, rule->suffix, rule->suffix_len)) {
+            continue;
+        }
+        int at = s->len - rule->suffix_len;
+        if (!rule_holds(s, rule, at)) {
+            return NULL;
+        }
+        memcpy(s->w + at, rule->replace, rule->replace_len);
+        s->len = at + rule->replace_len;
+        return rule;
+    }
+    return NULL;
+}
+
+// Whether rule's condition holds for its suffix starting at w[at]
+static bool rule_holds(const stem_t *s, const rule_t *rule, int at) {
+    switch (rule->cond) {
+    case IN_R1:
+        return at >= s->r1;
+    case IN_R2:
+        return at >= s->r2;
+    case HAS_VOWEL:
+        return has_vowel(s->w, at);
+    case AFTER_L:
+        return at >= s->r1 && at > 0 && s->w[at - 1] == 'l';
+    case AFTER_LI_END:
+        return at >= s->r1 && at > 0 && strchr("cdeghkmnrt", s->w[at - 1]) != NULL;
+    case AFTER_S_OR_T:
+        return at >= s->r2 && at > 0 && (s->w[at - 1] == 's' || s->w[at - 1] == 't');
+    }
+    return false;
+}
+
+// Plurals: sses, ied, ies, s
+static void step_1a(stem_t *s) {
+    if (ends_with(s, "sses", 4)) {
+        s->len -= 2;
+    } else if (ends_with(s, "ied", 3) || ends_with(s, "ies", 3)) {
+        s->len -= (s->len > 4) ? 2 : 1; // to "i", or to "ie" after a single letter
+    } else if (ends_with(s, "us", 2) || ends_with(s, "ss", 2)) {
+        return;
+    } else if (ends_with(s, "s", 1) && has_vowel(s->w, s->len - 2)) {
+        s->len--;
+    }
+}
+
+// ed, ing and ly endings, tidying up what is left after removing one
+static void step_1b(stem_t *s) {
+    const rule_t *rule = apply_rules(s, step1b);
+    if (rule == NULL || rule->cond != HAS_VOWEL) {
+        return; // nothing removed, or eed(ly) became ee
+    }
+    char *w = s->w;
+    int len = s->len;
+    if (ends_with(s, "at", 2) || ends_with(s, "bl", 2) || ends_with(s, "iz", 2)) {
+        w[s->len++] = 'e';
+    } else if (len >= 2 && w[len - 1] == w[len - 2] && strchr("bdfgmnprt", w[len - 1]) != NULL) {
+        s->len--;
+    } else if (s->r1 >= len && ends_short_syllable(w, len)) {
+        w[s->len++] = 'e';
+    }
+}
+
+// A final y after a consonant (not the first letter) becomes i
+static void step_1c(stem_t *s) {
+    char last = s->w[s->len - 1];
+    if ((last == 'y' || last == 'Y') && s->len > 2 && !is_vowel(s->w[s->len - 2])) {
+        s->w[s->len - 1] = 'i';
+    }
+}
+
+// A final e, or the second l of a final ll
+static void step_5(stem_t *s) {
+    int at = s->len - 1;
+    if (s->w[at] == 'e') {
+        if (at >= s->r2 || (at >= s->r1 && !ends_short_syllable(s->w, at))) {
+            s->len--;
+        }
+    } else if (s->w[at] == 'l' && at >= s->r2 && s->w[at - 1] == 'l') {
+        s->len--;
+    }
+}
+
+// The entry of table for w[0..len), or NULL
+static const exception_t *find_exception(const exception_t *table, int size, const char *w, int len) {
+    if (len > MAX_EXCEPTION) {
+        return NULL;
+    }
+    for (int i = 0; i < size; i++) {
+        if (table[i].word_len == len && table[i].word[0] == w[0] && memcmp(w, table[i].word, len) == 0) {
+            return &table[i];
+        }
+    }
+    return NULL;
+}
@@ -0,0 +1,44 @@
+/*
+ * analyzer.h - header file for the word analyzers
+ *
+ * Author: Insecticide
+ * Date: 10-17-2026
+ *
+ * Description: An analyzer turns a lowercased word from the tokenizer
+ * into the term that is indexed, and a query word into the term that
+ * is looked up; the two must use the same one. An index records the
+ * analyzer it was built with (see indexio.h).
+ *
+ *   lower    - the word as it is (the tokenizer already lowercased it)
+ *   porter2  - the word's Porter2 (Snowball English) stem, so that
+ *              "connect", "connected" and "connection" are one term
+ */
+
+#pragma once
+
+typedef enum analyzer {
+    ANALYZER_LOWER,
+    ANALYZER_PORTER2
+} analyzer_t;
+
+/* analyzer_name -- the name an index records for analyzer */
+const char *analyzer_name(analyzer_t analyzer);
+
+/* analyzer_lookup -- the analyzer called name
+ * returns -1 if there is none
+ */
+int analyzer_lookup(const char *name);
+
+/*
+ * analyzer_apply - Rewrites the lowercased word[0..len) in place into
+ * its term, which is never longer, and NUL-terminates it.
+ * Returns the term's length.
+ */
+int analyzer_apply(analyzer_t analyzer, char *word, int len);
+
+/*
+ * stem_porter2 - Replaces the lowercased word[0..len) with its
+ * Porter2 stem, in place, and NUL-terminates it.
+ * Returns the stem's length (at most len).
+ */
+int stem_porter2(char *word, int len);
@@ -0,0 +1,112 @@
+/*
+ * bqueue.c - implementation of the bounded blocking queue module
+ *
+ * Author: Insecticide
+ * Date: 10-17-2026
+ *
+ * Description: A ring buffer guarded by one mutex and two condition
+ * variables (not_full for producers, not_empty for consumers).
+ */
+
+#include <stdlib.h>
+#include <pthread.h>
+#include "bqueue.h"
+
+struct bqueue {
+    void **slots;             // ring buffer of elements
+    int capacity;             // size of slots
+    int head;                 // index of the first element
+    int count;                // number of elements in the ring
+    bool done;                // no more puts will happen
+    pthread_mutex_t lock;
+    pthread_cond_t not_full;  // signalled when an element is taken
+    pthread_cond_t not_empty; // signalled when an element is added
+};
+
+bqueue_t *bqopen(int capacity) {
+    if (capacity <= 0) return NULL;
+    bqueue_t *bq = malloc(sizeof(bqueue_t));
+    if (bq == NULL) return NULL;
+    bq->slots = calloc(capacity, sizeof(void*));
+    if (bq->slots == NULL) {
+        free(bq);
+        return NULL;
+    }
+    bq->capacity = capacity;
+    bq->head = 0;
+    bq->count = 0;
+    bq->done = false;
+    pthread_mutex_init(&bq->lock, NULL);
+    pthread_cond_init(&bq->not_full, NULL);
+    pthread_cond_init(&bq->not_empty, NULL);
+    return bq;
+}
+
+void bqclose(bqueue_t *bqp) {
+    if (bqp == NULL) return;
+    pthread_mutex_destroy(&bqp->lock);
+    pthread_cond_destroy(&bqp->not_full);
+    pthread_cond_destroy(&bqp->not_empty);
+    free(bqp->slots);
+    free(bqp);
+}
+
+int32_t bqput(bqueue_t *bqp, void *elementp) {
+    if (bqp == NULL || elementp == NULL) return 1;
+
+    pthread_mutex_lock(&bqp->lock);
+    while (bqp->count == bqp->capacity && !bqp->done) {
+        pthread_cond_wait(&bqp->not_full, &bqp->lock);
+    }
+    if (bqp->done) {
+        pthread_mutex_unlock(&bqp->lock);
+        return 1;
+    }
+    bqp->slots[(bqp->head + bqp->count) % bqp->capacity] = elementp;
+    bqp->count++;
+    pthread_cond_signal(&bqp->not_empty);
+    pthread_mutex_unlock(&bqp->lock);
+    return 0;
+}
+
+void *bqget(bqueue_t *bqp) {
+    if (bqp == NULL) return NULL;
+
+    pthread_mutex_lock(&bqp->lock);
+    while (bqp->count == 0 && !bqp->done) {
+        pthread_cond_wait(&bqp->not_empty, &bqp->lock);
+    }
+    void *data = NULL;
+    if (bqp->count > 0) {
+        data = bqp->slots[bqp->head];
+        bqp->head = (bqp->head + 1) % bqp->capacity;
+        bqp->count--;
+        pthread_cond_signal(&bqp->not_full);
+    }
+    pthread_mutex_unlock(&bqp->lock);
+    return data;
+}
+
+void *bqtryget(bqueue_t *bqp) {
+    if (bqp == NULL) return NULL;
+
+    pthread_mutex_lock(&bqp->lock);
+    void *data = NULL;
+    if (bqp->count > 0) {
+        data = bqp->slots[bqp->head];
+        bqp->head = (bqp->head + 1) % bqp->capacity;
+        bqp->count--;
+        pthread_cond_signal(&bqp->not_full);
+    }
+    pthread_mutex_unlock(&bqp->lock);
+    return data;
+}
+
+void bqdone(bqueue_t *bqp) {
+    if (bqp == NULL) return;
+    pthread_mutex_lock(&bqp->lock);
+    bqp->done = true;
+    pthread_cond_broadcast(&bqp->not_empty);
+    pthread_cond_broadcast(&bqp->not_full);
+    pthread_mutex_unlock(&bqp->lock);
+}
@@ -0,0 +1,41 @@
+/*
+ * bqueue.h - header file for the bounded blocking queue module
+ *
+ * Author: Insecticide
+ * Date: 10-17-2026
+ *
+ * Description: A fixed-capacity FIFO that is safe to share between
+ * threads. Producers block while it is full and consumers block while
+ * it is empty, so a fast stage can never run arbitrarily far ahead of
+ * a slow one.
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+
+typedef struct bqueue bqueue_t;
+
+/* bqopen -- create an empty queue holding at most capacity elements */
+bqueue_t *bqopen(int capacity);
+
+/* bqclose -- deallocate the queue; any elements left in it are NOT freed */
+void bqclose(bqueue_t *bqp);
+
+/* bqput -- append elementp, blocking while the queue is full
+ * returns 0 if successful; nonzero otherwise (NULL element, or bqdone called)
+ */
+int32_t bqput(bqueue_t *bqp, void *elementp);
+
+/* bqget -- remove and return the first element, blocking while the
+ * queue is empty; returns NULL once bqdone has been called and the
+ * queue has drained
+ */
+void *bqget(bqueue_t *bqp);
+
+/* bqtryget -- like bqget, but returns NULL at once if the queue is empty */
+void *bqtryget(bqueue_t *bqp);
+
+/* bqdone -- signal that no more elements will be put; wakes all consumers */
+void bqdone(bqueue_t *bqp);
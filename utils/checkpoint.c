@@ -0,0 +1,216 @@
+/*
+ * checkpoint.c - implementation of the crawler checkpoint module
+ *
+ * Author: Insecticide
+ * Date: 10-17-2026
+ *
+ * Description: Appends seen URLs and commit markers to a log file and
+ * replays it on resume. See checkpoint.h for the file format.
+ */
+
+#define _POSIX_C_SOURCE 200809L // getline, fileno, fdatasync, truncate
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include "checkpoint.h"
+#include "webpage.h"
+
+#define CHECKPOINT_FILE ".crawler.ckpt"
+
+struct checkpoint {
+    FILE *fp;           // log, opened for appending
+    time_t last_commit; // time of the last commit marker
+};
+
+// One '+' record read back during replay
+typedef struct ckpt_entry {
+    char *url;
+    int depth;
+} ckpt_entry_t;
+
+// --- Static helper function prototypes ---
+static checkpoint_t *open_log(const char *path, const char *mode);
+static void free_entries(ckpt_entry_t *entries, int from, int to);
+
+/*
+ * checkpoint_open - Starts a new, empty checkpoint log.
+ */
+checkpoint_t *checkpoint_open(char *dirnm) {
+    char filepath[256];
+    snprintf(filepath, sizeof(filepath), "%s/%s", dirnm, CHECKPOINT_FILE);
+    return open_log(filepath, "w");
+}
+
+/*
+ * checkpoint_resume - Replays the log up to its last commit marker.
+ */
+checkpoint_t *checkpoint_resume(char *dirnm, hashtable_t *seen, queue_t *frontier,
+                                int *dequeued, int *nextID) {
+    char filepath[256];
+    snprintf(filepath, sizeof(filepath), "%s/%s", dirnm, CHECKPOINT_FILE);
+
+    FILE *fp = fopen(filepath, "r");
+    if (fp == NULL) {
+        return NULL;
+    }
+
+    ckpt_entry_t *entries = NULL;
+    int num_entries = 0, capacity = 0;
+    int committed = -1;     // number of entries covered by the last marker
+    long committed_off = 0; // file offset just past the last marker
+    int c_dequeued = 0, c_nextID = 1;
+    bool out_of_memory = false;
+
+    char *line = NULL;
+    size_t linecap = 0;
+    ssize_t len;
+    while ((len = getline(&line, &linecap, fp)) > 0) {
+        if (line[len - 1] != '\n') {
+            break; // torn final record
+        }
+        line[--len] = '\0';
+
+        if (line[0] == '+') {
+            int depth, n_read;
+            if (sscanf(line + 1, "%d %n", &depth, &n_read) != 1 || line[1 + n_read] == '\0') {
+                break;
+            }
+            if (num_entries == capacity) {
+                int grown_cap = capacity ? capacity * 2 : 256;
+                ckpt_entry_t *grown = realloc(entries, grown_cap * sizeof(ckpt_entry_t));
+                if (grown == NULL) {
+                    out_of_memory = true;
+                    break;
+                }
+                entries = grown;
+                capacity = grown_cap;
+            }
+            const char *url = line + 1 + n_read;
+            if ((entries[num_entries].url = malloc(strlen(url) + 1)) == NULL) {
+                out_of_memory = true;
+                break;
+            }
+            strcpy(entries[num_entries].url, url);
+            entries[num_entries].depth = depth;
+            num_entries++;
+        } else if (line[0] == '=') {
+            int d, n;
+            if (sscanf(line + 1, "%d %d", &d, &n) != 2 || d > num_entries) {
+                break;
+            }
+            committed = num_entries;
+            c_dequeued = d;
+            c_nextID = n;
+            committed_off = ftell(fp);
+        } else {
+            break; // garbage; trust only what was committed before it
+        }
+    }
+    free(line);
+    fclose(fp);
+
+    if (committed < 0 || out_of_memory) {
+        free_entries(entries, 0, num_entries);
+        free(entries);
+        return NULL;
+    }
+    free_entries(entries, committed, num_entries); // uncommitted tail
+
+    // Rebuild the seen set and the frontier from the committed records
+    for (int i = 0; i < committed; i++) {
+        if (i >= c_dequeued) {
+            qput(frontier, webpage_new(entries[i].url, entries[i].depth, NULL));
+        }
+        NormalizeURL(entries[i].url);
+        hput(seen, entries[i].url, entries[i].url, strlen(entries[i].url));
+    }
+    free(entries);
+
+    // Drop the uncommitted tail so new records follow the last marker
+    if (truncate(filepath, committed_off) != 0) {
+        perror("Error: checkpoint_resume failed to truncate log");
+        return NULL;
+    }
+
+    *dequeued = c_dequeued;
+    *nextID = c_nextID;
+    return open_log(filepath, "a");
+}
+
+/*
+ * checkpoint_seen - Buffers a '+' record.
+ */
+int32_t checkpoint_seen(checkpoint_t *cp, const char *url, int depth) {
+    if (cp == NULL || url == NULL) {
+        return 1;
+    }
+    return fprintf(cp->fp, "+%d %s\n", depth, url) < 0;
+}
+
+/*
+ * checkpoint_commit - Writes a '=' marker and flushes, at most every
+ * CHECKPOINT_INTERVAL seconds unless forced.
+ */
+int32_t checkpoint_commit(checkpoint_t *cp, int dequeued, int nextID, bool force) {
+    if (cp == NULL) {
+        return 1;
+    }
+    if (!force && !checkpoint_due(cp)) {
+        return 0;
+    }
+    cp->last_commit = time(NULL);
+
+    if (fprintf(cp->fp, "=%d %d\n", dequeued, nextID) < 0 || fflush(cp->fp) != 0) {
+        perror("Error: checkpoint_commit failed to write log");
+        return 1;
+    }
+    // Only the appended tail is dirty, so this stays cheap
+    if (fdatasync(fileno(cp->fp)) != 0) {
+        perror("Error: checkpoint_commit failed to sync log");
+        return 1;
+    }
+    return 0;
+}
+
+/*
+ * checkpoint_due - Whether CHECKPOINT_INTERVAL has passed since the last commit.
+ */
+bool checkpoint_due(checkpoint_t *cp) {
+    return cp != NULL && time(NULL) - cp->last_commit >= CHECKPOINT_INTERVAL;
+}
+
+/*
+ * checkpoint_close - Closes the log and frees cp.
+ */
+void checkpoint_close(checkpoint_t *cp) {
+    if (cp != NULL) {
+        fclose(cp->fp);
+        free(cp);
+    }
+}
+
+// Opens the log at path with the given fopen mode
+static checkpoint_t *open_log(const char *path, const char *mode) {
+    checkpoint_t *cp = malloc(sizeof(checkpoint_t));
+    if (cp == NULL) {
+        return NULL;
+    }
+    cp->fp = fopen(path, mode);
+    if (cp->fp == NULL) {
+        perror("Error: checkpoint failed to open log");
+        free(cp);
+        return NULL;
+    }
+    cp->last_commit = time(NULL);
+    return cp;
+}
+
+// Frees the URLs of entries[from..to)
+static void free_entries(ckpt_entry_t *entries, int from, int to) {
+    for (int i = from; i < to; i++) {
+        free(entries[i].url);
+    }
+}
@@ -0,0 +1,75 @@
+/*
+ * checkpoint.h - header file for the crawler checkpoint module
+ *
+ * Author: Insecticide
+ * Date: 10-17-2026
+ *
+ * Description: Records the crawler's state (frontier, seen URLs and
+ * next docID) in an append-only log inside the page directory, so an
+ * interrupted crawl can be resumed where it left off.
+ *
+ * The log is a text file named .crawler.ckpt with two kinds of lines:
+ *   +<depth> <url>          a URL was added to the seen set and frontier
+ *   =<dequeued> <nextID>    commit marker: everything above is durable
+ * Since the frontier is FIFO and every seen URL is queued exactly once,
+ * the frontier is just the seen URLs after the first <dequeued> ones.
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "hash.h"
+#include "queue.h"
+
+// Minimum number of seconds between two non-forced commits
+#define CHECKPOINT_INTERVAL 5
+
+typedef struct checkpoint checkpoint_t;
+
+/*
+ * checkpoint_open - Starts a new, empty checkpoint log in dirnm,
+ * discarding any previous one.
+ * Returns NULL on failure.
+ */
+checkpoint_t *checkpoint_open(char *dirnm);
+
+/*
+ * checkpoint_resume - Replays the checkpoint log in dirnm up to its
+ * last commit marker and reopens it for appending.
+ * @seen: receives a malloc'd, normalized copy of every seen URL
+ *        (keyed by the URL itself, as the crawler does).
+ * @frontier: receives a new webpage_t for every URL not yet crawled.
+ * @dequeued: set to the number of URLs already taken off the frontier.
+ * @nextID: set to the next docID to assign.
+ * Returns NULL if there is no usable log, or no memory to replay it;
+ * seen and frontier are then left as they were.
+ */
+checkpoint_t *checkpoint_resume(char *dirnm, hashtable_t *seen, queue_t *frontier,
+                                int *dequeued, int *nextID);
+
+/*
+ * checkpoint_seen - Records that url (at depth) was added to the
+ * seen set and the frontier. The record is buffered until the next commit.
+ * Returns 0 on success, non-zero on failure.
+ */
+int32_t checkpoint_seen(checkpoint_t *cp, const char *url, int depth);
+
+/*
+ * checkpoint_commit - Writes a commit marker and flushes the log to disk.
+ * Unless force is true, does nothing if the last commit was less than
+ * CHECKPOINT_INTERVAL seconds ago, so it is cheap to call after every page.
+ * Returns 0 on success, non-zero on failure.
+ */
+int32_t checkpoint_commit(checkpoint_t *cp, int dequeued, int nextID, bool force);
+
+/*
+ * checkpoint_due - Returns true if a non-forced commit would write a
+ * marker now, so callers can make their own state durable first.
+ */
+bool checkpoint_due(checkpoint_t *cp);
+
+/*
+ * checkpoint_close - Closes the log (without committing) and frees cp.
+ */
+void checkpoint_close(checkpoint_t *cp);
@@ -0,0 +1,446 @@
+/*
+ * doctext.c - implementation of the indexed pages' plain text
+ *
+ * Author: Insecticide
+ * Date: 10-17-2026
+ *
+ * Description: Writing appends each page's text as it comes and keeps
+ * the directory in memory, by docID, until the file is closed. Reading
+ * loads the directory and seeks to one text at a time. Snippets are
+ * found by tokenizing the text as the indexer tokenizes pages, so the
+ * words highlighted are the words that matched. See doctext.h.
+ */
+
+#define _POSIX_C_SOURCE 200809L // fseeko, ftello
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/types.h>
+#include "doctext.h"
+#include "htmllex.h"
+#include "tokenize.h"
+#include "utf8.h"
+
+#define DOCTEXT_MAGIC "TSETEXT1"
+#define MAGIC_LEN 8
+#define ENTRY_LEN 16   // docID, length, offset
+#define TRAILER_LEN 16 // the directory's offset and number of entries
+#define MAX_DOCID (1 << 28) // a larger one means the file is damaged
+#define SNIPPET_WORDS 24    // words in a snippet...
+#define SNIPPET_LEAD 4      // ...of which this many come before its first term
+#define SNIPPET_EDGE 16     // bytes of punctuation or digits kept at either end
+#define MAX_TERM 256        // longer words are never terms
+#define HIGHLIGHT "**"
+
+struct doctext {
+    FILE *fp;
+    bool writing;
+    uint64_t *offset;  // of each docID's text, or 0 if it has none
+    uint32_t *length;
+    int size;          // docIDs are below this
+    char *buf;         // the text of the page being written
+};
+
+// The text being extracted from a page
+typedef struct extract {
+    char *out;
+    int len;
+    int max;
+    bool space; // whitespace is pending
+    bool full;
+} extract_t;
+
+// --- Static helper function prototypes ---
+static bool load_directory(doctext_t *dt);
+static bool grow(doctext_t *dt, int docID);
+static void text_helper(const char *text, int len, void *arg);
+static void put_char(extract_t *x, const char *c, int n);
+static void append(char *out, int *pos, const char *s, int n);
+static void put_u32(unsigned char *p, uint32_t v);
+static void put_u64(unsigned char *p, uint64_t v);
+static uint32_t get_u32(const unsigned char *p);
+static uint64_t get_u64(const unsigned char *p);
+
+doctext_t *doctext_create(const char *path, bool append) {
+    doctext_t *dt = calloc(1, sizeof(doctext_t));
+    if (dt == NULL || (dt->buf = malloc(DOCTEXT_MAXTEXT + 1)) == NULL) {
+        free(dt);
+        return NULL;
+    }
+    dt->writing = true;
+
+    // The old texts stay where they are; only the directory is rewritten
+    if (append && (dt->fp = fopen(path, "rb")) != NULL) {
+        bool loaded = load_directory(dt);
+        fclose(dt->fp);
+        dt->fp = loaded ? fopen(path, "ab") : NULL;
+    }
+    if (dt->fp == NULL) {
+        free(dt->offset);
+        free(dt->length);
+        dt->offset = NULL;
+        dt->length = NULL;
+        dt->size = 0;
+        if ((dt->fp = fopen(path, "wb")) != NULL) {
+            fwrite(DOCTEXT_MAGIC, 1, MAGIC_LEN, dt->fp);
+        }
+    }
+    if (dt->fp == NULL) {
+        perror("Error: doctext_create failed to open file");
+        free(dt->offset);
+        free(dt->length);
+        free(dt->buf);
+        free(dt);
+        return NULL;
+    }
+    return dt;
+}
+
+int32_t doctext_put(doctext_t *dt, int docID, const char *html, int len) {
+    if (docID <= 0 || docID >= MAX_DOCID || !grow(dt, docID)) {
+        return 1;
+    }
+    int n = doctext_extract(html, len, dt->buf, DOCTEXT_MAXTEXT);
+    fseeko(dt->fp, 0, SEEK_END);
+    off_t offset = ftello(dt->fp);
+    if (offset < MAGIC_LEN || fwrite(dt->buf, 1, n, dt->fp) != (size_t)n) {
+        return 1;
+    }
+    dt->offset[docID] = offset;
+    dt->length[docID] = n;
+    return 0;
+}
+
+void doctext_remove(doctext_t *dt, int docID) {
+    if (docID > 0 && docID < dt->size) {
+        dt->offset[docID] = 0;
+        dt->length[docID] = 0;
+    }
+}
+
+doctext_t *doctext_open(const char *path) {
+    doctext_t *dt = calloc(1, sizeof(doctext_t));
+    if (dt == NULL) {
+        return NULL;
+    }
+    dt->fp = fopen(path, "rb");
+    if (dt->fp == NULL || !load_directory(dt)) {
+        if (dt->fp != NULL) {
+            fprintf(stderr, "Error: '%s' is not a text file.\n", path);
+        }
+        doctext_close(dt);
+        return NULL;
+    }
+    return dt;
+}
+
+int doctext_get(doctext_t *dt, int docID, char *buf) {
+    if (docID <= 0 || docID >= dt->size || dt->offset[docID] == 0) {
+        return -1;
+    }
+    uint32_t len = dt->length[docID];
+    if (fseeko(dt->fp, dt->offset[docID], SEEK_SET) != 0 || fread(buf, 1, len, dt->fp) != len) {
+        return -1;
+    }
+    buf[len] = '\0';
+    return len;
+}
+
+int32_t doctext_close(doctext_t *dt) {
+    int32_t status = 0;
+    if (dt->writing && dt->fp != NULL) {
+        unsigned char entry[ENTRY_LEN];
+        fseeko(dt->fp, 0, SEEK_END);
+        off_t dir_offset = ftello(dt->fp);
+        uint64_t count = 0;
+        for (int d = 1; d < dt->size; d++) {
+            if (dt->offset[d] != 0) {
+                put_u32(entry, d);
+                put_u32(entry + 4, dt->length[d]);
+                put_u64(entry + 8, dt->offset[d]);
+                fwrite(entry, 1, ENTRY_LEN, dt->fp);
+                count++;
+            }
+        }
+        put_u64(entry, dir_offset);
+        put_u64(entry + 8, count);
+        fwrite(entry, 1, TRAILER_LEN, dt->fp);
+        status = (dir_offset < MAGIC_LEN || fflush(dt->fp) != 0 || ferror(dt->fp));
+    }
+    if (dt->fp != NULL && fclose(dt->fp) != 0) {
+        status = 1;
+    }
+    free(dt->offset);
+    free(dt->length);
+    free(dt->buf);
+    free(dt);
+    return status;
+}
+
+int doctext_extract(const char *html, int len, char *out, int max) {
+    extract_t x = { out, 0, max, false, false };
+    htmllex_handler_t handler = { .text = text_helper, .arg = &x };
+    htmllex_run(html, len, &handler);
+    out[x.len] = '\0';
+    return x.len;
+}
+
+int doctext_snippet(const char *text, int len, const char *const terms[], int num_terms, analyzer_t analyzer,
+                    char *out) {
+    out[0] = '\0';
+    char *lower = malloc(len + 1);
+    int cap = len / 2 + 1; // words are separated, so there are no more than this
+    int *starts = malloc(cap * sizeof(int));
+    int *ends = malloc(cap * sizeof(int));
+    int *hits = malloc(cap * sizeof(int)); // the term each word is, or -1
+    if (lower == NULL || starts == NULL || ends == NULL || hits == NULL) {
+        free(lower);
+        free(starts);
+        free(ends);
+        free(hits);
+        return 0;
+    }
+
+    // The words, and which of them are terms
+    tokenizer_t tk;
+    tokenizer_init(&tk, text, len, lower);
+    const char *word;
+    int word_len, end, num_words = 0;
+    char term[MAX_TERM];
+    while ((end = tokenizer_next(&tk, &word, &word_len)) >= 0 && num_words < cap) {
+        starts[num_words] = word - lower; // decoding may shorten the word
+        ends[num_words] = end;
+        hits[num_words] = -1;
+        if (word_len < MAX_TERM) {
+            memcpy(term, word, word_len);
+            term[analyzer_apply(analyzer, term, word_len)] = '\0';
+            for (int t = 0; t < num_terms && hits[num_words] < 0; t++) {
+                if (strcmp(term, terms[t]) == 0) {
+                    hits[num_words] = t;
+                }
+            }
+        }
+        num_words++;
+    }
+
+    // The stretch with the most distinct terms, then the most words that are terms
+    int first = 0, best = 0;
+    for (int w = 0; w < num_words; w++) {
+        if (hits[w] < 0) {
+            continue;
+        }
+        int start = (w > SNIPPET_LEAD) ? w - SNIPPET_LEAD : 0;
+        uint32_t seen = 0;
+        int score = 0;
+        for (int i = start; i < num_words && i < start + SNIPPET_WORDS; i++) {
+            if (hits[i] >= 0) {
+                uint32_t bit = 1u << (hits[i] < 31 ? hits[i] : 31);
+                score += (seen & bit) ? 1 : SNIPPET_WORDS;
+                seen |= bit;
+            }
+        }
+        if (score > best) {
+            best = score;
+            first = start;
+        }
+    }
+
+    // Written out as it appears, up to the room there is, from the space
+    // before its first word to the space after its last (or a few bytes)
+    int pos = 0, num_hits = 0;
+    int last = (first + SNIPPET_WORDS < num_words) ? first + SNIPPET_WORDS : num_words;
+    int from = 0;
+    if (num_words > 0) {
+        int floor = (first > 0) ? ends[first - 1] : 0;
+        for (from = starts[first]; from > floor && from > starts[first] - SNIPPET_EDGE && text[from - 1] != ' '; ) {
+            from--;
+        }
+    }
+    if (from > 0) {
+        append(out, &pos, "... ", 4);
+    }
+    int w;
+    for (w = first; w < last; w++) {
+        int need = ends[w] - from + (hits[w] >= 0 ? 2 * strlen(HIGHLIGHT) : 0);
+        if (pos + need > DOCTEXT_MAXSNIPPET - 5) { // leaves room for " ..."
+            break;
+        }
+        append(out, &pos, text + from, starts[w] - from);
+        if (hits[w] >= 0) {
+            append(out, &pos, HIGHLIGHT, strlen(HIGHLIGHT));
+            num_hits++;
+        }
+        append(out, &pos, text + starts[w], ends[w] - starts[w]);
+        if (hits[w] >= 0) {
+            append(out, &pos, HIGHLIGHT, strlen(HIGHLIGHT));
+        }
+        from = ends[w];
+    }
+    int limit = (w < num_words) ? starts[w] : len;
+    int to = from;
+    while (to < limit && to < from + SNIPPET_EDGE && text[to] != ' ') {
+        to++;
+    }
+    if (pos + to - from <= DOCTEXT_MAXSNIPPET - 5) {
+        append(out, &pos, text + from, to - from);
+    } else {
+        to = from;
+    }
+    if (to < len) {
+        append(out, &pos, " ...", 4);
+    }
+
+    free(lower);
+    free(starts);
+    free(ends);
+    free(hits);
+    return num_hits;
+}
+
+
+// --- Helper Functions ---
+
+/*
+ * Reads the directory of the file dt->fp into dt.
+ * Returns false if the file is not a whole text file.
+ */
+static bool load_directory(doctext_t *dt) {
+    unsigned char head[MAGIC_LEN], trailer[TRAILER_LEN];
+    if (fread(head, 1, MAGIC_LEN, dt->fp) != MAGIC_LEN || memcmp(head, DOCTEXT_MAGIC, MAGIC_LEN) != 0
+        || fseeko(dt->fp, -TRAILER_LEN, SEEK_END) != 0) {
+        return false;
+    }
+    off_t size = ftello(dt->fp) + TRAILER_LEN;
+    if (fread(trailer, 1, TRAILER_LEN, dt->fp) != TRAILER_LEN) {
+        return false;
+    }
+    uint64_t dir_offset = get_u64(trailer), count = get_u64(trailer + 8);
+    if (dir_offset < MAGIC_LEN || dir_offset > (uint64_t)size - TRAILER_LEN
+        || count != ((uint64_t)size - TRAILER_LEN - dir_offset) / ENTRY_LEN
+        || fseeko(dt->fp, dir_offset, SEEK_SET) != 0) {
+        return false;
+    }
+
+    unsigned char entry[ENTRY_LEN];
+    for (uint64_t i = 0; i < count; i++) {
+        if (fread(entry, 1, ENTRY_LEN, dt->fp) != ENTRY_LEN) {
+            return false;
+        }
+        uint32_t docID = get_u32(entry), len = get_u32(entry + 4);
+        uint64_t offset = get_u64(entry + 8);
+        if (docID == 0 || docID >= MAX_DOCID || len > DOCTEXT_MAXTEXT || offset < MAGIC_LEN
+            || offset + len > dir_offset || !grow(dt, docID)) {
+            return false;
+        }
+        dt->offset[docID] = offset;
+        dt->length[docID] = len;
+    }
+    return true;
+}
+
+// Makes room in the directory for docID
+static bool grow(doctext_t *dt, int docID) {
+    if (docID < dt->size) {
+        return true;
+    }
+    int size = (docID + 1 > 2 * dt->size) ? docID + 1 : 2 * dt->size;
+    uint64_t *offset = realloc(dt->offset, size * sizeof(uint64_t));
+    if (offset != NULL) {
+        dt->offset = offset;
+    }
+    uint32_t *length = realloc(dt->length, size * sizeof(uint32_t));
+    if (length != NULL) {
+        dt->length = length;
+    }
+    if (offset == NULL || length == NULL) {
+        return false;
+    }
+    memset(dt->offset + dt->size, 0, (size - dt->size) * sizeof(uint64_t));
+    memset(dt->length + dt->size, 0, (size - dt->size) * sizeof(uint32_t));
+    dt->size = size;
+    return true;
+}
+
+/*
+ * Adds a run of text to the extract (for htmllex_run): whitespace and
+ * control characters collapse into a space, as do the breaks between
+ * runs; references are decoded, except those for '<', '>' and '&',
+ * which stay as written so that the text tokenizes as the page did.
+ * Malformed bytes are dropped.
+ */
+static void text_helper(const char *text, int len, void *arg) {
+    extract_t *x = arg;
+    x->space = (x->len > 0);
+    for (int i = 0; i < len && !x->full; ) {
+        unsigned char c = text[i];
+        uint32_t cp = c;
+        int n = 1;
+        char encoded[4];
+        const char *bytes = text + i;
+        int num_bytes = 1;
+        if (c == '&' && (n = htmllex_entity(text, len, i, &cp)) > 0 && cp != '<' && cp != '>' && cp != '&') {
+            if (cp >= 0xD800 && cp <= 0xDFFF) {
+                cp = 0xFFFD; // a lone surrogate is not a character
+            }
+            num_bytes = utf8_encode(cp, encoded);
+            bytes = encoded;
+        } else if (c == '&') {
+            n = 1;
+            cp = c;
+        } else if (c >= 0x80) {
+            n = num_bytes = utf8_decode(text, len, i, &cp);
+            if (n == 0) {
+                i++;
+                continue;
+            }
+        }
+        i += n;
+        if (cp <= ' ' || cp == 0x7F || cp == 0xA0) {
+            x->space = (x->len > 0);
+        } else {
+            put_char(x, bytes, num_bytes);
+        }
+    }
+}
+
+// Appends the character c[0..n) to the extract, after any pending space
+static void put_char(extract_t *x, const char *c, int n) {
+    if (x->len + x->space + n > x->max) {
+        x->full = true;
+        return;
+    }
+    if (x->space) {
+        x->out[x->len++] = ' ';
+        x->space = false;
+    }
+    memcpy(x->out + x->len, c, n);
+    x->len += n;
+}
+
+// Appends s[0..n) to the snippet at *pos and NUL-terminates it
+static void append(char *out, int *pos, const char *s, int n) {
+    memcpy(out + *pos, s, n);
+    *pos += n;
+    out[*pos] = '\0';
+}
+
+static void put_u32(unsigned char *p, uint32_t v) {
+    for (int i = 0; i < 4; i++) {
+        p[i] = (v >> (8 * i)) & 0xFF;
+    }
+}
+
+static void put_u64(unsigned char *p, uint64_t v) {
+    for (int i = 0; i < 8; i++) {
+        p[i] = (v >> (8 * i)) & 0xFF;
+    }
+}
+
+static uint32_t get_u32(const unsigned char *p) {
+    return p[0] | (p[1] << 8) | (p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+static uint64_t get_u64(const unsigned char *p) {
+    return get_u32(p) | ((uint64_t)get_u32(p + 4) << 32);
+}
@@ -0,0 +1,94 @@
+/*
+ * doctext.h - header file for the indexed pages' plain text, for snippets
+ *
+ * Author: Insecticide
+ * Date: 10-17-2026
+ *
+ * Description: Keeps the visible text of every indexed page -- the runs
+ * of text between its tags (see htmllex.h), outside the title, with
+ * whitespace collapsed and character references decoded -- in a
+ * sidecar file next to the index, so that the querier can show the
+ * words around a match without fetching, lexing and tokenizing the
+ * page itself. At most DOCTEXT_MAXTEXT bytes of each page are kept,
+ * which bounds what a result costs to read.
+ *
+ * The file is an 8-byte "TSETEXT1" header, the texts one after another,
+ * then a directory of (docID (4 bytes), length (4 bytes), offset
+ * (8 bytes)) entries, and last the directory's offset and number of
+ * entries (8 bytes each), all little-endian. Appending adds texts after
+ * the old directory and writes a whole new one, so pages replaced by an
+ * update leave their old text behind until the index is next built.
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "analyzer.h"
+
+#define DOCTEXT_SUFFIX ".text"  // the indexer saves the text as <indexFile>.text
+#define DOCTEXT_MAXTEXT 32768   // bytes of a page's text that are kept
+#define DOCTEXT_MAXSNIPPET 512  // room doctext_snippet() needs at most
+
+typedef struct doctext doctext_t;
+
+/*
+ * doctext_create - Opens the text file at path for writing. If append
+ * is true and the file is a text file, its pages are kept and new ones
+ * added; otherwise it is started afresh.
+ * Returns NULL on failure.
+ */
+doctext_t *doctext_create(const char *path, bool append);
+
+/*
+ * doctext_put - Writes the visible text of html[0..len) as the text of
+ * page docID, replacing any it had.
+ * Returns 0 on success, non-zero on failure.
+ */
+int32_t doctext_put(doctext_t *dt, int docID, const char *html, int len);
+
+/*
+ * doctext_remove - Forgets the text of page docID.
+ */
+void doctext_remove(doctext_t *dt, int docID);
+
+/*
+ * doctext_open - Opens the text file at path for reading, loading its
+ * directory.
+ * Returns NULL if there is none, or it cannot be read.
+ */
+doctext_t *doctext_open(const char *path);
+
+/*
+ * doctext_get - Reads the text of page docID into buf, which has room
+ * for DOCTEXT_MAXTEXT + 1 bytes, and NUL-terminates it.
+ * Returns its length, or -1 if the file has no text for docID.
+ */
+int doctext_get(doctext_t *dt, int docID, char *buf);
+
+/*
+ * doctext_close - For a file being written, writes the directory;
+ * then closes the file and frees dt.
+ * Returns 0 on success, non-zero on failure.
+ */
+int32_t doctext_close(doctext_t *dt);
+
+/*
+ * doctext_extract - Writes the visible text of html[0..len) to out,
+ * which has room for max + 1 bytes, NUL-terminated, cutting it at a
+ * character boundary if it is longer than max.
+ * Returns its length.
+ */
+int doctext_extract(const char *html, int len, char *out, int max);
+
+/*
+ * doctext_snippet - Picks the stretch of text[0..len) (a page's text)
+ * with the most of the terms (the query's words, as analyzer makes
+ * them), and writes it to out (DOCTEXT_MAXSNIPPET bytes) with each
+ * word that is one of the terms wrapped in "**". The stretch starts a
+ * few words before the first term in it; "..." marks text left out.
+ * With no terms in the text, the stretch is the text's beginning.
+ * Returns the number of words highlighted.
+ */
+int doctext_snippet(const char *text, int len, const char *const terms[], int num_terms, analyzer_t analyzer,
+                    char *out);
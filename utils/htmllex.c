@@ -0,0 +1,408 @@
+/*
+ * htmllex.c - implementation of the streaming HTML lexer
+ *
+ * Author: Insecticide
+ * Date: 10-17-2026
+ *
+ * Description: Alternates between text runs (up to the next '<') and
+ * tags (up to the next '>'). Tags are only looked into for their name
+ * and, for a, area and meta, their attributes. Script, style and
+ * comment bodies are passed over with memchr. See htmllex.h.
+ */
+
+#define _POSIX_C_SOURCE 200809L // strncasecmp
+
+#include <string.h>
+#include <strings.h>
+#include <ctype.h>
+#include "htmllex.h"
+#include "utf8.h"
+
+// Named character references worth knowing (the rest of the 2000-odd are rare)
+static const struct {
+    const char *name;
+    uint32_t cp;
+} entities[] = {
+    { "amp", '&' }, { "lt", '<' }, { "gt", '>' }, { "quot", '"' }, { "apos", '\'' },
+    { "nbsp", 0xA0 }, { "iexcl", 0xA1 }, { "cent", 0xA2 }, { "pound", 0xA3 }, { "yen", 0xA5 },
+    { "sect", 0xA7 }, { "copy", 0xA9 }, { "laquo", 0xAB }, { "shy", 0xAD }, { "reg", 0xAE },
+    { "deg", 0xB0 }, { "plusmn", 0xB1 }, { "sup2", 0xB2 }, { "micro", 0xB5 }, { "para", 0xB6 },
+    { "middot", 0xB7 }, { "raquo", 0xBB }, { "frac14", 0xBC }, { "frac12", 0xBD },
+    { "frac34", 0xBE }, { "iquest", 0xBF }, { "Agrave", 0xC0 }, { "Aacute", 0xC1 },
+    { "Auml", 0xC4 }, { "Ccedil", 0xC7 }, { "Egrave", 0xC8 }, { "Eacute", 0xC9 },
+    { "Ntilde", 0xD1 }, { "Ouml", 0xD6 }, { "times", 0xD7 }, { "Uuml", 0xDC }, { "szlig", 0xDF },
+    { "agrave", 0xE0 }, { "aacute", 0xE1 }, { "acirc", 0xE2 }, { "auml", 0xE4 },
+    { "ccedil", 0xE7 }, { "egrave", 0xE8 }, { "eacute", 0xE9 }, { "ecirc", 0xEA },
+    { "iacute", 0xED }, { "ntilde", 0xF1 }, { "oacute", 0xF3 }, { "ouml", 0xF6 },
+    { "divide", 0xF7 }, { "uacute", 0xFA }, { "uuml", 0xFC }, { "ensp", 0x2002 },
+    { "emsp", 0x2003 }, { "thinsp", 0x2009 }, { "zwnj", 0x200C }, { "zwj", 0x200D },
+    { "lrm", 0x200E }, { "rlm", 0x200F }, { "ndash", 0x2013 }, { "mdash", 0x2014 },
+    { "lsquo", 0x2018 }, { "rsquo", 0x2019 }, { "sbquo", 0x201A }, { "ldquo", 0x201C },
+    { "rdquo", 0x201D }, { "bdquo", 0x201E }, { "bull", 0x2022 }, { "hellip", 0x2026 },
+    { "euro", 0x20AC }, { "trade", 0x2122 }, { "larr", 0x2190 }, { "uarr", 0x2191 },
+    { "rarr", 0x2192 }, { "darr", 0x2193 }, { "minus", 0x2212 }, { "hearts", 0x2665 },
+};
+#define NUM_ENTITIES (sizeof(entities) / sizeof(entities[0]))
+#define MAX_ENTITY_NAME 8 // longest name in the table is 6; numeric ones fit too
+
+// A (pointer, length) slice of the html
+typedef struct span {
+    const char *p;
+    int len;
+} span_t;
+
+// Lexer state for one document
+typedef struct lexer {
+    const char *html;
+    const htmllex_handler_t *h;
+    bool in_anchor;              // between <a href=...> and </a>
+    span_t href;                 // ...whose href this is
+    char text[HTMLLEX_MAXTEXT];  // ...and text so far, whitespace collapsed
+    int text_len;
+    bool space;                  // whitespace is pending in text
+    int title_start;             // offset just past <title>, or -1
+    bool title_done;
+    bool desc_done;
+} lexer_t;
+
+// --- Static helper function prototypes ---
+static void lex_text(lexer_t *lx, int start, int end);
+static void lex_tag(lexer_t *lx, int start, int end);
+static int next_attr(const char *html, int pos, int end, span_t *name, span_t *value);
+static bool span_is(span_t s, const char *word);
+static void end_anchor(lexer_t *lx);
+static int find_end_tag(const char *html, int len, int pos, const char *name);
+
+/*
+ * htmllex_run - One pass over the text runs and tags of html.
+ */
+void htmllex_run(const char *html, int len, const htmllex_handler_t *handler) {
+    lexer_t lx;
+    lx.html = html;
+    lx.h = handler;
+    lx.in_anchor = false;
+    lx.title_start = -1;
+    lx.title_done = false;
+    lx.desc_done = false;
+
+    int pos = 0;
+    while (pos < len) {
+        const char *lt = memchr(html + pos, '<', len - pos);
+        int tag = lt ? (int)(lt - html) : len;
+        if (tag > pos) {
+            lex_text(&lx, pos, tag);
+        }
+        if (lt == NULL) {
+            break;
+        }
+        int resume = htmllex_skip(html, len, tag);
+        if (resume > tag) {
+            pos = resume; // script, style or comment: nothing in it is text
+            continue;
+        }
+        const char *gt = memchr(lt, '>', len - tag);
+        if (gt == NULL) {
+            break; // unterminated tag: nothing more to read
+        }
+        lex_tag(&lx, tag + 1, gt - html);
+        pos = gt - html + 1;
+    }
+    end_anchor(&lx);
+}
+
+/*
+ * htmllex_skip - Recognizes "<!--", "<script" and "<style" (any case,
+ * followed by a non-name byte) and finds where they end.
+ */
+int htmllex_skip(const char *html, int len, int pos) {
+    const char *p = html + pos + 1;
+    int rest = len - pos - 1;
+    if (rest >= 3 && p[0] == '!' && p[1] == '-' && p[2] == '-') {
+        // "-->" may overlap "<!--", as in "<!-->"
+        for (int i = pos + 2; i + 3 <= len; i++) {
+            const char *dash = memchr(html + i, '-', len - i);
+            if (dash == NULL) {
+                break;
+            }
+            i = dash - html;
+            if (i + 3 <= len && dash[1] == '-' && dash[2] == '>') {
+                return i + 3;
+            }
+        }
+        return len;
+    }
+
+    static const char *const raw[] = { "script", "style" };
+    for (int r = 0; r < 2; r++) {
+        int n = strlen(raw[r]);
+        if (rest > n && strncasecmp(p, raw[r], n) == 0 && !isalnum((unsigned char)p[n])) {
+            return find_end_tag(html, len, pos + 1 + n, raw[r]);
+        }
+    }
+    return pos;
+}
+
+/*
+ * htmllex_entity - "&name;", "&#digits;" or "&#xhex;".
+ */
+int htmllex_entity(const char *html, int len, int pos, uint32_t *cp) {
+    int i = pos + 1;
+    int max = (len - i < MAX_ENTITY_NAME + 2) ? len - i : MAX_ENTITY_NAME + 2;
+    const char *semi = memchr(html + i, ';', max > 0 ? max : 0);
+    if (semi == NULL || semi == html + i) {
+        return 0;
+    }
+    int n = semi - (html + i); // name length
+
+    if (html[i] == '#') {
+        bool hex = n > 1 && (html[i + 1] == 'x' || html[i + 1] == 'X');
+        int digits = hex ? i + 2 : i + 1;
+        if (digits == i + n) {
+            return 0;
+        }
+        uint32_t value = 0;
+        for (int d = digits; d < i + n; d++) {
+            char c = html[d];
+            int v = isdigit((unsigned char)c) ? c - '0'
+                  : (hex && isxdigit((unsigned char)c)) ? (c | 0x20) - 'a' + 10 : -1;
+            if (v < 0) {
+                return 0;
+            }
+            value = value * (hex ? 16 : 10) + v;
+        }
+        *cp = (value == 0 || value > 0x10FFFF) ? 0xFFFD : value;
+        return n + 2;
+    }
+
+    for (size_t e = 0; e < NUM_ENTITIES; e++) {
+        if ((int)strlen(entities[e].name) == n && memcmp(html + i, entities[e].name, n) == 0) {
+            *cp = entities[e].cp;
+            return n + 2;
+        }
+    }
+    return 0;
+}
+
+/*
+ * htmllex_letter - A reference only where there is an '&'.
+ */
+int htmllex_letter(const char *html, int len, int pos) {
+    uint32_t cp;
+    int n;
+    if (html[pos] == '&' && (n = htmllex_entity(html, len, pos, &cp)) > 0) {
+        return utf8_isletter(cp) ? n : 0;
+    }
+    return utf8_letter(html, len, pos);
+}
+
+/*
+ * htmllex_decode - Copies forward; each reference shrinks, so out
+ * never overtakes word.
+ */
+int htmllex_decode(const char *word, int len, char *out) {
+    int n = 0;
+    for (int i = 0; i < len; ) {
+        uint32_t cp;
+        int ref = (word[i] == '&') ? htmllex_entity(word, len, i, &cp) : 0;
+        if (ref > 0) {
+            n += utf8_encode(cp, out + n);
+            i += ref;
+        } else {
+            out[n++] = word[i++];
+        }
+    }
+    return n;
+}
+
+
+// --- Helper Functions ---
+
+// Reports html[start..end) and its words, and adds it to the anchor text
+static void lex_text(lexer_t *lx, int start, int end) {
+    const char *html = lx->html;
+
+    if (lx->h->text != NULL && (lx->title_start < 0 || lx->title_done)) {
+        lx->h->text(html + start, end - start, lx->h->arg);
+    }
+
+    if (lx->h->word != NULL) {
+        for (int i = start; i < end; ) {
+            if (htmllex_letter(html, end, i) == 0) {
+                uint32_t cp;
+                int n = (html[i] == '&') ? htmllex_entity(html, end, i, &cp) : 0;
+                i += (n > 0) ? n : 1;
+                continue;
+            }
+            int beg = i;
+            int n;
+            while (i < end && (n = htmllex_letter(html, end, i)) > 0) {
+                i += n;
+            }
+            lx->h->word(html + beg, i - beg, lx->h->arg);
+        }
+    }
+
+    if (lx->in_anchor) {
+        for (int i = start; i < end && lx->text_len < HTMLLEX_MAXTEXT; i++) {
+            if (isspace((unsigned char)html[i])) {
+                lx->space = lx->text_len > 0;
+                continue;
+            }
+            if (lx->space && lx->text_len < HTMLLEX_MAXTEXT - 1) {
+                lx->text[lx->text_len++] = ' ';
+            }
+            lx->space = false;
+            lx->text[lx->text_len++] = html[i];
+        }
+    }
+}
+
+// Acts on the tag html[start..end), start being just past its '<'
+static void lex_tag(lexer_t *lx, int start, int end) {
+    const char *html = lx->html;
+    int pos = start;
+    bool closing = (pos < end && html[pos] == '/');
+    if (closing) {
+        pos++;
+    }
+    span_t name = { html + pos, 0 };
+    while (pos < end && isalnum((unsigned char)html[pos])) {
+        pos++;
+        name.len++;
+    }
+
+    if (span_is(name, "a")) {
+        end_anchor(lx); // closes this anchor, or one left open
+        if (closing) {
+            return;
+        }
+    } else if (span_is(name, "title")) {
+        if (!closing && lx->title_start < 0) {
+            lx->title_start = end + 1;
+        } else if (closing && lx->title_start >= 0 && !lx->title_done) {
+            lx->title_done = true;
+            if (lx->h->title != NULL) {
+                lx->h->title(html + lx->title_start, start - 1 - lx->title_start, lx->h->arg);
+            }
+        }
+        return;
+    } else if (closing || !(span_is(name, "area") || span_is(name, "meta"))) {
+        return;
+    }
+
+    // <a>, <area> or <meta>: look at the attributes
+    span_t attr, value, href = { NULL, 0 }, meta_name = { NULL, 0 }, content = { NULL, 0 };
+    while ((pos = next_attr(html, pos, end, &attr, &value)) >= 0) {
+        if (span_is(attr, "href")) {
+            href = value;
+        } else if (span_is(attr, "name")) {
+            meta_name = value;
+        } else if (span_is(attr, "content")) {
+            content = value;
+        }
+    }
+
+    if (span_is(name, "meta")) {
+        if (!lx->desc_done && content.p != NULL && span_is(meta_name, "description")) {
+            lx->desc_done = true;
+            if (lx->h->description != NULL) {
+                lx->h->description(content.p, content.len, lx->h->arg);
+            }
+        }
+    } else if (href.p != NULL && lx->h->link != NULL) {
+        if (span_is(name, "area")) {
+            lx->h->link(href.p, href.len, "", 0, lx->h->arg);
+        } else {
+            lx->in_anchor = true;
+            lx->href = href;
+            lx->text_len = 0;
+            lx->space = false;
+        }
+    }
+}
+
+/*
+ * Reads the attribute starting at or after html[pos], within the tag
+ * ending at html[end]: name, optional '=', optional quoted value.
+ * A missing value is an empty span.
+ * Returns the position after it, or -1 if there are no more.
+ */
+static int next_attr(const char *html, int pos, int end, span_t *name, span_t *value) {
+    while (pos < end && (isspace((unsigned char)html[pos]) || html[pos] == '/')) {
+        pos++;
+    }
+    if (pos >= end) {
+        return -1;
+    }
+
+    name->p = html + pos;
+    while (pos < end && !isspace((unsigned char)html[pos]) && html[pos] != '=' && html[pos] != '/') {
+        pos++;
+    }
+    name->len = html + pos - name->p;
+
+    while (pos < end && isspace((unsigned char)html[pos])) {
+        pos++;
+    }
+    value->p = html + pos;
+    value->len = 0;
+    if (pos >= end || html[pos] != '=') {
+        return pos;
+    }
+    pos++;
+    while (pos < end && isspace((unsigned char)html[pos])) {
+        pos++;
+    }
+
+    if (pos < end && (html[pos] == '"' || html[pos] == '\'')) {
+        char quote = html[pos++];
+        value->p = html + pos;
+        while (pos < end && html[pos] != quote) {
+            pos++;
+        }
+        value->len = html + pos - value->p;
+        if (pos < end) {
+            pos++; // past the closing quote
+        }
+    } else {
+        value->p = html + pos;
+        while (pos < end && !isspace((unsigned char)html[pos])) {
+            pos++;
+        }
+        value->len = html + pos - value->p;
+    }
+    return pos;
+}
+
+// Whether s is word, ignoring case
+static bool span_is(span_t s, const char *word) {
+    return s.p != NULL && (int)strlen(word) == s.len && strncasecmp(s.p, word, s.len) == 0;
+}
+
+// Reports the open anchor, if any, with the text collected for it
+static void end_anchor(lexer_t *lx) {
+    if (lx->in_anchor) {
+        lx->in_anchor = false;
+        lx->h->link(lx->href.p, lx->href.len, lx->text, lx->text_len, lx->h->arg);
+    }
+}
+
+/*
+ * Returns the offset of the "</name" (any case) at or after html[pos],
+ * or len if there is none.
+ */
+static int find_end_tag(const char *html, int len, int pos, const char *name) {
+    int n = strlen(name);
+    while (pos < len) {
+        const char *lt = memchr(html + pos, '<', len - pos);
+        if (lt == NULL) {
+            break;
+        }
+        pos = lt - html;
+        if (len - pos > n + 1 && lt[1] == '/' && strncasecmp(lt + 2, name, n) == 0) {
+            return pos;
+        }
+        pos++;
+    }
+    return len;
+}
@@ -0,0 +1,84 @@
+/*
+ * htmllex.h - header file for the streaming HTML lexer
+ *
+ * Author: Insecticide
+ * Date: 10-17-2026
+ *
+ * Description: Walks an html document once, front to back, without
+ * modifying it, and reports what the crawler, indexer and querier
+ * look for through callbacks:
+ *   word        - each run of letters (ASCII or UTF-8, see utf8.h,
+ *                 or references to them) outside tags (the words
+ *                 webpage_getNextWordSpan() finds), as a span
+ *   link        - the href of each <a> or <area>, as a span, with
+ *                 the anchor's text (whitespace collapsed)
+ *   text        - each run of text between tags, outside the title
+ *                 (raw: references not decoded, whitespace as is),
+ *                 as a span
+ *   title       - the raw text of the first <title>...</title>
+ *   description - the raw content of the first
+ *                 <meta name="description" content="...">
+ * A tag runs from '<' to the next '>'; an unterminated tag ends the
+ * document. The insides of <script> and <style> elements and of
+ * <!-- comments --> are not text: they have no words, links or anchor
+ * text. A character reference (&amp;, &#8217;, ...) stands for one
+ * character: one for a letter (&eacute;, &#65;) is part of the word
+ * around it, left undecoded in its span (see htmllex_decode()), and
+ * any other separates words. Spans point into the html and are not
+ * NUL-terminated.
+ */
+
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#define HTMLLEX_MAXTEXT 1024 // anchor text beyond this is dropped
+
+typedef struct htmllex_handler {
+    void (*word)(const char *word, int len, void *arg);
+    void (*link)(const char *href, int href_len, const char *text, int text_len, void *arg);
+    void (*text)(const char *text, int len, void *arg);
+    void (*title)(const char *title, int len, void *arg);
+    void (*description)(const char *desc, int len, void *arg);
+    void *arg;  // passed to every callback
+} htmllex_handler_t;
+
+/*
+ * htmllex_run - Lexes html[0..len), calling the non-NULL callbacks of
+ * handler in document order. Allocates nothing.
+ */
+void htmllex_run(const char *html, int len, const htmllex_handler_t *handler);
+
+/*
+ * htmllex_skip - For the '<' at html[pos], returns where text resumes
+ * if it opens a region with no text: for <script ...> or <style ...>,
+ * the '<' of the closing tag; for "<!--", the byte after "-->"; len
+ * if the region is never closed. Returns pos for any other tag.
+ * Shared by every tokenizer, so that they agree on what text is.
+ */
+int htmllex_skip(const char *html, int len, int pos);
+
+/*
+ * htmllex_entity - For the '&' at html[pos], returns the length of the
+ * character reference starting there (through its ';') and sets *cp
+ * to the character's code point; returns 0 if there is none. Named
+ * references are recognized from a table of the common ones.
+ */
+int htmllex_entity(const char *html, int len, int pos, uint32_t *cp);
+
+/*
+ * htmllex_letter - The length in bytes of the letter at html[pos]: a
+ * letter (see utf8_letter()) or a character reference to one; 0 if
+ * there is none there. Shared by every tokenizer, so that they agree
+ * on what a word is.
+ */
+int htmllex_letter(const char *html, int len, int pos);
+
+/*
+ * htmllex_decode - Copies word[0..len) to out with each character
+ * reference replaced by the UTF-8 encoding of its character, which is
+ * never longer than the reference; out may be word. Returns the
+ * length written (out is not NUL-terminated).
+ */
+int htmllex_decode(const char *word, int len, char *out);
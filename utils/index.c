@@ -0,0 +1,338 @@
+/*
+ * index.c - builds an in-memory index one page at a time
+ *
+ * Author: Insecticide
+ * Date: 10-17-2026
+ *
+ * Description: Shared by the indexer, which reads pages back from a
+ * crawler directory, and the crawler's pipelined mode, which indexes
+ * pages as they are fetched.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "index.h"
+#include "tokenize.h"
+#include "htmllex.h"
+
+// Where a page's title and description are, as offsets into its html
+typedef struct page_fields {
+    const char* html;
+    int title_start;     // -1 if it has none
+    int title_end;
+    int desc_start;      // -1 if it has none
+    int desc_len;
+} page_fields_t;
+
+// --- Static helper function prototypes ---
+static int add_term(hashtable_t* index, const char* term, int len, int docID, int field);
+static void title_helper(const char* title, int len, void* arg);
+static void desc_helper(const char* desc, int len, void* arg);
+static bool search_word(void* elementp, const void* keyp);
+static bool search_doc(void* elementp, const void* keyp);
+static void free_doc_entry(void* data);
+static void free_word_entry(void* data);
+static void remove_helper(void* data);
+static void set_stopbit(word_entry_t* word, int docID);
+static void sort_helper(void* data);
+static void count_helper(void* data);
+static int compare_docs(const void* a, const void* b);
+
+// --- Static state for apply helpers ---
+static int g_docID;   // docID being removed
+static int g_count;   // postings counted so far
+
+/*
+ * index_new - Creates a new, empty index.
+ */
+hashtable_t* index_new(void) {
+    return hopen(500);
+}
+
+/*
+ * index_addpage - Adds every word of the page to the index under docID,
+ * then the words of its description.
+ */
+int index_addpage(hashtable_t* index, webpage_t* page, int docID, analyzer_t analyzer) {
+    int num_words = 0;
+    const char* token;
+    int len;
+
+    char* html = webpage_getHTML(page);
+    if (html == NULL) {
+        return 0;
+    }
+
+    // Where the title and description are (the lexer allocates nothing)
+    int html_len = webpage_getHTMLlen(page);
+    page_fields_t fields = { html, -1, -1, -1, 0 };
+    htmllex_handler_t handler = { .title = title_helper, .description = desc_helper, .arg = &fields };
+    htmllex_run(html, html_len, &handler);
+
+    // The tokenizer lowercases the words into one buffer per page, so a
+    // token costs no allocation unless it is a new word
+    char* lower = malloc(html_len + 1);
+    tokenizer_t tk;
+    tokenizer_init(&tk, html, html_len, lower);
+
+    int end;
+    while ((end = tokenizer_next(&tk, &token, &len)) > 0) {
+        // The term is written over the word, in the same buffer
+        char* normalized = lower + (token - lower);
+        int field = (end > fields.title_start && end <= fields.title_end) ? FIELD_TITLE : FIELD_BODY;
+        num_words += add_term(index, normalized, analyzer_apply(analyzer, normalized, len), docID, field);
+    }
+
+    // The description is inside a tag, whose bytes no word above came from
+    if (fields.desc_start >= 0) {
+        tokenizer_init(&tk, html + fields.desc_start, fields.desc_len, lower + fields.desc_start);
+        while (tokenizer_next(&tk, &token, &len) > 0) {
+            char* normalized = lower + (token - lower);
+            num_words += add_term(index, normalized, analyzer_apply(analyzer, normalized, len), docID, FIELD_DESC);
+        }
+    }
+    free(lower);
+    return num_words;
+}
+
+/*
+ * index_addanchor - Tokenizes the text as if it were a page of its own.
+ */
+int index_addanchor(hashtable_t* index, const char* text, int len, int docID, analyzer_t analyzer) {
+    int num_words = 0;
+    const char* token;
+    int word_len;
+    char* lower = malloc(len + 1);
+    tokenizer_t tk;
+    tokenizer_init(&tk, text, len, lower);
+    while (tokenizer_next(&tk, &token, &word_len) > 0) {
+        char* normalized = lower + (token - lower);
+        num_words += add_term(index, normalized, analyzer_apply(analyzer, normalized, word_len), docID, FIELD_ANCHOR);
+    }
+    free(lower);
+    return num_words;
+}
+
+/*
+ * index_addstopword - Creates the word's entry with an empty bitmap, or
+ * moves its postings into one.
+ */
+void index_addstopword(hashtable_t* index, const char* term) {
+    int len = strlen(term);
+    word_entry_t* word = hsearch(index, search_word, term, len);
+    if (word == NULL) {
+        word = malloc(sizeof(word_entry_t));
+        word->word = malloc(len + 1);
+        memcpy(word->word, term, len + 1);
+        word->docs = qopen();
+        word->stopbits = NULL;
+        hput(index, word, word->word, len);
+    }
+    if (word->stopbits != NULL) {
+        return;
+    }
+
+    word->stopbits = calloc(1, 1);
+    word->stopbits_len = 1;
+    doc_entry_t* doc;
+    while ((doc = qget(word->docs)) != NULL) {
+        set_stopbit(word, doc->docID);
+        free(doc);
+    }
+}
+
+/*
+ * index_stopbit - Tests the page's bit.
+ */
+bool index_stopbit(const word_entry_t* word, int docID) {
+    int byte = docID / 8;
+    return byte < word->stopbits_len && (word->stopbits[byte] & (1 << (docID % 8))) != 0;
+}
+
+/*
+ * index_removepage - Removes every posting of docID from the index.
+ */
+void index_removepage(hashtable_t* index, int docID) {
+    g_docID = docID;
+    happly(index, remove_helper);
+}
+
+/*
+ * index_sortpostings - Sorts every word's postings by docID.
+ */
+void index_sortpostings(hashtable_t* index) {
+    happly(index, sort_helper);
+}
+
+/*
+ * index_freeword - Frees one word entry.
+ */
+void index_freeword(word_entry_t* word) {
+    free_word_entry(word);
+}
+
+/*
+ * index_delete - Frees an index and every entry in it.
+ */
+void index_delete(hashtable_t* index) {
+    if (index != NULL) {
+        happly(index, free_word_entry);
+        hclose(index);
+    }
+}
+
+
+// --- Helper Functions ---
+
+/*
+ * Adds one occurrence of term[0..len) in field of page docID. One in
+ * the description only sets the field, so that it leaves the count
+ * (and the rank, without a description boost) as it was.
+ * Returns 1 if it was indexed, 0 if it is too short.
+ */
+static int add_term(hashtable_t* index, const char* term, int len, int docID, int field) {
+    if (len < MIN_WORD_LEN) {
+        return 0;
+    }
+    word_entry_t* found_word = hsearch(index, search_word, term, len);
+
+    if (found_word == NULL) {
+        // New word, not in hash table
+        word_entry_t* new_word_entry = malloc(sizeof(word_entry_t));
+        new_word_entry->word = malloc(len + 1);
+        memcpy(new_word_entry->word, term, len + 1);
+        new_word_entry->docs = qopen();
+        new_word_entry->stopbits = NULL;
+        new_word_entry->stopbits_len = 0;
+
+        doc_entry_t* new_doc_entry = malloc(sizeof(doc_entry_t));
+        new_doc_entry->docID = docID;
+        new_doc_entry->count = (field == FIELD_DESC) ? 0 : 1;
+        new_doc_entry->fields = field;
+
+        qput(new_word_entry->docs, new_doc_entry);
+        hput(index, new_word_entry, new_word_entry->word, len);
+    } else if (found_word->stopbits != NULL) {
+        // Stopword: just note the page
+        set_stopbit(found_word, docID);
+    } else {
+        // Word is already in the hash table
+        doc_entry_t* found_doc = qsearch(found_word->docs, search_doc, &docID);
+
+        if (found_doc == NULL) {
+            // Word's first time in this doc
+            doc_entry_t* new_doc_entry = malloc(sizeof(doc_entry_t));
+            new_doc_entry->docID = docID;
+            new_doc_entry->count = (field == FIELD_DESC) ? 0 : 1;
+            new_doc_entry->fields = field;
+            qput(found_word->docs, new_doc_entry);
+        } else {
+            // Word seen before in this doc, increment count
+            found_doc->count += (field == FIELD_DESC) ? 0 : 1;
+            found_doc->fields |= field;
+        }
+    }
+    return 1;
+}
+
+// Notes where the title's text is (for htmllex_run)
+static void title_helper(const char* title, int len, void* arg) {
+    page_fields_t* fields = (page_fields_t*)arg;
+    fields->title_start = title - fields->html;
+    fields->title_end = fields->title_start + len;
+}
+
+// Notes where the description is (for htmllex_run)
+static void desc_helper(const char* desc, int len, void* arg) {
+    page_fields_t* fields = (page_fields_t*)arg;
+    fields->desc_start = desc - fields->html;
+    fields->desc_len = len;
+}
+
+// Search function for hash table (compares word)
+static bool search_word(void* elementp, const void* keyp) {
+    word_entry_t* entry = (word_entry_t*)elementp;
+    return strcmp(entry->word, (const char*)keyp) == 0;
+}
+
+// Search function for inner queue (compares docID)
+static bool search_doc(void* elementp, const void* keyp) {
+    doc_entry_t* entry = (doc_entry_t*)elementp;
+    return entry->docID == *(int*)keyp;
+}
+
+// Frees a doc_entry_t (for qapply)
+static void free_doc_entry(void* data) {
+    doc_entry_t* doc = (doc_entry_t*)data;
+    if (doc) free(doc);
+}
+
+// Frees a word_entry_t (for happly)
+static void free_word_entry(void* data) {
+    word_entry_t* word = (word_entry_t*)data;
+    if (word) {
+        free(word->word); // Free the word string
+        free(word->stopbits);
+        qapply(word->docs, free_doc_entry); // Free all doc entries
+        qclose(word->docs); // Free the queue itself
+        free(word); // Free the word entry struct
+    }
+}
+
+// Removes the posting (or bit) of g_docID from one word (for happly)
+static void remove_helper(void* data) {
+    word_entry_t* word = (word_entry_t*)data;
+    if (word->stopbits != NULL) {
+        if (g_docID / 8 < word->stopbits_len) {
+            word->stopbits[g_docID / 8] &= ~(1 << (g_docID % 8));
+        }
+        return;
+    }
+    free_doc_entry(qremove(word->docs, search_doc, &g_docID));
+}
+
+// Sets the stopword's bit for docID, growing its bitmap as needed
+static void set_stopbit(word_entry_t* word, int docID) {
+    int byte = docID / 8;
+    if (byte >= word->stopbits_len) {
+        int len = 2 * word->stopbits_len > byte + 1 ? 2 * word->stopbits_len : byte + 1;
+        word->stopbits = realloc(word->stopbits, len);
+        memset(word->stopbits + word->stopbits_len, 0, len - word->stopbits_len);
+        word->stopbits_len = len;
+    }
+    word->stopbits[byte] |= 1 << (docID % 8);
+}
+
+// Sorts one word's postings by docID (for happly)
+static void sort_helper(void* data) {
+    word_entry_t* word = (word_entry_t*)data;
+    g_count = 0;
+    qapply(word->docs, count_helper);
+    if (g_count < 2) {
+        return;
+    }
+
+    doc_entry_t** docs = malloc(g_count * sizeof(doc_entry_t*));
+    int n = 0;
+    doc_entry_t* doc;
+    while ((doc = qget(word->docs)) != NULL) {
+        docs[n++] = doc;
+    }
+    qsort(docs, n, sizeof(doc_entry_t*), compare_docs);
+    for (int i = 0; i < n; i++) {
+        qput(word->docs, docs[i]);
+    }
+    free(docs);
+}
+
+static void count_helper(void* data) {
+    if (data != NULL) g_count++;
+}
+
+// qsort comparator: increasing docID
+static int compare_docs(const void* a, const void* b) {
+    const doc_entry_t* doc_a = *(doc_entry_t* const*)a;
+    const doc_entry_t* doc_b = *(doc_entry_t* const*)b;
+    return doc_a->docID - doc_b->docID;
+}
@@ -5,21 +5,100 @@
  * Date: 10-30-2025
  *
  * Description: Defines the data structures used by the
- * indexer and indexio modules.
+ * indexer and indexio modules, and the functions that build
+ * an index one page at a time.
  */
 
 #pragma once
 
 #include "queue.h"
+#include "hash.h"
+#include "webpage.h"
+#include "analyzer.h"
+
+#define MIN_WORD_LEN 3 // shorter terms are not indexed
+
+// Where on a page a word occurs (the bits of doc_entry_t.fields)
+#define FIELD_BODY   0x1 // the text, outside the title
+#define FIELD_TITLE  0x2 // the <title>
+#define FIELD_DESC   0x4 // the content of <meta name="description">
+#define FIELD_ANCHOR 0x8 // the text of links to the page, on other pages
 
 // Entry in the document queue (stores count for a doc)
 typedef struct doc_entry {
     int docID;
-    int count;
+    int count;   // occurrences, outside the description
+    int fields;  // FIELD_* bits
 } doc_entry_t;
 
 // Entry in the index (stores the word and its queue of docs)
 typedef struct word_entry {
     char *word;       // The word itself
     queue_t *docs; // Queue of doc_entry_t
+    unsigned char *stopbits; // For a stopword: bit d set if it is on page d; else NULL
+    int stopbits_len;        // Bytes in stopbits
 } word_entry_t;
+
+/*
+ * index_new - Creates a new, empty index.
+ * Returns NULL on failure.
+ */
+hashtable_t *index_new(void);
+
+/*
+ * index_addpage - Adds every word of page's html to the index under docID.
+ * Words are normalized (lowercased, then turned into terms by analyzer;
+ * terms shorter than 3 letters are skipped). Each posting records which
+ * fields its word was found in. The words of the meta description are
+ * the page's too, but are not counted: a word only there has a posting
+ * with count 0, which its DESC field alone ranks. Pages must be added in
+ * increasing docID order, all with the same analyzer. Stopwords only
+ * get the page's bit set.
+ * Returns the number of words indexed.
+ */
+int index_addpage(hashtable_t *index, webpage_t *page, int docID, analyzer_t analyzer);
+
+/*
+ * index_addanchor - Adds the words of text[0..len), the anchor text of
+ * a link to page docID, to the index under docID, normalized as
+ * index_addpage() does. They count as the page's words, in the anchor
+ * field. The page's postings may then be out of order (see
+ * index_sortpostings()).
+ * Returns the number of words indexed.
+ */
+int index_addanchor(hashtable_t *index, const char *text, int len, int docID, analyzer_t analyzer);
+
+/*
+ * index_addstopword - Makes term a stopword of the index: from then on
+ * its pages are kept in a bitmap, with no counts, instead of postings
+ * (postings it already has are turned into bits). Stopwords are saved
+ * and loaded with the index, so later updates keep them in their tier.
+ */
+void index_addstopword(hashtable_t *index, const char *term);
+
+/*
+ * index_stopbit - Whether the stopword word is on page docID.
+ */
+bool index_stopbit(const word_entry_t *word, int docID);
+
+/*
+ * index_removepage - Removes every posting of docID from the index.
+ * Words left without postings stay in the index but are not saved.
+ */
+void index_removepage(hashtable_t *index, int docID);
+
+/*
+ * index_sortpostings - Restores increasing docID order in every word's
+ * postings, after pages were added out of order.
+ */
+void index_sortpostings(hashtable_t *index);
+
+/*
+ * index_freeword - Frees a word_entry_t and its postings or bitmap.
+ */
+void index_freeword(word_entry_t *word);
+
+/*
+ * index_delete - Frees an index and every entry in it.
+ */
+void index_delete(hashtable_t *index);
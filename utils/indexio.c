@@ -7,111 +7,338 @@
  * Description: Saves and loads index data structures.
  */
 
+#define _POSIX_C_SOURCE 200809L // getline
+
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <ctype.h>
 #include "index.h"    // Contains the struct definitions
 #include "indexio.h"  // Contains our function prototypes
 #include "hash.h"
 #include "queue.h"
 
+#define ANALYZER_TAG "#analyzer" // first word of the analyzer line
+#define STOPWORD_MARK '*'    // stands for the postings of a stopword
+#define FIELDS_MARK '/'      // follows a count with the posting's fields, in hex
+
+struct indexreader {
+    FILE* fp;
+    char* line; // Lines grow with the number of pages
+    size_t cap;
+};
+
+struct indexwriter {
+    FILE* fp;
+};
+
 // --- Static helper function prototypes for saving ---
-static void save_word_entry(void* data);
+static void collect_word(void* data);
+static int compare_words(const void* a, const void* b);
 static void save_doc_queue(void* data);
+static bool any_doc(void* elementp, const void* keyp);
+
+// --- Static helper function prototypes for loading ---
+static word_entry_t* parse_line(const char* line);
+static void load_stopbits(word_entry_t* word, const char* text);
 
-// --- Static file pointer for apply helpers ---
-static FILE* save_fp; // Used by the apply helper functions
+// --- Static state for apply helpers ---
+static FILE* save_fp;              // Used by the apply helper functions
+static word_entry_t** save_words;  // The words collected by collect_word
+static int save_count;
+static int save_cap;
+static bool save_failed;           // collect_word ran out of memory
 
 /*
- * indexsave - Saves the index to a file.
+ * indexsave - Saves the index to a file, sorting its words first.
  */
-int indexsave(hashtable_t* index, const char* indexnm) {
-    save_fp = fopen(indexnm, "w");
-    if (save_fp == NULL) {
-        perror("Error: indexsave failed to open file");
+int indexsave(hashtable_t* index, const char* indexnm, analyzer_t analyzer) {
+    indexwriter_t* w = indexwriter_open(indexnm, analyzer);
+    if (w == NULL) {
         return 1;
     }
 
-    // Use happly to iterate over every word in the index
-    happly(index, save_word_entry);
+    // Use happly to gather every word in the index, then write them in order
+    save_words = NULL;
+    save_count = save_cap = 0;
+    save_failed = false;
+    happly(index, collect_word);
+    if (save_failed) {
+        fprintf(stderr, "Error: indexsave ran out of memory.\n");
+        free(save_words);
+        indexwriter_close(w);
+        return 1;
+    }
+    if (save_count > 1) {
+        qsort(save_words, save_count, sizeof(word_entry_t*), compare_words);
+    }
+    for (int i = 0; i < save_count; i++) {
+        indexwriter_put(w, save_words[i]);
+    }
+    free(save_words);
+    save_words = NULL;
 
-    fclose(save_fp);
-    return 0;
+    return indexwriter_close(w);
 }
 
-// Helper for happly (saves one word_entry)
-static void save_word_entry(void* data) {
-    word_entry_t* word = (word_entry_t*)data;
+/*
+ * indexwriter_open - Opens the file and writes the analyzer line.
+ */
+indexwriter_t* indexwriter_open(const char* indexnm, analyzer_t analyzer) {
+    indexwriter_t* w = malloc(sizeof(indexwriter_t));
+    if (w == NULL) {
+        return NULL;
+    }
+    w->fp = fopen(indexnm, "w");
+    if (w->fp == NULL) {
+        perror("Error: indexsave failed to open file");
+        free(w);
+        return NULL;
+    }
+
+    // Indexes built with lower keep the original format
+    if (analyzer != ANALYZER_LOWER) {
+        fprintf(w->fp, "%s %s\n", ANALYZER_TAG, analyzer_name(analyzer));
+    }
+    return w;
+}
+
+/*
+ * indexwriter_put - Writes one word_entry's line.
+ */
+void indexwriter_put(indexwriter_t* w, const word_entry_t* word) {
+    // Words whose pages were all removed are dropped (stopwords are kept)
+    if (word->stopbits == NULL && qsearch(word->docs, any_doc, NULL) == NULL) {
+        return;
+    }
+
     // Print the word
-    fprintf(save_fp, "%s", word->word);
+    fprintf(w->fp, "%s", word->word);
+
+    // A stopword's bitmap, up to its last nonzero byte
+    if (word->stopbits != NULL) {
+        int len = word->stopbits_len;
+        while (len > 0 && word->stopbits[len - 1] == 0) {
+            len--;
+        }
+        fprintf(w->fp, " %c ", STOPWORD_MARK);
+        for (int i = 0; i < len; i++) {
+            fprintf(w->fp, "%02x", word->stopbits[i]);
+        }
+        fprintf(w->fp, "\n");
+        return;
+    }
     
     // Use qapply to iterate over the docs for this word
+    save_fp = w->fp;
     qapply(word->docs, save_doc_queue);
     
     // End the line
-    fprintf(save_fp, "\n");
+    fprintf(w->fp, "\n");
+}
+
+/*
+ * indexwriter_close - Closes the file, reporting any failed write.
+ */
+int indexwriter_close(indexwriter_t* w) {
+    int status = ferror(w->fp);
+    if (fclose(w->fp) != 0) {
+        status = 1;
+    }
+    if (status != 0) {
+        fprintf(stderr, "Error: indexsave failed to write the index.\n");
+    }
+    free(w);
+    return status != 0;
+}
+
+// Helper for happly (adds one word_entry to save_words)
+static void collect_word(void* data) {
+    if (save_failed) {
+        return;
+    }
+    if (save_count == save_cap) {
+        int cap = (save_cap == 0) ? 1024 : 2 * save_cap;
+        word_entry_t** grown = realloc(save_words, cap * sizeof(word_entry_t*));
+        if (grown == NULL) {
+            save_failed = true;
+            return;
+        }
+        save_words = grown;
+        save_cap = cap;
+    }
+    save_words[save_count++] = (word_entry_t*)data;
+}
+
+// qsort comparator: byte order of the words
+static int compare_words(const void* a, const void* b) {
+    const word_entry_t* word_a = *(word_entry_t* const*)a;
+    const word_entry_t* word_b = *(word_entry_t* const*)b;
+    return strcmp(word_a->word, word_b->word);
 }
 
 // Helper for qapply (saves one doc_entry)
 static void save_doc_queue(void* data) {
     doc_entry_t* doc = (doc_entry_t*)data;
-    // Print " <docID> <count>"
+    // Print " <docID> <count>", and "/<fields>" unless it is only in the body
     fprintf(save_fp, " %d %d", doc->docID, doc->count);
+    if (doc->fields != FIELD_BODY) {
+        fprintf(save_fp, "%c%x", FIELDS_MARK, doc->fields);
+    }
+}
+
+// Search function matching any doc_entry (for qsearch)
+static bool any_doc(void* elementp, const void* keyp) {
+    return true;
 }
 
 
 /*
  * indexload - Loads an index from a file.
  */
-hashtable_t* indexload(const char* indexnm) {
-    FILE* fp = fopen(indexnm, "r");
-    if (fp == NULL) {
-        perror("Error: indexload failed to open file");
+hashtable_t* indexload(const char* indexnm, analyzer_t* analyzer) {
+    indexreader_t* r = indexreader_open(indexnm, analyzer);
+    if (r == NULL) {
         return NULL;
     }
 
     // Create a new index
     hashtable_t* index = hopen(500); // 500 is a reasonable size
     if (index == NULL) {
+        indexreader_close(r);
+        return NULL;
+    }
+
+    // Add each complete word_entry_t to the hash table
+    word_entry_t* word_entry;
+    while ((word_entry = indexreader_next(r)) != NULL) {
+        hput(index, word_entry, word_entry->word, strlen(word_entry->word));
+    }
+
+    indexreader_close(r);
+    return index;
+}
+
+/*
+ * indexreader_open - Opens the file and reads its analyzer line.
+ */
+indexreader_t* indexreader_open(const char* indexnm, analyzer_t* analyzer) {
+    FILE* fp = fopen(indexnm, "r");
+    if (fp == NULL) {
+        perror("Error: indexload failed to open file");
+        return NULL;
+    }
+    indexreader_t* r = malloc(sizeof(indexreader_t));
+    if (r == NULL) {
         fclose(fp);
         return NULL;
     }
+    r->fp = fp;
+    r->line = NULL;
+    r->cap = 0;
 
-    // Max line length assumption
-    char line[10000]; 
-    while (fgets(line, sizeof(line), fp) != NULL) {
-        char word[256];
-        int offset = 0;
-        int n_read = 0;
+    // Which analyzer built it (lower unless the first line says)
+    char name[64];
+    *analyzer = ANALYZER_LOWER;
+    if (getline(&r->line, &r->cap, fp) != -1 &&
+        sscanf(r->line, ANALYZER_TAG " %63s", name) == 1) {
+        int found = analyzer_lookup(name);
+        if (found < 0) {
+            fprintf(stderr, "Error: index '%s' was built with an unknown analyzer '%s'.\n", indexnm, name);
+            indexreader_close(r);
+            return NULL;
+        }
+        *analyzer = found;
+    } else {
+        rewind(fp);
+    }
+    return r;
+}
 
-        // 1. Read the word
-        if (sscanf(line, "%255s%n", word, &n_read) != 1) {
-            continue; // Skip malformed lines
+/*
+ * indexreader_next - Reads lines until one holds a word.
+ */
+word_entry_t* indexreader_next(indexreader_t* r) {
+    while (getline(&r->line, &r->cap, r->fp) != -1) {
+        word_entry_t* word_entry = parse_line(r->line);
+        if (word_entry != NULL) {
+            return word_entry;
         }
+    }
+    return NULL;
+}
+
+/*
+ * indexreader_close - Closes the file.
+ */
+void indexreader_close(indexreader_t* r) {
+    free(r->line);
+    fclose(r->fp);
+    free(r);
+}
+
+// Makes the word_entry of one line of the file, or NULL if it is malformed
+static word_entry_t* parse_line(const char* line) {
+    char word[256];
+    int offset = 0;
+    int n_read = 0;
+
+    // 1. Read the word
+    if (sscanf(line, "%255s%n", word, &n_read) != 1) {
+        return NULL;
+    }
+    offset += n_read;
+
+    // 2. Create the index entry for this word
+    word_entry_t* word_entry = malloc(sizeof(word_entry_t));
+    word_entry->word = malloc(strlen(word) + 1);
+    strcpy(word_entry->word, word);
+    word_entry->docs = qopen();
+    word_entry->stopbits = NULL;
+    word_entry->stopbits_len = 0;
+
+    // 3. A stopword has its bitmap instead of postings
+    char mark;
+    if (sscanf(line + offset, " %c%n", &mark, &n_read) == 1 && mark == STOPWORD_MARK) {
         offset += n_read;
+        load_stopbits(word_entry, line + offset);
+        return word_entry;
+    }
 
-        // 2. Create the index entry for this word
-        word_entry_t* word_entry = malloc(sizeof(word_entry_t));
-        word_entry->word = malloc(strlen(word) + 1);
-        strcpy(word_entry->word, word);
-        word_entry->docs = qopen();
+    // 4. Loop, reading (doc, count[/fields]) pairs from the rest of the line
+    int docID, count;
+    while (sscanf(line + offset, " %d %d%n", &docID, &count, &n_read) == 2) {
+        // Create doc_entry_t and add to queue
+        doc_entry_t* doc_entry = malloc(sizeof(doc_entry_t));
+        doc_entry->docID = docID;
+        doc_entry->count = count;
+        doc_entry->fields = FIELD_BODY; // indexes from before fields were kept
+        qput(word_entry->docs, doc_entry);
         
-        // 3. Loop, reading (doc, count) pairs from the rest of the line
-        int docID, count;
-        while (sscanf(line + offset, " %d %d%n", &docID, &count, &n_read) == 2) {
-            // Create doc_entry_t and add to queue
-            doc_entry_t* doc_entry = malloc(sizeof(doc_entry_t));
-            doc_entry->docID = docID;
-            doc_entry->count = count;
-            qput(word_entry->docs, doc_entry);
-            
-            offset += n_read; // Move offset past the pair
+        offset += n_read; // Move offset past the pair
+        unsigned int fields;
+        if (line[offset] == FIELDS_MARK && sscanf(line + offset + 1, "%x%n", &fields, &n_read) == 1) {
+            doc_entry->fields = fields;
+            offset += 1 + n_read;
         }
-        
-        // 4. Add the complete word_entry_t to the hash table
-        hput(index, word_entry, word_entry->word, strlen(word_entry->word));
     }
+    return word_entry;
+}
 
-    fclose(fp);
-    return index;
+// Reads a stopword's hex bitmap from text into word
+static void load_stopbits(word_entry_t* word, const char* text) {
+    while (isspace((unsigned char)*text)) {
+        text++;
+    }
+    int len = 0;
+    while (isxdigit((unsigned char)text[2 * len]) && isxdigit((unsigned char)text[2 * len + 1])) {
+        len++;
+    }
+    word->stopbits = calloc(len > 0 ? len : 1, 1);
+    word->stopbits_len = len > 0 ? len : 1;
+    for (int i = 0; i < len; i++) {
+        unsigned int byte;
+        sscanf(text + 2 * i, "%2x", &byte);
+        word->stopbits[i] = byte;
+    }
 }
@@ -5,24 +5,86 @@
  * Date: 10-30-2025
  *
  * Description: Saves and loads index data structures.
+ *
+ * An index file has one line per word: the word, then a docID and a
+ * count for each page it is on. A count is followed by '/' and the
+ * posting's FIELD_* bits in hex unless the word was only in the body
+ * text ("cat 1 2 3 5/3"); postings without them load as body only. A
+ * stopword's line (see
+ * index_addstopword()) has a '*' and its bitmap in hex instead, the
+ * byte for docIDs 0-7 first, low bit first ("the * 3eff7f").
+ * An index built with an analyzer other than lower starts with a line
+ * naming it ("#analyzer porter2"); a file without one was built with
+ * lower.
+ *
+ * indexsave() writes the lines in byte order of their words, so that
+ * saved indexes can be merged as streams (see indexmerge); an index
+ * reader and writer go through a file a word at a time.
  */
 
 #pragma once
 
 #include "hash.h"
+#include "index.h"
+#include "analyzer.h"
+
+typedef struct indexreader indexreader_t;
+typedef struct indexwriter indexwriter_t;
 
 /*
- * indexsave - Saves the index to a file.
+ * indexsave - Saves the index to a file, its words in byte order.
  * @index: pointer to the index hash table.
  * @indexnm: name of the file to save to.
+ * @analyzer: the analyzer the index was built with, to record.
  * Returns 0 on success, non-zero on failure.
  */
-int indexsave(hashtable_t *index, const char *indexnm);
+int indexsave(hashtable_t *index, const char *indexnm, analyzer_t analyzer);
 
 /*
  * indexload - Loads an index from a file.
  * @indexnm: name of the file to load from.
- * Returns a new hashtable_t* on success, NULL on failure.
+ * @analyzer: set to the analyzer the index was built with; queries
+ *            and updates must use the same one.
+ * Returns a new hashtable_t* on success, NULL on failure (including an
+ * analyzer this program does not know).
  * Caller is responsible for hclosing the returned table.
  */
-hashtable_t *indexload(const char *indexnm);
+hashtable_t *indexload(const char *indexnm, analyzer_t *analyzer);
+
+/*
+ * indexreader_open - Opens an index file to read a word at a time.
+ * @analyzer: set to the analyzer the index was built with.
+ * Returns NULL on failure, as indexload() does.
+ */
+indexreader_t *indexreader_open(const char *indexnm, analyzer_t *analyzer);
+
+/*
+ * indexreader_next - Reads the next word of the file, in file order.
+ * Returns it (the caller's, to free with index_freeword()), or NULL at
+ * the end of the file.
+ */
+word_entry_t *indexreader_next(indexreader_t *r);
+
+/*
+ * indexreader_close - Closes the file and frees r.
+ */
+void indexreader_close(indexreader_t *r);
+
+/*
+ * indexwriter_open - Starts an index file, recording the analyzer.
+ * Returns NULL on failure.
+ */
+indexwriter_t *indexwriter_open(const char *indexnm, analyzer_t analyzer);
+
+/*
+ * indexwriter_put - Writes a word's line: its postings in queue order,
+ * or its bitmap. A word with neither is left out. To be read as a
+ * stream, words must be put in byte order.
+ */
+void indexwriter_put(indexwriter_t *w, const word_entry_t *word);
+
+/*
+ * indexwriter_close - Finishes the file and frees w.
+ * Returns 0 on success, non-zero if anything could not be written.
+ */
+int indexwriter_close(indexwriter_t *w);
@@ -0,0 +1,266 @@
+/*
+ * linkfile.c - implementation of the crawler's link edge file
+ *
+ * Author: Insecticide
+ * Date: 10-17-2026
+ *
+ * Description: A page's links are gathered in memory and written as one
+ * block when the page is done, then flushed, so a crash loses at most
+ * the block being written. Reading takes two passes over the file: the
+ * first reads only the headers, seeking past URLs and text, to find the
+ * last block of each page and where the complete blocks end; the second
+ * reads one link at a time into a buffer big enough for any. Neither
+ * holds more of the file in memory than that. See linkfile.h.
+ */
+
+#define _POSIX_C_SOURCE 200809L // truncate
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "linkfile.h"
+
+#define LINKFILE_FILE ".links"
+#define LINKFILE_MAGIC "TSELINK1"
+#define MAGIC_LEN 8
+#define BLOCK_HEADER 8 // source and number of links
+#define LINK_HEADER 4  // lengths of the URL and the text
+
+struct linkfile {
+    FILE *fp;
+    unsigned char *buf;   // links of the page being recorded
+    int len;
+    int cap;
+    uint32_t num_links;
+};
+
+// --- Static helper function prototypes ---
+static void put_bytes(linkfile_t *lf, const void *data, int len);
+static void put_u16(unsigned char *p, uint16_t v);
+static void put_u32(unsigned char *p, uint32_t v);
+static uint16_t get_u16(const unsigned char *p);
+static uint32_t get_u32(const unsigned char *p);
+static long skip_block(FILE *fp, long size, long pos, uint32_t *source);
+static FILE *open_links(const char *path, long *size);
+
+linkfile_t *linkfile_open(const char *pageDir, bool append) {
+    char path[256];
+    snprintf(path, sizeof(path), "%s/%s", pageDir, LINKFILE_FILE);
+    linkfile_t *lf = calloc(1, sizeof(linkfile_t));
+    if (lf == NULL) {
+        return NULL;
+    }
+
+    // A block cut short by a crash would hide the ones appended after it
+    long size;
+    FILE *fp = append ? open_links(path, &size) : NULL;
+    if (fp != NULL) {
+        long pos = MAGIC_LEN, end;
+        uint32_t source;
+        while ((end = skip_block(fp, size, pos, &source)) > 0) {
+            pos = end;
+        }
+        fclose(fp);
+        if (pos < size && truncate(path, pos) != 0) {
+            perror("Error: linkfile_open failed to drop a partial block");
+        }
+    }
+
+    lf->fp = fopen(path, append ? "a" : "w");
+    if (lf->fp == NULL) {
+        perror("Error: linkfile_open failed to open file");
+        free(lf);
+        return NULL;
+    }
+    fseek(lf->fp, 0, SEEK_END);
+    if (ftell(lf->fp) == 0) {
+        fwrite(LINKFILE_MAGIC, 1, MAGIC_LEN, lf->fp);
+    }
+    return lf;
+}
+
+void linkfile_add(linkfile_t *lf, const char *url, const char *text, int text_len) {
+    int url_len = strlen(url);
+    if (url_len > LINKFILE_MAXURL) {
+        return;
+    }
+    if (text_len > 0xFFFF) {
+        text_len = 0xFFFF;
+    }
+    unsigned char header[LINK_HEADER];
+    put_u16(header, url_len);
+    put_u16(header + 2, text_len);
+    put_bytes(lf, header, LINK_HEADER);
+    put_bytes(lf, url, url_len);
+    put_bytes(lf, text, text_len);
+    lf->num_links++;
+}
+
+int32_t linkfile_end(linkfile_t *lf, int source) {
+    unsigned char header[BLOCK_HEADER];
+    put_u32(header, source);
+    put_u32(header + 4, lf->num_links);
+    int32_t status = fwrite(header, 1, BLOCK_HEADER, lf->fp) != BLOCK_HEADER ||
+                     fwrite(lf->buf, 1, lf->len, lf->fp) != (size_t)lf->len ||
+                     fflush(lf->fp) != 0;
+    lf->len = 0;
+    lf->num_links = 0;
+    return status;
+}
+
+void linkfile_close(linkfile_t *lf) {
+    if (lf != NULL) {
+        fclose(lf->fp);
+        free(lf->buf);
+        free(lf);
+    }
+}
+
+int linkfile_apply(const char *pageDir,
+                   void (*fn)(int source, const char *url, const char *text, int text_len, bool latest, void *arg),
+                   void *arg) {
+    char path[256];
+    snprintf(path, sizeof(path), "%s/%s", pageDir, LINKFILE_FILE);
+    long size;
+    FILE *fp = open_links(path, &size);
+    if (fp == NULL) {
+        return -1;
+    }
+
+    // 1. The last block of each page, and where the complete blocks end
+    long *latest = NULL;
+    uint32_t num_latest = 0, source;
+    long pos = MAGIC_LEN, end;
+    while ((end = skip_block(fp, size, pos, &source)) > 0) {
+        if (source >= num_latest) {
+            uint32_t n = (source + 1 > 2 * num_latest) ? source + 1 : 2 * num_latest;
+            latest = realloc(latest, n * sizeof(long));
+            memset(latest + num_latest, 0, (n - num_latest) * sizeof(long));
+            num_latest = n;
+        }
+        latest[source] = pos;
+        pos = end;
+    }
+    end = pos;
+
+    // 2. Every link of every block, the URL and its text read side by side
+    int num_links = 0;
+    char *buf = malloc(LINKFILE_MAXURL + 1 + 0xFFFF);
+    fseek(fp, MAGIC_LEN, SEEK_SET);
+    for (pos = MAGIC_LEN; pos < end; ) {
+        unsigned char header[BLOCK_HEADER];
+        if (fread(header, 1, BLOCK_HEADER, fp) != BLOCK_HEADER) {
+            break;
+        }
+        source = get_u32(header);
+        uint32_t count = get_u32(header + 4);
+        bool last = (latest[source] == pos);
+        pos += BLOCK_HEADER;
+        for (uint32_t i = 0; i < count; i++) {
+            unsigned char link[LINK_HEADER];
+            if (fread(link, 1, LINK_HEADER, fp) != LINK_HEADER) {
+                pos = end;
+                break;
+            }
+            int url_len = get_u16(link);
+            int text_len = get_u16(link + 2);
+            if (fread(buf, 1, url_len, fp) != (size_t)url_len ||
+                fread(buf + url_len + 1, 1, text_len, fp) != (size_t)text_len) {
+                pos = end;
+                break;
+            }
+            buf[url_len] = '\0';
+            fn(source, buf, buf + url_len + 1, text_len, last, arg);
+            pos += LINK_HEADER + url_len + text_len;
+            num_links++;
+        }
+    }
+    free(buf);
+    free(latest);
+    fclose(fp);
+    return num_links;
+}
+
+
+// --- Helper Functions ---
+
+// Appends len bytes to the page's links, growing the buffer as needed
+static void put_bytes(linkfile_t *lf, const void *data, int len) {
+    if (lf->len + len > lf->cap) {
+        lf->cap = (lf->len + len > 2 * lf->cap) ? lf->len + len : 2 * lf->cap;
+        lf->buf = realloc(lf->buf, lf->cap);
+    }
+    memcpy(lf->buf + lf->len, data, len);
+    lf->len += len;
+}
+
+static void put_u16(unsigned char *p, uint16_t v) {
+    p[0] = v & 0xFF;
+    p[1] = v >> 8;
+}
+
+static void put_u32(unsigned char *p, uint32_t v) {
+    for (int i = 0; i < 4; i++) {
+        p[i] = (v >> (8 * i)) & 0xFF;
+    }
+}
+
+static uint16_t get_u16(const unsigned char *p) {
+    return p[0] | (p[1] << 8);
+}
+
+static uint32_t get_u32(const unsigned char *p) {
+    return p[0] | (p[1] << 8) | (p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+/*
+ * Opens the file at path for reading, past its header, and sets *size.
+ * Returns NULL if it cannot be read or is not a link file (an empty
+ * one is not reported: a crash can leave it before the header is out).
+ */
+static FILE *open_links(const char *path, long *size) {
+    FILE *fp = fopen(path, "rb");
+    if (fp == NULL) {
+        return NULL;
+    }
+    fseek(fp, 0, SEEK_END);
+    *size = ftell(fp);
+    rewind(fp);
+    char magic[MAGIC_LEN];
+    if (*size < MAGIC_LEN || fread(magic, 1, MAGIC_LEN, fp) != MAGIC_LEN ||
+        memcmp(magic, LINKFILE_MAGIC, MAGIC_LEN) != 0) {
+        if (*size > 0) {
+            fprintf(stderr, "Error: '%s' is not a link file.\n", path);
+        }
+        fclose(fp);
+        return NULL;
+    }
+    return fp;
+}
+
+/*
+ * Reads the header of the block at pos, where fp is, and sets *source;
+ * reads the lengths of its links and seeks past the rest.
+ * Returns where the block ends, or 0 if it is missing or cut short.
+ */
+static long skip_block(FILE *fp, long size, long pos, uint32_t *source) {
+    unsigned char header[BLOCK_HEADER];
+    if (pos + BLOCK_HEADER > size || fread(header, 1, BLOCK_HEADER, fp) != BLOCK_HEADER) {
+        return 0;
+    }
+    *source = get_u32(header);
+    uint32_t count = get_u32(header + 4);
+    pos += BLOCK_HEADER;
+    for (uint32_t i = 0; i < count; i++) {
+        unsigned char link[LINK_HEADER];
+        if (pos + LINK_HEADER > size || fread(link, 1, LINK_HEADER, fp) != LINK_HEADER) {
+            return 0;
+        }
+        pos += LINK_HEADER + get_u16(link) + get_u16(link + 2);
+        if (pos > size || fseek(fp, pos, SEEK_SET) != 0) {
+            return 0;
+        }
+    }
+    return pos;
+}
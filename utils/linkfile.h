@@ -0,0 +1,66 @@
+/*
+ * linkfile.h - header file for the crawler's link edge file
+ *
+ * Author: Insecticide
+ * Date: 10-17-2026
+ *
+ * Description: Records, for every page a crawl saves, the links on it:
+ * the URL each one leads to (resolved and normalized, in scope) and its
+ * anchor text. The indexer credits anchor words to the pages the links
+ * lead to, without parsing any page twice.
+ *
+ * The edges live in <pageDirectory>/.links, a binary file of one block
+ * per saved page, appended as pages are crawled:
+ *   source docID (4 bytes), number of links (4 bytes), then per link
+ *   the URL's length (2 bytes), the text's length (2 bytes), the URL,
+ *   the text
+ * all little-endian, after an 8-byte "TSELINK1" header. When a page
+ * has more than one block (recrawled, or crawled again after a
+ * resume), the last one wins. A block cut short by a crash is ignored.
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#define LINKFILE_MAXURL 65535 // longer URLs are not recorded
+
+typedef struct linkfile linkfile_t;
+
+/*
+ * linkfile_open - Opens the edge file of the crawler directory pageDir
+ * for writing. If append is true, blocks are added to the existing
+ * ones; otherwise the file is started afresh.
+ * Returns NULL on failure.
+ */
+linkfile_t *linkfile_open(const char *pageDir, bool append);
+
+/*
+ * linkfile_add - Adds a link of the page being recorded: to url (a
+ * NUL-terminated string), with anchor text[0..text_len).
+ */
+void linkfile_add(linkfile_t *lf, const char *url, const char *text, int text_len);
+
+/*
+ * linkfile_end - Writes the links added since the last call as the
+ * block of page source (even if there are none).
+ * Returns 0 on success, non-zero on failure.
+ */
+int32_t linkfile_end(linkfile_t *lf, int source);
+
+/*
+ * linkfile_close - Closes the file and frees lf.
+ */
+void linkfile_close(linkfile_t *lf);
+
+/*
+ * linkfile_apply - Reads the edge file of pageDir and calls
+ * fn(source, url, text, text_len, latest, arg) for every link of every
+ * block, in file order; latest is whether the block is its page's last
+ * one. url is NUL-terminated; text is not.
+ * Returns the number of links read, or -1 if there is no edge file.
+ */
+int linkfile_apply(const char *pageDir,
+                   void (*fn)(int source, const char *url, const char *text, int text_len, bool latest, void *arg),
+                   void *arg);
@@ -0,0 +1,379 @@
+/*
+ * linkgraph.c - implementation of the link graph and PageRank module
+ *
+ * Author: Insecticide
+ * Date: 10-17-2026
+ *
+ * Description: The graph is built in one pass over the link file, which
+ * resolves each link's URL once, keeps its target (4 bytes) and counts
+ * the links to each page; the sources are then filed in the slots the
+ * counts give. URLs are found in an open-addressing table of their
+ * FNV-1a hashes (see pagemeta_hash()), a probe or two per link.
+ * PageRank pulls each page's rank from the pages linking to it. See
+ * linkgraph.h.
+ */
+
+#define _POSIX_C_SOURCE 200809L // sysconf, access
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <pthread.h>
+#include "linkgraph.h"
+#include "linkfile.h"
+#include "pagemeta.h"
+#include "webpage.h"
+
+#define MAX_THREADS 64
+
+// A page's URL (normalized, as the crawler records links) and docID
+typedef struct url_slot {
+    uint64_t hash;
+    char *url;           // NULL if the slot is free
+    int docID;
+} url_slot_t;
+
+// The URLs of the pages; at most half the slots are used
+typedef struct url_table {
+    url_slot_t *slots;
+    uint64_t mask;       // the number of slots, less one
+} url_table_t;
+
+// The links of one page, as a run of build_state_t.targets
+typedef struct link_run {
+    uint32_t source;
+    uint32_t start;
+} link_run_t;
+
+// What the pass over the link file needs
+typedef struct build_state {
+    linkgraph_t *g;
+    url_table_t urls;
+    uint32_t *last_source; // the last page found linking to each page
+    uint32_t *targets;     // of the links that count, in file order
+    uint32_t num_targets;
+    uint32_t max_targets;
+    link_run_t *runs;      // where each page's links start in targets
+    int num_runs;
+    int max_runs;
+} build_state_t;
+
+// One thread's share of an iteration: pages [lo, hi)
+typedef struct rank_worker {
+    const linkgraph_t *g;
+    int lo;
+    int hi;
+    double base;           // what every page gets from jumps and dead ends
+    double damping;
+    const double *rank;    // last iteration's ranks
+    const double *share;   // ...and what each page passes to each link
+    double *next_rank;
+    double *next_share;
+    double change;         // out: the sum of the changes in rank
+    double dangling;       // out: the rank of the pages without links
+    pthread_t thread;
+    bool running;          // whether thread is running it
+} rank_worker_t;
+
+// --- Static helper function prototypes ---
+static void meta_helper(page_meta_t *m, void *arg);
+static void link_helper(int source, const char *url, const char *text, int text_len, bool latest, void *arg);
+static void *rank_run(void *arg);
+static url_slot_t *find_url(const url_table_t *urls, const char *url, uint64_t hash);
+
+linkgraph_t *linkgraph_load(const char *pageDir) {
+    char path[256];
+    snprintf(path, sizeof(path), "%s/.links", pageDir);
+    if (access(path, F_OK) != 0) {
+        return NULL;
+    }
+
+    // 1. The pages, and the URL of each
+    pagemeta_t *meta = pagemeta_open((char *)pageDir, true);
+    if (meta == NULL) {
+        return NULL;
+    }
+    linkgraph_t *g = calloc(1, sizeof(linkgraph_t));
+    g->size = pagemeta_maxid(meta) + 1;
+    g->page = calloc(g->size, 1);
+    g->in_start = calloc(g->size + 1, sizeof(uint32_t));
+    g->out_degree = calloc(g->size, sizeof(uint32_t));
+    uint64_t num_slots = 16;
+    while (num_slots < 2 * (uint64_t)g->size) {
+        num_slots *= 2;
+    }
+    build_state_t state = { .g = g, .urls = { calloc(num_slots, sizeof(url_slot_t)), num_slots - 1 },
+                            .last_source = calloc(g->size, sizeof(uint32_t)) };
+    pagemeta_apply(meta, meta_helper, &state);
+    pagemeta_close(meta);
+
+    // 2. The links that count, and the number to each page at in_start[docID + 1]
+    if (linkfile_apply(pageDir, link_helper, &state) < 0) {
+        linkgraph_delete(g);
+        g = NULL;
+    } else {
+        for (int d = 0; d < g->size; d++) {
+            g->in_start[d + 1] += g->in_start[d];
+        }
+        g->num_links = g->in_start[g->size];
+
+        // 3. Their sources: in_start[d] moves up to where page d + 1 starts
+        g->sources = malloc((g->num_links > 0 ? g->num_links : 1) * sizeof(uint32_t));
+        for (int r = 0; r < state.num_runs; r++) {
+            uint32_t end = (r + 1 < state.num_runs) ? state.runs[r + 1].start : state.num_targets;
+            for (uint32_t i = state.runs[r].start; i < end; i++) {
+                g->sources[g->in_start[state.targets[i]]++] = state.runs[r].source;
+            }
+        }
+        memmove(g->in_start + 1, g->in_start, g->size * sizeof(uint32_t));
+        g->in_start[0] = 0;
+    }
+
+    for (uint64_t i = 0; i <= state.urls.mask; i++) {
+        free(state.urls.slots[i].url);
+    }
+    free(state.urls.slots);
+    free(state.last_source);
+    free(state.targets);
+    free(state.runs);
+    return g;
+}
+
+double *linkgraph_pagerank(const linkgraph_t *g, double damping, double tolerance, int max_iters,
+                           int num_threads, int *iterations) {
+    if (num_threads <= 0) {
+        num_threads = (int)sysconf(_SC_NPROCESSORS_ONLN);
+    }
+    if (num_threads < 1) {
+        num_threads = 1;
+    } else if (num_threads > MAX_THREADS) {
+        num_threads = MAX_THREADS;
+    }
+    double *rank = calloc(g->size, sizeof(double));
+    double *share = calloc(g->size, sizeof(double));
+    double *next_rank = calloc(g->size, sizeof(double));
+    double *next_share = calloc(g->size, sizeof(double));
+    if (rank == NULL || share == NULL || next_rank == NULL || next_share == NULL || g->num_pages == 0) {
+        free(share);
+        free(next_rank);
+        free(next_share);
+        return rank;
+    }
+
+    // Every page starts with an equal rank
+    double dangling = 0;
+    for (int d = 0; d < g->size; d++) {
+        if (g->page[d]) {
+            rank[d] = 1.0 / g->num_pages;
+            if (g->out_degree[d] > 0) {
+                share[d] = rank[d] / g->out_degree[d];
+            } else {
+                dangling += rank[d];
+            }
+        }
+    }
+
+    // Each thread gets about as many links to follow (and a page for each)
+    rank_worker_t workers[MAX_THREADS];
+    uint64_t work = (uint64_t)g->num_links + g->size;
+    int lo = 0;
+    for (int t = 0; t < num_threads; t++) {
+        int hi = lo;
+        uint64_t goal = work * (t + 1) / num_threads;
+        while (hi < g->size && (uint64_t)g->in_start[hi] + hi < goal) {
+            hi++;
+        }
+        if (t == num_threads - 1) {
+            hi = g->size;
+        }
+        workers[t] = (rank_worker_t){ .g = g, .lo = lo, .hi = hi, .damping = damping };
+        lo = hi;
+    }
+
+    int iter = 0;
+    double change = tolerance;
+    while (iter < max_iters && change >= tolerance) {
+        double base = ((1 - damping) + damping * dangling) / g->num_pages;
+        for (int t = 0; t < num_threads; t++) {
+            rank_worker_t *w = &workers[t];
+            w->base = base;
+            w->rank = rank;
+            w->share = share;
+            w->next_rank = next_rank;
+            w->next_share = next_share;
+            w->running = (t > 0 && pthread_create(&w->thread, NULL, rank_run, w) == 0);
+            if (t > 0 && !w->running) {
+                rank_run(w); // no thread to spare: do it here
+            }
+        }
+        rank_run(&workers[0]);
+
+        change = dangling = 0;
+        for (int t = 0; t < num_threads; t++) {
+            if (workers[t].running) {
+                pthread_join(workers[t].thread, NULL);
+            }
+            change += workers[t].change;
+            dangling += workers[t].dangling;
+        }
+        double *swap = rank;
+        rank = next_rank;
+        next_rank = swap;
+        swap = share;
+        share = next_share;
+        next_share = swap;
+        iter++;
+    }
+
+    if (iterations != NULL) {
+        *iterations = iter;
+    }
+    free(share);
+    free(next_rank);
+    free(next_share);
+    return rank;
+}
+
+int32_t linkgraph_saveranks(const char *path, const linkgraph_t *g, const double *ranks) {
+    FILE *fp = fopen(path, "w");
+    if (fp == NULL) {
+        perror("Error: linkgraph_saveranks failed to open file");
+        return 1;
+    }
+    for (int d = 0; d < g->size; d++) {
+        if (g->page[d]) {
+            fprintf(fp, "%d %.6g\n", d, ranks[d] * g->num_pages);
+        }
+    }
+    return fclose(fp) != 0;
+}
+
+double *linkgraph_loadranks(const char *path, int *size) {
+    FILE *fp = fopen(path, "r");
+    if (fp == NULL) {
+        return NULL;
+    }
+    int cap = 64, docID;
+    double score;
+    double *scores = calloc(cap, sizeof(double));
+    *size = 0;
+    while (fscanf(fp, "%d %lf", &docID, &score) == 2) {
+        if (docID < 0) {
+            continue;
+        }
+        if (docID >= cap) {
+            int n = (2 * cap > docID + 1) ? 2 * cap : docID + 1;
+            scores = realloc(scores, n * sizeof(double));
+            memset(scores + cap, 0, (n - cap) * sizeof(double));
+            cap = n;
+        }
+        scores[docID] = score;
+        if (docID >= *size) {
+            *size = docID + 1;
+        }
+    }
+    fclose(fp);
+    return scores;
+}
+
+void linkgraph_delete(linkgraph_t *g) {
+    if (g != NULL) {
+        free(g->page);
+        free(g->in_start);
+        free(g->sources);
+        free(g->out_degree);
+        free(g);
+    }
+}
+
+
+// --- Helper Functions ---
+
+// Files one page of the crawl (for pagemeta_apply)
+static void meta_helper(page_meta_t *m, void *arg) {
+    build_state_t *state = (build_state_t *)arg;
+    char *url = malloc(strlen(m->url) + 1);
+    strcpy(url, m->url);
+    NormalizeURL(url); // the seed URL is saved as it was given
+    uint64_t hash = pagemeta_hash(url, strlen(url));
+    url_slot_t *slot = find_url(&state->urls, url, hash);
+    if (m->docID <= 0 || slot->url != NULL) {
+        free(url);
+        return;
+    }
+    *slot = (url_slot_t){ hash, url, m->docID };
+    state->g->page[m->docID] = 1;
+    state->g->num_pages++;
+}
+
+/*
+ * Keeps and counts one link, if it counts (for linkfile_apply). A
+ * page's links are all in one block, so last_source tells whether it
+ * linked to the same page already, and whether a new run starts.
+ */
+static void link_helper(int source, const char *url, const char *text, int text_len, bool latest, void *arg) {
+    build_state_t *state = (build_state_t *)arg;
+    linkgraph_t *g = state->g;
+    if (!latest || source <= 0 || source >= g->size || !g->page[source]) {
+        return;
+    }
+    url_slot_t *slot = find_url(&state->urls, url, pagemeta_hash(url, strlen(url)));
+    if (slot->url == NULL || slot->docID == source || state->last_source[slot->docID] == (uint32_t)source) {
+        return;
+    }
+    int target = slot->docID;
+    if (g->out_degree[source] == 0) {
+        if (state->num_runs == state->max_runs) {
+            state->max_runs = 2 * state->max_runs + 64;
+            state->runs = realloc(state->runs, state->max_runs * sizeof(link_run_t));
+        }
+        state->runs[state->num_runs++] = (link_run_t){ source, state->num_targets };
+    }
+    if (state->num_targets == state->max_targets) {
+        state->max_targets = 2 * state->max_targets + 1024;
+        state->targets = realloc(state->targets, state->max_targets * sizeof(uint32_t));
+    }
+    state->targets[state->num_targets++] = target;
+    state->last_source[target] = source;
+    g->out_degree[source]++;
+    g->in_start[target + 1]++;
+}
+
+// Computes the next ranks of one thread's pages
+static void *rank_run(void *arg) {
+    rank_worker_t *w = (rank_worker_t *)arg;
+    const linkgraph_t *g = w->g;
+    double change = 0, dangling = 0;
+    for (int d = w->lo; d < w->hi; d++) {
+        if (!g->page[d]) {
+            continue;
+        }
+        double sum = 0;
+        for (uint32_t i = g->in_start[d]; i < g->in_start[d + 1]; i++) {
+            sum += w->share[g->sources[i]];
+        }
+        double rank = w->base + w->damping * sum;
+        change += (rank > w->rank[d]) ? rank - w->rank[d] : w->rank[d] - rank;
+        w->next_rank[d] = rank;
+        if (g->out_degree[d] > 0) {
+            w->next_share[d] = rank / g->out_degree[d];
+        } else {
+            w->next_share[d] = 0;
+            dangling += rank;
+        }
+    }
+    w->change = change;
+    w->dangling = dangling;
+    return NULL;
+}
+
+// The slot of url (whose hash is given), or the free slot where it would go
+static url_slot_t *find_url(const url_table_t *urls, const char *url, uint64_t hash) {
+    uint64_t i = hash & urls->mask;
+    while (urls->slots[i].url != NULL &&
+           (urls->slots[i].hash != hash || strcmp(urls->slots[i].url, url) != 0)) {
+        i = (i + 1) & urls->mask;
+    }
+    return &urls->slots[i];
+}
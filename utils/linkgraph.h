@@ -0,0 +1,81 @@
+/*
+ * linkgraph.h - header file for the crawl's link graph and PageRank
+ *
+ * Author: Insecticide
+ * Date: 10-17-2026
+ *
+ * Description: The pages of a crawl and the links between them, as
+ * recorded by the crawler (see linkfile.h and pagemeta.h), in
+ * compressed sparse row form over docIDs: the pages linking to page d
+ * are sources[in_start[d]..in_start[d + 1]). A graph costs 4 bytes per
+ * link and 9 per docID; building it takes 4 more per link for a while
+ * and reads the link file a link at a time, so tens of millions of
+ * links fit in memory.
+ *
+ * Only the last links recorded for each page count, and only between
+ * pages still in the crawl. A page linking to another more than once
+ * counts once; a page linking to itself does not count.
+ *
+ * PageRank is found by power iteration, with the pages split between
+ * threads by their number of links; each pass reads the last pass's
+ * ranks and writes its own, so the threads share nothing they write.
+ * Pages without links share their rank with every page, as if they
+ * linked to all of them.
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#define LINKGRAPH_RANKS_SUFFIX ".pagerank" // the indexer saves the scores as <indexFile>.pagerank
+
+typedef struct linkgraph {
+    int size;             // docIDs are below this
+    int num_pages;        // docIDs that are pages of the graph
+    uint32_t num_links;
+    unsigned char *page;  // whether each docID is a page of the graph
+    uint32_t *in_start;   // size + 1 offsets into sources
+    uint32_t *sources;    // the pages linking to each page, in turn
+    uint32_t *out_degree; // the number of pages each page links to
+} linkgraph_t;
+
+/*
+ * linkgraph_load - Builds the link graph of the crawler directory
+ * pageDir from its link file and page metadata.
+ * Returns NULL if it has no link file, or on failure.
+ */
+linkgraph_t *linkgraph_load(const char *pageDir);
+
+/*
+ * linkgraph_pagerank - Computes the PageRank of every page of g with
+ * the given damping factor, iterating until the ranks change by less
+ * than tolerance in all (the sum of the changes), or max_iters times.
+ * num_threads threads share the work; 0 means one per processor.
+ * @iterations: if not NULL, set to the number of iterations run.
+ * Returns the ranks by docID (0 for docIDs that are not pages), which
+ * add up to 1 and are the caller's to free, or NULL on failure.
+ */
+double *linkgraph_pagerank(const linkgraph_t *g, double damping, double tolerance, int max_iters,
+                           int num_threads, int *iterations);
+
+/*
+ * linkgraph_saveranks - Writes the ranks of g's pages to the file at
+ * path, one "docID score" line each, where the score is the rank times
+ * the number of pages (so the average page scores 1).
+ * Returns 0 on success, non-zero on failure.
+ */
+int32_t linkgraph_saveranks(const char *path, const linkgraph_t *g, const double *ranks);
+
+/*
+ * linkgraph_loadranks - Reads a file written by linkgraph_saveranks().
+ * @size: set to the length of the array returned.
+ * Returns the scores by docID (0 for docIDs it does not list), which
+ * are the caller's to free, or NULL if the file cannot be read.
+ */
+double *linkgraph_loadranks(const char *path, int *size);
+
+/*
+ * linkgraph_delete - Frees g.
+ */
+void linkgraph_delete(linkgraph_t *g);
@@ -0,0 +1,178 @@
+/*
+ * pagedict.c - implementation of the page compression dictionary module
+ *
+ * Author: Insecticide
+ * Date: 10-17-2026
+ *
+ * Description: Trains, loads and saves preset dictionaries for page
+ * compression. See pagedict.h.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "pagedict.h"
+#include "pageio.h"
+#include "pagedir.h"
+#include "hash.h"
+
+#define MIN_LINE 8    // shorter lines are cheap to encode anyway
+#define MAX_LINE 1024 // longer lines are content, not boilerplate
+
+// A distinct line seen while training
+typedef struct dict_line {
+    int len;
+    int df;      // number of pages containing the line
+    int lastdoc; // last page it was counted for
+    char text[]; // the line, NUL-terminated
+} dict_line_t;
+
+// --- Static helper function prototypes ---
+static bool line_matches(void *elementp, const void *keyp);
+static int by_value(const void *a, const void *b);
+
+/*
+ * pagedict_train - Counts in how many pages each line occurs, then
+ * keeps the shared lines with the highest (df - 1) * len.
+ */
+pagedict_t *pagedict_train(char *dirnm, int maxpages) {
+    hashtable_t *lines = hopen(4096);
+    dict_line_t **all = NULL;
+    int num_lines = 0, capacity = 0;
+    char key[MAX_LINE + 1];
+
+    // The first pages by docID, which need not be consecutive
+    int num_ids = 0;
+    int *ids = pagedir_list(dirnm, &num_ids);
+    webpage_t *page;
+    for (int i = 0; i < num_ids && i < maxpages; i++) {
+        int id = ids[i];
+        if ((page = pageload(id, dirnm)) == NULL) {
+            continue;
+        }
+        char *html = webpage_getHTML(page);
+        int html_len = webpage_getHTMLlen(page);
+
+        for (int start = 0, end; start < html_len; start = end + 1) {
+            char *nl = memchr(html + start, '\n', html_len - start);
+            end = nl ? (int)(nl - html) : html_len;
+            int len = end - start + 1; // keep the newline
+            if (nl == NULL || len < MIN_LINE || len > MAX_LINE) {
+                continue;
+            }
+            memcpy(key, html + start, len);
+            key[len] = '\0';
+
+            dict_line_t *line = hsearch(lines, line_matches, key, len);
+            if (line == NULL) {
+                line = malloc(sizeof(dict_line_t) + len + 1);
+                line->len = len;
+                line->df = 0;
+                line->lastdoc = 0;
+                memcpy(line->text, key, len + 1);
+                hput(lines, line, line->text, len);
+
+                if (num_lines == capacity) {
+                    capacity = capacity ? capacity * 2 : 1024;
+                    all = realloc(all, capacity * sizeof(dict_line_t *));
+                }
+                all[num_lines++] = line;
+            }
+            if (line->lastdoc != id) {
+                line->df++;
+                line->lastdoc = id;
+            }
+        }
+        webpage_delete(page);
+    }
+    hclose(lines);
+    free(ids);
+
+    // Most valuable first, then fill the dictionary back to front
+    qsort(all, num_lines, sizeof(dict_line_t *), by_value);
+    pagedict_t *dict = malloc(sizeof(pagedict_t));
+    dict->data = malloc(PAGEDICT_MAXLEN);
+    dict->len = 0;
+    int end = PAGEDICT_MAXLEN;
+    for (int i = 0; i < num_lines && all[i]->df > 1; i++) {
+        if (all[i]->len <= end) {
+            end -= all[i]->len;
+            memcpy(dict->data + end, all[i]->text, all[i]->len);
+        }
+    }
+    dict->len = PAGEDICT_MAXLEN - end;
+    memmove(dict->data, dict->data + end, dict->len);
+
+    for (int i = 0; i < num_lines; i++) {
+        free(all[i]);
+    }
+    free(all);
+
+    if (dict->len == 0) {
+        pagedict_delete(dict);
+        return NULL;
+    }
+    return dict;
+}
+
+/*
+ * pagedict_load - Reads at most PAGEDICT_MAXLEN bytes from path.
+ */
+pagedict_t *pagedict_load(const char *path) {
+    FILE *fp = fopen(path, "rb");
+    if (fp == NULL) {
+        return NULL;
+    }
+    pagedict_t *dict = malloc(sizeof(pagedict_t));
+    dict->data = malloc(PAGEDICT_MAXLEN);
+    dict->len = fread(dict->data, 1, PAGEDICT_MAXLEN, fp);
+    fclose(fp);
+
+    if (dict->len == 0) {
+        pagedict_delete(dict);
+        return NULL;
+    }
+    return dict;
+}
+
+/*
+ * pagedict_save - Writes the dictionary bytes to path.
+ */
+int32_t pagedict_save(pagedict_t *dict, const char *path) {
+    FILE *fp = fopen(path, "wb");
+    if (fp == NULL) {
+        perror("Error: pagedict_save failed to open file for writing");
+        return 1;
+    }
+    int32_t status = fwrite(dict->data, 1, dict->len, fp) != (size_t)dict->len;
+    if (fclose(fp) != 0) {
+        status = 1;
+    }
+    return status;
+}
+
+/*
+ * pagedict_delete - Frees dict and its data.
+ */
+void pagedict_delete(pagedict_t *dict) {
+    if (dict != NULL) {
+        free(dict->data);
+        free(dict);
+    }
+}
+
+// --- Helper Functions ---
+
+// hsearch callback: does the line's text equal the key?
+static bool line_matches(void *elementp, const void *keyp) {
+    return strcmp(((dict_line_t *)elementp)->text, (const char *)keyp) == 0;
+}
+
+// qsort comparator: higher (df - 1) * len first
+static int by_value(const void *a, const void *b) {
+    const dict_line_t *la = *(dict_line_t *const *)a;
+    const dict_line_t *lb = *(dict_line_t *const *)b;
+    long va = (long)(la->df - 1) * la->len;
+    long vb = (long)(lb->df - 1) * lb->len;
+    return (va < vb) - (va > vb);
+}
@@ -0,0 +1,52 @@
+/*
+ * pagedict.h - header file for the page compression dictionary module
+ *
+ * Author: Insecticide
+ * Date: 10-17-2026
+ *
+ * Description: A preset dictionary for compressing crawler pages with
+ * zlib. Pages from one site share a lot of boilerplate (doctype, head,
+ * navigation, footer), which a small page cannot compress against on
+ * its own; priming the compressor with that boilerplate fixes this.
+ *
+ * A dictionary is trained from the pages already in a crawler
+ * directory: lines that occur in several pages are kept, the most
+ * valuable (occurrences x length) last, where zlib matches them most
+ * cheaply. A directory's dictionary lives in its PAGEDICT_FILE.
+ */
+
+#pragma once
+
+#include <stdint.h>
+
+#define PAGEDICT_FILE ".dict"  // dictionary file within a page directory
+#define PAGEDICT_MAXLEN 32768  // zlib uses at most the last 32K of a dictionary
+
+typedef struct pagedict {
+    unsigned char *data;
+    int len;
+} pagedict_t;
+
+/*
+ * pagedict_train - Builds a dictionary from the first maxpages pages
+ * of dirnm, by docID (see pagedir_list()).
+ * Returns NULL if the pages share nothing worth keeping.
+ */
+pagedict_t *pagedict_train(char *dirnm, int maxpages);
+
+/*
+ * pagedict_load - Reads a dictionary from the file at path.
+ * Returns NULL if there is none.
+ */
+pagedict_t *pagedict_load(const char *path);
+
+/*
+ * pagedict_save - Writes dict to the file at path.
+ * Returns 0 on success, non-zero on failure.
+ */
+int32_t pagedict_save(pagedict_t *dict, const char *path);
+
+/*
+ * pagedict_delete - Frees dict.
+ */
+void pagedict_delete(pagedict_t *dict);
@@ -0,0 +1,215 @@
+/*
+ * pagedir.c - implementation of listing and loading a crawler directory's pages
+ *
+ * Author: Insecticide
+ * Date: 10-17-2026
+ *
+ * Description: The loader's threads claim the next position of the list
+ * in turn, load that page with the lock released, and leave it in the
+ * slot for that position of a ring; the caller takes the slots in order.
+ * A thread waits before claiming a position more than the ring's length
+ * ahead of the caller, so the pages in memory stay bounded. See
+ * pagedir.h.
+ */
+
+#define _POSIX_C_SOURCE 200809L // sysconf
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <dirent.h>
+#include <pthread.h>
+#include <unistd.h>
+#include "pagedir.h"
+#include "pageio.h"
+
+#define MAX_DOCID_DIGITS 9 // docIDs fit an int
+
+// A position of the ring: the page loaded for it, once it is
+typedef struct slot {
+    webpage_t *page;
+    bool ready;
+} slot_t;
+
+struct pagedir {
+    char *dirnm;
+    const int *ids;
+    int count;
+    slot_t *slots;
+    int window;           // number of slots
+    int next_claim;       // next position of the list a thread loads...
+    int next_deliver;     // ...and hands over
+    bool stopping;
+    pthread_mutex_t lock; // guards all of the above that changes
+    pthread_cond_t ready; // a slot was filled
+    pthread_cond_t space; // a slot was emptied, or the threads should stop
+    pthread_t *threads;
+    int num_threads;
+};
+
+// --- Static helper function prototypes ---
+static int docid_of(const char *name);
+static int compare_ids(const void *a, const void *b);
+static void *load_run(void *arg);
+
+int *pagedir_list(const char *dirnm, int *count) {
+    DIR *dir = opendir(dirnm);
+    if (dir == NULL) {
+        return NULL;
+    }
+    int cap = 256, n = 0;
+    int *ids = malloc(cap * sizeof(int));
+    struct dirent *entry;
+    while (ids != NULL && (entry = readdir(dir)) != NULL) {
+        int docID = docid_of(entry->d_name);
+        if (docID <= 0) {
+            continue;
+        }
+        if (n == cap) {
+            cap *= 2;
+            int *grown = realloc(ids, cap * sizeof(int));
+            if (grown == NULL) {
+                free(ids);
+                ids = NULL;
+                break;
+            }
+            ids = grown;
+        }
+        ids[n++] = docID;
+    }
+    closedir(dir);
+    if (ids != NULL) {
+        qsort(ids, n, sizeof(int), compare_ids);
+        *count = n;
+    }
+    return ids;
+}
+
+pagedir_t *pagedir_open(char *dirnm, const int *ids, int count, int num_threads) {
+    if (num_threads <= 0) {
+        num_threads = (int)sysconf(_SC_NPROCESSORS_ONLN);
+        num_threads = (num_threads > 0) ? num_threads : 1;
+    }
+    pagedir_t *pd = calloc(1, sizeof(pagedir_t));
+    if (pd == NULL) {
+        return NULL;
+    }
+    pd->dirnm = malloc(strlen(dirnm) + 1);
+    pd->window = num_threads * PAGEDIR_AHEAD;
+    pd->slots = calloc(pd->window, sizeof(slot_t));
+    pd->threads = malloc(num_threads * sizeof(pthread_t));
+    if (pd->dirnm == NULL || pd->slots == NULL || pd->threads == NULL) {
+        free(pd->dirnm);
+        free(pd->slots);
+        free(pd->threads);
+        free(pd);
+        return NULL;
+    }
+    strcpy(pd->dirnm, dirnm);
+    pd->ids = ids;
+    pd->count = count;
+    pthread_mutex_init(&pd->lock, NULL);
+    pthread_cond_init(&pd->ready, NULL);
+    pthread_cond_init(&pd->space, NULL);
+
+    // Fewer threads than asked for still load every page
+    while (pd->num_threads < num_threads
+           && pthread_create(&pd->threads[pd->num_threads], NULL, load_run, pd) == 0) {
+        pd->num_threads++;
+    }
+    if (pd->num_threads == 0) {
+        fprintf(stderr, "Error: pagedir_open failed to start a thread.\n");
+        pagedir_close(pd);
+        return NULL;
+    }
+    return pd;
+}
+
+bool pagedir_next(pagedir_t *pd, int *docID, webpage_t **page) {
+    pthread_mutex_lock(&pd->lock);
+    if (pd->next_deliver >= pd->count) {
+        pthread_mutex_unlock(&pd->lock);
+        return false;
+    }
+    slot_t *slot = &pd->slots[pd->next_deliver % pd->window];
+    while (!slot->ready) {
+        pthread_cond_wait(&pd->ready, &pd->lock);
+    }
+    *docID = pd->ids[pd->next_deliver];
+    *page = slot->page;
+    slot->page = NULL;
+    slot->ready = false;
+    pd->next_deliver++;
+    pthread_cond_broadcast(&pd->space);
+    pthread_mutex_unlock(&pd->lock);
+    return true;
+}
+
+void pagedir_close(pagedir_t *pd) {
+    pthread_mutex_lock(&pd->lock);
+    pd->stopping = true;
+    pthread_cond_broadcast(&pd->space);
+    pthread_mutex_unlock(&pd->lock);
+    for (int t = 0; t < pd->num_threads; t++) {
+        pthread_join(pd->threads[t], NULL);
+    }
+
+    for (int s = 0; s < pd->window; s++) {
+        webpage_delete(pd->slots[s].page);
+    }
+    pthread_mutex_destroy(&pd->lock);
+    pthread_cond_destroy(&pd->ready);
+    pthread_cond_destroy(&pd->space);
+    free(pd->dirnm);
+    free(pd->slots);
+    free(pd->threads);
+    free(pd);
+}
+
+
+// --- Helper Functions ---
+
+// The docID a directory entry's name stands for, or 0 if it is not a page
+static int docid_of(const char *name) {
+    if (name[0] < '1' || name[0] > '9') {
+        return 0;
+    }
+    int docID = 0;
+    for (int i = 0; name[i] != '\0'; i++) {
+        if (i == MAX_DOCID_DIGITS || name[i] < '0' || name[i] > '9') {
+            return 0;
+        }
+        docID = docID * 10 + (name[i] - '0');
+    }
+    return docID;
+}
+
+static int compare_ids(const void *a, const void *b) {
+    int x = *(const int *)a, y = *(const int *)b;
+    return (x > y) - (x < y);
+}
+
+// A loading thread: claims positions and loads their pages until none are left
+static void *load_run(void *arg) {
+    pagedir_t *pd = arg;
+    pthread_mutex_lock(&pd->lock);
+    while (true) {
+        while (!pd->stopping && pd->next_claim < pd->count && pd->next_claim - pd->next_deliver >= pd->window) {
+            pthread_cond_wait(&pd->space, &pd->lock);
+        }
+        if (pd->stopping || pd->next_claim >= pd->count) {
+            break;
+        }
+        int pos = pd->next_claim++;
+        pthread_mutex_unlock(&pd->lock);
+
+        webpage_t *page = pagemap(pd->ids[pos], pd->dirnm);
+
+        pthread_mutex_lock(&pd->lock);
+        pd->slots[pos % pd->window].page = page;
+        pd->slots[pos % pd->window].ready = true;
+        pthread_cond_broadcast(&pd->ready);
+    }
+    pthread_mutex_unlock(&pd->lock);
+    return NULL;
+}
@@ -0,0 +1,58 @@
+/*
+ * pagedir.h - header file for listing and loading a crawler directory's pages
+ *
+ * Author: Insecticide
+ * Date: 10-17-2026
+ *
+ * Description: A crawler directory's pages are the files named by their
+ * docIDs (decimal, without leading zeros). The docIDs need not run
+ * 1, 2, 3, ... without gaps: a recrawl deletes the files of pages that
+ * are gone. pagedir_list() reads the directory once, instead of probing
+ * docID after docID for a missing file.
+ *
+ * A loader then loads a list of pages on a few threads (with pagemap(),
+ * see pageio.h) a bounded number of pages ahead of its caller, and hands
+ * them over in list order, so that the caller's work on one page
+ * overlaps the reading of the next ones.
+ */
+
+#pragma once
+
+#include <stdbool.h>
+#include "webpage.h"
+
+#define PAGEDIR_AHEAD 8 // pages loaded ahead of the caller, per thread
+
+typedef struct pagedir pagedir_t;
+
+/*
+ * pagedir_list - Lists the docIDs of the page files in the directory
+ * dirnm, in ascending order.
+ * @count: set to the number of docIDs.
+ * Returns them in an array that is the caller's to free, or NULL if the
+ * directory cannot be read.
+ */
+int *pagedir_list(const char *dirnm, int *count);
+
+/*
+ * pagedir_open - Starts loading the pages ids[0..count) of the directory
+ * dirnm on num_threads threads (0 means one per processor). ids must
+ * stay valid until pagedir_close().
+ * Returns NULL on failure.
+ */
+pagedir_t *pagedir_open(char *dirnm, const int *ids, int count, int num_threads);
+
+/*
+ * pagedir_next - Waits for the next page of the list.
+ * @docID: set to its docID.
+ * @page: set to the page, which becomes the caller's, or to NULL if it
+ * could not be loaded (pagemap() says why).
+ * Returns false, setting neither, once every page has been handed over.
+ */
+bool pagedir_next(pagedir_t *pd, int *docID, webpage_t **page);
+
+/*
+ * pagedir_close - Stops the threads, deletes the pages loaded but not
+ * handed over, and frees pd.
+ */
+void pagedir_close(pagedir_t *pd);
@@ -3,13 +3,54 @@
  * Author: Insecticide
  * Date: 10-30-2025
  *
- * Description: Implements pagesave and pageload.
+ * Description: Implements pagesave, pagewrite and pageload.
  * pagesave saves an existing webpage to a file.
- * pageload creates a new page by loading a file.
+ * pageload creates a new page by loading a file; pagemap does so by
+ * mapping it, without copying the html where it can.
+ * Pages may be stored deflated; see pagewrite in pageio.h.
  */
 
+#define _POSIX_C_SOURCE 200809L // open, writev, pread, mmap, posix_madvise
+
+#include <errno.h>
+#include <fcntl.h>
+#include <ctype.h>
+#include <pthread.h>
+#include <sys/uio.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <zlib.h>
 #include "pageio.h"
 
+// The dictionary of the last directory a compressed page was loaded
+// from; pageload may run on several threads, so it is guarded by a lock,
+// held only to look the dictionary up and set it on a stream
+static struct {
+    pthread_mutex_t lock;
+    char dirnm[256];
+    pagedict_t *dict;
+} dict_cache = { PTHREAD_MUTEX_INITIALIZER, "", NULL };
+
+// A page file's header, as parsed where it lies by pagemap
+typedef struct page_header {
+    char url[1000];
+    int depth;
+    int html_len;
+    int zlen;     // length of the deflated html, or -1 if it is stored as is
+    size_t body;  // offset of the html
+} page_header_t;
+
+// --- Static helper function prototypes ---
+static char *deflate_html(const char *html, int html_len, const page_codec_t *codec, int *zlen);
+static int inflate_html(unsigned char *zbuf, int zlen, char *html, int html_len, char *dirnm);
+static webpage_t *map_page(int fd, size_t size, const char *filepath, char *dirnm);
+static webpage_t *read_page(int fd, size_t size, const char *filepath, char *dirnm);
+static webpage_t *new_page(const page_header_t *h, char *html, const char *error, const char *filepath);
+static size_t read_at(int fd, char *buf, size_t len, off_t offset);
+static const char *parse_header(const char *data, size_t size, page_header_t *h);
+static bool scan_int(const char *data, size_t size, size_t *pos, int *value);
+static void skip_space(const char *data, size_t size, size_t *pos);
+
 /*
  * pagesave -- save the page in filename id in directory dirnm
  *
@@ -25,20 +66,90 @@ int32_t pagesave(webpage_t *pagep, int id, char *dirnm) {
     char filepath[256];
     sprintf(filepath, "%s/%d", dirnm, id);
 
-    FILE *fp = fopen(filepath, "w");
-    if (fp == NULL) {
+    int fd = open(filepath, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) {
         perror("Error: pagesave failed to open file for writing");
         return 1; // Indicate failure
     }
 
-    // Write the page content in the required format
-    fprintf(fp, "%s\n", webpage_getURL(pagep));
-    fprintf(fp, "%d\n", webpage_getDepth(pagep));
-    fprintf(fp, "%d\n", webpage_getHTMLlen(pagep));
-    fprintf(fp, "%s", webpage_getHTML(pagep));
+    int32_t status = pagewrite(pagep, fd, NULL);
+    if (close(fd) != 0) {
+        status = 1;
+    }
+    return status;
+}
 
-    fclose(fp);
-    return 0; // Indicate success
+
+/*
+ * pagewrite -- write the page, in pagesave's format, to fd
+ *
+ * returns: 0 for success; nonzero otherwise
+ */
+int32_t pagewrite(webpage_t *pagep, int fd, const page_codec_t *codec) {
+    const char *url = webpage_getURL(pagep);
+    char *html = webpage_getHTML(pagep);
+    int html_len = html ? webpage_getHTMLlen(pagep) : 0;
+
+    // Deflate first, if asked to, since the header carries both lengths
+    char *zbuf = NULL;
+    int zlen = 0;
+    if (codec != NULL && codec->level != 0 && html_len > 0) {
+        zbuf = deflate_html(html, html_len, codec, &zlen);
+        if (zbuf == NULL) {
+            return 1;
+        }
+    }
+
+    // Format the three header lines
+    char lenline[32];
+    if (zbuf != NULL) {
+        snprintf(lenline, sizeof(lenline), "z%d %d", html_len, zlen);
+    } else {
+        snprintf(lenline, sizeof(lenline), "%d", html_len);
+    }
+    int header_len = snprintf(NULL, 0, "%s\n%d\n%s\n", url, webpage_getDepth(pagep), lenline);
+    char *header = malloc(header_len + 1);
+    if (header == NULL) {
+        fprintf(stderr, "Error: pagewrite failed to allocate memory for header.\n");
+        free(zbuf);
+        return 1;
+    }
+    snprintf(header, header_len + 1, "%s\n%d\n%s\n", url, webpage_getDepth(pagep), lenline);
+
+    // Header and html go out together; writev may stop short, so
+    // keep going from wherever it got to
+    struct iovec iov[2] = { { header, header_len }, { html, html_len } };
+    if (zbuf != NULL) {
+        iov[1].iov_base = zbuf;
+        iov[1].iov_len = zlen;
+    }
+    struct iovec *iovp = iov;
+    int iovcnt = 2;
+    int32_t status = 0;
+    while (iovcnt > 0) {
+        ssize_t n = writev(fd, iovp, iovcnt);
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            perror("Error: pagewrite failed to write page");
+            status = 1;
+            break;
+        }
+        while (iovcnt > 0 && (size_t)n >= iovp->iov_len) {
+            n -= iovp->iov_len;
+            iovp++;
+            iovcnt--;
+        }
+        if (iovcnt > 0) {
+            iovp->iov_base = (char *)iovp->iov_base + n;
+            iovp->iov_len -= n;
+        }
+    }
+
+    free(header);
+    free(zbuf);
+    return status;
 }
 
 
@@ -77,12 +188,19 @@ webpage_t *pageload(int id, char *dirnm) {
         return NULL;
     }
 
-    // Read HTML length
-    if (fscanf(fp, "%d\n", &html_len) != 1) {
+    // Read HTML length, and the compressed length if there is one;
+    // only the newline ends the line, since the html may start with spaces
+    int zlen = -1;
+    if (fscanf(fp, "z%d %d", &html_len, &zlen) != 2 && fscanf(fp, "%d", &html_len) != 1) {
         fprintf(stderr, "Error: pageload failed to read HTML length from %s.\n", filepath);
         fclose(fp);
         return NULL;
     }
+    if (getc(fp) != '\n' || html_len < 0) {
+        fprintf(stderr, "Error: pageload found a malformed length line in %s.\n", filepath);
+        fclose(fp);
+        return NULL;
+    }
 
     // Allocate memory for HTML (+1 for the null-terminator)
     char *html = malloc(html_len + 1);
@@ -93,7 +211,18 @@ webpage_t *pageload(int id, char *dirnm) {
     }
 
     // Read the rest of the file (the HTML)
-    if (fread(html, sizeof(char), html_len, fp) != html_len) {
+    if (zlen >= 0) {
+        unsigned char *zbuf = malloc(zlen > 0 ? zlen : 1);
+        int status = zbuf == NULL || fread(zbuf, 1, zlen, fp) != (size_t)zlen ||
+                     inflate_html(zbuf, zlen, html, html_len, dirnm) != 0;
+        free(zbuf);
+        if (status) {
+            fprintf(stderr, "Error: pageload failed to decompress HTML content from %s.\n", filepath);
+            free(html);
+            fclose(fp);
+            return NULL;
+        }
+    } else if (fread(html, sizeof(char), html_len, fp) != html_len) {
         fprintf(stderr, "Error: pageload failed to read HTML content from %s.\n", filepath);
         free(html);
         fclose(fp);
@@ -112,3 +241,299 @@ webpage_t *pageload(int id, char *dirnm) {
 
     return page;
 }
+
+/*
+ * pagemap -- maps files of PAGEIO_MAPMIN bytes or more; reads smaller
+ * ones, header first, with the html read straight into place. The
+ * header is parsed as pageload's fscanf calls parse it. See pageio.h.
+ */
+webpage_t *pagemap(int id, char *dirnm) {
+    char filepath[256];
+    sprintf(filepath, "%s/%d", dirnm, id);
+
+    int fd = open(filepath, O_RDONLY);
+    if (fd < 0) {
+        return NULL; // expected if the file doesn't exist, as for pageload
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size == 0) {
+        fprintf(stderr, "Error: pagemap failed to read URL from %s.\n", filepath);
+        close(fd);
+        return NULL;
+    }
+    webpage_t *page = (st.st_size >= PAGEIO_MAPMIN) ? map_page(fd, st.st_size, filepath, dirnm)
+                                                    : read_page(fd, st.st_size, filepath, dirnm);
+    close(fd);
+    return page;
+}
+
+
+// --- Helper Functions ---
+
+// Deflates html into a new buffer, setting *zlen; NULL on failure
+static char *deflate_html(const char *html, int html_len, const page_codec_t *codec, int *zlen) {
+    z_stream zs = { 0 };
+    if (deflateInit(&zs, codec->level) != Z_OK) {
+        fprintf(stderr, "Error: pagewrite failed to start compression.\n");
+        return NULL;
+    }
+    if (codec->dict != NULL &&
+        deflateSetDictionary(&zs, codec->dict->data, codec->dict->len) != Z_OK) {
+        fprintf(stderr, "Error: pagewrite failed to set the dictionary.\n");
+        deflateEnd(&zs);
+        return NULL;
+    }
+
+    uLong bound = deflateBound(&zs, html_len);
+    char *zbuf = malloc(bound);
+    if (zbuf == NULL) {
+        fprintf(stderr, "Error: pagewrite failed to allocate memory for compression.\n");
+        deflateEnd(&zs);
+        return NULL;
+    }
+    zs.next_in = (Bytef *)html;
+    zs.avail_in = html_len;
+    zs.next_out = (Bytef *)zbuf;
+    zs.avail_out = bound;
+    int status = deflate(&zs, Z_FINISH);
+    *zlen = zs.total_out;
+    deflateEnd(&zs);
+
+    if (status != Z_STREAM_END) {
+        fprintf(stderr, "Error: pagewrite failed to compress page.\n");
+        free(zbuf);
+        return NULL;
+    }
+    return zbuf;
+}
+
+// Inflates zbuf into exactly html_len bytes of html, fetching dirnm's
+// dictionary if the stream asks for one; returns non-zero on failure
+static int inflate_html(unsigned char *zbuf, int zlen, char *html, int html_len, char *dirnm) {
+    z_stream zs = { 0 };
+    if (inflateInit(&zs) != Z_OK) {
+        return 1;
+    }
+    zs.next_in = zbuf;
+    zs.avail_in = zlen;
+    zs.next_out = (Bytef *)html;
+    zs.avail_out = html_len + 1; // room to notice a longer stream
+
+    int status = inflate(&zs, Z_FINISH);
+    if (status == Z_NEED_DICT) {
+        pthread_mutex_lock(&dict_cache.lock);
+        if (dict_cache.dict == NULL || strcmp(dict_cache.dirnm, dirnm) != 0) {
+            char path[256];
+            snprintf(path, sizeof(path), "%s/%s", dirnm, PAGEDICT_FILE);
+            pagedict_delete(dict_cache.dict);
+            dict_cache.dict = pagedict_load(path);
+            snprintf(dict_cache.dirnm, sizeof(dict_cache.dirnm), "%s", dirnm);
+        }
+        // A different dictionary fails zlib's checksum here. zlib copies
+        // the dictionary into the stream's window, so the rest of the
+        // inflate does not need the cache, and loaders run side by side
+        bool have_dict = dict_cache.dict != NULL &&
+                         inflateSetDictionary(&zs, dict_cache.dict->data, dict_cache.dict->len) == Z_OK;
+        pthread_mutex_unlock(&dict_cache.lock);
+        if (have_dict) {
+            status = inflate(&zs, Z_FINISH);
+        }
+    }
+    int size = zs.total_out;
+    inflateEnd(&zs);
+    return status != Z_STREAM_END || size != html_len;
+}
+
+/*
+ * Parses the three header lines of a page file in data[0..size) into
+ * h, accepting what pageload's fscanf formats accept.
+ * Returns NULL, or the name of the part that could not be read.
+ */
+static const char *parse_header(const char *data, size_t size, page_header_t *h) {
+    size_t pos = 0;
+    skip_space(data, size, &pos);
+    size_t start = pos;
+    while (pos < size && !isspace((unsigned char)data[pos])) {
+        pos++;
+    }
+    if (pos == start || pos - start >= sizeof(h->url)) {
+        return "URL";
+    }
+    memcpy(h->url, data + start, pos - start);
+    h->url[pos - start] = '\0';
+    skip_space(data, size, &pos);
+
+    if (!scan_int(data, size, &pos, &h->depth)) {
+        return "depth";
+    }
+    skip_space(data, size, &pos);
+
+    // "z<html-length> <compressed-length>", or "<html-length>"
+    h->zlen = -1;
+    if (pos < size && data[pos] == 'z') {
+        pos++;
+        if (!scan_int(data, size, &pos, &h->html_len) || !scan_int(data, size, &pos, &h->zlen)) {
+            return "HTML length";
+        }
+    } else if (!scan_int(data, size, &pos, &h->html_len)) {
+        return "HTML length";
+    }
+    if (pos >= size || data[pos] != '\n' || h->html_len < 0) {
+        return "a well-formed length line";
+    }
+    h->body = pos + 1;
+    return NULL;
+}
+
+// Reads a decimal int at *pos, after any whitespace, as "%d" does
+static bool scan_int(const char *data, size_t size, size_t *pos, int *value) {
+    skip_space(data, size, pos);
+    size_t p = *pos;
+    bool negative = false;
+    if (p < size && (data[p] == '-' || data[p] == '+')) {
+        negative = (data[p++] == '-');
+    }
+    long n = 0;
+    size_t digits = p;
+    while (p < size && isdigit((unsigned char)data[p]) && n <= INT32_MAX) {
+        n = n * 10 + (data[p++] - '0');
+    }
+    if (p == digits || n > INT32_MAX) {
+        return false;
+    }
+    *value = negative ? -n : n;
+    *pos = p;
+    return true;
+}
+
+static void skip_space(const char *data, size_t size, size_t *pos) {
+    while (*pos < size && isspace((unsigned char)data[*pos])) {
+        (*pos)++;
+    }
+}
+
+/*
+ * Loads the page in the open file fd, of size bytes, by mapping it;
+ * the webpage keeps the mapping if its html can be used in place.
+ */
+static webpage_t *map_page(int fd, size_t size, const char *filepath, char *dirnm) {
+    char *map = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+    if (map == MAP_FAILED) {
+        perror("Error: pagemap failed to map file");
+        return NULL;
+    }
+    posix_madvise(map, size, POSIX_MADV_SEQUENTIAL);
+    posix_madvise(map, size, POSIX_MADV_WILLNEED);
+
+    page_header_t h;
+    const char *error = parse_header(map, size, &h);
+    if (error != NULL) {
+        fprintf(stderr, "Error: pagemap failed to read %s from %s.\n", error, filepath);
+        munmap(map, size);
+        return NULL;
+    }
+    char *body = map + h.body;
+    size_t avail = size - h.body;
+
+    // Past the end of the file, the rest of its last memory page reads
+    // as zeros: html running to the end is NUL-terminated where it lies
+    if (h.zlen < 0 && (size_t)h.html_len == avail && size % sysconf(_SC_PAGESIZE) != 0) {
+        webpage_t *page = webpage_newmapped(h.url, h.depth, body, map, size);
+        if (page == NULL) {
+            munmap(map, size);
+        }
+        return page;
+    }
+
+    char *html = malloc(h.html_len + 1);
+    if (html == NULL) {
+        error = "HTML content into memory";
+    } else if (h.zlen >= 0) {
+        if ((size_t)h.zlen > avail ||
+            inflate_html((unsigned char *)body, h.zlen, html, h.html_len, dirnm) != 0) {
+            error = "compressed HTML content";
+        }
+    } else if ((size_t)h.html_len > avail) {
+        error = "HTML content";
+    } else {
+        memcpy(html, body, h.html_len);
+    }
+    munmap(map, size);
+    return new_page(&h, html, error, filepath);
+}
+
+/*
+ * Loads the page in the open file fd, of size bytes, by reading its
+ * first PAGEIO_HEADMAX bytes for the header, then the rest of the html
+ * (or deflated html) straight into the buffer it stays in.
+ */
+static webpage_t *read_page(int fd, size_t size, const char *filepath, char *dirnm) {
+    char head[PAGEIO_HEADMAX];
+    size_t head_len = (size < sizeof(head)) ? size : sizeof(head);
+    page_header_t h;
+    const char *error = (read_at(fd, head, head_len, 0) != head_len) ? "URL" : parse_header(head, head_len, &h);
+    if (error != NULL) {
+        fprintf(stderr, "Error: pagemap failed to read %s from %s.\n", error, filepath);
+        return NULL;
+    }
+
+    size_t body_len = (h.zlen >= 0) ? (size_t)h.zlen : (size_t)h.html_len;
+    size_t have = head_len - h.body;
+    if (have > body_len) {
+        have = body_len;
+    }
+    char *body = malloc(body_len + 1);
+    if (body == NULL) {
+        return new_page(&h, NULL, "HTML content into memory", filepath);
+    }
+    memcpy(body, head + h.body, have);
+    if (read_at(fd, body + have, body_len - have, h.body + have) != body_len - have) {
+        error = (h.zlen >= 0) ? "compressed HTML content" : "HTML content";
+    }
+    if (h.zlen < 0 || error != NULL) {
+        return new_page(&h, body, error, filepath);
+    }
+
+    char *html = malloc(h.html_len + 1);
+    if (html == NULL) {
+        error = "HTML content into memory";
+    } else if (inflate_html((unsigned char *)body, h.zlen, html, h.html_len, dirnm) != 0) {
+        error = "compressed HTML content";
+    }
+    free(body);
+    return new_page(&h, html, error, filepath);
+}
+
+/*
+ * Makes the webpage of header h and html (h->html_len bytes, which it
+ * takes over), unless error says why the html could not be read.
+ */
+static webpage_t *new_page(const page_header_t *h, char *html, const char *error, const char *filepath) {
+    if (error != NULL) {
+        fprintf(stderr, "Error: pagemap failed to read %s from %s.\n", error, filepath);
+        free(html);
+        return NULL;
+    }
+    html[h->html_len] = '\0';
+    webpage_t *page = webpage_new((char *)h->url, h->depth, html);
+    if (page == NULL) {
+        free(html);
+    }
+    return page;
+}
+
+// Reads len bytes at offset of fd into buf; returns how many it could
+static size_t read_at(int fd, char *buf, size_t len, off_t offset) {
+    size_t done = 0;
+    while (done < len) {
+        ssize_t n = pread(fd, buf + done, len - done, offset + done);
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n <= 0) {
+            break;
+        }
+        done += n;
+    }
+    return done;
+}
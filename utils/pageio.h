@@ -17,6 +17,16 @@
 #include <inttypes.h>
 #include <unistd.h>
 #include "webpage.h"
+#include "pagedict.h"
+
+#define PAGEIO_MAPMIN (256 * 1024) // pagemap maps files this large; smaller ones cost less to read
+#define PAGEIO_HEADMAX 4096        // bytes pagemap reads first, for the header, from smaller files
+
+// How pagewrite stores the html
+typedef struct page_codec {
+    int level;        // zlib level (1-9 or -1 for zlib's default), or 0 to store the html as is
+    pagedict_t *dict; // preset dictionary (that of the page's directory), or NULL
+} page_codec_t;
 
 /*
  * pagesave -- save the page in filename id in directory dirnm
@@ -31,10 +41,46 @@
  */
 int32_t pagesave(webpage_t *pagep, int id, char *dirnm);
 
+/*
+ * pagewrite -- write the page, in pagesave's format, to the open
+ * file descriptor fd
+ *
+ * The html is written by its known length (so it is not scanned for
+ * a terminator), in one vectored write together with the header.
+ * If codec is non-NULL with a non-zero level, the html is deflated
+ * (with codec->dict as preset dictionary, if set) and the length line
+ * becomes "z<html-length> <compressed-length>".
+ *
+ * returns: 0 for success; nonzero otherwise
+ */
+int32_t pagewrite(webpage_t *pagep, int fd, const page_codec_t *codec);
+
 /* 
  * pageload -- loads the numbered filename <id> in direcory <dirnm>
  * into a new webpage
  *
+ * Compressed pages are inflated transparently, using dirnm's
+ * PAGEDICT_FILE if they were compressed with a dictionary.
+ *
  * returns: non-NULL for success; NULL otherwise
  */
 webpage_t *pageload(int id, char *dirnm);
+
+/*
+ * pagemap -- loads the numbered filename <id> in directory <dirnm>
+ * into a new webpage, as pageload does, but without stdio's buffer
+ * and parsing: a file of PAGEIO_MAPMIN bytes or more is mapped into
+ * memory (with hints that it is about to be read, front to back) and
+ * its header parsed where it lies; a smaller one, for which mapping
+ * costs more than it saves, has its header read and parsed first and
+ * its html read straight into the buffer the webpage keeps.
+ *
+ * If a mapped page's html is stored as is and runs to the end of the
+ * file, the webpage's html points into the mapping: it is neither
+ * allocated nor copied, and webpage_delete() unmaps it. (The mapping
+ * is private, so writing to the html does not change the file.)
+ * Otherwise the html is copied, or inflated, out of the mapping.
+ *
+ * returns: non-NULL for success; NULL otherwise
+ */
+webpage_t *pagemap(int id, char *dirnm);
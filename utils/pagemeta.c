@@ -0,0 +1,262 @@
+/*
+ * pagemeta.c - implementation of the per-URL crawl metadata module
+ *
+ * Author: Insecticide
+ * Date: 10-17-2026
+ *
+ * Description: Keeps page_meta_t records in a hash table keyed by URL,
+ * backed by an append-only text file. See pagemeta.h.
+ */
+
+#define _POSIX_C_SOURCE 200809L // getline
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <inttypes.h>
+#include <sys/stat.h>
+#include "pagemeta.h"
+#include "hash.h"
+
+#define PAGEMETA_FILE ".crawler.meta"
+#define BYTES_PER_SLOT 256 // of the file loaded, for each slot of the table
+
+struct pagemeta {
+    hashtable_t *table;     // page_meta_t records, keyed by url
+    FILE *fp;               // file, opened for appending
+    char path[256];         // path of the file
+};
+
+// --- Static helper function prototypes ---
+static page_meta_t *new_record(const char *url);
+static void load_records(pagemeta_t *pm);
+static int32_t write_record(FILE *fp, const page_meta_t *m);
+static bool search_url(void *elementp, const void *keyp);
+static void free_record(void *data);
+static void apply_helper(void *data);
+static void maxid_helper(page_meta_t *m, void *arg);
+static void compact_helper(page_meta_t *m, void *arg);
+
+// --- Static state for apply helpers ---
+static void (*apply_fn)(page_meta_t *m, void *arg);
+static void *apply_arg;
+
+pagemeta_t *pagemeta_open(char *dirnm, bool load) {
+    pagemeta_t *pm = malloc(sizeof(pagemeta_t));
+    if (pm == NULL) {
+        return NULL;
+    }
+    snprintf(pm->path, sizeof(pm->path), "%s/%s", dirnm, PAGEMETA_FILE);
+
+    // The table does not grow, so it is sized for the records to load
+    struct stat st;
+    long size = (load && stat(pm->path, &st) == 0) ? st.st_size : 0;
+    pm->table = hopen(500 + size / BYTES_PER_SLOT);
+    if (load) {
+        load_records(pm);
+    }
+
+    pm->fp = fopen(pm->path, load ? "a" : "w");
+    if (pm->fp == NULL) {
+        perror("Error: pagemeta_open failed to open file");
+        pagemeta_close(pm);
+        return NULL;
+    }
+    return pm;
+}
+
+page_meta_t *pagemeta_get(pagemeta_t *pm, const char *url) {
+    if (pm == NULL || url == NULL) {
+        return NULL;
+    }
+    return hsearch(pm->table, search_url, url, strlen(url));
+}
+
+int32_t pagemeta_put(pagemeta_t *pm, const char *url, int docID, uint64_t hash,
+                     const webpage_validators_t *val) {
+    if (pm == NULL || url == NULL) {
+        return 1;
+    }
+    page_meta_t *m = pagemeta_get(pm, url);
+    if (m == NULL) {
+        m = new_record(url);
+        hput(pm->table, m, m->url, strlen(m->url));
+    }
+    m->docID = docID;
+    m->hash = hash;
+    if (val != NULL) {
+        m->val = *val;
+    }
+
+    // One small write per page, so a crash loses at most the last record
+    if (write_record(pm->fp, m) != 0 || fflush(pm->fp) != 0) {
+        return 1;
+    }
+    return 0;
+}
+
+void pagemeta_remove(pagemeta_t *pm, const char *url) {
+    if (pm == NULL || url == NULL) {
+        return;
+    }
+    free_record(hremove(pm->table, search_url, url, strlen(url)));
+}
+
+void pagemeta_apply(pagemeta_t *pm, void (*fn)(page_meta_t *m, void *arg), void *arg) {
+    if (pm == NULL || fn == NULL) {
+        return;
+    }
+    apply_fn = fn;
+    apply_arg = arg;
+    happly(pm->table, apply_helper);
+}
+
+int pagemeta_maxid(pagemeta_t *pm) {
+    int maxid = 0;
+    pagemeta_apply(pm, maxid_helper, &maxid);
+    return maxid;
+}
+
+int32_t pagemeta_compact(pagemeta_t *pm) {
+    if (pm == NULL) {
+        return 1;
+    }
+    char tmppath[sizeof(pm->path) + 4];
+    snprintf(tmppath, sizeof(tmppath), "%s.tmp", pm->path);
+
+    FILE *tmp = fopen(tmppath, "w");
+    if (tmp == NULL) {
+        perror("Error: pagemeta_compact failed to open file");
+        return 1;
+    }
+    pagemeta_apply(pm, compact_helper, tmp);
+    if (fclose(tmp) != 0 || rename(tmppath, pm->path) != 0) {
+        perror("Error: pagemeta_compact failed to replace file");
+        return 1;
+    }
+
+    // Keep appending to the new file
+    fclose(pm->fp);
+    pm->fp = fopen(pm->path, "a");
+    return pm->fp == NULL;
+}
+
+void pagemeta_close(pagemeta_t *pm) {
+    if (pm != NULL) {
+        if (pm->fp != NULL) {
+            fclose(pm->fp);
+        }
+        happly(pm->table, free_record);
+        hclose(pm->table);
+        free(pm);
+    }
+}
+
+uint64_t pagemeta_hash(const char *html, size_t len) {
+    uint64_t h = 14695981039346656037ULL;
+    for (size_t i = 0; i < len; i++) {
+        h = (h ^ (unsigned char)html[i]) * 1099511628211ULL;
+    }
+    return h;
+}
+
+
+// --- Helper Functions ---
+
+// Allocates an empty record for url
+static page_meta_t *new_record(const char *url) {
+    page_meta_t *m = calloc(1, sizeof(page_meta_t));
+    m->url = malloc(strlen(url) + 1);
+    strcpy(m->url, url);
+    return m;
+}
+
+// Reads every line of the file into the table; later lines win
+static void load_records(pagemeta_t *pm) {
+    FILE *fp = fopen(pm->path, "r");
+    if (fp == NULL) {
+        return; // nothing crawled yet
+    }
+
+    char *line = NULL;
+    size_t linecap = 0;
+    ssize_t len;
+    while ((len = getline(&line, &linecap, fp)) > 0) {
+        if (line[len - 1] == '\n') {
+            line[--len] = '\0';
+        }
+        // split the five tab-separated fields
+        char *field[5];
+        field[0] = line;
+        int n = 1;
+        for (char *p = line; *p != '\0' && n < 5; p++) {
+            if (*p == '\t') {
+                *p = '\0';
+                field[n++] = p + 1;
+            }
+        }
+        int docID;
+        uint64_t hash;
+        if (n != 5 || sscanf(field[0], "%d", &docID) != 1
+            || sscanf(field[1], "%" SCNx64, &hash) != 1 || field[4][0] == '\0') {
+            continue; // skip malformed lines
+        }
+
+        page_meta_t *m = pagemeta_get(pm, field[4]);
+        if (m == NULL) {
+            m = new_record(field[4]);
+            hput(pm->table, m, m->url, strlen(m->url));
+        }
+        m->docID = docID;
+        m->hash = hash;
+        m->val.etag[0] = m->val.lastmod[0] = '\0';
+        if (strcmp(field[2], "-") != 0 && strlen(field[2]) < sizeof(m->val.etag)) {
+            strcpy(m->val.etag, field[2]);
+        }
+        if (strcmp(field[3], "-") != 0 && strlen(field[3]) < sizeof(m->val.lastmod)) {
+            strcpy(m->val.lastmod, field[3]);
+        }
+    }
+    free(line);
+    fclose(fp);
+}
+
+// Writes one record as a line
+static int32_t write_record(FILE *fp, const page_meta_t *m) {
+    int n = fprintf(fp, "%d\t%016" PRIx64 "\t%s\t%s\t%s\n", m->docID, m->hash,
+                    m->val.etag[0] ? m->val.etag : "-",
+                    m->val.lastmod[0] ? m->val.lastmod : "-",
+                    m->url);
+    return n < 0;
+}
+
+// Search function for the hash table (compares url)
+static bool search_url(void *elementp, const void *keyp) {
+    page_meta_t *m = (page_meta_t *)elementp;
+    return strcmp(m->url, (const char *)keyp) == 0;
+}
+
+// Frees a record (for happly)
+static void free_record(void *data) {
+    page_meta_t *m = (page_meta_t *)data;
+    if (m) {
+        free(m->url);
+        free(m);
+    }
+}
+
+// Adapts happly's one-argument callback to pagemeta_apply's
+static void apply_helper(void *data) {
+    apply_fn((page_meta_t *)data, apply_arg);
+}
+
+static void maxid_helper(page_meta_t *m, void *arg) {
+    int *maxid = (int *)arg;
+    if (m->docID > *maxid) {
+        *maxid = m->docID;
+    }
+}
+
+static void compact_helper(page_meta_t *m, void *arg) {
+    write_record((FILE *)arg, m);
+}
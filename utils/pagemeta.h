@@ -0,0 +1,86 @@
+/*
+ * pagemeta.h - header file for the per-URL crawl metadata module
+ *
+ * Author: Insecticide
+ * Date: 10-17-2026
+ *
+ * Description: Remembers, for every page saved in a crawler directory,
+ * its docID, a hash of its html and the HTTP validators (ETag and
+ * Last-Modified) it was served with, so a later recrawl can send
+ * conditional requests and rewrite only pages that changed.
+ *
+ * The records live in <pageDirectory>/.crawler.meta, one per line:
+ *   <docID>\t<hash>\t<etag>\t<last-modified>\t<url>
+ * with "-" for a missing validator. The file is appended to as pages
+ * are saved; when a URL appears more than once, the last line wins.
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "webpage.h"
+
+typedef struct page_meta {
+    char *url;
+    int docID;
+    uint64_t hash;              // pagemeta_hash() of the saved html
+    webpage_validators_t val;
+    bool visited;               // free for the caller's use; false on load
+} page_meta_t;
+
+typedef struct pagemeta pagemeta_t;
+
+/*
+ * pagemeta_open - Opens the metadata of the crawler directory dirnm.
+ * If load is true, existing records are read back; otherwise the
+ * file is started afresh.
+ * Returns NULL on failure.
+ */
+pagemeta_t *pagemeta_open(char *dirnm, bool load);
+
+/*
+ * pagemeta_get - Returns the record for url, or NULL if there is none.
+ */
+page_meta_t *pagemeta_get(pagemeta_t *pm, const char *url);
+
+/*
+ * pagemeta_put - Adds or replaces the record for url and appends it
+ * to the file.
+ * Returns 0 on success, non-zero on failure.
+ */
+int32_t pagemeta_put(pagemeta_t *pm, const char *url, int docID, uint64_t hash,
+                     const webpage_validators_t *val);
+
+/*
+ * pagemeta_remove - Forgets the record for url. The change reaches the
+ * file at the next pagemeta_compact().
+ */
+void pagemeta_remove(pagemeta_t *pm, const char *url);
+
+/*
+ * pagemeta_apply - Calls fn(record, arg) for every record.
+ * fn must not add or remove records.
+ */
+void pagemeta_apply(pagemeta_t *pm, void (*fn)(page_meta_t *m, void *arg), void *arg);
+
+/*
+ * pagemeta_maxid - Returns the largest docID of any record (0 if none).
+ */
+int pagemeta_maxid(pagemeta_t *pm);
+
+/*
+ * pagemeta_compact - Rewrites the file with exactly one line per record.
+ * Returns 0 on success, non-zero on failure.
+ */
+int32_t pagemeta_compact(pagemeta_t *pm);
+
+/*
+ * pagemeta_close - Closes the file and frees pm and all its records.
+ */
+void pagemeta_close(pagemeta_t *pm);
+
+/*
+ * pagemeta_hash - 64-bit FNV-1a hash of len bytes of html.
+ */
+uint64_t pagemeta_hash(const char *html, size_t len);
@@ -0,0 +1,229 @@
+/*
+ * pagewriter.c - implementation of the asynchronous page writer module
+ *
+ * Author: Insecticide
+ * Date: 10-17-2026
+ *
+ * Description: One thread drains a bqueue of pages in batches and
+ * writes them with pagewrite(), each to a temporary file renamed over
+ * the page's once written. See pagewriter.h.
+ */
+
+#define _POSIX_C_SOURCE 200809L // open, fdatasync, fsync
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <pthread.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include "pagewriter.h"
+#include "pageio.h"
+#include "bqueue.h"
+
+// A page waiting to be written
+typedef struct write_job {
+    webpage_t *page;
+    int id;
+} write_job_t;
+
+struct pagewriter {
+    char *dirnm;
+    int dirfd;                // dirnm, synced after every batch (-1 if not synced)
+    pagewriter_fsync_t policy;
+    page_codec_t codec;
+    bqueue_t *queue;          // write_job_t's from the producer
+    pthread_t thread;
+    pthread_mutex_t lock;     // guards written and failed
+    pthread_cond_t progress;  // signalled after every batch
+    int written;              // pages finished so far
+    int failed;               // pages that could not be written
+};
+
+// --- Static helper function prototypes ---
+static void *writer_run(void *arg);
+static void page_paths(pagewriter_t *pw, int id, char *tmppath, char *filepath);
+static int open_page(pagewriter_t *pw, int id);
+static int finish_page(pagewriter_t *pw, int fd, int id, bool ok, bool sync);
+
+pagewriter_t *pagewriter_start(char *dirnm, int capacity, pagewriter_fsync_t policy,
+                               const page_codec_t *codec) {
+    pagewriter_t *pw = malloc(sizeof(pagewriter_t));
+    if (pw == NULL) {
+        return NULL;
+    }
+    pw->dirnm = dirnm;
+    pw->dirfd = -1;
+    if (policy != PW_FSYNC_NONE) {
+        // A missing directory fails every page anyway
+        pw->dirfd = open(dirnm, O_RDONLY | O_DIRECTORY);
+    }
+    pw->policy = policy;
+    pw->codec.level = codec ? codec->level : 0;
+    pw->codec.dict = codec ? codec->dict : NULL;
+    pw->queue = bqopen(capacity);
+    pw->written = 0;
+    pw->failed = 0;
+    pthread_mutex_init(&pw->lock, NULL);
+    pthread_cond_init(&pw->progress, NULL);
+
+    if (pw->queue == NULL || pthread_create(&pw->thread, NULL, writer_run, pw) != 0) {
+        if (pw->dirfd >= 0) {
+            close(pw->dirfd);
+        }
+        bqclose(pw->queue);
+        pthread_mutex_destroy(&pw->lock);
+        pthread_cond_destroy(&pw->progress);
+        free(pw);
+        return NULL;
+    }
+    return pw;
+}
+
+int32_t pagewriter_put(pagewriter_t *pw, webpage_t *page, int id) {
+    if (pw == NULL || page == NULL) {
+        webpage_delete(page);
+        return 1;
+    }
+    write_job_t *job = malloc(sizeof(write_job_t));
+    job->page = page;
+    job->id = id;
+    if (bqput(pw->queue, job) != 0) {
+        webpage_delete(page);
+        free(job);
+        return 1;
+    }
+    return 0;
+}
+
+void pagewriter_wait(pagewriter_t *pw, int count) {
+    if (pw == NULL) {
+        return;
+    }
+    pthread_mutex_lock(&pw->lock);
+    while (pw->written < count) {
+        pthread_cond_wait(&pw->progress, &pw->lock);
+    }
+    pthread_mutex_unlock(&pw->lock);
+}
+
+int pagewriter_finish(pagewriter_t *pw) {
+    if (pw == NULL) {
+        return 0;
+    }
+    bqdone(pw->queue);
+    pthread_join(pw->thread, NULL);
+
+    int failed = pw->failed;
+    if (pw->dirfd >= 0) {
+        close(pw->dirfd);
+    }
+    bqclose(pw->queue);
+    pthread_mutex_destroy(&pw->lock);
+    pthread_cond_destroy(&pw->progress);
+    free(pw);
+    return failed;
+}
+
+
+// --- Helper Functions ---
+
+/*
+ * Body of the writer thread. Each batch is the first job plus whatever
+ * else is already queued; with PW_FSYNC_BATCH the batch's files stay
+ * open until they are all written, then are synced and renamed into
+ * place together. Unless the policy is PW_FSYNC_NONE, the directory is
+ * synced before the batch counts as written, so that the renames last.
+ */
+static void *writer_run(void *arg) {
+    pagewriter_t *pw = (pagewriter_t *)arg;
+    int fds[PAGEWRITER_BATCH];
+    int ids[PAGEWRITER_BATCH];
+    write_job_t *job;
+
+    while ((job = bqget(pw->queue)) != NULL) {
+        int num_fds = 0;
+        int num_jobs = 0;
+        int num_failed = 0;
+
+        do {
+            int fd = open_page(pw, job->id);
+            if (fd < 0) {
+                num_failed++;
+            } else if (pagewrite(job->page, fd, &pw->codec) != 0) {
+                finish_page(pw, fd, job->id, false, false);
+                num_failed++;
+            } else if (pw->policy == PW_FSYNC_BATCH) {
+                fds[num_fds] = fd;
+                ids[num_fds++] = job->id;
+            } else if (finish_page(pw, fd, job->id, true, pw->policy == PW_FSYNC_EACH) != 0) {
+                num_failed++;
+            }
+            webpage_delete(job->page);
+            free(job);
+            num_jobs++;
+        } while (num_jobs < PAGEWRITER_BATCH && (job = bqtryget(pw->queue)) != NULL);
+
+        for (int i = 0; i < num_fds; i++) {
+            if (finish_page(pw, fds[i], ids[i], true, true) != 0) {
+                num_failed++;
+            }
+        }
+        if (pw->dirfd >= 0 && fsync(pw->dirfd) != 0) {
+            perror("Error: pagewriter failed to sync directory");
+            num_failed += num_jobs - num_failed;
+        }
+
+        pthread_mutex_lock(&pw->lock);
+        pw->written += num_jobs;
+        pw->failed += num_failed;
+        pthread_cond_broadcast(&pw->progress);
+        pthread_mutex_unlock(&pw->lock);
+    }
+    return NULL;
+}
+
+// The temporary file page id is written to ('.' keeps it out of
+// pagedir_list()), and the page's own file
+static void page_paths(pagewriter_t *pw, int id, char *tmppath, char *filepath) {
+    snprintf(tmppath, 256, "%s/.%d.tmp", pw->dirnm, id);
+    snprintf(filepath, 256, "%s/%d", pw->dirnm, id);
+}
+
+// Opens (creating or truncating) the temporary file for page id
+static int open_page(pagewriter_t *pw, int id) {
+    char tmppath[256], filepath[256];
+    page_paths(pw, id, tmppath, filepath);
+    int fd = open(tmppath, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) {
+        perror("Error: pagewriter failed to open file for writing");
+    }
+    return fd;
+}
+
+/*
+ * Optionally syncs, then closes fd, the temporary file of page id; if
+ * ok, renames it over the page's file, so that a page being rewritten
+ * is never left half written, else removes it.
+ * Returns non-zero on failure (a page not ok is a failure already).
+ */
+static int finish_page(pagewriter_t *pw, int fd, int id, bool ok, bool sync) {
+    char tmppath[256], filepath[256];
+    page_paths(pw, id, tmppath, filepath);
+    int status = 0;
+    if (ok && sync && fdatasync(fd) != 0) {
+        perror("Error: pagewriter failed to sync file");
+        status = 1;
+    }
+    if (close(fd) != 0) {
+        status = 1;
+    }
+    if (ok && status == 0 && rename(tmppath, filepath) != 0) {
+        perror("Error: pagewriter failed to rename file into place");
+        status = 1;
+    }
+    if (!ok || status != 0) {
+        unlink(tmppath);
+    }
+    return status;
+}
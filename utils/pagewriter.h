@@ -0,0 +1,63 @@
+/*
+ * pagewriter.h - header file for the asynchronous page writer module
+ *
+ * Author: Insecticide
+ * Date: 10-17-2026
+ *
+ * Description: Saves pages to a crawler directory from a dedicated
+ * thread, so that disk latency stays out of the crawler's fetch loop.
+ * Pages are handed over through a bounded queue; the writer takes
+ * whatever has piled up (up to PAGEWRITER_BATCH pages) as one batch,
+ * writes each page with pagewrite() and syncs them per the policy. A
+ * page is written to a temporary file renamed over its own, so that a
+ * page rewritten by a recrawl is either the old one or the new one.
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include "webpage.h"
+#include "pageio.h"
+
+#define PAGEWRITER_BATCH 32 // Max pages written between two syncs
+
+// When written pages are forced to disk
+typedef enum pagewriter_fsync {
+    PW_FSYNC_NONE,  // never; leave it to the kernel (like pagesave)
+    PW_FSYNC_BATCH, // once per batch, before the files are closed
+    PW_FSYNC_EACH   // after every page
+    // (under both, the directory is synced after every batch)
+} pagewriter_fsync_t;
+
+typedef struct pagewriter pagewriter_t;
+
+/*
+ * pagewriter_start - Starts a writer thread saving into dirnm, with
+ * room for capacity pages waiting in its queue. Pages are stored as
+ * codec says (NULL for plain html); the codec is copied, but its
+ * dictionary must outlive the writer.
+ * Returns NULL on failure.
+ */
+pagewriter_t *pagewriter_start(char *dirnm, int capacity, pagewriter_fsync_t policy,
+                               const page_codec_t *codec);
+
+/*
+ * pagewriter_put - Queues page to be saved as file id, blocking while
+ * the queue is full. The writer takes ownership of page and deletes it
+ * once written; the page's html must no longer change.
+ * Returns 0 on success, non-zero on failure (page is deleted anyway).
+ */
+int32_t pagewriter_put(pagewriter_t *pw, webpage_t *page, int id);
+
+/*
+ * pagewriter_wait - Blocks until at least count pages, counting from
+ * the start, have been written (and synced, per the policy).
+ */
+void pagewriter_wait(pagewriter_t *pw, int count);
+
+/*
+ * pagewriter_finish - Writes every queued page, stops the thread and
+ * frees pw.
+ * Returns the number of pages that could not be written.
+ */
+int pagewriter_finish(pagewriter_t *pw);
@@ -0,0 +1,647 @@
+/*
+ * querytree.c - implementation of the boolean query language
+ *
+ * Author: Insecticide
+ * Date: 10-17-2026
+ *
+ * Description: A recursive descent parser builds the tree directly out
+ * of iterator nodes. Every node is positioned on a page (its doc) and
+ * moves forward only, through skip_to(target), which lands it on its
+ * first page >= target:
+ *   term    - a binary search (galloping from where it is) in the
+ *             word's postings, copied into an array
+ *   stop    - the next set bit of a stopword's bitmap
+ *   and     - leapfrogs its positive children until they agree, then
+ *             skips the page if a negated child is on it too
+ *   phrase  - an "and" of its indexed words whose pages must also have
+ *             the words in sequence
+ *   or      - the least page any child is on (a fuzzy word is an "or"
+ *             of the terms close to it)
+ * See querytree.h.
+ */
+
+#define _POSIX_C_SOURCE 200809L // strdup, strcasecmp
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <limits.h>
+#include "querytree.h"
+#include "index.h"
+#include "pageio.h"
+#include "webpage.h"
+#include "tokenize.h"
+
+#define DOC_END INT_MAX // doc of a node that has no more pages
+#define NEUTRAL (-1)    // score of a node that only filters (stopwords); 0 is a real score
+#define FUZZY_MAX_TERMS 16 // terms a fuzzy word matches at most
+
+typedef enum node_type {
+    NODE_NONE,   // matches nothing, and is left out of "and" and "or"
+    NODE_TERM,
+    NODE_STOP,
+    NODE_AND,
+    NODE_OR,
+    NODE_NOT,    // only ever a child of an "and"
+    NODE_PHRASE
+} node_type_t;
+
+typedef struct node {
+    node_type_t type;
+    int doc;                  // page it is on: -1 before the first, DOC_END after the last
+    int score;                // its rank on that page, or NEUTRAL
+    doc_entry_t** postings;   // term: the word's postings, by docID
+    int num_postings;
+    int at;                   // ...and the one it is on
+    const word_entry_t* stop; // stop: the stopword
+    struct node** kids;       // and, or, not, phrase
+    int num_kids;
+    char** words;             // phrase: all of its words, indexed or not
+    int num_words;
+} node_t;
+
+struct querytree {
+    node_t* root;
+    char* pageDirectory;
+    analyzer_t analyzer;
+    field_boosts_t boosts;
+};
+
+// Parser state for one query
+typedef struct parser {
+    hashtable_t* index;
+    spell_t* spell;        // for fuzzy words; may be NULL
+    char** tokens;
+    int num_tokens;
+    int pos;               // next token
+    const char* error;     // set on the first error
+} parser_t;
+
+// --- Static state for apply helpers ---
+static doc_entry_t** g_postings; // postings being copied
+static int g_count;              // postings counted or copied so far
+
+// --- Static helper function prototypes ---
+static node_t* parse_or(parser_t* p);
+static node_t* parse_and(parser_t* p);
+static node_t* parse_unary(parser_t* p);
+static node_t* parse_primary(parser_t* p);
+static node_t* parse_phrase(parser_t* p);
+static node_t* parse_fuzzy(parser_t* p, const char* word);
+static const char* operand_error(const parser_t* p);
+static bool is_token(const parser_t* p, int pos, const char* token);
+static bool is_operator(const parser_t* p, int pos);
+static node_t* new_node(node_type_t type);
+static node_t* new_leaf(hashtable_t* index, const char* word);
+static node_t* new_group(node_type_t type, node_t** kids, int num_kids);
+static void add_kid(node_t* node, node_t* kid);
+static void free_node(node_t* node);
+static void skip_to(querytree_t* query, node_t* node, int target);
+static void term_skip_to(querytree_t* query, node_t* node, int target);
+static void stop_skip_to(node_t* node, int target);
+static void and_skip_to(querytree_t* query, node_t* node, int target);
+static void or_skip_to(querytree_t* query, node_t* node, int target);
+static int phrase_count(querytree_t* query, const node_t* phrase, int docID);
+static bool search_word(void* elementp, const void* keyp);
+static void count_helper(void* data);
+static void copy_helper(void* data);
+static int compare_docs(const void* a, const void* b);
+
+/*
+ * querytree_compile - Parses the tokens; a NONE root is kept, and
+ * simply matches nothing.
+ */
+querytree_t* querytree_compile(hashtable_t* index, spell_t* spell, char* tokens[], int num_tokens,
+                               const char* pageDirectory, analyzer_t analyzer, const field_boosts_t* boosts,
+                               const char** error) {
+    parser_t p = { index, spell, tokens, num_tokens, 0, NULL };
+    node_t* root = parse_or(&p);
+    if (root != NULL && p.pos < num_tokens) {
+        p.error = "Unbalanced parentheses.";
+    }
+    if (p.error != NULL) {
+        free_node(root);
+        *error = p.error;
+        return NULL;
+    }
+
+    querytree_t* query = malloc(sizeof(querytree_t));
+    query->root = root;
+    query->pageDirectory = strdup(pageDirectory);
+    query->analyzer = analyzer;
+    query->boosts = (boosts != NULL) ? *boosts : (field_boosts_t){ 0, 0, 0 };
+    return query;
+}
+
+/*
+ * querytree_next - Moves the root past its page.
+ */
+int querytree_next(querytree_t* query, int* rank) {
+    node_t* root = query->root;
+    if (root->doc == DOC_END) {
+        return -1;
+    }
+    skip_to(query, root, root->doc + 1);
+    if (root->doc == DOC_END) {
+        return -1;
+    }
+    *rank = (root->score == NEUTRAL) ? 1 : root->score;
+    return root->doc;
+}
+
+/*
+ * querytree_delete - Frees every node.
+ */
+void querytree_delete(querytree_t* query) {
+    if (query != NULL) {
+        free_node(query->root);
+        free(query->pageDirectory);
+        free(query);
+    }
+}
+
+
+// --- Helper Functions ---
+
+// orexpr := andexpr { "or" andexpr }
+static node_t* parse_or(parser_t* p) {
+    node_t* kids[p->num_tokens + 1];
+    int num_kids = 0;
+    while (true) {
+        node_t* kid = parse_and(p);
+        if (kid == NULL) {
+            while (num_kids > 0) free_node(kids[--num_kids]);
+            return NULL;
+        }
+        kids[num_kids++] = kid;
+        if (!is_token(p, p->pos, "or")) {
+            break;
+        }
+        p->pos++;
+    }
+    return new_group(NODE_OR, kids, num_kids);
+}
+
+// andexpr := unary { ["and"] unary }, with at least one not negated
+static node_t* parse_and(parser_t* p) {
+    node_t* kids[p->num_tokens + 1];
+    int num_kids = 0;
+    int positive = 0;
+    while (true) {
+        bool negated = is_token(p, p->pos, "not");
+        node_t* kid = parse_unary(p);
+        if (kid == NULL) {
+            while (num_kids > 0) free_node(kids[--num_kids]);
+            return NULL;
+        }
+        kids[num_kids++] = kid;
+        positive += !negated;
+
+        if (is_token(p, p->pos, "and")) {
+            p->pos++;
+        } else if (p->pos == p->num_tokens || is_token(p, p->pos, "or") || is_token(p, p->pos, ")")) {
+            break;
+        }
+    }
+    if (positive == 0) {
+        while (num_kids > 0) free_node(kids[--num_kids]);
+        p->error = "'not' needs a word to exclude pages from.";
+        return NULL;
+    }
+    return new_group(NODE_AND, kids, num_kids);
+}
+
+// unary := ["not"] primary
+static node_t* parse_unary(parser_t* p) {
+    if (!is_token(p, p->pos, "not")) {
+        return parse_primary(p);
+    }
+    p->pos++;
+    node_t* kid = parse_primary(p);
+    if (kid == NULL) {
+        return NULL;
+    }
+    if (kid->type == NODE_NONE) {
+        return kid;
+    }
+    node_t* node = new_node(NODE_NOT);
+    add_kid(node, kid);
+    return node;
+}
+
+// primary := word | word '~' | phrase | '(' orexpr ')'
+static node_t* parse_primary(parser_t* p) {
+    if (p->pos == p->num_tokens || is_operator(p, p->pos) || is_token(p, p->pos, ")")) {
+        p->error = operand_error(p);
+        return NULL;
+    }
+    if (p->tokens[p->pos][0] == '~') {
+        p->error = "'~' must follow a word.";
+        return NULL;
+    }
+    if (is_token(p, p->pos, "\"")) {
+        return parse_phrase(p);
+    }
+    if (is_token(p, p->pos, "(")) {
+        p->pos++;
+        node_t* node = parse_or(p);
+        if (node != NULL && !is_token(p, p->pos, ")")) {
+            free_node(node);
+            p->error = "Unbalanced parentheses.";
+            return NULL;
+        }
+        p->pos++;
+        return node;
+    }
+    const char* word = p->tokens[p->pos++];
+    if (p->pos < p->num_tokens && p->tokens[p->pos][0] == '~') {
+        return parse_fuzzy(p, word);
+    }
+    return new_leaf(p->index, word);
+}
+
+// '"' word { word } '"'; operators inside are words
+static node_t* parse_phrase(parser_t* p) {
+    int start = ++p->pos;
+    while (p->pos < p->num_tokens && !is_token(p, p->pos, "\"")) {
+        if (is_token(p, p->pos, "(") || is_token(p, p->pos, ")")) {
+            p->error = "A phrase cannot hold parentheses.";
+            return NULL;
+        }
+        if (p->tokens[p->pos][0] == '~') {
+            p->error = "A phrase cannot hold fuzzy words.";
+            return NULL;
+        }
+        p->pos++;
+    }
+    if (p->pos == p->num_tokens) {
+        p->error = "Unterminated phrase.";
+        return NULL;
+    }
+    int end = p->pos++;
+    if (end == start) {
+        p->error = "Empty phrase.";
+        return NULL;
+    }
+    if (end - start == 1) {
+        return new_leaf(p->index, p->tokens[start]);
+    }
+
+    node_t* phrase = new_node(NODE_PHRASE);
+    phrase->words = malloc((end - start) * sizeof(char*));
+    for (int i = start; i < end; i++) {
+        phrase->words[phrase->num_words++] = strdup(p->tokens[i]);
+        node_t* leaf = new_leaf(p->index, p->tokens[i]);
+        if (leaf->type == NODE_NONE) {
+            free_node(leaf);
+        } else {
+            add_kid(phrase, leaf);
+        }
+    }
+    if (phrase->num_kids == 0) {
+        phrase->type = NODE_NONE; // no word to find candidates with
+    }
+    return phrase;
+}
+
+// word '~' [distance]: an "or" of the terms within distance edits of word
+static node_t* parse_fuzzy(parser_t* p, const char* word) {
+    const char* mark = p->tokens[p->pos++];
+    int distance = 1;
+    if (mark[1] != '\0') {
+        distance = mark[1] - '0';
+        if (mark[2] != '\0' || distance < 1 || distance > SPELL_MAX_DISTANCE) {
+            p->error = "Fuzzy distance must be 1 or 2.";
+            return NULL;
+        }
+    }
+    if (p->spell == NULL) {
+        p->error = "Fuzzy matching is not available.";
+        return NULL;
+    }
+    const char* terms[FUZZY_MAX_TERMS];
+    node_t* kids[FUZZY_MAX_TERMS];
+    int num_terms = spell_lookup(p->spell, word, distance, terms, FUZZY_MAX_TERMS);
+    for (int i = 0; i < num_terms; i++) {
+        kids[i] = new_leaf(p->index, terms[i]);
+    }
+    return new_group(NODE_OR, kids, num_terms);
+}
+
+// Why there is no operand at p->pos
+static const char* operand_error(const parser_t* p) {
+    bool at_end = (p->pos == p->num_tokens);
+    if (p->pos == 0) {
+        return "Query cannot begin with an operator.";
+    } else if (is_operator(p, p->pos - 1)) {
+        return at_end ? "Query cannot end with an operator." : "Cannot have adjacent operators.";
+    } else if (is_token(p, p->pos - 1, "(")) {
+        return "A group cannot be empty or begin with an operator.";
+    }
+    return "Unbalanced parentheses.";
+}
+
+// Whether tokens[pos] is token, ignoring case
+static bool is_token(const parser_t* p, int pos, const char* token) {
+    return pos < p->num_tokens && strcasecmp(p->tokens[pos], token) == 0;
+}
+
+static bool is_operator(const parser_t* p, int pos) {
+    return is_token(p, pos, "and") || is_token(p, pos, "or") || is_token(p, pos, "not");
+}
+
+static node_t* new_node(node_type_t type) {
+    node_t* node = calloc(1, sizeof(node_t));
+    node->type = type;
+    node->doc = (type == NODE_NONE) ? DOC_END : -1;
+    return node;
+}
+
+// The node for one query word: its postings, its stopword bits, or NONE
+static node_t* new_leaf(hashtable_t* index, const char* word) {
+    int len = strlen(word);
+    if (len < MIN_WORD_LEN) {
+        return new_node(NODE_NONE);
+    }
+    word_entry_t* entry = hsearch(index, search_word, word, len);
+    if (entry != NULL && entry->stopbits != NULL) {
+        node_t* node = new_node(NODE_STOP);
+        node->stop = entry;
+        return node;
+    }
+
+    node_t* node = new_node(NODE_TERM);
+    if (entry != NULL) {
+        g_count = 0;
+        qapply(entry->docs, count_helper);
+        node->postings = malloc((g_count + 1) * sizeof(doc_entry_t*));
+        g_postings = node->postings;
+        g_count = 0;
+        qapply(entry->docs, copy_helper);
+        node->num_postings = g_count;
+        for (int i = 1; i < node->num_postings; i++) {
+            if (node->postings[i - 1]->docID > node->postings[i]->docID) {
+                qsort(node->postings, node->num_postings, sizeof(doc_entry_t*), compare_docs);
+                break;
+            }
+        }
+    }
+    return node; // an unknown word has no postings
+}
+
+/*
+ * An "and" or "or" of kids, without the NONE ones; one kid is returned
+ * as it is, and NONE if nothing (or, for "and", nothing positive) is
+ * left.
+ */
+static node_t* new_group(node_type_t type, node_t** kids, int num_kids) {
+    int kept = 0, positive = 0;
+    for (int i = 0; i < num_kids; i++) {
+        if (kids[i]->type == NODE_NONE) {
+            free_node(kids[i]);
+        } else {
+            kids[kept++] = kids[i];
+            positive += (kids[i]->type != NODE_NOT);
+        }
+    }
+    if (positive == 0) {
+        while (kept > 0) free_node(kids[--kept]);
+        return new_node(NODE_NONE);
+    }
+    if (kept == 1) {
+        return kids[0];
+    }
+    node_t* node = new_node(type);
+    for (int i = 0; i < kept; i++) {
+        add_kid(node, kids[i]);
+    }
+    return node;
+}
+
+static void add_kid(node_t* node, node_t* kid) {
+    node->kids = realloc(node->kids, (node->num_kids + 1) * sizeof(node_t*));
+    node->kids[node->num_kids++] = kid;
+}
+
+static void free_node(node_t* node) {
+    if (node == NULL) {
+        return;
+    }
+    for (int i = 0; i < node->num_kids; i++) {
+        free_node(node->kids[i]);
+    }
+    for (int i = 0; i < node->num_words; i++) {
+        free(node->words[i]);
+    }
+    free(node->kids);
+    free(node->words);
+    free(node->postings);
+    free(node);
+}
+
+// Moves node to its first page >= target (if it is not there already)
+static void skip_to(querytree_t* query, node_t* node, int target) {
+    if (node->doc >= target) {
+        return;
+    }
+    switch (node->type) {
+    case NODE_TERM:
+        term_skip_to(query, node, target);
+        break;
+    case NODE_STOP:
+        stop_skip_to(node, target);
+        break;
+    case NODE_AND:
+    case NODE_PHRASE:
+        and_skip_to(query, node, target);
+        break;
+    case NODE_OR:
+        or_skip_to(query, node, target);
+        break;
+    default:
+        node->doc = DOC_END;
+        break;
+    }
+}
+
+// Gallops forward from the current posting, then bisects
+static void term_skip_to(querytree_t* query, node_t* node, int target) {
+    int lo = node->at, hi = lo, step = 1;
+    int n = node->num_postings;
+    while (hi < n && node->postings[hi]->docID < target) {
+        lo = hi + 1;
+        hi += step;
+        step *= 2;
+    }
+    if (hi > n) {
+        hi = n;
+    }
+    while (lo < hi) { // postings before lo are < target, and hi's (if any) >= target
+        int mid = (lo + hi) / 2;
+        if (node->postings[mid]->docID < target) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    node->at = lo;
+    if (lo < n) {
+        const doc_entry_t* posting = node->postings[lo];
+        node->doc = posting->docID;
+        node->score = posting->count;
+        if (posting->fields & FIELD_TITLE) {
+            node->score += query->boosts.title;
+        }
+        if (posting->fields & FIELD_DESC) {
+            node->score += query->boosts.description;
+        }
+        if (posting->fields & FIELD_ANCHOR) {
+            node->score += query->boosts.anchor;
+        }
+    } else {
+        node->doc = DOC_END;
+    }
+}
+
+// Scans the bitmap a byte at a time until a byte has a bit at or past target
+static void stop_skip_to(node_t* node, int target) {
+    const unsigned char* bits = node->stop->stopbits;
+    int num_bits = 8 * node->stop->stopbits_len;
+    for (int doc = (target > 0) ? target : 0; doc < num_bits; doc++) {
+        if ((doc & 7) == 0 && bits[doc >> 3] == 0) {
+            doc += 7;
+        } else if (bits[doc >> 3] & (1 << (doc & 7))) {
+            node->doc = doc;
+            node->score = NEUTRAL;
+            return;
+        }
+    }
+    node->doc = DOC_END;
+}
+
+/*
+ * Moves every positive kid to target; whenever one overshoots, its page
+ * becomes the target. Once they all agree, the page is a match unless
+ * a negated kid is on it too (or, for a phrase, its words are not in
+ * sequence there). Scores the least kid score that is not NEUTRAL.
+ */
+static void and_skip_to(querytree_t* query, node_t* node, int target) {
+    while (target != DOC_END) {
+        bool agreed = true;
+        for (int i = 0; i < node->num_kids && agreed; i++) {
+            node_t* kid = node->kids[i];
+            if (kid->type != NODE_NOT) {
+                skip_to(query, kid, target);
+                if (kid->doc > target) {
+                    target = kid->doc;
+                    agreed = false;
+                }
+            }
+        }
+        if (!agreed) {
+            continue;
+        }
+
+        bool excluded = false;
+        int score = NEUTRAL;
+        for (int i = 0; i < node->num_kids && !excluded; i++) {
+            node_t* kid = node->kids[i];
+            if (kid->type == NODE_NOT) {
+                skip_to(query, kid->kids[0], target);
+                excluded = (kid->kids[0]->doc == target);
+            } else if (kid->score != NEUTRAL && (score == NEUTRAL || kid->score < score)) {
+                score = kid->score;
+            }
+        }
+        if (!excluded && node->type == NODE_PHRASE) {
+            score = phrase_count(query, node, target);
+            excluded = (score == 0);
+        }
+        if (!excluded) {
+            node->doc = target;
+            node->score = score;
+            return;
+        }
+        target++;
+    }
+    node->doc = DOC_END;
+}
+
+// Moves every kid to target; lands on the least of their pages, scoring the sum of theirs
+static void or_skip_to(querytree_t* query, node_t* node, int target) {
+    int doc = DOC_END;
+    for (int i = 0; i < node->num_kids; i++) {
+        skip_to(query, node->kids[i], target);
+        if (node->kids[i]->doc < doc) {
+            doc = node->kids[i]->doc;
+        }
+    }
+    int score = 0;
+    for (int i = 0; i < node->num_kids; i++) {
+        if (node->kids[i]->doc == doc) {
+            score += (node->kids[i]->score == NEUTRAL) ? 1 : node->kids[i]->score;
+        }
+    }
+    node->doc = doc;
+    node->score = score;
+}
+
+/*
+ * Counts the places on page docID where the phrase's words follow one
+ * another, tokenizing and analyzing its text as index_addpage() does.
+ */
+static int phrase_count(querytree_t* query, const node_t* phrase, int docID) {
+    webpage_t* page = pagemap(docID, query->pageDirectory);
+    if (page == NULL || webpage_getHTML(page) == NULL) {
+        webpage_delete(page);
+        return 0;
+    }
+    int html_len = webpage_getHTMLlen(page);
+    char* lower = malloc(html_len + 1);
+    tokenizer_t tk;
+    tokenizer_init(&tk, webpage_getHTML(page), html_len, lower);
+
+    int k = phrase->num_words;
+    const char* window[k]; // the last k words, as a ring
+    int seen = 0, count = 0;
+    const char* token;
+    int len;
+    while (tokenizer_next(&tk, &token, &len) > 0) {
+        char* word = lower + (token - lower);
+        analyzer_apply(query->analyzer, word, len);
+        window[seen++ % k] = word;
+        if (seen < k) {
+            continue;
+        }
+        int j = 0;
+        while (j < k && strcmp(window[(seen - k + j) % k], phrase->words[j]) == 0) {
+            j++;
+        }
+        count += (j == k);
+    }
+
+    free(lower);
+    webpage_delete(page);
+    return count;
+}
+
+static bool search_word(void* elementp, const void* keyp) {
+    word_entry_t* entry = (word_entry_t*)elementp;
+    return strcmp(entry->word, (const char*)keyp) == 0;
+}
+
+static void count_helper(void* data) {
+    if (data != NULL) g_count++;
+}
+
+static void copy_helper(void* data) {
+    g_postings[g_count++] = (doc_entry_t*)data;
+}
+
+// qsort comparator: increasing docID
+static int compare_docs(const void* a, const void* b) {
+    const doc_entry_t* doc_a = *(doc_entry_t* const*)a;
+    const doc_entry_t* doc_b = *(doc_entry_t* const*)b;
+    return doc_a->docID - doc_b->docID;
+}
@@ -0,0 +1,80 @@
+/*
+ * querytree.h - header file for the boolean query language
+ *
+ * Author: Insecticide
+ * Date: 10-17-2026
+ *
+ * Description: Compiles a query into a tree of postings iterators and
+ * streams the matching pages out of it one at a time, in increasing
+ * docID order, without building the result set of any subexpression.
+ *
+ * Grammar (operators are case-insensitive; "and" may be left out):
+ *     query   := orexpr
+ *     orexpr  := andexpr { "or" andexpr }
+ *     andexpr := unary { ["and"] unary }
+ *     unary   := ["not"] primary
+ *     primary := word [fuzzy] | '"' word { word } '"' | '(' orexpr ')'
+ *     fuzzy   := "~" | "~1" | "~2"
+ * "and" binds tighter than "or". A "not" excludes pages from the
+ * "and" it is part of, which must have something that is not negated;
+ * "cat or not dog" is an error. A quoted phrase matches pages where
+ * its words appear consecutively: its indexed words find the
+ * candidates, whose text is then checked (the index has no positions).
+ * A fuzzy word ("~" alone means "~1") matches the terms within that
+ * many edits of it (see spell.h), the closest and commonest first, up
+ * to 16 of them.
+ *
+ * Ranks follow the flat querier's: a word ranks a page by its count,
+ * plus the boost of each field (title, description, anchor text) it is
+ * in there;
+ * "and" takes the least of its words' ranks, "or" adds them up, and a
+ * phrase ranks by its number of occurrences; a fuzzy word adds up its
+ * terms' ranks. Stopwords (see index_addstopword()) only filter, and a
+ * match with nothing but stopwords ranks 1. Words shorter than
+ * MIN_WORD_LEN, which the index never has, are left out, as is an
+ * "and" or "or" left with nothing.
+ */
+
+#pragma once
+
+#include "hash.h"
+#include "analyzer.h"
+#include "spell.h"
+
+typedef struct querytree querytree_t;
+
+// What a query word adds to the rank of a page with it in these fields
+typedef struct field_boosts {
+    int title;
+    int description;
+    int anchor;      // the text of links to the page
+} field_boosts_t;
+
+/*
+ * querytree_compile - Parses tokens[0..num_tokens) into a tree over
+ * index. Words must already be normalized as index words are (see
+ * analyzer.h); the other tokens are "and", "or", "not", "(", ")",
+ * "\"" and the fuzzy marks. Fuzzy words are looked up with spell
+ * (NULL makes them an error). Phrases are checked against the pages in
+ * pageDirectory, with analyzer. Words in a page's title, description
+ * or anchor text rank it higher by boosts (NULL for none), which must
+ * not be negative. The tokens are not needed once it returns.
+ * @error: set to a description of what is wrong, on failure.
+ * Returns the tree, or NULL if the query is malformed.
+ */
+querytree_t* querytree_compile(hashtable_t* index, spell_t* spell, char* tokens[], int num_tokens,
+                               const char* pageDirectory, analyzer_t analyzer, const field_boosts_t* boosts,
+                               const char** error);
+
+/*
+ * querytree_next - Finds the next page that matches.
+ * @rank: set to its rank.
+ * Returns its docID, which is greater than the last one returned, or
+ * -1 when there are no more.
+ */
+int querytree_next(querytree_t* query, int* rank);
+
+/*
+ * querytree_delete - Frees the tree.
+ */
+void querytree_delete(querytree_t* query);
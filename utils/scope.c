@@ -0,0 +1,285 @@
+/*
+ * scope.c - implementation of the crawl scope
+ *
+ * Author: Insecticide
+ * Date: 10-17-2026
+ *
+ * Description: The trie's nodes are numbered, node 0 being the empty
+ * prefix, and each node records the rule ending there, if any. Edges
+ * live in one open-addressing table keyed by (node, byte), so a node
+ * costs no space for the bytes it has no child for. See scope.h.
+ */
+
+#define _POSIX_C_SOURCE 200809L // getline, st_mtim
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <stdint.h>
+#include <sys/stat.h>
+#include "scope.h"
+
+#define RULE_NONE 0
+#define RULE_ALLOW 1
+#define RULE_DENY (-1)
+
+// An edge of the trie; a slot is empty while to is 0 (nothing leads to the root)
+typedef struct edge {
+    int from;
+    int to;
+    unsigned char byte;
+} edge_t;
+
+struct scope {
+    char *path;             // rules file, or NULL
+    struct stat loaded;     // the file as it was when its rules were read
+    signed char *rules;     // rule ending at each node
+    int num_nodes;
+    int node_cap;
+    edge_t *edges;          // table_size slots, at most half full
+    int num_edges;
+    int table_size;         // a power of 2
+};
+
+// --- Static helper function prototypes ---
+static scope_t *read_rules(const char *path);
+static int find_child(const scope_t *scope, int node, unsigned char byte);
+static int add_child(scope_t *scope, int node, unsigned char byte);
+static void grow_table(scope_t *scope);
+static uint32_t edge_hash(int node, unsigned char byte);
+static bool same_file(const struct stat *a, const struct stat *b);
+
+/*
+ * scope_new - Just the root, with no rule.
+ */
+scope_t *scope_new(void) {
+    scope_t *scope = malloc(sizeof(scope_t));
+    if (scope == NULL) {
+        return NULL;
+    }
+    scope->path = NULL;
+    scope->node_cap = 64;
+    scope->rules = calloc(scope->node_cap, sizeof(signed char));
+    scope->num_nodes = 1;
+    scope->table_size = 128;
+    scope->edges = calloc(scope->table_size, sizeof(edge_t));
+    scope->num_edges = 0;
+    if (scope->rules == NULL || scope->edges == NULL) {
+        scope_delete(scope);
+        return NULL;
+    }
+    return scope;
+}
+
+/*
+ * scope_load - Reads the rules, and remembers the file to reload.
+ */
+scope_t *scope_load(const char *path) {
+    scope_t *scope = read_rules(path);
+    if (scope != NULL) {
+        scope->path = malloc(strlen(path) + 1);
+        strcpy(scope->path, path);
+    }
+    return scope;
+}
+
+/*
+ * scope_add - Walks the prefix from the root, adding the nodes that
+ * are missing, and marks the last one.
+ */
+void scope_add(scope_t *scope, const char *prefix, bool allow) {
+    int node = 0;
+    for (const unsigned char *p = (const unsigned char *)prefix; *p != '\0'; p++) {
+        int child = find_child(scope, node, *p);
+        node = (child != 0) ? child : add_child(scope, node, *p);
+    }
+    scope->rules[node] = allow ? RULE_ALLOW : RULE_DENY;
+}
+
+/*
+ * scope_allows - Follows url down the trie as far as it goes; the
+ * deepest rule passed on the way is the longest matching one.
+ */
+bool scope_allows(const scope_t *scope, const char *url) {
+    if (scope == NULL || url == NULL) {
+        return false;
+    }
+    int node = 0;
+    int rule = scope->rules[0];
+    for (const unsigned char *p = (const unsigned char *)url; *p != '\0'; p++) {
+        node = find_child(scope, node, *p);
+        if (node == 0) {
+            break;
+        }
+        if (scope->rules[node] != RULE_NONE) {
+            rule = scope->rules[node];
+        }
+    }
+    return rule == RULE_ALLOW;
+}
+
+/*
+ * scope_reload - Rereads the file if stat() says it is not the one
+ * read last time, and swaps the new trie in.
+ */
+bool scope_reload(scope_t *scope) {
+    struct stat now;
+    if (scope == NULL || scope->path == NULL || stat(scope->path, &now) != 0 ||
+        same_file(&now, &scope->loaded)) {
+        return false;
+    }
+
+    scope_t *fresh = read_rules(scope->path);
+    if (fresh == NULL) {
+        scope->loaded = now; // don't report the same bad file again
+        return false;
+    }
+
+    scope_t old = *scope;
+    *scope = *fresh;
+    scope->path = old.path;
+    old.path = NULL;
+    *fresh = old;
+    scope_delete(fresh);
+    return true;
+}
+
+/*
+ * scope_delete - Frees the trie and the scope.
+ */
+void scope_delete(scope_t *scope) {
+    if (scope != NULL) {
+        free(scope->path);
+        free(scope->rules);
+        free(scope->edges);
+        free(scope);
+    }
+}
+
+
+// --- Helper Functions ---
+
+/*
+ * Builds a scope from the rules file at path, noting the file's stat.
+ * Returns NULL, after reporting why, if it cannot.
+ */
+static scope_t *read_rules(const char *path) {
+    FILE *fp = fopen(path, "r");
+    if (fp == NULL) {
+        fprintf(stderr, "Error: Cannot read scope rules '%s'.\n", path);
+        return NULL;
+    }
+    scope_t *scope = scope_new();
+    if (scope == NULL || fstat(fileno(fp), &scope->loaded) != 0) {
+        scope_delete(scope);
+        fclose(fp);
+        return NULL;
+    }
+
+    char *line = NULL;
+    size_t cap = 0;
+    int line_no = 0;
+    while (getline(&line, &cap, fp) > 0) {
+        line_no++;
+        char *p = line;
+        while (isspace((unsigned char)*p)) {
+            p++;
+        }
+        if (*p == '\0' || *p == '#') {
+            continue;
+        }
+
+        char sign = *p++;
+        while (isspace((unsigned char)*p)) {
+            p++;
+        }
+        char *prefix = p;
+        while (*p != '\0' && !isspace((unsigned char)*p)) {
+            p++;
+        }
+        char *end = p;
+        while (isspace((unsigned char)*p)) {
+            p++;
+        }
+        if ((sign != '+' && sign != '-') || *p != '\0' || end == prefix) {
+            // a rule for the empty prefix would decide every url
+            fprintf(stderr, "Error: %s:%d: expected '+ prefix' or '- prefix'.\n", path, line_no);
+            free(line);
+            fclose(fp);
+            scope_delete(scope);
+            return NULL;
+        }
+        *end = '\0';
+        scope_add(scope, prefix, sign == '+');
+    }
+
+    free(line);
+    fclose(fp);
+    return scope;
+}
+
+// The child of node by byte, or 0 if it has none
+static int find_child(const scope_t *scope, int node, unsigned char byte) {
+    uint32_t mask = scope->table_size - 1;
+    for (uint32_t slot = edge_hash(node, byte) & mask; scope->edges[slot].to != 0; slot = (slot + 1) & mask) {
+        if (scope->edges[slot].from == node && scope->edges[slot].byte == byte) {
+            return scope->edges[slot].to;
+        }
+    }
+    return 0;
+}
+
+// Adds a new node as the child of node by byte; returns it
+static int add_child(scope_t *scope, int node, unsigned char byte) {
+    if (scope->num_nodes == scope->node_cap) {
+        scope->node_cap *= 2;
+        scope->rules = realloc(scope->rules, scope->node_cap * sizeof(signed char));
+    }
+    int child = scope->num_nodes++;
+    scope->rules[child] = RULE_NONE;
+
+    if (2 * (scope->num_edges + 1) > scope->table_size) {
+        grow_table(scope);
+    }
+    uint32_t mask = scope->table_size - 1;
+    uint32_t slot = edge_hash(node, byte) & mask;
+    while (scope->edges[slot].to != 0) {
+        slot = (slot + 1) & mask;
+    }
+    edge_t edge = { node, child, byte };
+    scope->edges[slot] = edge;
+    scope->num_edges++;
+    return child;
+}
+
+// Doubles the edge table, rehashing every edge
+static void grow_table(scope_t *scope) {
+    edge_t *old = scope->edges;
+    int old_size = scope->table_size;
+    scope->table_size *= 2;
+    scope->edges = calloc(scope->table_size, sizeof(edge_t));
+
+    uint32_t mask = scope->table_size - 1;
+    for (int i = 0; i < old_size; i++) {
+        if (old[i].to != 0) {
+            uint32_t slot = edge_hash(old[i].from, old[i].byte) & mask;
+            while (scope->edges[slot].to != 0) {
+                slot = (slot + 1) & mask;
+            }
+            scope->edges[slot] = old[i];
+        }
+    }
+    free(old);
+}
+
+// Multiplicative hash of an edge's key
+static uint32_t edge_hash(int node, unsigned char byte) {
+    return ((uint32_t)node * 256u + byte) * 2654435761u >> 7;
+}
+
+// Whether two stats describe the same version of a file
+static bool same_file(const struct stat *a, const struct stat *b) {
+    return a->st_ino == b->st_ino && a->st_dev == b->st_dev && a->st_size == b->st_size &&
+           a->st_mtim.tv_sec == b->st_mtim.tv_sec && a->st_mtim.tv_nsec == b->st_mtim.tv_nsec;
+}
@@ -0,0 +1,54 @@
+/*
+ * scope.h - header file for the crawl scope (URL allow/deny rules)
+ *
+ * Author: Insecticide
+ * Date: 10-17-2026
+ *
+ * Description: Decides which URLs a crawl may follow, from a set of
+ * URL prefixes to allow or deny. The rules are compiled into a byte
+ * trie, so checking a URL takes time proportional to its length no
+ * matter how many rules there are. The longest rule that is a prefix
+ * of the URL decides; a URL no rule matches is out of scope.
+ *
+ * A rules file has one rule per line:
+ *     + https://thayer.github.io/engs50/    allow this prefix
+ *     - https://thayer.github.io/engs50/old deny this (longer) prefix
+ * Blank lines and lines starting with '#' are ignored. URLs are
+ * checked after normalization (see NormalizeURL()), so schemes and
+ * hosts in rules should be lowercase. A prefix is matched byte for
+ * byte: end a host with '/' to keep "https://a.com" from also
+ * matching "https://a.com.example.org/".
+ */
+
+#pragma once
+
+#include <stdbool.h>
+
+typedef struct scope scope_t;
+
+/* scope_new -- create a scope with no rules (nothing is in it) */
+scope_t *scope_new(void);
+
+/* scope_load -- create a scope from a rules file
+ * returns NULL (after reporting the line) if the file cannot be read
+ * or has a malformed rule (a sign without a prefix is one)
+ */
+scope_t *scope_load(const char *path);
+
+/* scope_add -- add a rule; a later rule for the same prefix replaces
+ * an earlier one
+ */
+void scope_add(scope_t *scope, const char *prefix, bool allow);
+
+/* scope_allows -- whether the normalized url is in scope */
+bool scope_allows(const scope_t *scope, const char *url);
+
+/* scope_reload -- if scope was loaded from a file that has changed
+ * since, replace its rules with the file's
+ * returns true if the rules changed; on an unreadable or malformed
+ * file, reports it and keeps the old rules
+ */
+bool scope_reload(scope_t *scope);
+
+/* scope_delete -- free the scope */
+void scope_delete(scope_t *scope);
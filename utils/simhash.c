@@ -0,0 +1,220 @@
+/*
+ * simhash.c - implementation of the page fingerprint module
+ *
+ * Author: Insecticide
+ * Date: 10-17-2026
+ *
+ * Description: Exact and SimHash fingerprints of page text, and a
+ * banded lookup table for finding near-duplicates. See simhash.h.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include "simhash.h"
+#include "tokenize.h"
+
+#define NUM_BANDS 4
+#define BAND_BITS 16
+#define BAND_SLOTS (1 << BAND_BITS)
+#define SHINGLE_LEN 3
+
+#define FNV_OFFSET 14695981039346656037ULL
+#define FNV_PRIME  1099511628211ULL
+
+// One fingerprinted page, chained into one bucket per band
+typedef struct dup_entry {
+    fingerprint_t fp;
+    int docID;
+    int next[NUM_BANDS];           // next entry in the same bucket, or -1
+} dup_entry_t;
+
+struct dupindex {
+    dup_entry_t *entries;
+    int num_entries;
+    int capacity;
+    int *heads[NUM_BANDS];         // BAND_SLOTS bucket heads per band, or -1
+};
+
+// --- Static helper function prototypes ---
+static uint64_t hash_word(const char *word, int len);
+static uint64_t mix64(uint64_t x);
+static uint64_t rotl64(uint64_t x, int r);
+static void add_shingle(int weights[64], uint64_t h);
+static int band_of(uint64_t simhash, int band);
+
+/*
+ * page_fingerprint - hashes the page's words and 3-word shingles.
+ */
+fingerprint_t page_fingerprint(webpage_t *page) {
+    fingerprint_t fp = { FNV_OFFSET, 0, 0 };
+    int weights[64] = { 0 };
+    uint64_t window[SHINGLE_LEN];  // hashes of the last words seen
+    int num_words = 0;
+    const char *word;
+    int len;
+
+    char *html = webpage_getHTML(page);
+    int html_len = html ? webpage_getHTMLlen(page) : 0;
+    char *lower = malloc(html_len + 1);
+    tokenizer_t tk;
+    tokenizer_init(&tk, html ? html : "", html_len, lower);
+
+    while (tokenizer_next(&tk, &word, &len) > 0) {
+        uint64_t h = hash_word(word, len);
+
+        // exact: FNV over the word hashes, so word boundaries count
+        for (int i = 0; i < 8; i++) {
+            fp.exact = (fp.exact ^ ((h >> (8 * i)) & 0xff)) * FNV_PRIME;
+        }
+
+        window[num_words % SHINGLE_LEN] = h;
+        num_words++;
+        if (num_words >= SHINGLE_LEN) {
+            uint64_t s = 0;
+            for (int i = 0; i < SHINGLE_LEN; i++) {
+                // oldest word first, so shingles are order-sensitive
+                s ^= rotl64(window[(num_words + i) % SHINGLE_LEN], 21 * i);
+            }
+            add_shingle(weights, mix64(s));
+        }
+    }
+
+    free(lower);
+    fp.num_words = num_words;
+
+    // Too short for a full shingle: use the words themselves
+    for (int i = 0; i < num_words && num_words < SHINGLE_LEN; i++) {
+        add_shingle(weights, mix64(window[i]));
+    }
+
+    for (int bit = 0; bit < 64; bit++) {
+        if (weights[bit] > 0) {
+            fp.simhash |= 1ULL << bit;
+        }
+    }
+    return fp;
+}
+
+int simhash_distance(uint64_t a, uint64_t b) {
+    return __builtin_popcountll(a ^ b);
+}
+
+dupindex_t *dupindex_new(void) {
+    dupindex_t *di = calloc(1, sizeof(dupindex_t));
+    if (di == NULL) {
+        return NULL;
+    }
+    for (int b = 0; b < NUM_BANDS; b++) {
+        di->heads[b] = malloc(BAND_SLOTS * sizeof(int));
+        if (di->heads[b] == NULL) {
+            dupindex_delete(di);
+            return NULL;
+        }
+        memset(di->heads[b], -1, BAND_SLOTS * sizeof(int)); // all bytes 0xff == -1
+    }
+    return di;
+}
+
+int dupindex_add(dupindex_t *di, const fingerprint_t *fp, int docID) {
+    if (di == NULL || fp == NULL) {
+        return 1;
+    }
+    if (fp->num_words == 0) {
+        return 0; // nothing to compare it by
+    }
+    if (di->num_entries == di->capacity) {
+        int capacity = di->capacity ? di->capacity * 2 : 256;
+        dup_entry_t *entries = realloc(di->entries, capacity * sizeof(dup_entry_t));
+        if (entries == NULL) {
+            return 1;
+        }
+        di->entries = entries;
+        di->capacity = capacity;
+    }
+
+    int idx = di->num_entries++;
+    dup_entry_t *e = &di->entries[idx];
+    e->fp = *fp;
+    e->docID = docID;
+    for (int b = 0; b < NUM_BANDS; b++) {
+        int slot = band_of(fp->simhash, b);
+        e->next[b] = di->heads[b][slot];
+        di->heads[b][slot] = idx;
+    }
+    return 0;
+}
+
+int dupindex_find(const dupindex_t *di, const fingerprint_t *fp, int maxdist) {
+    if (di == NULL || fp == NULL || fp->num_words == 0) {
+        return 0;
+    }
+    if (maxdist > SIMHASH_MAXDIST) {
+        maxdist = SIMHASH_MAXDIST;
+    }
+
+    int best_docID = 0;
+    int best_dist = maxdist + 1;
+    for (int b = 0; b < NUM_BANDS; b++) {
+        int slot = band_of(fp->simhash, b);
+        for (int i = di->heads[b][slot]; i >= 0; i = di->entries[i].next[b]) {
+            const dup_entry_t *e = &di->entries[i];
+            if (e->fp.exact == fp->exact && e->fp.simhash == fp->simhash) {
+                return e->docID; // exact duplicate, can't do better
+            }
+            int dist = simhash_distance(e->fp.simhash, fp->simhash);
+            // entries are chained newest first; ties keep the oldest page
+            if (dist < best_dist || (dist == best_dist && e->docID < best_docID)) {
+                best_dist = dist;
+                best_docID = e->docID;
+            }
+        }
+    }
+    return best_docID;
+}
+
+void dupindex_delete(dupindex_t *di) {
+    if (di != NULL) {
+        for (int b = 0; b < NUM_BANDS; b++) {
+            free(di->heads[b]);
+        }
+        free(di->entries);
+        free(di);
+    }
+}
+
+
+// --- Helper Functions ---
+
+// FNV-1a hash of a word span
+static uint64_t hash_word(const char *word, int len) {
+    uint64_t h = FNV_OFFSET;
+    for (int i = 0; i < len; i++) {
+        h = (h ^ (unsigned char)word[i]) * FNV_PRIME;
+    }
+    return h;
+}
+
+// splitmix64 finalizer: spreads every input bit over the whole output
+static uint64_t mix64(uint64_t x) {
+    x ^= x >> 30;
+    x *= 0xbf58476d1ce4e5b9ULL;
+    x ^= x >> 27;
+    x *= 0x94d049bb133111ebULL;
+    x ^= x >> 31;
+    return x;
+}
+
+static uint64_t rotl64(uint64_t x, int r) {
+    return r == 0 ? x : (x << r) | (x >> (64 - r));
+}
+
+// Adds a shingle hash to the simhash bit counters
+static void add_shingle(int weights[64], uint64_t h) {
+    for (int bit = 0; bit < 64; bit++) {
+        weights[bit] += ((h >> bit) & 1) ? 1 : -1;
+    }
+}
+
+static int band_of(uint64_t simhash, int band) {
+    return (int)((simhash >> (band * BAND_BITS)) & (BAND_SLOTS - 1));
+}
@@ -0,0 +1,75 @@
+/*
+ * simhash.h - header file for the page fingerprint module
+ *
+ * Author: Insecticide
+ * Date: 10-17-2026
+ *
+ * Description: Fingerprints the text of a page so that exact and
+ * near-duplicate pages (templates, mirrors) can be recognized.
+ *
+ * Each page gets two 64-bit fingerprints over its normalized words:
+ *   exact    - a hash of the whole word sequence
+ *   simhash  - Charikar's SimHash over 3-word shingles; pages with
+ *              mostly the same text differ in only a few bits.
+ * A dupindex_t finds an earlier page within a small Hamming distance
+ * by splitting the simhash into four 16-bit bands: two fingerprints
+ * within distance 3 must agree exactly on at least one band.
+ *
+ * Pages with fewer than 3 words are hashed word by word instead. Pages
+ * with no words at all (empty, or only markup) would all share one
+ * fingerprint; they are never recorded or reported as duplicates.
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include "webpage.h"
+
+// Largest Hamming distance the band lookup can guarantee to find
+#define SIMHASH_MAXDIST 3
+
+typedef struct fingerprint {
+    uint64_t exact;
+    uint64_t simhash;
+    int num_words;   // 0: the page has no text to compare
+} fingerprint_t;
+
+typedef struct dupindex dupindex_t;
+
+/*
+ * page_fingerprint - Computes the fingerprints of page's words.
+ * Must be called before webpage_getNextURL, which rewrites the html.
+ */
+fingerprint_t page_fingerprint(webpage_t *page);
+
+/*
+ * simhash_distance - Number of differing bits between two simhashes.
+ */
+int simhash_distance(uint64_t a, uint64_t b);
+
+/*
+ * dupindex_new - Creates an empty duplicate index.
+ * Returns NULL on failure.
+ */
+dupindex_t *dupindex_new(void);
+
+/*
+ * dupindex_add - Records the fingerprint of docID (unless its page has
+ * no words).
+ * Returns 0 on success, non-zero on failure.
+ */
+int dupindex_add(dupindex_t *di, const fingerprint_t *fp, int docID);
+
+/*
+ * dupindex_find - Looks for an earlier page that duplicates fp.
+ * An exact match is preferred; otherwise the closest page whose
+ * simhash is within maxdist bits (at most SIMHASH_MAXDIST) is returned.
+ * Returns that page's docID, or 0 if there is none (always, if fp's
+ * page has no words).
+ */
+int dupindex_find(const dupindex_t *di, const fingerprint_t *fp, int maxdist);
+
+/*
+ * dupindex_delete - Frees a duplicate index.
+ */
+void dupindex_delete(dupindex_t *di);
@@ -0,0 +1,385 @@
+/*
+ * spell.c - implementation of fuzzy lookup over an index's terms
+ *
+ * Author: Insecticide
+ * Date: 10-17-2026
+ *
+ * Description: Deletions are made a character at a time, each after
+ * the position of the one before (so a set of positions is deleted in
+ * one order only), and filed as (FNV-1a hash, term) pairs sorted by
+ * hash. A hash shared by two strings only adds a candidate, which the
+ * distance check then rejects. Candidates are checked once per lookup
+ * (a stamp per term), after a length filter. See spell.h.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include "spell.h"
+#include "index.h"
+#include "utf8.h"
+
+#define MAX_CHARS 48      // longer words are neither filed nor looked up
+#define SHORT_WORD 4      // suggestions for words this short allow one edit
+#define MAX_CANDIDATES 64 // terms a lookup keeps before the best are taken
+
+// A term, and the number of pages it is on
+typedef struct term {
+    const char* word;
+    int pages;
+    int chars;            // its length in characters
+} term_t;
+
+// A deletion of a term
+typedef struct deletion {
+    uint32_t hash;
+    uint32_t term;
+} deletion_t;
+
+struct spell {
+    hashtable_t* index;
+    bool built;
+    term_t* terms;
+    int num_terms;
+    deletion_t* deletions;  // sorted by hash
+    int num_deletions;
+    int capacity;
+    unsigned* stamps;       // per term: the lookup that last checked it
+    unsigned lookups;
+};
+
+// A term found by a lookup
+typedef struct match {
+    const term_t* term;
+    int distance;
+} match_t;
+
+// State of one lookup (the word's characters, and the terms found)
+typedef struct lookup {
+    uint32_t chars[MAX_CHARS];
+    int num_chars;
+    int max_distance;
+    match_t matches[MAX_CANDIDATES];
+    int num_matches;
+} lookup_t;
+
+// What to do with each deletion generated
+typedef void (*deletion_fn)(spell_t* spell, uint32_t hash, uint32_t term, void* arg);
+
+// --- Static state for apply helpers ---
+static spell_t* g_spell;  // speller whose terms are being collected
+static int g_pages;       // postings counted so far
+
+// --- Static helper function prototypes ---
+static void build(spell_t* spell);
+static void collect_term(void* data);
+static int count_pages(const word_entry_t* entry);
+static void count_helper(void* data);
+static void file_deletion(spell_t* spell, uint32_t hash, uint32_t term, void* arg);
+static void check_deletion(spell_t* spell, uint32_t hash, uint32_t term, void* arg);
+static void deletions(spell_t* spell, char* s, int len, int from, int edits, uint32_t term,
+                      deletion_fn fn, void* arg);
+static int decode(const char* word, uint32_t* chars);
+static int distance(const uint32_t* a, int a_len, const uint32_t* b, int b_len, int max);
+static uint32_t fnv1a(const char* s, int len);
+static int compare_deletions(const void* a, const void* b);
+static int compare_matches(const void* a, const void* b);
+
+/*
+ * spell_new - Only records the index; build() files its terms.
+ */
+spell_t* spell_new(hashtable_t* index) {
+    spell_t* spell = calloc(1, sizeof(spell_t));
+    if (spell != NULL) {
+        spell->index = index;
+    }
+    return spell;
+}
+
+/*
+ * spell_lookup - Checks the terms filed under each deletion of word.
+ */
+int spell_lookup(spell_t* spell, const char* word, int max_distance, const char* terms[], int max_terms) {
+    if (!spell->built) {
+        build(spell);
+    }
+    int len = strlen(word);
+    if (max_distance > SPELL_MAX_DISTANCE) {
+        max_distance = SPELL_MAX_DISTANCE;
+    }
+    lookup_t lk;
+    lk.num_chars = decode(word, lk.chars);
+    if (lk.num_chars < 0) {
+        return 0;
+    }
+    lk.max_distance = max_distance;
+    lk.num_matches = 0;
+    spell->lookups++;
+
+    char copy[4 * MAX_CHARS + 1];
+    memcpy(copy, word, len + 1);
+    deletions(spell, copy, len, 0, max_distance, 0, check_deletion, &lk);
+
+    qsort(lk.matches, lk.num_matches, sizeof(match_t), compare_matches);
+    int n = (lk.num_matches < max_terms) ? lk.num_matches : max_terms;
+    for (int i = 0; i < n; i++) {
+        terms[i] = lk.matches[i].term->word;
+    }
+    return n;
+}
+
+/*
+ * spell_suggest - The first of a lookup, unless that is word itself.
+ */
+const char* spell_suggest(spell_t* spell, const char* word) {
+    uint32_t chars[MAX_CHARS];
+    int num_chars = decode(word, chars);
+    if (num_chars < 0) {
+        return NULL;
+    }
+    const char* best;
+    int max_distance = (num_chars <= SHORT_WORD) ? 1 : SPELL_MAX_DISTANCE;
+    if (spell_lookup(spell, word, max_distance, &best, 1) == 0 || strcmp(best, word) == 0) {
+        return NULL;
+    }
+    return best;
+}
+
+/*
+ * spell_delete - Frees the terms and deletions.
+ */
+void spell_delete(spell_t* spell) {
+    if (spell != NULL) {
+        free(spell->terms);
+        free(spell->deletions);
+        free(spell->stamps);
+        free(spell);
+    }
+}
+
+
+// --- Helper Functions ---
+
+// Collects the index's terms and files every deletion of each
+static void build(spell_t* spell) {
+    g_spell = spell;
+    happly(spell->index, collect_term);
+
+    for (int t = 0; t < spell->num_terms; t++) {
+        char copy[4 * MAX_CHARS + 1];
+        int len = strlen(spell->terms[t].word);
+        memcpy(copy, spell->terms[t].word, len + 1);
+        deletions(spell, copy, len, 0, SPELL_MAX_DISTANCE, t, file_deletion, NULL);
+    }
+    qsort(spell->deletions, spell->num_deletions, sizeof(deletion_t), compare_deletions);
+
+    // A term with repeated letters has some deletions more than once
+    int kept = 0;
+    for (int i = 0; i < spell->num_deletions; i++) {
+        if (kept == 0 || compare_deletions(&spell->deletions[kept - 1], &spell->deletions[i]) != 0) {
+            spell->deletions[kept++] = spell->deletions[i];
+        }
+    }
+    spell->num_deletions = kept;
+    spell->stamps = calloc(spell->num_terms + 1, sizeof(unsigned));
+    spell->built = true;
+}
+
+// Adds a term that is on some page and is not too long (for happly)
+static void collect_term(void* data) {
+    word_entry_t* entry = (word_entry_t*)data;
+    spell_t* spell = g_spell;
+    uint32_t chars[MAX_CHARS];
+    int pages = count_pages(entry);
+    int num_chars = decode(entry->word, chars);
+    if (pages == 0 || num_chars < 0) {
+        return;
+    }
+    if (spell->num_terms % 1024 == 0) {
+        spell->terms = realloc(spell->terms, (spell->num_terms + 1024) * sizeof(term_t));
+    }
+    term_t* term = &spell->terms[spell->num_terms++];
+    term->word = entry->word;
+    term->pages = pages;
+    term->chars = num_chars;
+}
+
+// Pages a term is on: its postings, or the bits of a stopword
+static int count_pages(const word_entry_t* entry) {
+    if (entry->stopbits != NULL) {
+        int pages = 0;
+        for (int i = 0; i < entry->stopbits_len; i++) {
+            pages += __builtin_popcount(entry->stopbits[i]);
+        }
+        return pages;
+    }
+    g_pages = 0;
+    qapply(entry->docs, count_helper);
+    return g_pages;
+}
+
+static void count_helper(void* data) {
+    if (data != NULL) g_pages++;
+}
+
+static void file_deletion(spell_t* spell, uint32_t hash, uint32_t term, void* arg) {
+    if (spell->num_deletions == spell->capacity) {
+        spell->capacity = spell->capacity ? 2 * spell->capacity : 1 << 16;
+        spell->deletions = realloc(spell->deletions, spell->capacity * sizeof(deletion_t));
+    }
+    spell->deletions[spell->num_deletions].hash = hash;
+    spell->deletions[spell->num_deletions++].term = term;
+}
+
+// Checks every term filed under hash against the looked-up word
+static void check_deletion(spell_t* spell, uint32_t hash, uint32_t term, void* arg) {
+    lookup_t* lk = (lookup_t*)arg;
+    int lo = 0, hi = spell->num_deletions;
+    while (lo < hi) {
+        int mid = (lo + hi) / 2;
+        if (spell->deletions[mid].hash < hash) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    for (int i = lo; i < spell->num_deletions && spell->deletions[i].hash == hash; i++) {
+        uint32_t t = spell->deletions[i].term;
+        const term_t* found = &spell->terms[t];
+        if (spell->stamps[t] == spell->lookups || abs(found->chars - lk->num_chars) > lk->max_distance) {
+            continue;
+        }
+        spell->stamps[t] = spell->lookups;
+
+        uint32_t chars[MAX_CHARS];
+        decode(found->word, chars);
+        int d = distance(lk->chars, lk->num_chars, chars, found->chars, lk->max_distance);
+        if (d <= lk->max_distance) {
+            match_t m = { found, d };
+            if (lk->num_matches < MAX_CANDIDATES) {
+                lk->matches[lk->num_matches++] = m;
+            } else {
+                // Full: replace the worst, if this is better
+                int worst = 0;
+                for (int j = 1; j < MAX_CANDIDATES; j++) {
+                    if (compare_matches(&lk->matches[j], &lk->matches[worst]) > 0) {
+                        worst = j;
+                    }
+                }
+                if (compare_matches(&m, &lk->matches[worst]) < 0) {
+                    lk->matches[worst] = m;
+                }
+            }
+        }
+    }
+}
+
+/*
+ * Calls fn with the hash of s[0..len) and of every string made from it
+ * by deleting up to edits more characters, each after position from.
+ * s is changed on the way but restored.
+ */
+static void deletions(spell_t* spell, char* s, int len, int from, int edits, uint32_t term,
+                      deletion_fn fn, void* arg) {
+    fn(spell, fnv1a(s, len), term, arg);
+    if (edits == 0) {
+        return;
+    }
+    char saved[4 * MAX_CHARS + 1];
+    for (int i = from; i < len; ) {
+        int n = utf8_letter(s, len, i);
+        if (n == 0) {
+            n = 1; // not a letter; delete it as a byte
+        }
+        memcpy(saved, s + i, len - i);
+        memmove(s + i, s + i + n, len - i - n);
+        deletions(spell, s, len - n, i, edits - 1, term, fn, arg);
+        memcpy(s + i, saved, len - i);
+        i += n;
+    }
+}
+
+// Decodes word into chars; returns its length in characters, or -1 if too long
+static int decode(const char* word, uint32_t* chars) {
+    int len = strlen(word);
+    int n = 0;
+    for (int i = 0; i < len; n++) {
+        if (n == MAX_CHARS) {
+            return -1;
+        }
+        int bytes = utf8_decode(word, len, i, &chars[n]);
+        if (bytes == 0) {
+            chars[n] = (unsigned char)word[i];
+            bytes = 1;
+        }
+        i += bytes;
+    }
+    return n;
+}
+
+/*
+ * The optimal string alignment distance between a and b, or max + 1
+ * as soon as every alignment so far needs more than max edits.
+ */
+static int distance(const uint32_t* a, int a_len, const uint32_t* b, int b_len, int max) {
+    int rows[3][MAX_CHARS + 1]; // rows i - 2, i - 1 and i
+    int* before = rows[0];
+    int* prev = rows[1];
+    int* cur = rows[2];
+    for (int j = 0; j <= b_len; j++) {
+        prev[j] = j;
+    }
+    for (int i = 1; i <= a_len; i++) {
+        cur[0] = i;
+        int row_min = i;
+        for (int j = 1; j <= b_len; j++) {
+            int cost = (a[i - 1] != b[j - 1]);
+            int d = prev[j - 1] + cost;
+            if (prev[j] + 1 < d) d = prev[j] + 1;
+            if (cur[j - 1] + 1 < d) d = cur[j - 1] + 1;
+            if (i > 1 && j > 1 && a[i - 1] == b[j - 2] && a[i - 2] == b[j - 1] && before[j - 2] + 1 < d) {
+                d = before[j - 2] + 1;
+            }
+            cur[j] = d;
+            if (d < row_min) row_min = d;
+        }
+        if (row_min > max) {
+            return max + 1;
+        }
+        int* t = before;
+        before = prev;
+        prev = cur;
+        cur = t;
+    }
+    return prev[b_len];
+}
+
+static uint32_t fnv1a(const char* s, int len) {
+    uint32_t h = 2166136261u;
+    for (int i = 0; i < len; i++) {
+        h = (h ^ (unsigned char)s[i]) * 16777619u;
+    }
+    return h;
+}
+
+// qsort comparator: by hash, then term
+static int compare_deletions(const void* a, const void* b) {
+    const deletion_t* da = (const deletion_t*)a;
+    const deletion_t* db = (const deletion_t*)b;
+    if (da->hash != db->hash) {
+        return (da->hash < db->hash) ? -1 : 1;
+    }
+    return (da->term > db->term) - (da->term < db->term);
+}
+
+// qsort comparator: closest, then on most pages, then alphabetical
+static int compare_matches(const void* a, const void* b) {
+    const match_t* ma = (const match_t*)a;
+    const match_t* mb = (const match_t*)b;
+    if (ma->distance != mb->distance) {
+        return ma->distance - mb->distance;
+    }
+    if (ma->term->pages != mb->term->pages) {
+        return mb->term->pages - ma->term->pages;
+    }
+    return strcmp(ma->term->word, mb->term->word);
+}
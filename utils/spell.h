@@ -0,0 +1,57 @@
+/*
+ * spell.h - header file for fuzzy lookup over an index's terms
+ *
+ * Author: Insecticide
+ * Date: 10-17-2026
+ *
+ * Description: Finds the terms of an index within a few edits of a
+ * word, for "did you mean" suggestions and the query language's "~"
+ * operator (see querytree.h). An edit inserts, deletes or replaces a
+ * letter, or swaps two adjacent ones (the optimal string alignment
+ * distance); letters are characters, so "é" for "e" is one edit.
+ *
+ * It is a SymSpell deletion index: every term is filed under each
+ * string it becomes with up to SPELL_MAX_DISTANCE letters deleted
+ * (as a hash, in one sorted array). Two words within d edits of each
+ * other have a deletion of at most d letters in common, so a lookup
+ * only checks the distance to the terms filed under the word's own
+ * deletions -- a few dozen binary searches, whatever the vocabulary.
+ * The index is built the first time it is needed.
+ */
+
+#pragma once
+
+#include "hash.h"
+
+#define SPELL_MAX_DISTANCE 2 // most edits a lookup may allow
+
+typedef struct spell spell_t;
+
+/*
+ * spell_new - Creates a speller over the terms of index, which must
+ * not change (or be freed) while the speller is in use.
+ * Returns NULL on failure.
+ */
+spell_t* spell_new(hashtable_t* index);
+
+/*
+ * spell_lookup - Finds the terms within max_distance edits of the
+ * normalized word (itself included, if it is a term): the closest
+ * first, then those on the most pages.
+ * @terms: receives at most max_terms of them (the index's strings).
+ * Returns how many it received.
+ */
+int spell_lookup(spell_t* spell, const char* word, int max_distance, const char* terms[], int max_terms);
+
+/*
+ * spell_suggest - The term most likely meant by the normalized word:
+ * the best one spell_lookup() finds within SPELL_MAX_DISTANCE edits
+ * (one, for a word of four letters or fewer).
+ * Returns NULL if word is a term itself, or no term is close enough.
+ */
+const char* spell_suggest(spell_t* spell, const char* word);
+
+/*
+ * spell_delete - Frees the speller (not the index).
+ */
+void spell_delete(spell_t* spell);
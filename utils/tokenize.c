@@ -0,0 +1,404 @@
+/*
+ * tokenize.c - implementation of the vectorized word tokenizer
+ *
+ * Author: Insecticide
+ * Date: 10-17-2026
+ *
+ * Description: Each block of TOKENIZE_BLOCK bytes is classified into
+ * bitmasks (bit i for byte i): ASCII letters, '<', '>', '&' and bytes
+ * of 0x80 and up. Walking the
+ * '<' / '>' bits gives the bytes outside tags; the letters among those
+ * are the words, whose first and last bytes fall out of a shift and a
+ * mask. A word may run on into the next block, so one is carried over.
+ * The few '<' that open a script, style or comment region, and the
+ * '&' that start character references, are looked at one by one
+ * (htmllex_skip / htmllex_entity) and their bytes dropped from the
+ * text, except for references to letters, whose bytes count as
+ * letters; a region or reference may run on into later blocks too.
+ * Only the words that had such a reference are decoded, from the html
+ * (htmllex_decode), into the lowercased copy. So
+ * are the high bytes, decoded (utf8_letter) into whole letters that
+ * join the ASCII ones; pure-ASCII blocks never get that far, and only
+ * the words that had any are folded (utf8_fold_span).
+ * See tokenize.h.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include "tokenize.h"
+#include "htmllex.h"
+#include "utf8.h"
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define TOKENIZE_X86
+#include <immintrin.h>
+#endif
+
+// Classifies TOKENIZE_BLOCK bytes of src, writing them lowercased to dst
+typedef void (*classify_fn)(const char *src, char *dst, uint32_t *alpha, uint32_t *lt, uint32_t *gt,
+                            uint32_t *amp, uint32_t *high);
+
+static classify_fn classify;
+static pthread_once_t classify_once = PTHREAD_ONCE_INIT;
+
+// --- Static helper function prototypes ---
+static void choose_classify(void);
+static bool next_block(tokenizer_t *tk);
+static inline uint32_t text_mask(const tokenizer_t *tk, int block, bool *in_tag, int *skip,
+                                 uint32_t lt, uint32_t gt);
+static inline uint32_t drop_entities(const tokenizer_t *tk, int block, int *entity, int *ref_end,
+                                     uint32_t amp, uint32_t *refs);
+static inline uint32_t utf8_letters(const tokenizer_t *tk, int block, int *letter_end, uint32_t high);
+static inline uint32_t span_bits(int from, int to);
+static inline void add_word(tokenizer_t *tk, int i, int start, int end, int letter_end, int ref_end);
+#ifdef TOKENIZE_X86
+static void classify_sse2(const char *src, char *dst, uint32_t *alpha, uint32_t *lt, uint32_t *gt,
+                          uint32_t *amp, uint32_t *high);
+static void classify_avx2(const char *src, char *dst, uint32_t *alpha, uint32_t *lt, uint32_t *gt,
+                          uint32_t *amp, uint32_t *high);
+#else
+static void classify_scalar(const char *src, char *dst, uint32_t *alpha, uint32_t *lt, uint32_t *gt,
+                            uint32_t *amp, uint32_t *high);
+#endif
+
+/*
+ * tokenizer_init - Resets tk to the start of html.
+ */
+void tokenizer_init(tokenizer_t *tk, const char *html, int len, char *lower) {
+    pthread_once(&classify_once, choose_classify);
+    tk->html = html;
+    tk->len = len;
+    tk->lower = lower;
+    tk->lower[len] = '\0';
+    tk->block = 0;
+    tk->in_tag = false;
+    tk->skip = 0;
+    tk->entity = 0;
+    tk->ref_end = 0;
+    tk->letter_end = 0;
+    tk->open = -1;
+    tk->num_words = 0;
+    tk->next_word = 0;
+}
+
+/*
+ * tokenizer_next - Returns the next word of the current block,
+ * classifying more blocks until one yields words.
+ */
+int tokenizer_next(tokenizer_t *tk, const char **word, int *len) {
+    if (tk->next_word == tk->num_words && !next_block(tk)) {
+        return -1;
+    }
+    int i = tk->next_word++;
+    *word = tk->lower + tk->starts[i];
+    *len = tk->lens[i];
+    return tk->ends[i];
+}
+
+
+// --- Helper Functions ---
+
+// Picks the widest classifier this CPU supports (once per process)
+static void choose_classify(void) {
+#ifdef TOKENIZE_X86
+    classify = __builtin_cpu_supports("avx2") ? classify_avx2 : classify_sse2;
+#else
+    classify = classify_scalar;
+#endif
+}
+
+/*
+ * Classifies blocks until one completes at least one word, filling
+ * tk->starts / tk->ends. Returns false at the end of the html.
+ * Works on locals, since every store into lower may alias *tk.
+ */
+static bool next_block(tokenizer_t *tk) {
+    const char *html = tk->html;
+    char *lower = tk->lower;
+    int len = tk->len;
+    int block = tk->block;
+    int open = tk->open;
+    bool in_tag = tk->in_tag;
+    int skip = tk->skip;
+    int entity = tk->entity;
+    int ref_end = tk->ref_end;
+    int letter_end = tk->letter_end;
+    int num_words = 0;
+
+    while (num_words == 0) {
+        int n = len - block;
+        if (n <= 0) {
+            if (open < 0) {
+                break;
+            }
+            add_word(tk, num_words++, open, len, letter_end, ref_end); // word ran to the very end
+            open = -1;
+            break;
+        }
+
+        uint32_t alpha, lt, gt, amp, high;
+        if (n >= TOKENIZE_BLOCK) {
+            classify(html + block, lower + block, &alpha, &lt, &gt, &amp, &high);
+        } else {
+            // Short last block: pad with NULs, which are neither letters nor tags
+            char in[TOKENIZE_BLOCK] = { 0 };
+            char out[TOKENIZE_BLOCK];
+            memcpy(in, html + block, n);
+            classify(in, out, &alpha, &lt, &gt, &amp, &high);
+            memcpy(lower + block, out, n);
+        }
+        if (high != 0 || letter_end > block) {
+            alpha |= utf8_letters(tk, block, &letter_end, high);
+        }
+
+        uint32_t text = text_mask(tk, block, &in_tag, &skip, lt, gt);
+        uint32_t refs;
+        uint32_t dropped = drop_entities(tk, block, &entity, &ref_end, amp & text, &refs);
+        uint32_t m = ((alpha & ~dropped) | refs) & text; // letters in text
+        uint32_t starts = m & ~((m << 1) | (open >= 0));        // letter after non-letter
+        uint32_t ends = m & ~(m >> 1) & ~(1u << (TOKENIZE_BLOCK - 1)); // letter before non-letter
+
+        // Finish the word carried over from the previous block
+        if (open >= 0) {
+            if (!(m & 1)) {
+                add_word(tk, num_words++, open, block, letter_end, ref_end);
+                open = -1;
+            } else if (ends != 0) {
+                add_word(tk, num_words++, open, block + __builtin_ctz(ends) + 1, letter_end, ref_end);
+                ends &= ends - 1;
+                open = -1;
+            }
+            // else the whole block is one word's middle
+        }
+
+        // Pair every start with the next end; an unpaired start runs on
+        while (starts != 0) {
+            int s = __builtin_ctz(starts);
+            starts &= starts - 1;
+            if (ends != 0) {
+                add_word(tk, num_words++, block + s, block + __builtin_ctz(ends) + 1, letter_end, ref_end);
+                ends &= ends - 1;
+            } else {
+                open = block + s;
+            }
+        }
+        block += TOKENIZE_BLOCK;
+    }
+
+    tk->block = block;
+    tk->open = open;
+    tk->in_tag = in_tag;
+    tk->skip = skip;
+    tk->entity = entity;
+    tk->ref_end = ref_end;
+    tk->letter_end = letter_end;
+    tk->num_words = num_words;
+    tk->next_word = 0;
+    return num_words > 0;
+}
+
+/*
+ * Returns the mask of text bytes in the block at offset block, with
+ * the given '<' and '>' masks: a tag runs from any '<' through the
+ * next '>', and a script, style or comment region from its '<' to
+ * *skip. Updates *in_tag and *skip for the next block.
+ */
+static inline uint32_t text_mask(const tokenizer_t *tk, int block, bool *in_tag, int *skip,
+                                 uint32_t lt, uint32_t gt) {
+    uint32_t text = 0;
+    int b = 0;
+    if (*skip > block) {
+        if (*skip >= block + TOKENIZE_BLOCK) {
+            return 0; // the whole block is inside a region
+        }
+        b = *skip - block;
+    }
+    while (b < TOKENIZE_BLOCK) {
+        uint32_t from = ~0u << b; // bits b and up
+        if (*in_tag) {
+            uint32_t g = gt & from;
+            if (g == 0) {
+                break;
+            }
+            b = __builtin_ctz(g) + 1;
+            *in_tag = false;
+        } else {
+            uint32_t l = lt & from;
+            if (l == 0) {
+                text |= from;
+                break;
+            }
+            int p = __builtin_ctz(l);
+            text |= from & ((1u << p) - 1);
+
+            // Only "<!", "<s" and "<S" can open a region
+            int at = block + p;
+            char next = (at + 1 < tk->len) ? tk->html[at + 1] : '\0';
+            if (next == '!' || (next | 0x20) == 's') {
+                int end = htmllex_skip(tk->html, tk->len, at);
+                if (end > at) {
+                    *skip = end;
+                    if (end >= block + TOKENIZE_BLOCK) {
+                        break;
+                    }
+                    b = end - block;
+                    continue;
+                }
+            }
+            b = p + 1;
+            *in_tag = true;
+        }
+    }
+    return text;
+}
+
+/*
+ * Returns the mask of bytes of the block at offset block that belong
+ * to character references: one running on from an earlier block (up
+ * to *entity), and one for each '&' in amp that starts one. Those of
+ * references to letters go in *refs instead, and the last one's end
+ * in *ref_end (so a reference running on is to a letter when it ends
+ * there too).
+ */
+static inline uint32_t drop_entities(const tokenizer_t *tk, int block, int *entity, int *ref_end,
+                                     uint32_t amp, uint32_t *refs) {
+    uint32_t dropped = 0;
+    *refs = 0;
+    if (*entity > block) {
+        if (*ref_end == *entity) {
+            *refs = span_bits(0, *entity - block);
+        } else {
+            dropped = span_bits(0, *entity - block);
+        }
+    }
+    while (amp != 0) {
+        int p = __builtin_ctz(amp);
+        amp &= amp - 1;
+        uint32_t cp;
+        int n;
+        if (block + p >= *entity && (n = htmllex_entity(tk->html, tk->len, block + p, &cp)) > 0) {
+            *entity = block + p + n;
+            if (utf8_isletter(cp)) {
+                *ref_end = *entity;
+                *refs |= span_bits(p, p + n);
+            } else {
+                dropped |= span_bits(p, p + n);
+            }
+        }
+    }
+    return dropped;
+}
+
+/*
+ * Returns the mask of bytes of the block at offset block that belong
+ * to multibyte letters: one running on from an earlier block (up to
+ * *letter_end), and one for each high byte in high that starts one.
+ */
+static inline uint32_t utf8_letters(const tokenizer_t *tk, int block, int *letter_end, uint32_t high) {
+    uint32_t letters = 0;
+    if (*letter_end > block) {
+        letters = span_bits(0, *letter_end - block);
+    }
+    while (high != 0) {
+        int p = __builtin_ctz(high);
+        high &= high - 1;
+        int n;
+        if (block + p >= *letter_end && (n = utf8_letter(tk->html, tk->len, block + p)) > 0) {
+            *letter_end = block + p + n;
+            letters |= span_bits(p, p + n);
+        }
+    }
+    return letters;
+}
+
+// Bits from through to - 1, clipped to the block
+static inline uint32_t span_bits(int from, int to) {
+    uint32_t below_to = (to >= TOKENIZE_BLOCK) ? ~0u : (1u << to) - 1;
+    return below_to & (~0u << from);
+}
+
+/*
+ * Records word i as html[start..end) and NUL-terminates its lowercased
+ * copy; a word with a multibyte letter (one ending past start, as
+ * letter_end does) also has those folded, and one with a reference to
+ * a letter (as ref_end tells) is decoded from the html and folded.
+ */
+static inline void add_word(tokenizer_t *tk, int i, int start, int end, int letter_end, int ref_end) {
+    int len = end - start;
+    if (ref_end > start) {
+        len = htmllex_decode(tk->html + start, len, tk->lower + start);
+    }
+    tk->starts[i] = start;
+    tk->ends[i] = end;
+    tk->lens[i] = len;
+    tk->lower[start + len] = '\0'; // in the span, or end: a non-letter (or len), already copied
+    if (letter_end > start || ref_end > start) {
+        utf8_fold_span(tk->lower + start, len);
+    }
+}
+
+#ifdef TOKENIZE_X86
+/*
+ * A byte c is an ASCII letter iff (c | 0x20) - 'a' < 26 as unsigned;
+ * SSE2/AVX2 only compare signed bytes, so both sides are offset by 0x80.
+ * OR-ing 0x20 into the letters lowercases them.
+ */
+static void classify_sse2(const char *src, char *dst, uint32_t *alpha, uint32_t *lt, uint32_t *gt,
+                          uint32_t *amp, uint32_t *high) {
+    const __m128i case_bit = _mm_set1_epi8(0x20);
+    const __m128i first = _mm_set1_epi8('a');
+    const __m128i flip = _mm_set1_epi8((char)0x80);
+    const __m128i limit = _mm_set1_epi8((char)(0x80 + 26));
+    *alpha = *lt = *gt = *amp = *high = 0;
+
+    for (int half = 0; half < TOKENIZE_BLOCK; half += 16) {
+        __m128i v = _mm_loadu_si128((const __m128i *)(src + half));
+        __m128i folded = _mm_xor_si128(_mm_sub_epi8(_mm_or_si128(v, case_bit), first), flip);
+        __m128i letter = _mm_cmplt_epi8(folded, limit);
+        _mm_storeu_si128((__m128i *)(dst + half), _mm_or_si128(v, _mm_and_si128(letter, case_bit)));
+
+        *alpha |= (uint32_t)_mm_movemask_epi8(letter) << half;
+        *lt |= (uint32_t)_mm_movemask_epi8(_mm_cmpeq_epi8(v, _mm_set1_epi8('<'))) << half;
+        *gt |= (uint32_t)_mm_movemask_epi8(_mm_cmpeq_epi8(v, _mm_set1_epi8('>'))) << half;
+        *amp |= (uint32_t)_mm_movemask_epi8(_mm_cmpeq_epi8(v, _mm_set1_epi8('&'))) << half;
+        *high |= (uint32_t)_mm_movemask_epi8(v) << half;
+    }
+}
+
+__attribute__((target("avx2")))
+static void classify_avx2(const char *src, char *dst, uint32_t *alpha, uint32_t *lt, uint32_t *gt,
+                          uint32_t *amp, uint32_t *high) {
+    const __m256i case_bit = _mm256_set1_epi8(0x20);
+    const __m256i first = _mm256_set1_epi8('a');
+    const __m256i flip = _mm256_set1_epi8((char)0x80);
+    const __m256i limit = _mm256_set1_epi8((char)(0x80 + 26));
+
+    __m256i v = _mm256_loadu_si256((const __m256i *)src);
+    __m256i folded = _mm256_xor_si256(_mm256_sub_epi8(_mm256_or_si256(v, case_bit), first), flip);
+    __m256i letter = _mm256_cmpgt_epi8(limit, folded);
+    _mm256_storeu_si256((__m256i *)dst, _mm256_or_si256(v, _mm256_and_si256(letter, case_bit)));
+
+    *alpha = (uint32_t)_mm256_movemask_epi8(letter);
+    *lt = (uint32_t)_mm256_movemask_epi8(_mm256_cmpeq_epi8(v, _mm256_set1_epi8('<')));
+    *gt = (uint32_t)_mm256_movemask_epi8(_mm256_cmpeq_epi8(v, _mm256_set1_epi8('>')));
+    *amp = (uint32_t)_mm256_movemask_epi8(_mm256_cmpeq_epi8(v, _mm256_set1_epi8('&')));
+    *high = (uint32_t)_mm256_movemask_epi8(v);
+}
+#else
+// One byte at a time, for CPUs without a vector classifier
+static void classify_scalar(const char *src, char *dst, uint32_t *alpha, uint32_t *lt, uint32_t *gt,
+                            uint32_t *amp, uint32_t *high) {
+    *alpha = *lt = *gt = *amp = *high = 0;
+    for (int i = 0; i < TOKENIZE_BLOCK; i++) {
+        unsigned char c = src[i];
+        bool letter = (unsigned char)((c | 0x20) - 'a') < 26;
+        dst[i] = letter ? (c | 0x20) : c;
+        *alpha |= (uint32_t)letter << i;
+        *lt |= (uint32_t)(c == '<') << i;
+        *gt |= (uint32_t)(c == '>') << i;
+        *amp |= (uint32_t)(c == '&') << i;
+        *high |= (uint32_t)(c >= 0x80) << i;
+    }
+}
+#endif
@@ -0,0 +1,64 @@
+/*
+ * tokenize.h - header file for the vectorized word tokenizer
+ *
+ * Author: Insecticide
+ * Date: 10-17-2026
+ *
+ * Description: Finds the same words as webpage_getNextWordSpan() --
+ * runs of letters (and references to letters, e.g. &eacute;) outside
+ * <...> tags, script and style elements, comments and other character
+ * references (see htmllex.h) -- but classifies
+ * the html 32 bytes at a time (SSE2, or AVX2 where the CPU has it)
+ * into letter, '<', '>', '&' and high-byte bitmasks, and writes a
+ * lowercased copy of each block in the same pass. Letters are ASCII
+ * or UTF-8 (see utf8.h); blocks of pure ASCII take no detour for them.
+ * Words come back lowercased (UTF-8 ones folded, references decoded)
+ * and NUL-terminated, as spans into that copy, with no allocation per
+ * word. A word starts in lower where it starts in html, but one with a
+ * reference is shorter than its span of the html.
+ *
+ * Unlike the scalar tokenizer, the html is bounded by its length
+ * rather than by its first NUL, so a stray NUL byte is just a
+ * separator. On html without NULs the two find identical words.
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#define TOKENIZE_BLOCK 32 // bytes classified at a time
+
+typedef struct tokenizer {
+    const char *html;   // text being tokenized
+    int len;            // its length
+    char *lower;        // lowercased copy, len + 1 bytes (the caller's)
+    int block;          // offset of the next block to classify
+    bool in_tag;        // the last block ended inside <...>
+    int skip;           // end of the script/style/comment region last seen
+    int entity;         // end of the character reference last seen
+    int ref_end;        // end of the last one that was to a letter
+    int letter_end;     // end of the multibyte letter last seen
+    int open;           // start of a word running past the last block, or -1
+    int num_words;      // words found in the last block...
+    int next_word;      // ...and the next one to return
+    int starts[TOKENIZE_BLOCK / 2 + 1];
+    int ends[TOKENIZE_BLOCK / 2 + 1];
+    int lens[TOKENIZE_BLOCK / 2 + 1];
+} tokenizer_t;
+
+/*
+ * tokenizer_init - Starts tokenizing html[0..len). lower must have
+ * room for len + 1 bytes; it receives the lowercased words.
+ */
+void tokenizer_init(tokenizer_t *tk, const char *html, int len, char *lower);
+
+/*
+ * tokenizer_next - Finds the next word.
+ * @word: set to the lowercased, NUL-terminated word, inside lower,
+ *        at the offset where it starts in html.
+ * @len: set to its length.
+ * Returns the offset in html just past the word, or -1 when there are
+ * no more words.
+ */
+int tokenizer_next(tokenizer_t *tk, const char **word, int *len);
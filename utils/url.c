@@ -0,0 +1,401 @@
+/*
+ * url.c - implementation of the span-based URL normalizer
+ *
+ * Author: Insecticide
+ * Date: 10-17-2026
+ *
+ * Description: A URL is split into spans (scheme, user, host, path,
+ * query, fragment) by the rules of webpage.c's ParseURL(), and put
+ * back together straight into the output buffer; dot segments are
+ * removed from the path as it is copied (RFC 3986 5.2.4). See url.h.
+ */
+
+#define _POSIX_C_SOURCE 200809L // strncasecmp
+
+#include <stdbool.h>
+#include <string.h>
+#include <strings.h>
+#include "url.h"
+
+// The parts of an absolute URL, as offsets into it ([x, x_end))
+typedef struct url_parts {
+    int scheme_end;   // just past ':' or "://"; the scheme starts at 0
+    int host;         // just past any "user@"
+    int host_end;     // at the path's '/', or the end
+    int path_end;     // at '?' or '#', or the end
+    int query;        // at '?', or -1
+    int query_end;
+    int frag;         // at '#', or -1
+} url_parts_t;
+
+// Accepted page extensions (the same list as webpage.c's EXTS)
+static const char *const exts[] = { "html", "jsp", "php" };
+#define NUM_EXTS (sizeof(exts) / sizeof(exts[0]))
+
+// Output buffer being filled
+typedef struct out {
+    char *p;
+    int len;
+    int cap;
+} out_t;
+
+// --- Static helper function prototypes ---
+static int scheme_colon(const char *s, int len);
+static bool parse(const char *url, int len, url_parts_t *parts);
+static void set_base(url_base_t *b, const char *base);
+static int join(const url_base_t *b, const char *rel, int len, char *out, int cap);
+static int resolve_link(const url_base_t *b, const char *href, int len, char *out, int cap);
+static bool good_extension(const char *path, int len);
+static void put(out_t *o, const char *s, int len);
+static void put_lower(out_t *o, const char *s, int len);
+static void put_path(out_t *o, const char *path, int len);
+static int finish(out_t *o);
+static uint32_t hash_span(const char *s, int len);
+static inline bool is_space(char c);
+
+/*
+ * url_normalize - Puts the parts of url back together, lowercasing the
+ * scheme and host and removing dot segments from the path.
+ */
+int url_normalize(const char *url, int len, char *out, int cap) {
+    url_parts_t u;
+    if (!parse(url, len, &u)) {
+        return URL_INVALID;
+    }
+    if (!good_extension(url + u.host_end, u.path_end - u.host_end)) {
+        return URL_INVALID;
+    }
+
+    out_t o = { out, 0, cap };
+    put_lower(&o, url, u.scheme_end);
+    put(&o, url + u.scheme_end, u.host - u.scheme_end); // user, if any
+    put_lower(&o, url + u.host, u.host_end - u.host);
+    put_path(&o, url + u.host_end, u.path_end - u.host_end);
+    if (u.query >= 0) {
+        put(&o, url + u.query, u.query_end - u.query);
+    }
+    if (u.frag >= 0) {
+        put(&o, url + u.frag, len - u.frag);
+    }
+    return finish(&o);
+}
+
+/*
+ * url_resolve - Splits base, then joins rel to it.
+ */
+int url_resolve(const char *base, const char *rel, int len, char *out, int cap) {
+    url_base_t b;
+    set_base(&b, base);
+    return join(&b, rel, len, out, cap);
+}
+
+/*
+ * url_resolve_link - Condenses href (no whitespace, no fragment),
+ * resolves it if it is relative, and normalizes the result.
+ */
+int url_resolve_link(const char *base, const char *href, int len, char *out, int cap) {
+    url_base_t b;
+    set_base(&b, base);
+    return resolve_link(&b, href, len, out, cap);
+}
+
+/*
+ * url_memo_reset - Splits the new base once for all its links; a new
+ * generation makes every slot stale at once.
+ */
+void url_memo_reset(url_memo_t *memo, const char *base) {
+    set_base(&memo->base, base);
+    memo->arena_used = 0;
+    if (++memo->gen == 0) { // wrapped: stale slots could look current
+        memset(memo->slots, 0, sizeof(memo->slots));
+        memo->gen = 1;
+    }
+}
+
+/*
+ * url_memo_resolve - Looks href up by its bytes (linear probing);
+ * resolves and remembers it on a miss while there is room.
+ */
+int url_memo_resolve(url_memo_t *memo, const char *href, int len, const char **url) {
+    uint32_t hash = hash_span(href, len);
+    int slot = hash & (URL_MEMO_SLOTS - 1);
+    int probes = 0;
+    while (memo->slots[slot].gen == memo->gen) {
+        if (memo->slots[slot].hash == hash && memo->slots[slot].href_len == len &&
+            memcmp(memo->slots[slot].href, href, len) == 0) {
+            *url = memo->arena + memo->slots[slot].url;
+            return memo->slots[slot].url_len;
+        }
+        slot = (slot + 1) & (URL_MEMO_SLOTS - 1);
+        if (++probes == URL_MEMO_SLOTS) {
+            break; // full
+        }
+    }
+
+    int url_len = resolve_link(&memo->base, href, len, memo->buf, sizeof(memo->buf));
+    *url = memo->buf;
+    if (url_len == URL_TOOLONG || probes == URL_MEMO_SLOTS) {
+        return url_len;
+    }
+    int need = (url_len < 0) ? 1 : url_len + 1;
+    if (memo->arena_used + need > URL_MEMO_ARENA) {
+        return url_len;
+    }
+
+    char *kept = memo->arena + memo->arena_used;
+    if (url_len < 0) {
+        kept[0] = '\0';
+    } else {
+        memcpy(kept, memo->buf, need);
+    }
+    memo->slots[slot].gen = memo->gen;
+    memo->slots[slot].hash = hash;
+    memo->slots[slot].href = href;
+    memo->slots[slot].href_len = len;
+    memo->slots[slot].url = memo->arena_used;
+    memo->slots[slot].url_len = url_len;
+    memo->arena_used += need;
+    *url = kept;
+    return url_len;
+}
+
+
+// --- Helper Functions ---
+
+// Index of the ':' ending the scheme of s[0..len), or -1 if it is not absolute
+static int scheme_colon(const char *s, int len) {
+    for (int i = 0; i < len; i++) {
+        switch (s[i]) {
+        case ':': return i;
+        case '/': case '?': case '#': return -1;
+        }
+    }
+    return -1;
+}
+
+/*
+ * Fills b from the absolute url base, as FixupRelativeURL() would use
+ * it: scheme, user and host (lowercased) for links starting with '/',
+ * and those plus the path up to its last '/' for other links.
+ */
+static void set_base(url_base_t *b, const char *base) {
+    url_parts_t u;
+    int len = strlen(base);
+    if (!parse(base, len, &u)) {
+        b->root_len = b->dir_len = URL_INVALID;
+        return;
+    }
+
+    out_t o = { b->prefix, 0, sizeof(b->prefix) };
+    put_lower(&o, base, u.scheme_end);
+    put(&o, base + u.scheme_end, u.host - u.scheme_end); // user, if any
+    put_lower(&o, base + u.host, u.host_end - u.host);
+    b->root_len = o.len;
+
+    int slash = u.path_end - 1;
+    while (slash > u.host_end && base[slash] != '/') {
+        slash--;
+    }
+    if (slash > u.host_end) {
+        put(&o, base + u.host_end, slash - u.host_end);
+    }
+    put(&o, "/", 1);
+    b->dir_len = o.len;
+    if (finish(&o) < 0) {
+        b->root_len = b->dir_len = URL_TOOLONG;
+    }
+}
+
+// Joins rel[0..len) (up to any NUL) to b, as FixupRelativeURL() does
+static int join(const url_base_t *b, const char *rel, int len, char *out, int cap) {
+    if (b->root_len < 0) {
+        return b->root_len;
+    }
+    const char *nul = memchr(rel, '\0', len);
+    if (nul != NULL) {
+        len = nul - rel;
+    }
+    out_t o = { out, 0, cap };
+    put(&o, b->prefix, (len > 0 && rel[0] == '/') ? b->root_len : b->dir_len);
+    put(&o, rel, len);
+    return finish(&o);
+}
+
+// url_resolve_link() against an already split base
+static int resolve_link(const url_base_t *b, const char *href, int len, char *out, int cap) {
+    char link[URL_MAXLEN];
+    int n = 0;
+    for (int i = 0; i < len && href[i] != '#' && href[i] != '\0'; i++) {
+        if (!is_space(href[i])) {
+            if (n == URL_MAXLEN) {
+                return URL_TOOLONG;
+            }
+            link[n++] = href[i];
+        }
+    }
+    if (n == 0) {
+        return URL_INVALID; // empty link or same-page reference
+    }
+
+    // absolute if ':' comes before any '/', '?' or '#'
+    if (scheme_colon(link, n) >= 0) {
+        if (n < 4 || strncasecmp(link, "http", 4) != 0) {
+            return URL_INVALID;
+        }
+        return url_normalize(link, n, out, cap);
+    }
+
+    char abs_url[URL_MAXLEN];
+    int abs_len = join(b, link, n, abs_url, sizeof(abs_url));
+    if (abs_len < 0) {
+        return abs_len;
+    }
+    return url_normalize(abs_url, abs_len, out, cap);
+}
+
+/*
+ * Splits the absolute url[0..len) as ParseURL() does. Returns false if
+ * it is not absolute, or if a '?' or '#' comes before its path.
+ */
+static bool parse(const char *url, int len, url_parts_t *u) {
+    int colon = scheme_colon(url, len);
+    if (colon < 0) {
+        return false;
+    }
+    int pos = colon + 1;
+    if (len - pos >= 2 && url[pos] == '/' && url[pos + 1] == '/') {
+        pos += 2;
+    }
+    u->scheme_end = pos;
+
+    // first '@' before any '/', first '/', '?' and '#', in one pass
+    int at = -1, slash = len, query = len, frag = len;
+    for (int i = pos; i < len; i++) {
+        switch (url[i]) {
+        case '@': if (at < 0 && slash == len) at = i; break;
+        case '/': if (slash == len) slash = i; break;
+        case '?': if (query == len) query = i; break;
+        case '#': if (frag == len) frag = i; break;
+        }
+    }
+    u->host = (at >= 0) ? at + 1 : pos;
+    u->host_end = slash;
+    u->path_end = (query < frag) ? query : frag;
+    if (u->path_end < u->host_end) {
+        return false;
+    }
+    u->query = (query < frag) ? query : -1;
+    u->query_end = frag;
+    u->frag = (frag < len) ? frag : -1;
+    return true;
+}
+
+// Whether path's last segment has no extension, or starts with an accepted one
+static bool good_extension(const char *path, int len) {
+    int i = len - 1;
+    while (i >= 0 && path[i] != '.' && path[i] != '/') {
+        i--;
+    }
+    if (i < 0 || path[i] != '.' || i == len - 1) {
+        return true;
+    }
+    // a '.' after the last '/'; NormalizeURL also wants some '/' before it
+    int slash = i;
+    while (slash >= 0 && path[slash] != '/') {
+        slash--;
+    }
+    if (slash < 0) {
+        return true;
+    }
+    const char *ext = path + i + 1;
+    int ext_len = len - i - 1;
+    for (size_t e = 0; e < NUM_EXTS; e++) {
+        int n = strlen(exts[e]);
+        if (ext_len >= n && strncasecmp(ext, exts[e], n) == 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// Appends s[0..len) if it fits; once something does not, o->len passes o->cap
+static void put(out_t *o, const char *s, int len) {
+    if (o->len + len < o->cap) {
+        memcpy(o->p + o->len, s, len);
+    }
+    o->len += len;
+}
+
+// put(), lowercasing (ASCII, as tolower() does in the C locale)
+static void put_lower(out_t *o, const char *s, int len) {
+    if (o->len + len < o->cap) {
+        for (int i = 0; i < len; i++) {
+            char c = s[i];
+            o->p[o->len + i] = (c >= 'A' && c <= 'Z') ? c + ('a' - 'A') : c;
+        }
+    }
+    o->len += len;
+}
+
+/*
+ * put(), removing the dot segments of a path starting with '/' as
+ * RemoveDotSegments() does: "/./" and a final "/." become "/", and
+ * "/../" and a final "/.." become "/" after dropping the last segment
+ * already written (but never anything before the path).
+ */
+static void put_path(out_t *o, const char *path, int len) {
+    if (o->len + len >= o->cap) {
+        o->len += len; // the result can be no longer than the path
+        return;
+    }
+    char *out = o->p;
+    int start = o->len, n = o->len;
+    int i = 0;
+    while (i < len) {
+        int rest = len - i;
+        if (rest >= 3 && memcmp(path + i, "/./", 3) == 0) {
+            i += 2;
+        } else if (rest == 2 && memcmp(path + i, "/.", 2) == 0) {
+            out[n++] = '/';
+            break;
+        } else if ((rest >= 4 && memcmp(path + i, "/../", 4) == 0) ||
+                   (rest == 3 && memcmp(path + i, "/..", 3) == 0)) {
+            while (n > start && out[--n] != '/') {
+                ;
+            }
+            if (rest == 3) {
+                out[n++] = '/';
+                break;
+            }
+            i += 3;
+        } else {
+            do {
+                out[n++] = path[i++];
+            } while (i < len && path[i] != '/');
+        }
+    }
+    o->len = n;
+}
+
+// NUL-terminates the output; returns its length, or URL_TOOLONG
+static int finish(out_t *o) {
+    if (o->len >= o->cap) {
+        return URL_TOOLONG;
+    }
+    o->p[o->len] = '\0';
+    return o->len;
+}
+
+// isspace() in the C locale, without the call
+static inline bool is_space(char c) {
+    return c == ' ' || (c >= '\t' && c <= '\r');
+}
+
+// FNV-1a
+static uint32_t hash_span(const char *s, int len) {
+    uint32_t h = 2166136261u;
+    for (int i = 0; i < len; i++) {
+        h = (h ^ (unsigned char)s[i]) * 16777619u;
+    }
+    return h;
+}
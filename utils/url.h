@@ -0,0 +1,101 @@
+/*
+ * url.h - header file for the span-based URL normalizer
+ *
+ * Author: Insecticide
+ * Date: 10-17-2026
+ *
+ * Description: Resolves and normalizes URLs exactly as
+ * webpage_resolveURL(), FixupRelativeURL() and NormalizeURL() do, but
+ * reads (pointer, length) spans and writes into a buffer the caller
+ * provides, so nothing is allocated per URL. url_memo_t remembers the
+ * links already resolved against one page, since pages repeat the same
+ * navigation links many times.
+ *
+ * The webpage functions remain the reference (test/urltest.c checks
+ * the two agree). URLs that the old parser cannot make sense of -- a
+ * '?' or '#' before the end of the host -- are rejected here.
+ */
+
+#pragma once
+
+#include <stdint.h>
+
+#define URL_MAXLEN 2048   // buffer size that fits any URL the crawler follows
+#define URL_INVALID (-1)  // not a URL to follow
+#define URL_TOOLONG (-2)  // did not fit the caller's buffer
+
+/*
+ * url_normalize - Normalizes the absolute url[0..len) as NormalizeURL()
+ * does: scheme and host lowercased, . and .. path segments removed,
+ * and only pages with no extension or an html-like one accepted.
+ * Writes the result, NUL-terminated, to out (cap bytes).
+ * Returns its length, URL_INVALID, or URL_TOOLONG.
+ */
+int url_normalize(const char *url, int len, char *out, int cap);
+
+/*
+ * url_resolve - Resolves the relative url rel[0..len) against the
+ * absolute url base as FixupRelativeURL() does, without normalizing.
+ * Writes the result, NUL-terminated, to out (cap bytes).
+ * Returns its length, URL_INVALID if base cannot be parsed, or
+ * URL_TOOLONG.
+ */
+int url_resolve(const char *base, const char *rel, int len, char *out, int cap);
+
+/*
+ * url_resolve_link - Turns a link found on the page at base into the
+ * URL to follow: webpage_resolveURL() followed by NormalizeURL().
+ * Writes the result, NUL-terminated, to out (cap bytes).
+ * Returns its length, URL_INVALID, or URL_TOOLONG.
+ */
+int url_resolve_link(const char *base, const char *href, int len, char *out, int cap);
+
+#define URL_MEMO_SLOTS 256        // links remembered per page (a power of 2)
+#define URL_MEMO_ARENA (32 * 1024) // bytes for their resolved URLs
+
+/*
+ * url_base_t: a base URL split once for resolving many links against:
+ * prefix[0..root_len) goes before links starting with '/', and
+ * prefix[0..dir_len) (ending in '/') before other relative links.
+ * root_len is URL_INVALID or URL_TOOLONG if the base is unusable.
+ */
+typedef struct url_base {
+    int root_len;
+    int dir_len;
+    char prefix[URL_MAXLEN];
+} url_base_t;
+
+/*
+ * url_memo_t: the links of one page resolved so far. Keys are the
+ * link spans themselves, so the page must outlive the memo's use.
+ * Large (about 45kB): allocate one and reuse it, page after page.
+ */
+typedef struct url_memo {
+    url_base_t base;            // url of the page, split
+    uint32_t gen;               // slots from earlier pages have older gens
+    int arena_used;
+    struct {
+        uint32_t gen;
+        uint32_t hash;
+        const char *href;       // key, in the page's html
+        int href_len;
+        int url;                // offset of the result in arena
+        int url_len;            // its length, or URL_INVALID
+    } slots[URL_MEMO_SLOTS];
+    char arena[URL_MEMO_ARENA];
+    char buf[URL_MAXLEN];       // result that did not fit the arena
+} url_memo_t;
+
+/*
+ * url_memo_reset - Forgets every link and starts on the page at base.
+ * Zero the memo before its first reset.
+ */
+void url_memo_reset(url_memo_t *memo, const char *base);
+
+/*
+ * url_memo_resolve - url_resolve_link() on href[0..len), remembered.
+ * @url: set to the NUL-terminated result, inside the memo; valid until
+ *       the next call.
+ * Returns the result's length, URL_INVALID, or URL_TOOLONG.
+ */
+int url_memo_resolve(url_memo_t *memo, const char *href, int len, const char **url);
@@ -0,0 +1,216 @@
+/*
+ * utf8.c - implementation of UTF-8 letters and case folding
+ *
+ * Author: Insecticide
+ * Date: 10-17-2026
+ *
+ * Description: Letters are a sorted table of code point ranges,
+ * searched by bisection; folding is a short table of ranges whose
+ * capitals sit at a fixed offset from their lowercase letters, or
+ * alternate with them. See utf8.h.
+ */
+
+#include <stddef.h>
+#include "utf8.h"
+
+// Code points lo..hi
+typedef struct range {
+    uint32_t lo;
+    uint32_t hi;
+} range_t;
+
+static const range_t letters[] = {
+    { 'A', 'Z' }, { 'a', 'z' },
+    { 0x00AA, 0x00AA }, { 0x00B5, 0x00B5 }, { 0x00BA, 0x00BA },
+    { 0x00C0, 0x00D6 }, { 0x00D8, 0x00F6 }, { 0x00F8, 0x02AF }, // Latin-1, Extended-A/B, IPA
+    { 0x0300, 0x036F },                                         // combining accents
+    { 0x0370, 0x0373 }, { 0x0376, 0x0377 }, { 0x037B, 0x037D }, // Greek
+    { 0x0386, 0x0386 }, { 0x0388, 0x03F5 }, { 0x03F7, 0x03FF },
+    { 0x0400, 0x0481 }, { 0x048A, 0x052F },                     // Cyrillic
+    { 0x0531, 0x0556 }, { 0x0561, 0x0587 },                     // Armenian
+    { 0x05D0, 0x05EA },                                         // Hebrew
+    { 0x0620, 0x064A },                                         // Arabic
+    { 0x1E00, 0x1EFF },                                         // Latin Extended Additional
+    { 0x3041, 0x3096 }, { 0x30A1, 0x30FA },                     // Hiragana, Katakana
+    { 0x4E00, 0x9FFF },                                         // CJK ideographs
+    { 0xAC00, 0xD7A3 }                                          // Hangul syllables
+};
+
+// Capitals in lo..hi: each is offset below its lowercase letter, or,
+// with offset 0, the capitals are the even (or odd) code points and
+// each is followed by its lowercase letter
+typedef struct fold {
+    uint32_t lo;
+    uint32_t hi;
+    int offset;
+    int parity;  // for offset 0: 0 if capitals are even, 1 if odd
+} fold_t;
+
+static const fold_t folds[] = {
+    { 'A', 'Z', 0x20, 0 },
+    { 0x00C0, 0x00D6, 0x20, 0 }, { 0x00D8, 0x00DE, 0x20, 0 },
+    { 0x0100, 0x012F, 0, 0 }, { 0x0132, 0x0137, 0, 0 }, { 0x0139, 0x0148, 0, 1 },
+    { 0x014A, 0x0177, 0, 0 }, { 0x0178, 0x0178, 0x00FF - 0x0178, 0 }, { 0x0179, 0x017E, 0, 1 },
+    { 0x0386, 0x0386, 0x26, 0 }, { 0x0388, 0x038A, 0x25, 0 }, { 0x038C, 0x038C, 0x40, 0 },
+    { 0x038E, 0x038F, 0x3F, 0 }, { 0x0391, 0x03A1, 0x20, 0 }, { 0x03A3, 0x03AB, 0x20, 0 },
+    { 0x0400, 0x040F, 0x50, 0 }, { 0x0410, 0x042F, 0x20, 0 },
+    { 0x0460, 0x0481, 0, 0 }, { 0x048A, 0x04BF, 0, 0 }, { 0x04D0, 0x052F, 0, 0 },
+    { 0x0531, 0x0556, 0x30, 0 },
+    { 0x1E00, 0x1E95, 0, 0 }, { 0x1EA0, 0x1EFF, 0, 0 }
+};
+
+#define COUNT(a) ((int)(sizeof(a) / sizeof(a[0])))
+
+// --- Static helper function prototypes ---
+static const range_t *find_range(const range_t *ranges, int n, uint32_t cp);
+static void encode(uint32_t cp, int n, char *out);
+
+/*
+ * utf8_decode - Checks the lead byte, then each continuation byte,
+ * then that the sequence was the shortest form of a valid code point.
+ */
+int utf8_decode(const char *s, int len, int pos, uint32_t *cp) {
+    static const uint32_t min[] = { 0, 0, 0x80, 0x800, 0x10000 };
+    const unsigned char *p = (const unsigned char *)s + pos;
+    unsigned char c = p[0];
+    int n;
+    uint32_t value;
+    if (c < 0x80) {
+        *cp = c;
+        return 1;
+    } else if ((c & 0xE0) == 0xC0) {
+        n = 2;
+        value = c & 0x1F;
+    } else if ((c & 0xF0) == 0xE0) {
+        n = 3;
+        value = c & 0x0F;
+    } else if ((c & 0xF8) == 0xF0) {
+        n = 4;
+        value = c & 0x07;
+    } else {
+        return 0; // a continuation byte, or 0xF8 and up
+    }
+    if (pos + n > len) {
+        return 0;
+    }
+    for (int i = 1; i < n; i++) {
+        if ((p[i] & 0xC0) != 0x80) {
+            return 0;
+        }
+        value = (value << 6) | (p[i] & 0x3F);
+    }
+    if (value < min[n] || value > 0x10FFFF || (value >= 0xD800 && value <= 0xDFFF)) {
+        return 0;
+    }
+    *cp = value;
+    return n;
+}
+
+/*
+ * utf8_isletter - Bisects the letters table.
+ */
+bool utf8_isletter(uint32_t cp) {
+    return find_range(letters, COUNT(letters), cp) != NULL;
+}
+
+/*
+ * utf8_fold - Looks cp up in the folds table.
+ */
+uint32_t utf8_fold(uint32_t cp) {
+    for (int i = 0; i < COUNT(folds); i++) {
+        const fold_t *f = &folds[i];
+        if (cp < f->lo) {
+            break;
+        }
+        if (cp <= f->hi) {
+            if (f->offset != 0) {
+                return cp + f->offset;
+            }
+            return ((int)(cp & 1) == f->parity) ? cp + 1 : cp;
+        }
+    }
+    return cp;
+}
+
+/*
+ * utf8_encode - Picks the length from the code point.
+ */
+int utf8_encode(uint32_t cp, char *out) {
+    int n = (cp < 0x80) ? 1 : (cp < 0x800) ? 2 : (cp < 0x10000) ? 3 : 4;
+    if (n == 1) {
+        out[0] = (char)cp;
+    } else {
+        encode(cp, n, out);
+    }
+    return n;
+}
+
+/*
+ * utf8_letter - ASCII by arithmetic, anything else by decoding.
+ */
+int utf8_letter(const char *s, int len, int pos) {
+    unsigned char c = s[pos];
+    if (c < 0x80) {
+        return (unsigned char)((c | 0x20) - 'a') < 26;
+    }
+    uint32_t cp;
+    int n = utf8_decode(s, len, pos, &cp);
+    return (n > 0 && utf8_isletter(cp)) ? n : 0;
+}
+
+/*
+ * utf8_fold_span - Folds character by character, rewriting those that
+ * change.
+ */
+void utf8_fold_span(char *s, int len) {
+    for (int i = 0; i < len; ) {
+        unsigned char c = s[i];
+        if (c < 0x80) {
+            if ((unsigned char)(c - 'A') < 26) {
+                s[i] = c | 0x20;
+            }
+            i++;
+            continue;
+        }
+        uint32_t cp;
+        int n = utf8_decode(s, len, i, &cp);
+        if (n == 0) {
+            i++;
+            continue;
+        }
+        uint32_t folded = utf8_fold(cp);
+        if (folded != cp) {
+            encode(folded, n, s + i);
+        }
+        i += n;
+    }
+}
+
+
+// --- Helper Functions ---
+
+// The range of the sorted ranges[0..n) that holds cp, or NULL
+static const range_t *find_range(const range_t *ranges, int n, uint32_t cp) {
+    int lo = 0, hi = n - 1;
+    while (lo <= hi) {
+        int mid = (lo + hi) / 2;
+        if (cp < ranges[mid].lo) {
+            hi = mid - 1;
+        } else if (cp > ranges[mid].hi) {
+            lo = mid + 1;
+        } else {
+            return &ranges[mid];
+        }
+    }
+    return NULL;
+}
+
+// Writes cp as the n-byte sequence it was decoded from
+static void encode(uint32_t cp, int n, char *out) {
+    static const unsigned char lead[] = { 0, 0, 0xC0, 0xE0, 0xF0 };
+    for (int i = n - 1; i > 0; i--) {
+        out[i] = (char)(0x80 | (cp & 0x3F));
+        cp >>= 6;
+    }
+    out[0] = (char)(lead[n] | cp);
+}
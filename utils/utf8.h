@@ -0,0 +1,58 @@
+/*
+ * utf8.h - header file for UTF-8 letters and case folding
+ *
+ * Author: Insecticide
+ * Date: 10-17-2026
+ *
+ * Description: The one definition of a letter that every word finder
+ * shares (the tokenizers, the html lexer and the querier): an ASCII
+ * letter, or a well-formed UTF-8 sequence for a letter of the Latin,
+ * Greek, Cyrillic, Armenian, Hebrew, Arabic, CJK, kana or Hangul
+ * blocks (combining accents included). Any other byte -- punctuation,
+ * a quote like U+2019, a stray or malformed high byte -- separates
+ * words.
+ *
+ * Folding lowercases ASCII and the Latin, Greek, Cyrillic and
+ * Armenian capitals whose lowercase letter has an encoding of the same
+ * length, so a word can be folded in place without moving its bytes.
+ * Locale settings play no part.
+ */
+
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/*
+ * utf8_decode - Decodes the character at s[pos], reading no further
+ * than s[len - 1].
+ * @cp: set to its code point.
+ * Returns its length in bytes (1 for ASCII), or 0 if s[pos] does not
+ * start a well-formed sequence (overlong forms and surrogates are not).
+ */
+int utf8_decode(const char *s, int len, int pos, uint32_t *cp);
+
+/* utf8_isletter -- whether cp counts as a letter in words */
+bool utf8_isletter(uint32_t cp);
+
+/* utf8_fold -- the lowercase of cp, or cp; encoded in as many bytes */
+uint32_t utf8_fold(uint32_t cp);
+
+/*
+ * utf8_encode - Writes cp (at most 0x10FFFF) to out as UTF-8, in the
+ * shortest form. Returns its length in bytes, 1 to 4.
+ */
+int utf8_encode(uint32_t cp, char *out);
+
+/*
+ * utf8_letter - The length in bytes of the letter at s[pos] (reading
+ * no further than s[len - 1]), or 0 if there is none there. ASCII is
+ * decided without decoding.
+ */
+int utf8_letter(const char *s, int len, int pos);
+
+/*
+ * utf8_fold_span - Folds every character of s[0..len) in place; the
+ * length does not change. Malformed bytes are left as they are.
+ */
+void utf8_fold_span(char *s, int len);
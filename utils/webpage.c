@@ -17,8 +17,10 @@
 #include <string.h>
 #include <ctype.h>
 #include <unistd.h>
+#include <sys/mman.h>
 #include <curl/curl.h>
 #include "webpage.h"
+#include "htmllex.h"
 
 /* Private Section */
 
@@ -30,6 +32,8 @@ typedef struct webpage {
   char *html;                              // html code of the page
   size_t html_len;                         // length of html code
   int depth;                               // depth of crawl
+  void *map;                               // mapping the html lies in, or NULL
+  size_t map_len;                          // length of that mapping
 } webpage_t;
 
 struct URL {
@@ -41,6 +45,17 @@ struct URL {
     char* fragment;	      // #top
 };
 
+/* fetch_buffer_t: where curl writes a page body as it arrives.
+ * page->html holds capacity bytes, grown geometrically; capacity is
+ * pre-sized from Content-Length when the server sends one.
+ */
+typedef struct fetch_buffer {
+  webpage_t *page;                         // page whose html is filled
+  CURL *curl;                              // transfer, to ask for Content-Length
+  size_t capacity;                         // bytes allocated for page->html
+  bool too_large;                          // body went over max_body
+} fetch_buffer_t;
+
 /* Private function prototypes */
 static char *RemoveDotSegments(char *input);
 static void RemoveWhitespace(char* str);
@@ -49,6 +64,8 @@ static char *FixupRelativeURL(char *base, char *rel, size_t len);
 static void *checkp(void *p, char *message);
 
 /* Private global variables */
+static size_t max_body = 0;              // fetch size cap, 0 for none
+#define MIN_BUFFER (16 * 1024)           // first allocation without Content-Length
 #define NUM_EXTS (3)			 // size of EXTS array
 static const char* EXTS[NUM_EXTS] = {	 // valid extensions
   "html",
@@ -74,6 +91,20 @@ webpage_t *webpage_new(char *url, const int depth, char *html) {
   page->depth = depth;
   page->html = html;
   page->html_len = html ? strlen(html) : 0;
+  page->map = NULL;
+  page->map_len = 0;
+  return page;
+}
+
+webpage_t *webpage_newmapped(char *url, const int depth, char *html, void *map, size_t map_len) {
+  if (html == NULL || map == NULL) {
+    return NULL;
+  }
+  webpage_t *page = webpage_new(url, depth, html);
+  if (page != NULL) {
+    page->map = map;
+    page->map_len = map_len;
+  }
   return page;
 }
 
@@ -83,7 +114,8 @@ void webpage_delete(void *data)
   webpage_t *page = data;
   if (page != NULL) {
     if (page->url) free(page->url);
-    if (page->html) free(page->html);
+    if (page->map) munmap(page->map, page->map_len);
+    else if (page->html) free(page->html);
     free(page);
   }
 }
@@ -96,33 +128,78 @@ void webpage_delete(void *data)
  *   cleaned by David Kotz in April 2016, 2017.
  *
  * Pseudocode:
- *     1. skip any leading non-alphabetic characters
- *     2. if we find a tag, i.e., <...tag...>, skip that tag
- *     3. save beginning of the word
- *     4. find the end, i.e., first non-alphabetic character
- *     5. create a new word buffer
- *     6. copy the word into the new buffer
- *     7. return first position past end of word
+ *     1. find the next word with webpage_getNextWordSpan
+ *     2. create a new word buffer
+ *     3. copy the word into the new buffer, decoding its references
+ *     4. return first position past end of word
  * 
  */
 int webpage_getNextWord(webpage_t *page, int pos, char **word) {
+  // make sure we have a place for the result
+  if (word == NULL) {
+    return -1;
+  }
+
+  const char *beg;                         // beginning of word
+  int wordlen;                             // length of word
+  pos = webpage_getNextWordSpan(page, pos, &beg, &wordlen);
+  if (pos < 0) {
+    *word = NULL;
+    return -1;
+  }
+
+  // allocate space for length of new word + '\0'
+  *word = calloc(wordlen + 1, sizeof(char));
+  if (*word == NULL) {	      // out of memory!
+    return -1;
+  }
+
+  // copy the new word, with any &eacute; etc. as the letter itself
+  htmllex_decode(beg, wordlen, *word);
+
+  return pos;
+}
+
+/**************** webpage_getNextWordSpan ****************/
+/*
+ * webpage_getNextWordSpan - finds the next word from doc[pos], in place
+ * See "webpage.h" for full documentation.
+ *
+ * Pseudocode:
+ *     1. skip any leading non-letters (see htmllex_letter)
+ *     2. if we find a tag, i.e., <...tag...>, skip that tag; skip
+ *        script, style and comment regions and entities whole
+ *     3. save beginning of the word
+ *     4. find the end, i.e., first non-letter; a reference to a
+ *        letter, e.g., &eacute;, is part of the word
+ *     5. return first position past end of word
+ * 
+ */
+int webpage_getNextWordSpan(webpage_t *page, int pos, const char **word, int *len) {
   // make sure we have something to search, and a place for the result
-  if (page == NULL || page->html == NULL || word == NULL) {
+  if (page == NULL || page->html == NULL || word == NULL || len == NULL) {
     return -1;
   }
 
   const char *doc = page->html;		   // the html document
-  const char *beg;                         // beginning of word
-  const char *end;                         // end of word
+  const char *end;                         // end of tag
+  int n;                                   // bytes in the letter at pos
 
   // consume any non-alphabetic characters
-  while (doc[pos] != '\0' && !isalpha(doc[pos])) {
+  while (doc[pos] != '\0' && htmllex_letter(doc, page->html_len, pos) == 0) {
+    int skip;                              // end of a region or entity
+    uint32_t cp;                           // character of an entity
+    // if we find a script, style or comment, skip all of it
+    if (doc[pos] == '<' && (skip = htmllex_skip(doc, page->html_len, pos)) > pos) {
+      pos = skip;
+    // if we find a character reference to a non-letter, e.g., &amp;, skip it
+    } else if (doc[pos] == '&' && (skip = htmllex_entity(doc, page->html_len, pos, &cp)) > 0) {
+      pos += skip;
     // if we find a tag, i.e., <...tag...>, skip it
-    if (doc[pos] == '<') {
+    } else if (doc[pos] == '<') {
       end = strchr(&doc[pos], '>');    // find the close
-			/* ST: end is a pointer -- cant compare to a char */
-      if(*end == '\0' || *(++end) == '\0') { // ran out of html
-				return -1;
+      if (end == NULL || *(++end) == '\0') { // ran out of html
+        return -1;
       }
       pos = end - doc;	      // skip over the <...tag...>
     } else {
@@ -132,34 +209,18 @@ int webpage_getNextWord(webpage_t *page, int pos, char **word) {
 
   // ran out of html
   if (doc[pos] == '\0') {
-    *word = NULL;
     return -1;
   }
 
   // pos is at the first character of a word
-  beg = &(doc[pos]);
+  *word = &(doc[pos]);
 
-  // consume word
-  while (doc[pos] != '\0' && isalpha(doc[pos])) {
-    pos++;
+  // consume word, a letter (one byte, a UTF-8 sequence or a reference) at a time
+  while (doc[pos] != '\0' && (n = htmllex_letter(doc, page->html_len, pos)) > 0) {
+    pos += n;
   }
   // at this point, doc[pos] is the first character *after* the word.
-
-  // pos refers to the last character of the word
-  end = &(doc[pos-1]);
-
-  // 'beg' points to first character of the word
-  // 'end' points to last character of the word
-  int wordlen = end - beg + 1;
-
-  // allocate space for length of new word + '\0'
-  *word = calloc(wordlen + 1, sizeof(char));
-  if (*word == NULL) {	      // out of memory!
-    return -1;
-  }
-
-  // copy the new word
-  strncpy(*word, beg, wordlen);
+  *len = &(doc[pos]) - *word;
 
   return pos;
 }
@@ -291,6 +352,50 @@ int webpage_getNextURL(webpage_t *page, int pos, char **result) {
   return end - html;
 }
 
+/**************** webpage_resolveURL ****************/
+/*
+ * resolve a link found in the page into an absolute url
+ * See "webpage.h" for full documentation.
+ *
+ * Pseudocode:
+ *     1. copy the href without whitespace, up to any #fragment
+ *     2. drop empty links and same-page references
+ *     3. determine if url is absolute; drop absolute non-http urls
+ *     4. fixup relative links
+ */
+char *webpage_resolveURL(webpage_t *page, const char *href, int len) {
+  // make sure we have a link and a base url
+  if (page == NULL || page->url == NULL || href == NULL || len < 0) {
+    return NULL;
+  }
+
+  // copy, condensed as webpage_getNextURL does, minus the fragment
+  char *url = calloc(len + 1, sizeof(char));
+  if (!url) { return NULL; }
+  int n = 0;
+  for (int i = 0; i < len && href[i] != '#'; i++) {
+    if (!isspace((unsigned char)href[i])) {
+      url[n++] = href[i];
+    }
+  }
+
+  // nothing left: empty link or internal reference
+  if (n == 0) { free(url); return NULL; }
+
+  // is the url absolute, i.e, ':' must precede any '/', '?', or '#'
+  char *ptr = strpbrk(url, ":/?#");
+  if (!ptr || *ptr != ':') {
+    char *abs_url = FixupRelativeURL(page->url, url, n);
+    free(url);
+    return abs_url;
+  }
+  if (strncasecmp(url, "http", 4)) {       // absolute, but not http(s)
+    free(url);
+    return NULL;
+  }
+  return url;
+}
+
 /******************** NormalizeURL *******************************/
 /* Normalize the url according to RFC 3986 chapter 3
  *
@@ -899,11 +1004,33 @@ checkp(void *p, char *message)
  */
 static size_t WriteMemoryCallback(void *contents, size_t size, size_t nmemb, void *userp) {
   size_t realsize = size * nmemb;
-  webpage_t *page = (webpage_t*) userp;
+  fetch_buffer_t *buf = (fetch_buffer_t*) userp;
+  webpage_t *page = buf->page;
+  size_t needed = page->html_len + realsize + 1;
 
-  page->html = realloc(page->html, page->html_len + realsize + 1);
-  if (page->html == NULL) {
-    return 0;
+  if (max_body > 0 && needed - 1 > max_body) {
+    buf->too_large = true;
+    return 0;                              // makes curl abort the transfer
+  }
+
+  if (needed > buf->capacity) {
+    // grow at least geometrically, but straight to the announced size
+    // when this is the first chunk (headers are complete by now)
+    size_t capacity = buf->capacity * 2;
+    if (page->html_len == 0) {
+      curl_off_t announced = -1;
+      curl_easy_getinfo(buf->curl, CURLINFO_CONTENT_LENGTH_DOWNLOAD_T, &announced);
+      capacity = announced > 0 ? (size_t)announced + 1 : MIN_BUFFER;
+    }
+    if (capacity < needed) capacity = needed;
+    if (max_body > 0 && capacity > max_body + 1) capacity = max_body + 1;
+
+    char *html = realloc(page->html, capacity);
+    if (html == NULL) {
+      return 0;
+    }
+    page->html = html;
+    buf->capacity = capacity;
   }
   memcpy(&(page->html[page->html_len]), contents, realsize);
   page->html_len += realsize;
@@ -912,27 +1039,84 @@ static size_t WriteMemoryCallback(void *contents, size_t size, size_t nmemb, voi
 }
 
 
+/* HeaderCallback - curl callback for each response header line
+ *
+ * Copies the ETag and Last-Modified values into the
+ * webpage_validators_t passed as userp.
+ *
+ * Should have no use outside of this file, thus declared static.
+ */
+static size_t HeaderCallback(char *buffer, size_t size, size_t nitems, void *userp) {
+  size_t len = size * nitems;
+  webpage_validators_t *val = (webpage_validators_t*) userp;
+  char *dst = NULL;                        // field to fill, if any
+  size_t dst_size = 0;
+  size_t name_len = 0;
+
+  if (len > 5 && strncasecmp(buffer, "ETag:", 5) == 0) {
+    dst = val->etag; dst_size = sizeof(val->etag); name_len = 5;
+  } else if (len > 14 && strncasecmp(buffer, "Last-Modified:", 14) == 0) {
+    dst = val->lastmod; dst_size = sizeof(val->lastmod); name_len = 14;
+  }
+
+  if (dst != NULL) {
+    // trim the leading blanks and the trailing CRLF
+    char *beg = buffer + name_len;
+    char *end = buffer + len;
+    while (beg < end && (*beg == ' ' || *beg == '\t')) beg++;
+    while (end > beg && isspace(end[-1])) end--;
+    if ((size_t)(end - beg) < dst_size) {    // too long: ignore it
+      memcpy(dst, beg, end - beg);
+      dst[end - beg] = '\0';
+    }
+  }
+  return len;
+}
+
+
+/* ************* webpage_setMaxBody ******************** */
+/* see webpage.h for usage documentation.
+ */
+void webpage_setMaxBody(size_t bytes) {
+  max_body = bytes;
+}
+
+
 /* ************* webpage_fetch ******************** */
+/* see webpage.h for usage documentation.
+ */
+bool webpage_fetch(webpage_t *page) {
+  return webpage_fetchIfModified(page, NULL) == 1;
+}
+
+
+/* ************* webpage_fetchIfModified ******************** */
 /* see webpage.h for usage documentation.
  *
  * Pseudocode:
  *     1. check for valid page pointer
  *     2. allocate buffer to page->html, set page->html_len to 0
- *     3. setup curl
+ *        (the write callback grows it; see fetch_buffer_t)
+ *     3. setup curl, with conditional headers from val
  *     4. curl the page->url
- *     5. check return status
- *     6. cleanup
+ *     5. check return status, and whether it was 304 Not Modified
+ *        or over the size cap
+ *     6. trim the buffer and cleanup
  */
-bool webpage_fetch(webpage_t *page) {
+int webpage_fetchIfModified(webpage_t *page, webpage_validators_t *val) {
   const int MAX_TRY = 3;               // maximum attempts to fetch
   static char errbuf[CURL_ERROR_SIZE]; // buffer for error messages
   int tries = 0;		       // number of attempts at curl
-  bool status = true;		       // return value
+  int status = 1;		       // return value
   CURL* curl_handle;		       // curl handle
   CURLcode res;		               // curl response code
+  long http_code = 0;		       // HTTP response status
+  struct curl_slist *headers = NULL;   // conditional request headers
+  webpage_validators_t received = { "", "" }; // validators in the response
+  fetch_buffer_t buf;                  // where the body goes
 
   // check page
-  if (page == NULL) { return false; }
+  if (page == NULL) { return -1; }
 
   // allocate space for the html, curl will realloc as needed
   page->html = calloc(1, sizeof(char));
@@ -940,6 +1124,10 @@ bool webpage_fetch(webpage_t *page) {
 
   // init curl session
   curl_handle = curl_easy_init();
+  buf.page = page;
+  buf.curl = curl_handle;
+  buf.capacity = 1;
+  buf.too_large = false;
 
   // specify url
   curl_easy_setopt(curl_handle, CURLOPT_URL, page->url);
@@ -947,8 +1135,13 @@ bool webpage_fetch(webpage_t *page) {
   // send all data to this function
   curl_easy_setopt(curl_handle, CURLOPT_WRITEFUNCTION, WriteMemoryCallback);
 
-  // pass page struct to callback function
-  curl_easy_setopt(curl_handle, CURLOPT_WRITEDATA, (void*)page);
+  // pass the buffer to callback function
+  curl_easy_setopt(curl_handle, CURLOPT_WRITEDATA, (void*)&buf);
+
+  // refuse oversized bodies up front when Content-Length gives them away
+  if (max_body > 0) {
+    curl_easy_setopt(curl_handle, CURLOPT_MAXFILESIZE_LARGE, (curl_off_t)max_body);
+  }
 
   // add a user agent just in case servers need it
   curl_easy_setopt(curl_handle, CURLOPT_USERAGENT, "libcurl-agent/1.0");
@@ -959,26 +1152,64 @@ bool webpage_fetch(webpage_t *page) {
   // save error messages
   curl_easy_setopt(curl_handle, CURLOPT_ERRORBUFFER, &errbuf);
 
-  // get the page; repeat MAX_TRY times
+  // send the validators we have, and collect the ones we get back
+  if (val != NULL) {
+    char line[sizeof(val->etag) + 32];
+    if (val->etag[0] != '\0') {
+      snprintf(line, sizeof(line), "If-None-Match: %s", val->etag);
+      headers = curl_slist_append(headers, line);
+    }
+    if (val->lastmod[0] != '\0') {
+      snprintf(line, sizeof(line), "If-Modified-Since: %s", val->lastmod);
+      headers = curl_slist_append(headers, line);
+    }
+    curl_easy_setopt(curl_handle, CURLOPT_HTTPHEADER, headers);
+    curl_easy_setopt(curl_handle, CURLOPT_HEADERFUNCTION, HeaderCallback);
+    curl_easy_setopt(curl_handle, CURLOPT_HEADERDATA, (void*)&received);
+  }
+
+  // get the page; repeat MAX_TRY times, but not if it is too big
   do {
+    page->html_len = 0;                    // drop any partial body
     res = curl_easy_perform(curl_handle);
 #ifndef NOSLEEP // CS50 students: please don't turn off the sleep!
     sleep(1);   // sleep one second between fetches, to lighten load on server
 #endif
-  } while (res != CURLE_OK && ++tries < MAX_TRY);
+    if (res == CURLE_FILESIZE_EXCEEDED) buf.too_large = true;
+  } while (res != CURLE_OK && !buf.too_large && ++tries < MAX_TRY);
 
   // check response code
   if (res != CURLE_OK) {
     // we're going to return the curl error message on failure
+    if (buf.too_large) {
+      snprintf(errbuf, sizeof(errbuf), "body larger than %zu bytes", max_body);
+    }
     free(page->html);
     page->html = calloc(strlen(errbuf) + 1, sizeof(char));
     page->html_len = strlen(errbuf);
     strcpy(page->html, errbuf);
 
-    status = false;                          // signal failure
+    status = -1;                             // signal failure
+  } else {
+    curl_easy_getinfo(curl_handle, CURLINFO_RESPONSE_CODE, &http_code);
+    if (http_code == 304) {                  // not modified: no body
+      free(page->html);
+      page->html = NULL;
+      page->html_len = 0;
+      status = 0;
+    } else if (buf.capacity > page->html_len + 1) {
+      // give back the growth slack; the page may be kept a while
+      char *html = realloc(page->html, page->html_len + 1);
+      if (html != NULL) page->html = html;
+    }
+    if (val != NULL) {                       // keep old values not resent
+      if (received.etag[0] != '\0') strcpy(val->etag, received.etag);
+      if (received.lastmod[0] != '\0') strcpy(val->lastmod, received.lastmod);
+    }
   }
 
   // cleanup curl stuff
+  curl_slist_free_all(headers);
   curl_easy_cleanup(curl_handle);
   curl_global_cleanup();
 
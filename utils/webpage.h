@@ -35,10 +35,20 @@ char *webpage_getHTML(const webpage_t *page);
  */
 webpage_t *webpage_new(char *url, const int depth, char *html);
 
+/**************** webpage_newmapped ****************/
+/* Like webpage_new(), but the html is not a string of its own: it
+ * lies inside the memory mapping map[0..map_len), which the page
+ * takes over, and is terminated by a NUL within it.
+ * webpage_delete() unmaps the mapping instead of freeing the html.
+ * Returns NULL on any error (the mapping is then the caller's).
+ */
+webpage_t *webpage_newmapped(char *url, const int depth, char *html, void *map, size_t map_len);
+
 /**************** webpage_delete ****************/
 /* Delete a webpage_t structure created by webpage_new().
  * This function may be called from something like bag_delete().
- * This function calls free() on both the url and the html, if not NULL.
+ * This function calls free() on both the url and the html, if not NULL
+ * (or unmaps the html's mapping, for a page from webpage_newmapped()).
  */
 void webpage_delete(void *data);
 
@@ -73,6 +83,44 @@ void webpage_delete(void *data);
  */
 bool webpage_fetch(webpage_t *page);
 
+/***************** webpage_validators_t ******************************/
+/* HTTP cache validators remembered for a page between crawls.
+ * An empty string means the server did not send that header.
+ */
+typedef struct webpage_validators {
+  char etag[256];                          // ETag response header
+  char lastmod[64];                        // Last-Modified response header
+} webpage_validators_t;
+
+/***************** webpage_setMaxBody *******************************/
+/* cap the size of page bodies downloaded by webpage_fetch() and
+ * webpage_fetchIfModified()
+ * @bytes: largest body accepted, or 0 for no limit (the default)
+ *
+ * A larger page fails to fetch (its html is an error message, as for
+ * other failures); when the server sends Content-Length the download
+ * is refused before it starts, otherwise it is aborted once the cap
+ * is passed. Applies to all later fetches.
+ */
+void webpage_setMaxBody(size_t bytes);
+
+/***************** webpage_fetchIfModified ***************************/
+/* conditionally retrieve HTML from page->url, store into page->html
+ * @page: the webpage struct containing the url to curl
+ * @val: validators from an earlier fetch of this url, or NULL
+ *
+ * Like webpage_fetch(), but sends If-None-Match / If-Modified-Since
+ * for each non-empty field of *val, so an unchanged page costs the
+ * server a 304 instead of a full download. On success, *val is updated
+ * from the response's ETag / Last-Modified headers.
+ *
+ * Returns:
+ *     1: page fetched; caller owns page->html as with webpage_fetch().
+ *     0: 304 Not Modified; page->html is NULL.
+ *    -1: some error fetching page.
+ */
+int webpage_fetchIfModified(webpage_t *page, webpage_validators_t *val);
+
 
 /**************** webpage_getNextWord ***********************************/
 /* return the next word from html[pos] into word
@@ -81,6 +129,12 @@ bool webpage_fetch(webpage_t *page);
  *     1. webpage has html
  *     2. don't care about opening/closing tags: ignore anything between <...>
  *     3. if the html is malformed, we don't care: match '<' with next '>'
+ *     4. <script> and <style> bodies, <!-- comments --> and character
+ *        references to non-letters (&amp;, &#8217;, ...) are not words;
+ *        see htmllex.h
+ *     5. a word is a run of letters: ASCII ones, UTF-8 sequences for
+ *        letters (é, ж, 中, ...; see utf8.h), and references to letters
+ *        (&eacute;), which come back decoded. It is not lowercased.
  *
  * Memory contract:
  *     1. inbound, webpage points to an existing struct, with existing html;
@@ -90,6 +144,20 @@ bool webpage_fetch(webpage_t *page);
 
 int webpage_getNextWord(webpage_t *page, int pos, char **word);
 
+/**************** webpage_getNextWordSpan *******************************/
+/* find the next word from html[pos], without copying it
+ * @word: set to the start of the word, inside the page's html
+ * @len: set to the length of the word (it is not NUL-terminated)
+ *
+ * Finds exactly the words webpage_getNextWord() returns, but allocates
+ * nothing: the span stays valid as long as the page's html does. A
+ * reference to a letter (caf&eacute;) is left as is in the span;
+ * htmllex_decode() decodes it, as webpage_getNextWord() does.
+ *
+ * Returns the position just past the word, or -1 when there are no more.
+ */
+int webpage_getNextWordSpan(webpage_t *page, int pos, const char **word, int *len);
+
 /****************** webpage_getNextURL ***********************************/
 /* return the next url from html[pos] into result
  * @page: pointer to the webpage info
@@ -119,6 +187,21 @@ int webpage_getNextWord(webpage_t *page, int pos, char **word);
 
 int webpage_getNextURL(webpage_t *page, int pos, char **result);
 
+/****************** webpage_resolveURL ***********************************/
+/* resolve a link found in the page into an absolute url
+ * @page: the page the link was found in (its url is the base)
+ * @href: the link's target as written, e.g. an href attribute value
+ * @len: length of href (it need not be NUL-terminated)
+ *
+ * Follows the rules of webpage_getNextURL(): whitespace is removed,
+ * the #fragment is dropped, relative links are made absolute, and
+ * same-page references and non-http absolute urls are not links.
+ *
+ * Returns a malloc'd url the caller must free, or NULL if href is not
+ * a link to follow.
+ */
+char *webpage_resolveURL(webpage_t *page, const char *href, int len);
+
 /***********************************************************************
  * NormalizeURL - attempts to normalize the url
  * @url: absolute url to normalize